@@ -218,6 +218,40 @@ struct SectionProperties
 
 DECLARE_REFLECTION_STRUCT(SectionProperties);
 
+DOCUMENT(R"(A set of resolved callstacks which share one table of frames, so that a frame
+appearing in many callstacks is only resolved and stored once.
+)");
+struct CallstackFrameTable
+{
+  DOCUMENT("");
+  CallstackFrameTable() = default;
+  CallstackFrameTable(const CallstackFrameTable &) = default;
+  CallstackFrameTable &operator=(const CallstackFrameTable &) = default;
+
+  DOCUMENT(R"(The distinct resolved frames, each formatted as a string.
+
+:type: List[str]
+)");
+  rdcarray<rdcstr> frames;
+
+  DOCUMENT(R"(For each address that was resolved, the index into :data:`frames` of its frame.
+These are in the same order as the addresses were given.
+
+:type: List[int]
+)");
+  rdcarray<uint32_t> frameIndices;
+
+  DOCUMENT(R"(The offset into :data:`frameIndices` where each callstack begins, followed by one
+final entry for the total number of indices. Callstack ``i`` covers the indices from
+``callstackOffsets[i]`` up to but not including ``callstackOffsets[i+1]``.
+
+:type: List[int]
+)");
+  rdcarray<uint32_t> callstackOffsets;
+};
+
+DECLARE_REFLECTION_STRUCT(CallstackFrameTable);
+
 struct ResourceFormat;
 
 #if !defined(SWIG)
@@ -46,6 +46,8 @@ class rdcliteral
 
   // similarly friend inflexible strings to allow them to decompose to a literal
   friend class rdcinflexiblestr;
+  // structured data arenas hand out strings that live as long as the objects using them
+  friend class SDObjectArena;
 
   constexpr rdcliteral(const char *s, size_t l) : str(s), len(l) {}
   rdcliteral() = delete;
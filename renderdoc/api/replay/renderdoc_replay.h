@@ -1336,6 +1336,25 @@ Must only be called after :meth:`InitResolver` has returned ``True``.
 )");
   virtual rdcarray<rdcstr> GetResolve(const rdcarray<uint64_t> &callstack) = 0;
 
+  DOCUMENT(R"(Retrieve the details of every stackframe in many callstacks at once, such as all of
+the callstacks in a capture.
+
+The callstacks are given as one list of addresses, with each callstack's addresses following the
+previous one's. Each distinct address is only resolved once no matter how many callstacks it appears
+in, and where possible the addresses are resolved in parallel.
+
+Must only be called after :meth:`InitResolver` has returned ``True``.
+
+:param List[int] addresses: The integer addresses of every callstack, one after another.
+:param List[int] callstackOffsets: The offset into ``addresses`` where each callstack begins,
+  followed by one final entry for the total number of addresses. If this is empty, all of the
+  addresses are treated as a single callstack.
+:return: The resolved frames, and the list of frames for each callstack.
+:rtype: CallstackFrameTable
+)");
+  virtual CallstackFrameTable GetResolves(const rdcarray<uint64_t> &addresses,
+                                          const rdcarray<uint32_t> &callstackOffsets) = 0;
+
   DOCUMENT(R"(Retrieves the name of the driver that was used to create this capture.
 
 :return: A simple string identifying the driver used to make the capture.
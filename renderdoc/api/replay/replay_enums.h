@@ -4584,6 +4584,13 @@ DOCUMENT(R"(A set of flags describing the properties of a section in a renderdoc
 .. data:: ZstdCompressed
 
   This section is compressed with Zstd on disk.
+
+.. data:: BlockIndexed
+
+  This compressed section has each block compressed independently, with an index of block offsets
+  stored after the compressed data. This allows seeking within the section without decompressing
+  everything before the desired offset. Readers that don't know about the index still read these
+  sections normally, as they stop decompressing once the section's uncompressed size has been read.
 )");
 enum class SectionFlags : uint32_t
 {
@@ -4591,6 +4598,7 @@ enum class SectionFlags : uint32_t
   ASCIIStored = 0x1,
   LZ4Compressed = 0x2,
   ZstdCompressed = 0x4,
+  BlockIndexed = 0x8,
 };
 
 BITMASK_OPERATORS(SectionFlags);
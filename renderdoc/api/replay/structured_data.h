@@ -232,6 +232,7 @@ DISABLE_PYTHON_FLAG_ENUMS;
 
 struct SDObject;
 struct SDChunk;
+class SDObjectArena;
 
 DOCUMENT("Details the name and properties of a structured type");
 struct SDType
@@ -613,6 +614,7 @@ struct SDObject
     ret->type = type;
     ret->data.basic = data.basic;
     ret->data.str = data.str;
+    CopyArenaStrings(ret);
 
     if(m_Lazy)
     {
@@ -806,7 +808,7 @@ returned.
       // we really shouldn't be deleting individually from a lazy array but just in case we are,
       // fully evaluate it first.
       PopulateAllChildren();
-      delete data.children.takeAt(index);
+      Destroy(data.children.takeAt(index));
     }
   }
 
@@ -814,7 +816,7 @@ returned.
   inline void DeleteChildren()
   {
     for(size_t i = 0; i < data.children.size(); i++)
-      delete data.children[i];
+      Destroy(data.children[i]);
 
     data.children.clear();
 
@@ -870,6 +872,16 @@ returned.
     objs.swap(data.children);
   }
 
+  // delete an object that might have been allocated from an SDObjectArena, where the memory
+  // belongs to the arena and only the destructor must run.
+  static void Destroy(SDObject *obj)
+  {
+    if(obj && obj->m_ArenaOwned)
+      obj->~SDObject();
+    else
+      delete obj;
+  }
+
   template <typename T>
   void SetLazyArray(uint64_t arrayCount, T *arrayData, LazyGenerator generator)
   {
@@ -1029,6 +1041,9 @@ protected:
   SDObject(const SDObject &other) = delete;
   SDObject &operator=(const SDObject &other) = delete;
 
+  // set for objects allocated from an SDObjectArena, which must not be deleted with delete
+  bool m_ArenaOwned = false;
+
   // these functions can be const because we have 'mutable' allowing us to modify these members.
   // It's ugly, but necessary
   inline void PopulateChild(size_t idx) const
@@ -1054,6 +1069,18 @@ protected:
     }
   }
 
+  // strings from an SDObjectArena are stored like literals, pointing into the arena's pages. A copy
+  // that can outlive the arena needs its own storage for them
+  void CopyArenaStrings(SDObject *dst) const
+  {
+    if(m_ArenaOwned)
+    {
+      dst->name = rdcstr(name.c_str());
+      dst->type.name = rdcstr(type.name.c_str());
+      dst->data.str = rdcstr(data.str.c_str());
+    }
+  }
+
   static void *alloc(size_t sz)
   {
     void *ret = NULL;
@@ -1079,6 +1106,8 @@ private:
   SDObject *m_Parent = NULL;
   mutable LazyArrayData *m_Lazy = NULL;
 
+  friend class SDObjectArena;
+
   // object serialisers need to be able to set the parent pointer. This is only for proxying really
   template <class SerialiserType>
   friend void DoSerialise(SerialiserType &ser, SDObject &el);
@@ -1489,6 +1518,7 @@ struct SDChunk : public SDObject
     ret->type = type;
     ret->data.basic = data.basic;
     ret->data.str = data.str;
+    CopyArenaStrings(ret);
 
     ret->data.children.resize(data.children.size());
 
@@ -1500,6 +1530,17 @@ struct SDChunk : public SDObject
     return ret;
   }
 
+#if !defined(SWIG)
+  // as SDObject::Destroy, for chunks which may have been allocated from an SDObjectArena
+  static void Destroy(SDChunk *chunk)
+  {
+    if(chunk && chunk->m_ArenaOwned)
+      chunk->~SDChunk();
+    else
+      delete chunk;
+  }
+#endif
+
 protected:
   SDChunk() : SDObject() {}
   SDChunk(const SDChunk &other) = delete;
@@ -1580,6 +1621,197 @@ private:
 
 DECLARE_REFLECTION_STRUCT(StructuredBufferList);
 
+#if !defined(SWIG)
+// A bump allocator that an SDFile can use to own its objects and their strings, see
+// SDFile::UseArena().
+//
+// Building the structured data for a large capture otherwise makes a heap allocation for every
+// object and for many of their strings, and frees each again individually. Objects from the arena
+// are placed one after another in large pages, so the children of an object are usually contiguous
+// in memory, and repeated names like chunk and enum names are only stored once. Everything is
+// released at once when the arena is destroyed after its objects.
+//
+// Strings returned from the arena aren't owned by whichever object they're assigned to, like
+// literals. Objects from the arena must be freed with SDObject::Destroy / SDChunk::Destroy, which
+// SDObject and SDFile do themselves. Not thread-safe.
+class SDObjectArena
+{
+public:
+  SDObjectArena() = default;
+  ~SDObjectArena()
+  {
+    for(byte *page : m_Pages)
+      deallocate(page);
+  }
+
+  void *operator new(size_t sz) { return allocate(sz); }
+  void operator delete(void *p) { deallocate(p); }
+  void *operator new[](size_t count) = delete;
+  void operator delete[](void *p) = delete;
+
+  SDObject *NewObject(rdcinflexiblestr &&name, rdcinflexiblestr &&type)
+  {
+    // the class's operator new allocates on the heap, so use the global placement new
+    SDObject *ret = ::new(Allocate(sizeof(SDObject))) SDObject(std::move(name), std::move(type));
+    ret->m_ArenaOwned = true;
+    return ret;
+  }
+
+  SDChunk *NewChunk(const rdcinflexiblestr &name)
+  {
+    SDChunk *ret = ::new(Allocate(sizeof(SDChunk))) SDChunk(name);
+    ret->m_ArenaOwned = true;
+    return ret;
+  }
+
+  // returns a string that lives as long as the arena, shared with any previous identical string.
+  // Intended for strings that repeat many times, like names
+  rdcinflexiblestr Intern(const rdcstr &str)
+  {
+    const uint64_t hash = Hash(str.c_str(), str.size());
+
+    if(m_InternCount * 2 >= m_Intern.size())
+      GrowIntern();
+
+    size_t mask = m_Intern.size() - 1;
+    size_t idx = size_t(hash) & mask;
+    while(m_Intern[idx].str)
+    {
+      const InternEntry &e = m_Intern[idx];
+      if(e.hash == hash && e.length == str.size() && !memcmp(e.str, str.c_str(), str.size()))
+        return rdcliteral(e.str, e.length);
+
+      idx = (idx + 1) & mask;
+    }
+
+    InternEntry &e = m_Intern[idx];
+    e.hash = hash;
+    e.length = str.size();
+    e.str = CopyChars(str.c_str(), str.size());
+    m_InternCount++;
+
+    return rdcliteral(e.str, e.length);
+  }
+
+  // returns a copy of a string that lives as long as the arena, for strings that are unlikely to
+  // repeat
+  rdcinflexiblestr Copy(const rdcstr &str)
+  {
+    return rdcliteral(CopyChars(str.c_str(), str.size()), str.size());
+  }
+
+  // the total size of the pages allocated, for statistics
+  uint64_t GetAllocatedBytes() const { return m_AllocatedBytes; }
+
+private:
+  static const size_t PageSize = 1024 * 1024;
+  static const size_t Alignment = 16;
+
+  struct InternEntry
+  {
+    uint64_t hash = 0;
+    size_t length = 0;
+    const char *str = NULL;
+  };
+
+  static void *allocate(size_t sz)
+  {
+    void *ret = NULL;
+#ifdef RENDERDOC_EXPORTS
+    ret = malloc(sz);
+    if(ret == NULL)
+      RENDERDOC_OutOfMemory(sz);
+#else
+    ret = RENDERDOC_AllocArrayMem(sz);
+#endif
+    return ret;
+  }
+  static void deallocate(void *p)
+  {
+#ifdef RENDERDOC_EXPORTS
+    free(p);
+#else
+    RENDERDOC_FreeArrayMem(p);
+#endif
+  }
+
+  static uint64_t Hash(const char *str, size_t len)
+  {
+    // FNV-1a
+    uint64_t hash = 14695981039346656037ULL;
+    for(size_t i = 0; i < len; i++)
+    {
+      hash ^= (byte)str[i];
+      hash *= 1099511628211ULL;
+    }
+    return hash;
+  }
+
+  void *Allocate(size_t size)
+  {
+    size = (size + Alignment - 1) & ~(Alignment - 1);
+
+    // large allocations get their own page so they don't waste the rest of the current one
+    if(size > PageSize / 4)
+    {
+      byte *page = (byte *)allocate(size);
+      m_Pages.push_back(page);
+      m_AllocatedBytes += size;
+      return page;
+    }
+
+    if(size > m_Remaining)
+    {
+      m_Cur = (byte *)allocate(PageSize);
+      m_Remaining = PageSize;
+      m_Pages.push_back(m_Cur);
+      m_AllocatedBytes += PageSize;
+    }
+
+    void *ret = m_Cur;
+    m_Cur += size;
+    m_Remaining -= size;
+    return ret;
+  }
+
+  const char *CopyChars(const char *str, size_t len)
+  {
+    char *ret = (char *)Allocate(len + 1);
+    memcpy(ret, str, len);
+    ret[len] = 0;
+    return ret;
+  }
+
+  void GrowIntern()
+  {
+    rdcarray<InternEntry> old;
+    old.swap(m_Intern);
+
+    m_Intern.resize(old.empty() ? 1024 : old.size() * 2);
+
+    const size_t mask = m_Intern.size() - 1;
+    for(const InternEntry &e : old)
+    {
+      if(!e.str)
+        continue;
+
+      size_t idx = size_t(e.hash) & mask;
+      while(m_Intern[idx].str)
+        idx = (idx + 1) & mask;
+      m_Intern[idx] = e;
+    }
+  }
+
+  rdcarray<byte *> m_Pages;
+  byte *m_Cur = NULL;
+  size_t m_Remaining = 0;
+  uint64_t m_AllocatedBytes = 0;
+
+  rdcarray<InternEntry> m_Intern;
+  size_t m_InternCount = 0;
+};
+#endif
+
 DOCUMENT("Contains the structured information in a file. Owns the buffers and chunks.");
 struct SDFile
 {
@@ -1618,10 +1850,13 @@ public:
   ~SDFile()
   {
     for(SDChunk *chunk : chunks)
-      delete chunk;
+      SDChunk::Destroy(chunk);
 
     for(bytebuf *buf : buffers)
       delete buf;
+
+    // the arena goes last, after all of its objects
+    delete m_Arena;
   }
 
   DOCUMENT(R"(The chunks in the file in order.
@@ -1651,9 +1886,25 @@ public:
     chunks.swap(other.chunks);
     buffers.swap(other.buffers);
     std::swap(version, other.version);
+    std::swap(m_Arena, other.m_Arena);
   }
 
+#if !defined(SWIG)
+  // allocate new objects and strings for this file from an SDObjectArena, which is freed with the
+  // file. Existing objects are unaffected.
+  void UseArena()
+  {
+    if(!m_Arena)
+      m_Arena = new SDObjectArena;
+  }
+
+  // returns NULL if the file doesn't use an arena
+  SDObjectArena *GetArena() { return m_Arena; }
+#endif
+
 protected:
   SDFile(const SDFile &) = delete;
   SDFile &operator=(const SDFile &) = delete;
+
+  SDObjectArena *m_Arena = NULL;
 };
@@ -23,6 +23,7 @@
  ******************************************************************************/
 
 #include <math.h>
+#include <algorithm>
 #include "formatting.h"
 #include "threading.h"
 
@@ -70,35 +71,55 @@ static float spinForce = 0.0f;
 // - jobs are basically go-wide then one big sync, no need to track lifetimes, don't need a
 // continuous
 //   rolling parallelisation only using this during specific points (loading, shader debugging)
-// - all jobs explicitly launched from main thread, jobs cannot launch jobs
+// - jobs are launched from main thread, or from inside other jobs on worker threads
 // - only simple dependencies: 1 job depends on N parents
+// - waiting is either for everything with SyncAllJobs() on the main thread, or for a specific set
+//   of jobs with Wait() from the main thread or inside a job. Job handles are valid until the next
+//   SyncAllJobs(), which frees every job, unless the main thread frees some of its own jobs early
+//   with WaitAndFree()
 // - don't need to be fair: as long as all jobs complete, can happen in mostly any order
 // - jobs should not be too fast, 2ms would be a lower bound
 // - since we expect one sync point, we don't expect perfect forward progress indefinitely with no
 // syncs
 //
+// Structure:
+//
+// - every worker owns a work-stealing deque, and the main thread owns one more. Only the owner
+//   pushes and pops at the bottom, any other thread can steal from the top. This means there is
+//   no global lock that every thread hits to get work.
+// - jobs only enter a deque once they are ready to run. Each job counts how many of its parents
+//   are still incomplete, and parents keep a list of children to release on completion. The thread
+//   that completes the last parent pushes the child onto its own deque, so jobs are never polled
+//   and never re-queued.
+// - new jobs (with no incomplete parents) are pushed onto the deque of the thread adding them, be
+//   that the main thread or a worker running a job.
+// - any thread waiting - the main thread in SyncAllJobs() or any thread in Wait() - helps run jobs
+//   until what it's waiting for completes, so a job waiting on its own children can't deadlock
+//   the workers. Waiting on a job that depends on the waiter is still a deadlock.
+//
 // Safety analysis:
 //
 // - over-waking a semaphore a little is not a problem, the worker might spin a bit but it will
 // eventually
 //   go back to sleep once it can't get any work.
-// - waking one semaphore is sufficient to drain the queue as one worker alone will eventually
+// - waking one semaphore is sufficient to drain the queues as one worker alone will eventually
 //   complete all work just potentially without the best parallelism if other workers are sleeping
 // - semaphore count limits mean we should not do one wake-per-job or it might overflow in theory
 // - we wake workers in a chain. Threads mark when they go to sleep and are prioritised to wake up
-//   for new jobs as we assume maximum saturation is desired. When a thread finds work in the queue
-//   pending it will try to wake a sleeping sibling.
+//   for new jobs as we assume maximum saturation is desired. When a thread finds more work pending
+//   after grabbing a job it will try to wake a sleeping sibling.
 // - The main thread could in theory push work right as all threads are going to sleep but fail to
 //   wake any of them if it thinks they're running. This can only happen for one job at most at a
 //   time, the most recent job to be pushed, as otherwise the next job would find sleeping
-//   threads and wake them. Forward progress is guaranteed by an assumed SyncAll() call. This could
-//   be improved by forcing the main thread to always wake at least one thread, or perhaps to wait
-//   until either it's woken a thread or the job has been grabbed from the job queue.
+//   threads and wake them. Forward progress is guaranteed by an assumed SyncAll() call, during
+//   which the main thread runs jobs itself.
 // - threads could be mis-identified as both sleeping or waking due to the gap between the atomic on
 //   'running' and the semaphore sleep/wake, but as a result of the above double-waking a thread is
 //   not a big problem as it will eventually sleep if there's no room. Thinking a thread is running
 //   when it's just gone to sleep is also fine as this is equivalent to if the thread really were
 //   running - we still have forward progress.
+// - a worker only pushes to its own deque when it completes a job, and it is running at that point
+//   so it will pop the released children itself before it considers sleeping.
 
 namespace JobSystem
 {
@@ -108,20 +129,16 @@ struct Job
   // 0 = not run or running, 1 = complete
   int32_t state = 0;
 
-  void run()
-  {
-    // run should not be called multiple times
-    RDCASSERT(state == 0);
-
-    callback();
-    Atomic::Inc32(&state);
+  // the number of parents that haven't completed yet. While the job is being added this also
+  // holds one extra reference so that it can't be released before all parents are registered
+  int32_t pendingParents = 0;
 
-    // run should not be called multiple times
-    RDCASSERT(state == 1);
-  }
+  // protects the transition of state to complete, and the list of children
+  SpinLock lock;
 
-  // list of jobs that must be complete before this job can be run
-  rdcarray<Job *> parents;
+  // list of jobs waiting on this job to complete. Once this job is complete the list is emptied
+  // and no more jobs will be added
+  rdcarray<Job *> children;
 
   // the actual callback
   std::function<void()> callback;
@@ -129,18 +146,149 @@ struct Job
 
 };    // namespace JobSystem
 
+// a power-of-two sized ring of job pointers backing a deque
+struct JobRing
+{
+  int64_t mask;
+  Threading::JobSystem::Job **jobs;
+};
+
+// Chase-Lev work-stealing deque. Push() and Pop() must only be called from the owning thread,
+// Steal() can be called from any thread.
+struct JobDeque
+{
+  void Init()
+  {
+    top = bottom = 0;
+    ring = NewRing(1024);
+  }
+
+  void Destroy()
+  {
+    FreeRing(ring);
+    ring = NULL;
+    for(JobRing *r : retiredRings)
+      FreeRing(r);
+    retiredRings.clear();
+  }
+
+  void Push(Threading::JobSystem::Job *job)
+  {
+    int64_t b = bottom;
+    int64_t t = top;
+
+    // if the ring is full, grow it. Stealers may still be reading from the old ring so we can't
+    // free it until shutdown, but it is never written again so anything they read is valid.
+    JobRing *r = ring;
+    if(b - t > r->mask)
+    {
+      JobRing *grown = NewRing(size_t(r->mask + 1) * 2);
+      for(int64_t i = t; i < b; i++)
+        grown->jobs[i & grown->mask] = r->jobs[i & r->mask];
+      retiredRings.push_back(r);
+      ring = r = grown;
+    }
+
+    r->jobs[b & r->mask] = job;
+
+    // publish the job. This is a full barrier so the write above is visible first
+    Atomic::Inc64(&bottom);
+  }
+
+  Threading::JobSystem::Job *Pop()
+  {
+    // reserve the bottom element before checking for stealers
+    int64_t b = Atomic::Dec64(&bottom);
+    int64_t t = top;
+
+    // the deque was empty, restore bottom
+    if(t > b)
+    {
+      Atomic::Inc64(&bottom);
+      return NULL;
+    }
+
+    Threading::JobSystem::Job *job = ring->jobs[b & ring->mask];
+
+    // if this is the last element, race any stealers for it by bumping top ourselves.
+    if(t == b)
+    {
+      if(Atomic::CmpExch64(&top, t, t + 1) != t)
+        job = NULL;
+
+      // either way the deque is now empty, with top == bottom
+      Atomic::Inc64(&bottom);
+    }
+
+    return job;
+  }
+
+  Threading::JobSystem::Job *Steal()
+  {
+    int64_t t = Atomic::CmpExch64(&top, 0, 0);
+    int64_t b = Atomic::CmpExch64(&bottom, 0, 0);
+
+    if(t >= b)
+      return NULL;
+
+    JobRing *r = ring;
+    Threading::JobSystem::Job *job = r->jobs[t & r->mask];
+
+    // if we lose the race to another stealer or the owner, give up rather than retrying. The
+    // caller will try other deques and come back around.
+    if(Atomic::CmpExch64(&top, t, t + 1) != t)
+      return NULL;
+
+    return job;
+  }
+
+  // conservative check, may be stale by the time it returns
+  bool Empty() { return Atomic::CmpExch64(&bottom, 0, 0) <= Atomic::CmpExch64(&top, 0, 0); }
+private:
+  static JobRing *NewRing(size_t size)
+  {
+    JobRing *ret = new JobRing;
+    ret->mask = int64_t(size) - 1;
+    ret->jobs = new Threading::JobSystem::Job *[size];
+    return ret;
+  }
+
+  static void FreeRing(JobRing *r)
+  {
+    if(r)
+      delete[] r->jobs;
+    delete r;
+  }
+
+  // next index to steal from. Only increments
+  int64_t top = 0;
+  // next index to push to. Only modified by the owner
+  int64_t bottom = 0;
+
+  JobRing *volatile ring = NULL;
+
+  // rings that have been grown out of, only accessed by the owner
+  rdcarray<JobRing *> retiredRings;
+};
+
 // TODO: could be multiple queues per-priority in future...
 
-// locked access to the queue and shutdown flag
-Threading::CriticalSection queueLock;
-// global flags for workers to shut down. DOES NOT automatically drain work, requires a sync first
-bool shutdown = false;
-// added to on on main thread and worker threads pull from and potentially reorder
-rdcarray<Threading::JobSystem::Job *> jobQueue;
+// global flag for workers to shut down. DOES NOT automatically drain work, requires a sync first
+int32_t shutdown = 0;
+
+// number of jobs added that haven't completed yet
+int32_t pendingJobs = 0;
+
+// deque owned by the main thread, that new jobs are pushed to
+JobDeque mainQueue;
 
-// list of jobs, only for lifetime management. Only accessed on main thread, for cleanup in SyncAll()
+// list of jobs added from the main thread, only for lifetime management. Only accessed on main
+// thread, for cleanup in SyncAll()
 rdcarray<Threading::JobSystem::Job *> allocatedJobs;
 
+// TLS slot pointing to the JobWorker for the current thread. NULL on non-worker threads
+uint64_t workerTLSSlot = 0;
+
 struct JobWorker
 {
   size_t idx;
@@ -148,6 +296,13 @@ struct JobWorker
   Threading::Semaphore *semaphore;
   Threading::ThreadHandle thread;
 
+  // deque of ready jobs owned by this worker
+  JobDeque queue;
+
+  // list of jobs added from jobs on this worker, only for lifetime management. Cleaned up by the
+  // main thread in SyncAll() while the worker is asleep
+  rdcarray<Threading::JobSystem::Job *> allocatedJobs;
+
   // 1 = running, or 0 = currently sleeping
   int32_t running = 1;
 };
@@ -157,6 +312,12 @@ uint64_t mainThread;
 
 rdcarray<JobWorker> workers;
 
+// returns the worker for the current thread, or NULL if it isn't a worker
+JobWorker *GetCurrentWorker()
+{
+  return (JobWorker *)Threading::GetTLSValue(workerTLSSlot);
+}
+
 // wake at most one sleeping worker, either starting from 0 (and any) or starting from N (and not waking itself)
 bool TryWakeFirstSleepingWorker(size_t firstIdx = ~0U)
 {
@@ -186,71 +347,128 @@ bool TryWakeFirstSleepingWorker(size_t firstIdx = ~0U)
   return false;
 }
 
-bool RunJobIfReady(Threading::JobSystem::Job *curJob)
+// try to steal a job from anywhere other than the given worker's deque, starting with the main
+// thread's deque then the worker after the thief. Returns the deque stolen from in victim so the
+// caller can check if there's more work there.
+Threading::JobSystem::Job *StealJob(size_t thiefIdx, JobDeque *&victim)
 {
-  // default to ready to run if there are no parents
-  bool dependenciesSatisfied = true;
+  victim = &mainQueue;
+  Threading::JobSystem::Job *ret = mainQueue.Steal();
+  if(ret)
+    return ret;
 
-  // check all parent jobs if they're completed. This is conservative,
-  // they might have finished but not updated state or one might finish after
-  // we checked it, but that's fine
-  for(Threading::JobSystem::Job *p : curJob->parents)
+  size_t firstIdx = thiefIdx == ~0U ? 0 : thiefIdx + 1;
+
+  for(size_t i = 0; i < workers.size(); i++)
   {
-    if(Atomic::CmpExch32(&p->state, 0, 0) == 0)
-      dependenciesSatisfied = false;
+    size_t idx = (firstIdx + i) % workers.size();
 
-    // check that parent state is valid, should either be finished or not
-    int32_t state = p->state;
-    RDCASSERT(state == 0 || state == 1);
+    if(idx == thiefIdx)
+      continue;
+
+    victim = &workers[idx].queue;
+    ret = victim->Steal();
+    if(ret)
+      return ret;
   }
 
-  // if we can run the job, run it. Return whether or not it was run
-  if(dependenciesSatisfied)
-  {
-    curJob->run();
+  victim = NULL;
+  return NULL;
+}
+
+bool AnyQueuedWork()
+{
+  if(!mainQueue.Empty())
     return true;
-  }
+
+  for(size_t i = 0; i < workers.size(); i++)
+    if(!workers[i].queue.Empty())
+      return true;
 
   return false;
 }
 
+void RunJob(Threading::JobSystem::Job *curJob, JobDeque &localQueue)
+{
+  // run should not be called multiple times, and jobs are only queued once all parents complete
+  RDCASSERT(curJob->state == 0);
+  RDCASSERT(curJob->pendingParents == 0);
+
+  curJob->callback();
+
+  rdcarray<Threading::JobSystem::Job *> children;
+
+  {
+    SCOPED_SPINLOCK(curJob->lock);
+
+    Atomic::Inc32(&curJob->state);
+
+    // run should not be called multiple times
+    RDCASSERT(curJob->state == 1);
+
+    children.swap(curJob->children);
+  }
+
+  RandomSleepSpin(false);
+
+  // release any children that were only waiting on us. We push them to our own deque so that we
+  // can run them ourselves, and siblings can steal them.
+  for(Threading::JobSystem::Job *child : children)
+  {
+    if(Atomic::Dec32(&child->pendingParents) == 0)
+      localQueue.Push(child);
+  }
+
+  // only mark the job as done once all children are queued, so SyncAllJobs() can't miss them
+  Atomic::Dec32(&pendingJobs);
+}
+
+// grab a job from the thread's own deque or steal one, and run it. Returns false if no job could
+// be found. Used by threads waiting on jobs, not by workers which sleep when there's no work.
+bool RunOneJob(JobDeque &localQueue, size_t idx)
+{
+  JobDeque *source = &localQueue;
+
+  Threading::JobSystem::Job *curJob = localQueue.Pop();
+  if(!curJob)
+    curJob = StealJob(idx, source);
+
+  if(!curJob)
+    return false;
+
+  // if there's more work to do, try to wake a sleeping worker
+  if(!source->Empty())
+    TryWakeFirstSleepingWorker(idx);
+
+  RunJob(curJob, localQueue);
+
+  return true;
+}
+
 void WorkerThread(JobWorker &worker)
 {
   Threading::SetCurrentThreadName(StringFormat::Fmt("JobWorker %02u", (uint32_t)worker.idx));
+  Threading::SetTLSValue(workerTLSSlot, &worker);
   // outer loop until shutdown
   while(true)
   {
-    // job we grabbed to work on
-    Threading::JobSystem::Job *curJob = NULL;
-    // if there is even more work to do
-    bool moreWork = false;
-
     RandomSleepSpin(false);
 
-    {
-      SCOPED_LOCK(queueLock);
-
-      RandomSleepSpin(true);
-
-      // grab a job if the queue is non-empty
-      if(!jobQueue.empty())
-      {
-        curJob = jobQueue.back();
-        jobQueue.pop_back();
-      }
-      // if there's even more work, note it so we can wake up a sibling worker as needed
-      moreWork = !jobQueue.empty();
+    // shut down immediately if requested
+    if(Atomic::CmpExch32(&shutdown, 0, 0) == 1)
+      break;
 
-      RandomSleepSpin(true);
+    // deque we got work from, to see if there's even more work
+    JobDeque *source = &worker.queue;
 
-      // shut down immediately if requested, check this in the lock
-      if(shutdown)
-        break;
-    }
+    // grab a job from our own deque first, then try to steal one
+    Threading::JobSystem::Job *curJob = worker.queue.Pop();
+    if(!curJob)
+      curJob = StealJob(worker.idx, source);
 
     RandomSleepSpin(false);
 
-    // if there's no more work, go to sleep
+    // if there's no work, go to sleep
     if(!curJob)
     {
       RDCASSERT(worker.running == 1);
@@ -258,23 +476,16 @@ void WorkerThread(JobWorker &worker)
 
       RandomSleepSpin(false);
 
-      // check the queue once more here to allow constant forward progress without a sync.
+      // check the queues once more here to allow constant forward progress without a sync.
       // If the main thread pushed work after we last checked, but it thought we were running so
       // didn't wake us up and we got here, we can check for work and re-wake without a semaphore
       // signal that might never come.
       // If there's no work here then when the main thread adds more it will definitely see us (or
       // at least one worker) not running and wake us
+      if(AnyQueuedWork() || Atomic::CmpExch32(&shutdown, 0, 0) == 1)
       {
-        SCOPED_LOCK(queueLock);
-        RandomSleepSpin(true);
-
-        if(!jobQueue.empty())
-        {
-          RandomSleepSpin(true);
-
-          Atomic::Inc32(&worker.running);
-          continue;
-        }
+        Atomic::Inc32(&worker.running);
+        continue;
       }
 
       RandomSleepSpin(false);
@@ -284,24 +495,17 @@ void WorkerThread(JobWorker &worker)
       Atomic::Inc32(&worker.running);
 
       RandomSleepSpin(false);
+
+      continue;
     }
 
     // if there's more work to do, try to wake a sleeping worker too. If none are sleeping, this will do nothing
-    if(moreWork)
+    if(!source->Empty())
       TryWakeFirstSleepingWorker(worker.idx);
 
     RandomSleepSpin(false);
 
-    // run our job, and push it back onto the queue if it couldn't be run
-    if(curJob && !RunJobIfReady(curJob))
-    {
-      SCOPED_LOCK(queueLock);
-
-      RandomSleepSpin(true);
-      jobQueue.insert(0, curJob);
-
-      RandomSleepSpin(true);
-    }
+    RunJob(curJob, worker.queue);
   }
 
   Atomic::Dec32(&worker.running);
@@ -313,8 +517,12 @@ void Init(uint32_t numThreads)
 {
   mainThread = Threading::GetCurrentID();
 
-  shutdown = false;
-  jobQueue.clear();
+  if(workerTLSSlot == 0)
+    workerTLSSlot = Threading::AllocateTLSSlot();
+
+  shutdown = 0;
+  pendingJobs = 0;
+  mainQueue.Init();
 
   // if numThreads is 0, auto-select a number of threads
   if(numThreads == 0)
@@ -340,9 +548,13 @@ void Init(uint32_t numThreads)
   for(size_t i = 0; i < numThreads; i++)
   {
     workers[i].idx = i;
+    workers[i].queue.Init();
     workers[i].semaphore = Threading::Semaphore::Create();
-    workers[i].thread = Threading::CreateThread([i] { WorkerThread(workers[i]); });
   }
+
+  // create threads only once all queues are initialised, since workers steal from each other
+  for(size_t i = 0; i < numThreads; i++)
+    workers[i].thread = Threading::CreateThread([i] { WorkerThread(workers[i]); });
 }
 
 void Shutdown()
@@ -356,10 +568,8 @@ void Shutdown()
 
   mainThread = 0;
 
-  {
-    SCOPED_LOCK(queueLock);
-    shutdown = true;
-  }
+  Atomic::Inc32(&shutdown);
+
   for(size_t i = 0; i < workers.size(); i++)
     workers[i].semaphore->Wake(1);
 
@@ -368,49 +578,38 @@ void Shutdown()
     Threading::JoinThread(workers[i].thread);
     Threading::CloseThread(workers[i].thread);
     workers[i].semaphore->Destroy();
+    workers[i].queue.Destroy();
   }
 
   workers.clear();
+
+  mainQueue.Destroy();
 }
 
 void SyncAllJobs()
 {
-  if(workers.empty())
+  if(mainThread == 0)
     return;
 
   RDCASSERTEQUAL(mainThread, Threading::GetCurrentID());
 
-  while(true)
+  // help out running jobs until every job has completed. Jobs that are waiting on parents aren't in
+  // any deque but will be pushed by whichever thread completes their last parent.
+  while(Atomic::CmpExch32(&pendingJobs, 0, 0) != 0)
   {
-    // job we grabbed to work on
-    Job *curJob = NULL;
-
-    {
-      SCOPED_LOCK(queueLock);
-      if(jobQueue.empty())
-        break;
-
-      curJob = jobQueue.back();
-      jobQueue.pop_back();
-    }
-
-    if(!RunJobIfReady(curJob))
-    {
-      SCOPED_LOCK(queueLock);
-      jobQueue.insert(0, curJob);
-    }
-
-    TryWakeFirstSleepingWorker();
+    // if all remaining jobs are running or waiting on running jobs, sleep rather than spinning
+    if(!RunOneJob(mainQueue, ~0U))
+      Threading::Sleep(0);
   }
 
-  // the queue is now empty, but workers may still be running
+  // all jobs are complete, but workers may still be running
   bool workersRunning = false;
   do
   {
     workersRunning = false;
 
     // if any worker is running, we keep looping. We know a worker can't wake up again after it's
-    // finished running because we force-drained the queue and nothing else will be adding work
+    // finished running because every deque is empty and nothing else will be adding work
     for(size_t i = 0; i < workers.size(); i++)
       workersRunning |= (Atomic::CmpExch32(&workers[i].running, 1, 1) == 1);
 
@@ -424,24 +623,130 @@ void SyncAllJobs()
   for(Job *job : allocatedJobs)
     delete job;
   allocatedJobs.clear();
+
+  for(size_t i = 0; i < workers.size(); i++)
+  {
+    for(Job *job : workers[i].allocatedJobs)
+      delete job;
+    workers[i].allocatedJobs.clear();
+  }
 }
 
-Job *AddJob(std::function<void()> &&callback, const rdcarray<Job *> &parents)
+void Wait(Job *job)
+{
+  Wait(rdcarray<Job *>({job}));
+}
+
+void Wait(const rdcarray<Job *> &jobs)
+{
+  JobWorker *worker = GetCurrentWorker();
+
+  if(!worker)
+    RDCASSERTEQUAL(mainThread, Threading::GetCurrentID());
+
+  JobDeque &localQueue = worker ? worker->queue : mainQueue;
+  size_t idx = worker ? worker->idx : ~0U;
+
+  for(Job *job : jobs)
+  {
+    // help out running jobs until this one completes. We don't care if the job we run is related,
+    // since it's necessary work either way and the one we're waiting on may be stuck behind it.
+    while(Atomic::CmpExch32(&job->state, 0, 0) == 0)
+    {
+      if(!RunOneJob(localQueue, idx))
+        Threading::Sleep(0);
+    }
+  }
+}
+
+void WaitAndFree(const rdcarray<Job *> &jobs)
 {
   RDCASSERTEQUAL(mainThread, Threading::GetCurrentID());
 
+  Wait(jobs);
+
+  rdcarray<Job *> sorted = jobs;
+  std::sort(sorted.begin(), sorted.end());
+
+  for(Job *job : sorted)
+  {
+    // the thread that ran the job marks it complete while holding the lock, so once we can take the
+    // lock that thread is done with it
+    SCOPED_SPINLOCK(job->lock);
+  }
+
+  // compact the list of jobs that are still allocated
+  size_t numFreed = 0, numKept = 0;
+  for(size_t i = 0; i < allocatedJobs.size(); i++)
+  {
+    Job *job = allocatedJobs[i];
+
+    if(std::binary_search(sorted.begin(), sorted.end(), job))
+    {
+      delete job;
+      numFreed++;
+    }
+    else
+    {
+      allocatedJobs[numKept++] = job;
+    }
+  }
+  allocatedJobs.resize(numKept);
+
+  if(numFreed != sorted.size())
+    RDCERR("%zu jobs to free weren't added from the main thread", sorted.size() - numFreed);
+}
+
+Job *AddJob(std::function<void()> &&callback, const rdcarray<Job *> &parents)
+{
+  // jobs can be added from the main thread or from a job running on a worker
+  JobWorker *worker = GetCurrentWorker();
+
+  if(!worker)
+    RDCASSERTEQUAL(mainThread, Threading::GetCurrentID());
+
   Job *ret = new Job;
   ret->callback = std::move(callback);
-  ret->parents = parents;
 
-  allocatedJobs.push_back(ret);
+  if(worker)
+    worker->allocatedJobs.push_back(ret);
+  else
+    allocatedJobs.push_back(ret);
 
+  Atomic::Inc32(&pendingJobs);
+
+  // hold a reference while registering with parents, so that a parent completing while we're
+  // still iterating can't release the job early
+  ret->pendingParents = 1;
+
+  for(Job *p : parents)
   {
-    SCOPED_LOCK(queueLock);
-    jobQueue.insert(0, ret);
+    SCOPED_SPINLOCK(p->lock);
+
+    // check that parent state is valid, should either be finished or not
+    RDCASSERT(p->state == 0 || p->state == 1);
+
+    if(p->state == 0)
+    {
+      Atomic::Inc32(&ret->pendingParents);
+      p->children.push_back(ret);
+    }
   }
 
-  TryWakeFirstSleepingWorker();
+  // if all parents were already complete the job is ready to run now
+  if(Atomic::Dec32(&ret->pendingParents) == 0)
+  {
+    if(worker)
+    {
+      worker->queue.Push(ret);
+      TryWakeFirstSleepingWorker(worker->idx);
+    }
+    else
+    {
+      mainQueue.Push(ret);
+      TryWakeFirstSleepingWorker();
+    }
+  }
 
   return ret;
 }
@@ -22,7 +22,9 @@
  * THE SOFTWARE.
  ******************************************************************************/
 
+#include <memory>
 #include "threading.h"
+#include "timing.h"
 
 namespace Threading
 {
@@ -133,6 +135,114 @@ void RunJobTests()
     for(size_t c = 0; c < numChains; c++)
       CHECK(a[c] == b[c]);
   }
+
+  // waiting on a subset of jobs
+  {
+    int32_t flag = 0;
+    rdcarray<int> a;
+    rdcarray<Threading::JobSystem::Job *> group;
+
+    // a job that won't finish until we let it, which we don't wait on. Since waiting threads help
+    // run jobs it's possible for the main thread to pick this job up itself, so it also gives up
+    // after a while to avoid deadlocking in that case
+    Threading::JobSystem::Job *blocker = Threading::JobSystem::AddJob([&flag]() {
+      PerformanceTimer timer;
+      while(Atomic::CmpExch32(&flag, 0, 0) == 0 && timer.GetMilliseconds() < 2000.0)
+        Threading::Sleep(0);
+    });
+
+    for(int i = 0; i < 10; i++)
+      group.push_back(Threading::JobSystem::AddJob([&a, i]() { a.push_back(i); }, group));
+
+    Threading::JobSystem::Wait(group);
+
+    CHECK(a == rdcarray<int>({0, 1, 2, 3, 4, 5, 6, 7, 8, 9}));
+
+    Atomic::Inc32(&flag);
+
+    Threading::JobSystem::Wait(blocker);
+
+    Threading::JobSystem::SyncAllJobs();
+  }
+
+  // jobs launching jobs, and waiting on them
+  {
+    static const size_t numJobs = 50;
+    static const size_t numChildren = 20;
+    rdcarray<int> a[numJobs];
+    int32_t done[numJobs] = {};
+
+    for(size_t j = 0; j < numJobs; j++)
+    {
+      Threading::JobSystem::AddJob([&a, &done, j]() {
+        a[j].resize(numChildren);
+
+        rdcarray<Threading::JobSystem::Job *> children;
+        for(size_t c = 0; c < numChildren; c++)
+          children.push_back(Threading::JobSystem::AddJob([&a, j, c]() { a[j][c] = int(c); }));
+
+        Threading::JobSystem::Wait(children);
+
+        // all children must be complete
+        bool complete = true;
+        for(size_t c = 0; c < numChildren; c++)
+          complete &= (a[j][c] == int(c));
+
+        if(complete)
+          Atomic::Inc32(&done[j]);
+      });
+    }
+
+    Threading::JobSystem::SyncAllJobs();
+
+    for(size_t j = 0; j < numJobs; j++)
+      CHECK(done[j] == 1);
+  }
+
+  // freeing jobs early, while other jobs are still running
+  {
+    int32_t flag = 0;
+    Threading::JobSystem::Job *blocker = Threading::JobSystem::AddJob([&flag]() {
+      while(Atomic::CmpExch32(&flag, 0, 0) == 0)
+        Threading::Sleep(0);
+    });
+
+    // the callbacks are destroyed with their jobs, releasing their reference
+    std::shared_ptr<int> token = std::make_shared<int>(0);
+
+    rdcarray<Threading::JobSystem::Job *> group;
+    int32_t count = 0;
+    for(int i = 0; i < 20; i++)
+      group.push_back(Threading::JobSystem::AddJob([token, &count]() { Atomic::Inc32(&count); }));
+
+    Threading::JobSystem::WaitAndFree(group);
+
+    CHECK(count == 20);
+    CHECK(token.use_count() == 1);
+
+    Atomic::Inc32(&flag);
+
+    Threading::JobSystem::Wait(blocker);
+
+    Threading::JobSystem::SyncAllJobs();
+  }
+
+  // jobs launching jobs that depend on each other, without waiting
+  {
+    rdcarray<int> a;
+
+    Threading::JobSystem::AddJob([&a]() {
+      rdcarray<Threading::JobSystem::Job *> parents;
+      for(int i = 0; i < 100; i++)
+        parents = {Threading::JobSystem::AddJob([&a, i]() { a.push_back(i); }, parents)};
+    });
+
+    Threading::JobSystem::SyncAllJobs();
+
+    REQUIRE(a.size() == 100);
+    for(int i = 0; i < 100; i++)
+      CHECK(a[i] == i);
+  }
 }
 
 TEST_CASE("Check job system behaviour is correct with common thread counts", "[jobs]")
@@ -182,4 +292,75 @@ TEST_CASE("Stress test job system with many threads", "[jobs][stress]")
   Threading::JobSystem::Shutdown();
 }
 
+// not run by default, this is for measuring scaling of the job system rather than correctness
+TEST_CASE("Benchmark job system throughput across worker counts", "[.][jobs][benchmark]")
+{
+  Threading::randomSleepRange = 0;
+  Threading::randomSpinRange = 0;
+
+  static const size_t numJobs = 50000;
+  static const size_t numChains = 64;
+
+  uint32_t maxThreads = RDCMAX(1U, Threading::NumberOfCores());
+
+  // go up in powers of two, and always include the number of cores
+  rdcarray<uint32_t> threadCounts;
+  for(uint32_t numThreads = 1; numThreads < maxThreads; numThreads *= 2)
+    threadCounts.push_back(numThreads);
+  threadCounts.push_back(maxThreads);
+
+  rdcarray<uint32_t> counts;
+
+  for(uint32_t numThreads : threadCounts)
+  {
+    Threading::JobSystem::Init(numThreads);
+
+    counts.fill(numJobs, 0);
+
+    PerformanceTimer timer;
+
+    // independent small jobs
+    for(size_t j = 0; j < numJobs; j++)
+    {
+      Threading::JobSystem::AddJob([&counts, j]() {
+        uint32_t x = uint32_t(j);
+        for(int i = 0; i < 1000; i++)
+          x = x * 1664525U + 1013904223U;
+        counts[j] = x | 1;
+      });
+    }
+
+    Threading::JobSystem::SyncAllJobs();
+
+    double independentMS = timer.GetMilliseconds();
+
+    timer.Restart();
+
+    // many dependency chains, which exercise releasing children on completion
+    rdcarray<Threading::JobSystem::Job *> parents[numChains];
+    for(size_t j = 0; j < numJobs; j++)
+    {
+      size_t c = j % numChains;
+      parents[c] = {Threading::JobSystem::AddJob(
+          [&counts, j]() { counts[j] = counts[j] * 1664525U + 1013904223U; }, parents[c])};
+    }
+
+    Threading::JobSystem::SyncAllJobs();
+
+    double chainedMS = timer.GetMilliseconds();
+
+    Threading::JobSystem::Shutdown();
+
+    size_t zeroes = 0;
+    for(size_t j = 0; j < numJobs; j++)
+      zeroes += counts[j] == 0 ? 1 : 0;
+
+    CHECK(zeroes == 0);
+
+    RDCLOG("%u workers: %.0f independent jobs/s, %.0f chained jobs/s", numThreads,
+           double(numJobs) * 1000.0 / RDCMAX(independentMS, 0.001),
+           double(numJobs) * 1000.0 / RDCMAX(chainedMS, 0.001));
+  }
+}
+
 #endif    // ENABLED(ENABLE_UNIT_TESTS)
@@ -25,6 +25,7 @@
 #pragma once
 
 #include <map>
+#include <unordered_map>
 #include "common/common.h"
 #include "serialise/streamio.h"
 #include "serialise/zstdio.h"
@@ -138,3 +139,428 @@ void SaveShaderCache(const rdcstr &filename, uint32_t magicNumber, uint32_t vers
   RDCDEBUG("Successfully wrote %u entries to cache, compressed from %llu to %llu", numentries,
            uncompressedSize, fileWriter.GetOffset());
 }
+
+static const uint32_t ShaderCacheIndexedMagic = MAKE_FOURCC('R', 'D', '$', '2');
+static const uint32_t ShaderCacheSegmentMagic = MAKE_FOURCC('S', 'E', 'G', '$');
+
+// Version 2 of the shader cache, which doesn't need to read the whole file at startup.
+//
+// The file is a small header followed by any number of segments. Each segment starts with an
+// index of the entries it contains - 64-bit hash, file offset and sizes - followed by the
+// individually compressed entries. On load the file is memory mapped and only the segment indices
+// are read, an entry is decompressed and created the first time it's looked up. New entries are
+// appended as a new segment on save rather than rewriting the file, with a later entry for the
+// same hash replacing an earlier one. If too much of the file is superseded entries it's compacted
+// into a single segment, written to a temporary file and moved over the old one so that any other
+// process with the file mapped keeps the old contents.
+//
+// The methods that create or destroy results take the same callbacks as LoadShaderCache, and
+// Destroy() must be called before the cache is destroyed to free any created results.
+template <typename ResultType>
+class IndexedShaderCache
+{
+public:
+  IndexedShaderCache() = default;
+  IndexedShaderCache(const IndexedShaderCache &) = delete;
+  IndexedShaderCache &operator=(const IndexedShaderCache &) = delete;
+  ~IndexedShaderCache()
+  {
+    RDCASSERTMSG("Shader cache destroyed without calling Destroy()", m_Entries.empty());
+    Unmap();
+  }
+
+  // opens and indexes the cache file, returns false if there was no valid cache
+  bool Load(const rdcstr &filename, uint32_t magicNumber, uint32_t versionNumber)
+  {
+    m_Filename = FileIO::GetAppFolderFilename(filename);
+    m_Magic = magicNumber;
+    m_Version = versionNumber;
+
+    FILE *f = FileIO::fopen(m_Filename, FileIO::ReadBinary);
+    if(!f)
+      return false;
+
+    m_Mapping = FileIO::MapFileForRead(f, m_MappingSize);
+    FileIO::fclose(f);
+
+    if(!m_Mapping)
+      return false;
+
+    if(m_MappingSize < sizeof(FileHeader))
+    {
+      Unmap();
+      return false;
+    }
+
+    FileHeader header;
+    memcpy(&header, m_Mapping, sizeof(header));
+
+    if(header.magic != ShaderCacheIndexedMagic || header.localMagic != m_Magic ||
+       header.version != m_Version)
+    {
+      Unmap();
+      return false;
+    }
+
+    uint64_t offs = sizeof(FileHeader);
+    while(offs + sizeof(SegmentHeader) <= m_MappingSize)
+    {
+      SegmentHeader seg;
+      memcpy(&seg, m_Mapping + offs, sizeof(seg));
+
+      const uint64_t indexSize = uint64_t(seg.numEntries) * sizeof(IndexEntry);
+
+      // a segment that's truncated or corrupt ends the file. Anything after it is discarded on the
+      // next save
+      if(seg.magic != ShaderCacheSegmentMagic || seg.size < sizeof(SegmentHeader) + indexSize ||
+         seg.size > m_MappingSize - offs)
+        break;
+
+      bool valid = true;
+      for(uint32_t i = 0; i < seg.numEntries; i++)
+      {
+        IndexEntry idx;
+        memcpy(&idx, m_Mapping + offs + sizeof(SegmentHeader) + i * sizeof(IndexEntry),
+               sizeof(idx));
+
+        if(idx.offset < offs + sizeof(SegmentHeader) + indexSize || idx.offset > offs + seg.size ||
+           idx.compressedSize > offs + seg.size - idx.offset || idx.size > MaxEntrySize)
+        {
+          valid = false;
+          break;
+        }
+
+        Entry &e = m_Entries[idx.hash];
+        if(e.onDisk)
+          m_DeadBytes += e.compressedSize;
+        e.onDisk = true;
+        e.offset = idx.offset;
+        e.compressedSize = idx.compressedSize;
+        e.size = idx.size;
+      }
+
+      if(!valid)
+        break;
+
+      offs += seg.size;
+    }
+
+    m_ValidSize = offs;
+
+    RDCDEBUG("Indexed %zu entries in shader cache, %llu bytes", m_Entries.size(), m_ValidSize);
+
+    return true;
+  }
+
+  // returns true and the result if the cache contains this hash, creating the result on first use
+  template <typename ShaderCallbacks>
+  bool Find(uint64_t hash, ResultType &result, const ShaderCallbacks &callbacks)
+  {
+    auto it = m_Entries.find(hash);
+    if(it == m_Entries.end())
+      return false;
+
+    Entry &e = it->second;
+
+    if(!e.created)
+    {
+      // the size was bounded when indexing, but don't trust it further than the compressed data
+      if(ZSTD_getFrameContentSize(m_Mapping + e.offset, e.compressedSize) != e.size)
+      {
+        RDCERR("Shadercache entry of size %u is corrupt", e.size);
+        m_DeadBytes += e.compressedSize;
+        m_Entries.erase(it);
+        return false;
+      }
+
+      bytebuf data;
+      data.resize(e.size);
+
+      size_t size =
+          ZSTD_decompress(data.data(), data.size(), m_Mapping + e.offset, e.compressedSize);
+
+      if(ZSTD_isError(size) || size != e.size || !callbacks.Create(e.size, data.data(), &e.result))
+      {
+        RDCERR("Couldn't create blob of size %u from shadercache", e.size);
+        m_DeadBytes += e.compressedSize;
+        m_Entries.erase(it);
+        return false;
+      }
+
+      e.created = true;
+    }
+
+    result = e.result;
+    return true;
+  }
+
+  // adds or replaces an entry. The cache takes ownership of the result. A replaced result is kept
+  // alive until Destroy() as it may still be referenced
+  void Insert(uint64_t hash, ResultType result)
+  {
+    Entry &e = m_Entries[hash];
+
+    if(e.created)
+      m_Replaced.push_back(e.result);
+
+    if(e.onDisk)
+      m_DeadBytes += e.compressedSize;
+
+    e.onDisk = false;
+    e.created = true;
+    e.result = result;
+
+    m_Dirty = true;
+  }
+
+  bool IsDirty() const { return m_Dirty; }
+  // writes any new entries to disk. The mapping is released so this must be the last use of the
+  // cache before Destroy()
+  template <typename ShaderCallbacks>
+  void Save(const ShaderCallbacks &callbacks)
+  {
+    if(!m_Dirty)
+      return;
+
+    uint64_t liveBytes = 0;
+    rdcarray<uint64_t> pending;
+    for(auto it = m_Entries.begin(); it != m_Entries.end(); ++it)
+    {
+      if(it->second.onDisk)
+        liveBytes += it->second.compressedSize;
+      else
+        pending.push_back(it->first);
+    }
+
+    // append if the file is intact and not mostly dead entries, otherwise write a fresh file with
+    // only the live entries
+    bool append = m_Mapping && m_ValidSize == m_MappingSize &&
+                  m_DeadBytes < RDCMAX(liveBytes, uint64_t(1024 * 1024));
+
+    if(append)
+    {
+      bytebuf segment;
+      WriteSegment(segment, 0, pending, callbacks);
+
+      Unmap();
+
+      FILE *f = FileIO::fopen(m_Filename, FileIO::UpdateBinary);
+      if(!f)
+      {
+        RDCERR("Error opening shader cache for append");
+        return;
+      }
+
+      FileIO::fseek64(f, 0, SEEK_END);
+      uint64_t base = FileIO::ftell64(f);
+
+      // offsets in the index are absolute, so rebase them on the real end of the file in case
+      // another process appended in the meantime
+      RebaseSegment(segment, base);
+
+      FileIO::fwrite(segment.data(), 1, segment.size(), f);
+      FileIO::fclose(f);
+
+      RDCDEBUG("Appended %zu entries to shader cache, %zu bytes", pending.size(), segment.size());
+    }
+    else
+    {
+      rdcarray<uint64_t> all;
+      for(auto it = m_Entries.begin(); it != m_Entries.end(); ++it)
+        all.push_back(it->first);
+
+      FileHeader header;
+      header.magic = ShaderCacheIndexedMagic;
+      header.localMagic = m_Magic;
+      header.version = m_Version;
+
+      bytebuf contents;
+      contents.append((const byte *)&header, sizeof(header));
+      WriteSegment(contents, sizeof(header), all, callbacks);
+
+      Unmap();
+
+      rdcstr tmpFilename = m_Filename + ".tmp";
+      FILE *f = FileIO::fopen(tmpFilename, FileIO::WriteBinary);
+      if(!f)
+      {
+        RDCERR("Error opening shader cache for write");
+        return;
+      }
+
+      FileIO::fwrite(contents.data(), 1, contents.size(), f);
+      FileIO::fclose(f);
+
+      if(!FileIO::Move(tmpFilename, m_Filename, true))
+      {
+        RDCERR("Couldn't replace shader cache");
+        FileIO::Delete(tmpFilename);
+        return;
+      }
+
+      RDCDEBUG("Wrote %zu entries to shader cache, %zu bytes", all.size(), contents.size());
+    }
+
+    m_Dirty = false;
+  }
+
+  // destroys all created results
+  template <typename ShaderCallbacks>
+  void Destroy(const ShaderCallbacks &callbacks)
+  {
+    for(auto it = m_Entries.begin(); it != m_Entries.end(); ++it)
+      if(it->second.created)
+        callbacks.Destroy(it->second.result);
+    for(ResultType &r : m_Replaced)
+      callbacks.Destroy(r);
+
+    m_Entries.clear();
+    m_Replaced.clear();
+    Unmap();
+  }
+
+private:
+  struct FileHeader
+  {
+    uint32_t magic;
+    uint32_t localMagic;
+    uint32_t version;
+    uint32_t padding = 0;
+  };
+
+  struct SegmentHeader
+  {
+    uint32_t magic;
+    uint32_t numEntries;
+    // including this header and the index
+    uint64_t size;
+  };
+
+  // no shader blob comes close to this, anything larger in the index is corrupt
+  static const uint32_t MaxEntrySize = 256 * 1024 * 1024;
+
+  struct IndexEntry
+  {
+    uint64_t hash;
+    // from the start of the file
+    uint64_t offset;
+    uint32_t compressedSize;
+    uint32_t size;
+  };
+
+  struct Entry
+  {
+    // location in the file, if it's been saved
+    bool onDisk = false;
+    uint64_t offset = 0;
+    uint32_t compressedSize = 0;
+    uint32_t size = 0;
+
+    bool created = false;
+    ResultType result = ResultType();
+  };
+
+  // appends a segment with the given entries to out, with offsets relative to base which is where
+  // the segment will be in the file. Entries that haven't been created are copied still compressed
+  template <typename ShaderCallbacks>
+  void WriteSegment(bytebuf &out, uint64_t base, const rdcarray<uint64_t> &hashes,
+                    const ShaderCallbacks &callbacks)
+  {
+    rdcarray<IndexEntry> index;
+    index.reserve(hashes.size());
+
+    bytebuf data;
+
+    for(uint64_t hash : hashes)
+    {
+      const Entry &e = m_Entries[hash];
+
+      IndexEntry idx;
+      idx.hash = hash;
+      // relative to the data for now
+      idx.offset = data.size();
+
+      if(e.onDisk && !e.created)
+      {
+        data.append(m_Mapping + e.offset, e.compressedSize);
+        idx.compressedSize = e.compressedSize;
+        idx.size = e.size;
+      }
+      else
+      {
+        const uint32_t size = callbacks.GetSize(e.result);
+        const size_t bound = ZSTD_compressBound(size);
+
+        data.resize(idx.offset + bound);
+
+        size_t compSize =
+            ZSTD_compress(data.data() + idx.offset, bound, callbacks.GetData(e.result), size, 7);
+
+        if(ZSTD_isError(compSize))
+        {
+          RDCERR("Failed to compress shader cache entry: %s", ZSTD_getErrorName(compSize));
+          data.resize((size_t)idx.offset);
+          continue;
+        }
+
+        data.resize(idx.offset + compSize);
+        idx.compressedSize = (uint32_t)compSize;
+        idx.size = size;
+      }
+
+      index.push_back(idx);
+    }
+
+    SegmentHeader seg;
+    seg.magic = ShaderCacheSegmentMagic;
+    seg.numEntries = (uint32_t)index.size();
+    seg.size = sizeof(seg) + index.byteSize() + data.size();
+
+    const uint64_t dataBase = base + sizeof(seg) + index.byteSize();
+    for(IndexEntry &idx : index)
+      idx.offset += dataBase;
+
+    out.append((const byte *)&seg, sizeof(seg));
+    out.append((const byte *)index.data(), index.byteSize());
+    out.append(data);
+  }
+
+  // adds base to all offsets in a segment written with a base of 0
+  static void RebaseSegment(bytebuf &segment, uint64_t base)
+  {
+    SegmentHeader seg;
+    memcpy(&seg, segment.data(), sizeof(seg));
+
+    for(uint32_t i = 0; i < seg.numEntries; i++)
+    {
+      byte *ptr = segment.data() + sizeof(seg) + i * sizeof(IndexEntry);
+
+      IndexEntry idx;
+      memcpy(&idx, ptr, sizeof(idx));
+      idx.offset += base;
+      memcpy(ptr, &idx, sizeof(idx));
+    }
+  }
+
+  void Unmap()
+  {
+    FileIO::UnmapFile(m_Mapping, m_MappingSize);
+    m_Mapping = NULL;
+    m_MappingSize = 0;
+  }
+
+  rdcstr m_Filename;
+  uint32_t m_Magic = 0, m_Version = 0;
+
+  const byte *m_Mapping = NULL;
+  uint64_t m_MappingSize = 0;
+  // how much of the file is valid, if it's less than the file size the file must be rewritten
+  uint64_t m_ValidSize = 0;
+  // compressed bytes in the file that have been superseded
+  uint64_t m_DeadBytes = 0;
+
+  bool m_Dirty = false;
+
+  std::unordered_map<uint64_t, Entry> m_Entries;
+  rdcarray<ResultType> m_Replaced;
+};
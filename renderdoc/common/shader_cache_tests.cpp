@@ -0,0 +1,281 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "common/globalconfig.h"
+
+#if ENABLED(ENABLE_UNIT_TESTS)
+
+#include "shader_cache.h"
+#include "os/os_specific.h"
+
+#include "catch/catch.hpp"
+
+struct TestBlobCallbacks
+{
+  bool Create(uint32_t size, byte *data, bytebuf **ret) const
+  {
+    *ret = new bytebuf(data, size);
+    created++;
+    return true;
+  }
+
+  void Destroy(bytebuf *blob) const
+  {
+    delete blob;
+    destroyed++;
+  }
+  uint32_t GetSize(bytebuf *blob) const { return (uint32_t)blob->size(); }
+  const byte *GetData(bytebuf *blob) const { return blob->data(); }
+  mutable int created = 0, destroyed = 0;
+};
+
+static bytebuf *MakeBlob(uint64_t hash, uint32_t size)
+{
+  bytebuf *ret = new bytebuf;
+  ret->resize(size);
+  for(uint32_t i = 0; i < size; i++)
+    ret->data()[i] = byte((hash * 31 + i / 7) & 0xff);
+  return ret;
+}
+
+static bool CheckBlob(bytebuf *blob, uint64_t hash, uint32_t size)
+{
+  bytebuf *expected = MakeBlob(hash, size);
+  bool ret = blob && *blob == *expected;
+  delete expected;
+  return ret;
+}
+
+TEST_CASE("Test indexed shader cache", "[shadercache]")
+{
+  const rdcstr cacheName = "shader_cache_test.cache";
+  const rdcstr filename = FileIO::GetAppFolderFilename(cacheName);
+  const uint32_t magic = 0x12345678;
+
+  FileIO::Delete(filename);
+
+  TestBlobCallbacks callbacks;
+
+  {
+    IndexedShaderCache<bytebuf *> cache;
+    CHECK_FALSE(cache.Load(cacheName, magic, 1));
+
+    for(uint64_t hash = 0; hash < 100; hash++)
+      cache.Insert(hash, MakeBlob(hash, uint32_t(100 + hash * 10)));
+
+    // large hashes are preserved
+    cache.Insert(0xfedcba9876543210ULL, MakeBlob(5, 5000));
+
+    CHECK(cache.IsDirty());
+    cache.Save(callbacks);
+    cache.Destroy(callbacks);
+  }
+
+  CHECK(callbacks.destroyed == 101);
+
+  SECTION("Entries are only created when looked up")
+  {
+    IndexedShaderCache<bytebuf *> cache;
+    REQUIRE(cache.Load(cacheName, magic, 1));
+    CHECK_FALSE(cache.IsDirty());
+    CHECK(callbacks.created == 0);
+
+    bytebuf *blob = NULL;
+    CHECK(cache.Find(50, blob, callbacks));
+    CHECK(CheckBlob(blob, 50, 600));
+    CHECK(callbacks.created == 1);
+
+    // the second lookup returns the same result
+    bytebuf *blob2 = NULL;
+    CHECK(cache.Find(50, blob2, callbacks));
+    CHECK(blob == blob2);
+    CHECK(callbacks.created == 1);
+
+    CHECK(cache.Find(0xfedcba9876543210ULL, blob, callbacks));
+    CHECK(CheckBlob(blob, 5, 5000));
+
+    CHECK_FALSE(cache.Find(1000, blob, callbacks));
+    CHECK(callbacks.created == 2);
+
+    cache.Destroy(callbacks);
+    CHECK(callbacks.destroyed == 103);
+  };
+
+  SECTION("Different magic or version is rejected")
+  {
+    IndexedShaderCache<bytebuf *> cache;
+    CHECK_FALSE(cache.Load(cacheName, magic + 1, 1));
+    CHECK_FALSE(cache.Load(cacheName, magic, 2));
+    cache.Destroy(callbacks);
+  };
+
+  SECTION("New entries are appended")
+  {
+    const uint64_t originalSize = FileIO::GetFileSize(filename);
+
+    {
+      IndexedShaderCache<bytebuf *> cache;
+      REQUIRE(cache.Load(cacheName, magic, 1));
+
+      cache.Insert(1000, MakeBlob(1000, 400));
+      // replacing an existing entry
+      cache.Insert(10, MakeBlob(11, 300));
+
+      cache.Save(callbacks);
+      cache.Destroy(callbacks);
+    }
+
+    // no entries were created or re-compressed from the old file
+    CHECK(callbacks.created == 0);
+    CHECK(FileIO::GetFileSize(filename) > originalSize);
+
+    IndexedShaderCache<bytebuf *> cache;
+    REQUIRE(cache.Load(cacheName, magic, 1));
+
+    bytebuf *blob = NULL;
+    CHECK(cache.Find(1000, blob, callbacks));
+    CHECK(CheckBlob(blob, 1000, 400));
+    CHECK(cache.Find(10, blob, callbacks));
+    CHECK(CheckBlob(blob, 11, 300));
+
+    for(uint64_t hash = 0; hash < 100; hash++)
+    {
+      if(hash == 10)
+        continue;
+
+      CHECK(cache.Find(hash, blob, callbacks));
+      CHECK(CheckBlob(blob, hash, uint32_t(100 + hash * 10)));
+    }
+
+    cache.Destroy(callbacks);
+  };
+
+  SECTION("A truncated file is rewritten")
+  {
+    {
+      IndexedShaderCache<bytebuf *> cache;
+      REQUIRE(cache.Load(cacheName, magic, 1));
+      cache.Insert(2000, MakeBlob(2000, 400));
+      cache.Save(callbacks);
+      cache.Destroy(callbacks);
+    }
+
+    // chop off part of the last segment
+    const uint64_t size = FileIO::GetFileSize(filename);
+    FILE *f = FileIO::fopen(filename, FileIO::ReadBinary);
+    REQUIRE(f);
+    bytebuf contents;
+    contents.resize((size_t)size - 10);
+    FileIO::fread(contents.data(), 1, contents.size(), f);
+    FileIO::fclose(f);
+
+    f = FileIO::fopen(filename, FileIO::WriteBinary);
+    REQUIRE(f);
+    FileIO::fwrite(contents.data(), 1, contents.size(), f);
+    FileIO::fclose(f);
+
+    {
+      IndexedShaderCache<bytebuf *> cache;
+      REQUIRE(cache.Load(cacheName, magic, 1));
+
+      bytebuf *blob = NULL;
+      CHECK_FALSE(cache.Find(2000, blob, callbacks));
+      CHECK(cache.Find(20, blob, callbacks));
+      CHECK(CheckBlob(blob, 20, 300));
+
+      cache.Insert(3000, MakeBlob(3000, 400));
+      cache.Save(callbacks);
+      cache.Destroy(callbacks);
+    }
+
+    IndexedShaderCache<bytebuf *> cache;
+    REQUIRE(cache.Load(cacheName, magic, 1));
+
+    bytebuf *blob = NULL;
+    CHECK(cache.Find(3000, blob, callbacks));
+    CHECK(CheckBlob(blob, 3000, 400));
+    for(uint64_t hash = 0; hash < 100; hash++)
+    {
+      CHECK(cache.Find(hash, blob, callbacks));
+      CHECK(CheckBlob(blob, hash, uint32_t(100 + hash * 10)));
+    }
+
+    cache.Destroy(callbacks);
+  };
+
+  SECTION("Corrupt index entries are rejected")
+  {
+    bytebuf original;
+    REQUIRE(FileIO::ReadAll(filename, original));
+
+    // the file and segment headers are 16 bytes each, followed by the first segment's index
+    struct IndexEntry
+    {
+      uint64_t hash;
+      uint64_t offset;
+      uint32_t compressedSize;
+      uint32_t size;
+    };
+
+    const uint32_t numEntries = *(const uint32_t *)(original.data() + 20);
+    REQUIRE(numEntries == 101);
+
+    for(int corruption = 0; corruption < 3; corruption++)
+    {
+      bytebuf contents = original;
+      IndexEntry *index = (IndexEntry *)(contents.data() + 32);
+
+      for(uint32_t i = 0; i < numEntries; i++)
+      {
+        if(index[i].hash != 30)
+          continue;
+
+        // an offset that would wrap around when the compressed size is added
+        if(corruption == 0)
+          index[i].offset = ~0ULL - 4;
+        // a huge uncompressed size that must not be allocated
+        else if(corruption == 1)
+          index[i].size = ~0U;
+        // a size that disagrees with the compressed data
+        else
+          index[i].size++;
+      }
+
+      REQUIRE(FileIO::WriteAll(filename, contents));
+
+      IndexedShaderCache<bytebuf *> cache;
+      REQUIRE(cache.Load(cacheName, magic, 1));
+
+      bytebuf *blob = NULL;
+      CHECK_FALSE(cache.Find(30, blob, callbacks));
+      cache.Destroy(callbacks);
+    }
+
+    CHECK(callbacks.created == 0);
+  };
+
+  FileIO::Delete(filename);
+};
+
+#endif    // ENABLED(ENABLE_UNIT_TESTS)
@@ -116,7 +116,17 @@ namespace JobSystem
 struct Job;
 void Init(uint32_t numThreads = 0);
 void Shutdown();
+// can be called from the main thread or from inside a job
 Job *AddJob(std::function<void()> &&cb, const rdcarray<Job *> &parents = {});
+// wait for only the given jobs to complete, running other jobs in the meantime. Can be called from
+// the main thread or from inside a job, but must not wait on a job that depends on the caller
+void Wait(Job *job);
+void Wait(const rdcarray<Job *> &jobs);
+// as Wait(), then free the jobs straight away instead of at the next SyncAllJobs(). Only called
+// from the main thread for jobs it added itself, and the handles must not be used afterwards
+void WaitAndFree(const rdcarray<Job *> &jobs);
+// wait for all jobs to complete and free them. Only called from the main thread, and invalidates
+// all job handles
 void SyncAllJobs();
 uint32_t GetCountWorkers();
 };
@@ -49,6 +49,346 @@
 
 extern "C" const rdcstr VulkanLayerJSONBasename = STRINGIZE(RDOC_BASE_NAME);
 
+// writes capture sections on a background thread. Data written to a section is copied into blocks
+// which are queued in order along with the commands to begin and end each section, and to finish
+// each capture file. The total size of queued blocks is bounded, and writers block when it is full
+// until the background thread catches up.
+class AsyncCaptureWriter
+{
+public:
+  AsyncCaptureWriter(uint64_t memoryBudget)
+  {
+    m_MemoryBudget = RDCMAX(memoryBudget, BlockSize * 2);
+    m_WorkSemaphore = Threading::Semaphore::Create();
+    m_SpaceSemaphore = Threading::Semaphore::Create();
+    m_Thread = Threading::CreateThread([this]() { ThreadEntry(); });
+  }
+
+  ~AsyncCaptureWriter()
+  {
+    Drain();
+
+    Command cmd;
+    cmd.type = Command::Kill;
+    Push(std::move(cmd));
+
+    Threading::JoinThread(m_Thread);
+    Threading::CloseThread(m_Thread);
+
+    m_WorkSemaphore->Destroy();
+    m_SpaceSemaphore->Destroy();
+  }
+
+  StreamWriter *WriteSection(RDCFile *rdc, const rdcstr &path, const SectionProperties &props);
+  void FinishFile(RDCFile *rdc, std::function<void()> &&finish);
+
+  // returns true if this file is still being written, including any file at the given path
+  bool IsWriting(RDCFile *rdc);
+  bool IsWriting(const rdcstr &path);
+
+  // wait until everything queued so far has been written
+  void Drain()
+  {
+    while(Atomic::CmpExch32(&m_Outstanding, 0, 0) != 0)
+      Threading::Sleep(1);
+  }
+
+private:
+  class SectionForwarder;
+  friend class SectionForwarder;
+
+  static const uint64_t BlockSize = 4 * 1024 * 1024;
+
+  // the state of one section, only accessed by the background thread after creation
+  struct Section
+  {
+    RDCFile *rdc;
+    SectionProperties props;
+    StreamWriter *writer = NULL;
+  };
+
+  struct Command
+  {
+    enum
+    {
+      BeginSection,
+      Data,
+      EndSection,
+      FinishFile,
+      Kill,
+    } type;
+
+    Section *section = NULL;
+    byte *data = NULL;
+    uint64_t size = 0;
+    std::function<void()> finish;
+  };
+
+  void Push(Command &&cmd);
+  void ThreadEntry();
+
+  uint64_t m_MemoryBudget;
+
+  Threading::ThreadHandle m_Thread = 0;
+  // woken once for every command pushed
+  Threading::Semaphore *m_WorkSemaphore = NULL;
+  // woken when blocks are written while writers are waiting for space
+  Threading::Semaphore *m_SpaceSemaphore = NULL;
+
+  // count of commands pushed but not yet processed
+  int32_t m_Outstanding = 0;
+
+  // the lock protects everything below
+  Threading::CriticalSection m_Lock;
+  rdcarray<Command> m_Queue;
+  uint64_t m_QueuedBytes = 0;
+  uint32_t m_WaitingForSpace = 0;
+  // files with commands in the queue, and the paths they're being written to
+  rdcarray<rdcpair<RDCFile *, rdcstr>> m_Files;
+};
+
+// the writer side of a section - buffers data into blocks and pushes them to the background thread.
+// The StreamWriter owns this, so when it's deleted the section is ended.
+class AsyncCaptureWriter::SectionForwarder : public Compressor
+{
+public:
+  SectionForwarder(AsyncCaptureWriter *writer, Section *section)
+      : Compressor(NULL, Ownership::Nothing), m_Writer(writer), m_Section(section)
+  {
+  }
+
+  ~SectionForwarder()
+  {
+    Finish();
+
+    Command cmd;
+    cmd.type = Command::EndSection;
+    cmd.section = m_Section;
+    m_Writer->Push(std::move(cmd));
+  }
+
+  bool Write(const void *data, uint64_t numBytes)
+  {
+    const byte *src = (const byte *)data;
+
+    while(numBytes > 0)
+    {
+      if(m_Block == NULL)
+      {
+        m_Block = AllocAlignedBuffer(BlockSize);
+        m_BlockUsed = 0;
+      }
+
+      uint64_t chunk = RDCMIN(numBytes, BlockSize - m_BlockUsed);
+      memcpy(m_Block + m_BlockUsed, src, (size_t)chunk);
+      m_BlockUsed += chunk;
+      src += chunk;
+      numBytes -= chunk;
+
+      if(m_BlockUsed == BlockSize)
+        PushBlock();
+    }
+
+    return true;
+  }
+
+  bool Finish()
+  {
+    if(m_Block)
+      PushBlock();
+    return true;
+  }
+
+private:
+  void PushBlock()
+  {
+    Command cmd;
+    cmd.type = Command::Data;
+    cmd.section = m_Section;
+    cmd.data = m_Block;
+    cmd.size = m_BlockUsed;
+    m_Writer->Push(std::move(cmd));
+
+    m_Block = NULL;
+    m_BlockUsed = 0;
+  }
+
+  AsyncCaptureWriter *m_Writer;
+  Section *m_Section;
+
+  byte *m_Block = NULL;
+  uint64_t m_BlockUsed = 0;
+};
+
+StreamWriter *AsyncCaptureWriter::WriteSection(RDCFile *rdc, const rdcstr &path,
+                                               const SectionProperties &props)
+{
+  {
+    SCOPED_LOCK(m_Lock);
+    bool found = false;
+    for(const rdcpair<RDCFile *, rdcstr> &f : m_Files)
+      found |= (f.first == rdc);
+    if(!found)
+      m_Files.push_back({rdc, path});
+  }
+
+  Section *section = new Section;
+  section->rdc = rdc;
+  section->props = props;
+
+  Command cmd;
+  cmd.type = Command::BeginSection;
+  cmd.section = section;
+  Push(std::move(cmd));
+
+  return new StreamWriter(new SectionForwarder(this, section), Ownership::Stream);
+}
+
+void AsyncCaptureWriter::FinishFile(RDCFile *rdc, std::function<void()> &&finish)
+{
+  Command cmd;
+  cmd.type = Command::FinishFile;
+  cmd.section = new Section;
+  cmd.section->rdc = rdc;
+  cmd.finish = std::move(finish);
+  Push(std::move(cmd));
+}
+
+bool AsyncCaptureWriter::IsWriting(RDCFile *rdc)
+{
+  SCOPED_LOCK(m_Lock);
+  for(const rdcpair<RDCFile *, rdcstr> &f : m_Files)
+    if(f.first == rdc)
+      return true;
+  return false;
+}
+
+bool AsyncCaptureWriter::IsWriting(const rdcstr &path)
+{
+  SCOPED_LOCK(m_Lock);
+  for(const rdcpair<RDCFile *, rdcstr> &f : m_Files)
+    if(f.second == path)
+      return true;
+  return false;
+}
+
+void AsyncCaptureWriter::Push(Command &&cmd)
+{
+  Atomic::Inc32(&m_Outstanding);
+
+  for(;;)
+  {
+    {
+      SCOPED_LOCK(m_Lock);
+
+      // always let a block in if nothing else is queued, so a budget smaller than one block can't
+      // deadlock
+      if(cmd.size == 0 || m_QueuedBytes == 0 || m_QueuedBytes + cmd.size <= m_MemoryBudget)
+      {
+        m_QueuedBytes += cmd.size;
+        m_Queue.push_back(std::move(cmd));
+        break;
+      }
+
+      m_WaitingForSpace++;
+    }
+
+    m_SpaceSemaphore->WaitForWake();
+  }
+
+  m_WorkSemaphore->Wake(1);
+}
+
+void AsyncCaptureWriter::ThreadEntry()
+{
+  Threading::SetCurrentThreadName("Capture writer");
+
+  for(;;)
+  {
+    m_WorkSemaphore->WaitForWake();
+
+    Command cmd;
+    {
+      SCOPED_LOCK(m_Lock);
+      cmd = std::move(m_Queue[0]);
+      m_Queue.erase(0);
+    }
+
+    Section *section = cmd.section;
+
+    switch(cmd.type)
+    {
+      case Command::BeginSection:
+        section->writer = section->rdc->WriteSection(section->props);
+        break;
+      case Command::Data:
+        section->writer->Write(cmd.data, cmd.size);
+        FreeAlignedBuffer(cmd.data);
+        break;
+      case Command::EndSection:
+        section->writer->Finish();
+        if(section->writer->IsErrored())
+          RDCERR("Error writing capture section in background: %s",
+                 ResultDetails(section->writer->GetError()).Message().c_str());
+        delete section->writer;
+        delete section;
+        break;
+      case Command::FinishFile:
+      {
+        // finish() deletes the RDCFile, so forget the pointer first in case a new file is allocated
+        // at the same address. The path stays listed as being written until finish() is done.
+        rdcstr path;
+        {
+          SCOPED_LOCK(m_Lock);
+          for(rdcpair<RDCFile *, rdcstr> &f : m_Files)
+          {
+            if(f.first == section->rdc)
+            {
+              f.first = NULL;
+              path = f.second;
+              break;
+            }
+          }
+        }
+
+        cmd.finish();
+
+        {
+          SCOPED_LOCK(m_Lock);
+          for(size_t i = 0; i < m_Files.size(); i++)
+          {
+            if(m_Files[i].first == NULL && m_Files[i].second == path)
+            {
+              m_Files.erase(i);
+              break;
+            }
+          }
+        }
+        delete section;
+        break;
+      }
+      case Command::Kill: break;
+    }
+
+    if(cmd.size > 0)
+    {
+      SCOPED_LOCK(m_Lock);
+      m_QueuedBytes -= cmd.size;
+      // wake every waiting writer to re-check, any that still don't fit will wait again
+      if(m_WaitingForSpace > 0)
+      {
+        m_SpaceSemaphore->Wake(m_WaitingForSpace);
+        m_WaitingForSpace = 0;
+      }
+    }
+
+    Atomic::Dec32(&m_Outstanding);
+
+    if(cmd.type == Command::Kill)
+      return;
+  }
+}
+
 RDOC_DEBUG_CONFIG(bool, Capture_Debug_SnapshotDiagnosticLog, false,
                   "Snapshot the diagnostic log at capture time and embed in the capture.");
 
@@ -57,6 +397,15 @@ RDOC_CONFIG(bool, Capture_IncludeExtendedThumbnail, false,
 
 RDOC_CONFIG(bool, Replay_Debug_PrintChunkTimings, false, "Print stats of chunk processing times");
 
+RDOC_CONFIG(bool, Capture_AsyncWriting, false,
+            "Compress and write captures to disk on a background thread, so the captured frame "
+            "returns to the application as soon as its data has been buffered. Captures only "
+            "appear in the list of captures once they have been completely written.");
+
+RDOC_CONFIG(uint32_t, Capture_AsyncWritingMemoryMB, 256,
+            "The maximum amount of memory in MB to buffer for captures being written in the "
+            "background. When this is full, capturing waits for the buffered data to be written.");
+
 RDOC_CONFIG(bool, Replay_Debug_SingleThreadedCompilation, false,
             "Compile all shaders and PSOs single-threaded.");
 
@@ -555,6 +904,11 @@ RenderDoc::~RenderDoc()
     (*it)();
   m_ShutdownFunctions.clear();
 
+  // let any captures still being written finish. Like the remote thread below we can't safely join
+  // the writer thread while modules are unloading, so once it's idle it's left behind.
+  if(m_AsyncCaptureWriter)
+    m_AsyncCaptureWriter->Drain();
+
   for(size_t i = 0; i < m_Captures.size(); i++)
   {
     if(m_Captures[i].retrieved)
@@ -600,6 +954,15 @@ void RenderDoc::RemoveHooks()
     UnloadCrashHandler();
   }
 
+  // wait for any captures being written. This can't be done while holding the lock since the writer
+  // thread takes it to register finished captures.
+  AsyncCaptureWriter *asyncWriter = NULL;
+  {
+    SCOPED_LOCK(m_CaptureLock);
+    std::swap(asyncWriter, m_AsyncCaptureWriter);
+  }
+  SAFE_DELETE(asyncWriter);
+
   if(m_RemoteThread)
   {
     // explicitly wait for thread to shutdown, this call is not from module unloading and
@@ -1494,17 +1857,19 @@ RDCFile *RenderDoc::CreateRDC(RDCDriver driver, uint32_t frameNum, const FramePi
   if(frameNum == ~0U)
     suffix = "_capture";
 
-  m_CurrentLogFile = StringFormat::Fmt("%s%s.rdc", m_CaptureFileTemplate.c_str(), suffix.c_str());
+  rdcstr filename =
+      StringFormat::Fmt("%s%s.rdc", m_CaptureFileTemplate.c_str(), suffix.c_str());
 
   // make sure we don't stomp another capture if we make multiple captures in the same frame.
   {
     SCOPED_LOCK(m_CaptureLock);
     int altnum = 2;
-    while(std::find_if(m_Captures.begin(), m_Captures.end(), [this](const CaptureData &o) {
-            return o.path == m_CurrentLogFile;
-          }) != m_Captures.end())
+    while(std::find_if(m_Captures.begin(), m_Captures.end(), [&filename](const CaptureData &o) {
+            return o.path == filename;
+          }) != m_Captures.end() ||
+          (m_AsyncCaptureWriter && m_AsyncCaptureWriter->IsWriting(filename)))
     {
-      m_CurrentLogFile =
+      filename =
           StringFormat::Fmt("%s%s_%d.rdc", m_CaptureFileTemplate.c_str(), suffix.c_str(), altnum);
       altnum++;
     }
@@ -1527,9 +1892,9 @@ RDCFile *RenderDoc::CreateRDC(RDCDriver driver, uint32_t frameNum, const FramePi
   ret->SetData(driver, ToStr(driver).c_str(), OSUtility::GetMachineIdent(), &outThumb, m_TimeBase,
                m_TimeFrequency);
 
-  FileIO::CreateParentDirectory(m_CurrentLogFile);
+  FileIO::CreateParentDirectory(filename);
 
-  ret->Create(m_CurrentLogFile.c_str());
+  ret->Create(filename.c_str());
 
   if(ret->Error() != ResultCode::Succeeded)
     SAFE_DELETE(ret);
@@ -1968,27 +2333,102 @@ void RenderDoc::SetCaptureFileTemplate(const rdcstr &pathtemplate)
   FileIO::CreateParentDirectory(m_CaptureFileTemplate);
 }
 
+StreamWriter *RenderDoc::WriteCaptureSection(RDCFile *rdc, const SectionProperties &props)
+{
+  AsyncCaptureWriter *asyncWriter = NULL;
+
+  {
+    SCOPED_LOCK(m_CaptureLock);
+
+    if(Capture_AsyncWriting() && !m_AsyncCaptureWriter)
+      m_AsyncCaptureWriter =
+          new AsyncCaptureWriter(uint64_t(Capture_AsyncWritingMemoryMB()) * 1024 * 1024);
+
+    // once a file starts being written asynchronously all of its sections must be, to keep them in
+    // order
+    if(m_AsyncCaptureWriter && (Capture_AsyncWriting() || m_AsyncCaptureWriter->IsWriting(rdc)))
+      asyncWriter = m_AsyncCaptureWriter;
+  }
+
+  if(asyncWriter)
+    return asyncWriter->WriteSection(rdc, rdc->GetFilename(), props);
+
+  return rdc->WriteSection(props);
+}
+
 void RenderDoc::FinishCaptureWriting(RDCFile *rdc, uint32_t frameNumber)
+{
+  // take everything the remaining sections need now, so that writing them later in the background
+  // gives the same file as writing them here
+  CaptureFileInfo info;
+  info.frameNumber = frameNumber;
+
+  if(rdc)
+  {
+    info.path = rdc->GetFilename();
+
+    // the title is only consumed by a capture that's actually written
+    info.title = m_CaptureTitle;
+    m_CaptureTitle.clear();
+
+    info.includeResolveDatabase = m_Options.captureCallstacks;
+    if(info.includeResolveDatabase)
+    {
+      size_t sz = 0;
+      Callstack::GetLoadedModules(NULL, sz);
+
+      info.resolveDatabase.resize(sz);
+      Callstack::GetLoadedModules(info.resolveDatabase.data(), sz);
+    }
+  }
+
+  AsyncCaptureWriter *asyncWriter = NULL;
+  {
+    SCOPED_LOCK(m_CaptureLock);
+    if(rdc && m_AsyncCaptureWriter && m_AsyncCaptureWriter->IsWriting(rdc))
+      asyncWriter = m_AsyncCaptureWriter;
+  }
+
+  if(asyncWriter)
+  {
+    asyncWriter->FinishFile(rdc, [this, rdc, info]() { FinishCaptureFile(rdc, info); });
+    return;
+  }
+
+  FinishCaptureFile(rdc, info);
+}
+
+void RenderDoc::DiscardCaptureWriting(RDCFile *rdc)
+{
+  AsyncCaptureWriter *asyncWriter = NULL;
+  {
+    SCOPED_LOCK(m_CaptureLock);
+    if(rdc && m_AsyncCaptureWriter && m_AsyncCaptureWriter->IsWriting(rdc))
+      asyncWriter = m_AsyncCaptureWriter;
+  }
+
+  // sections may still be being written in the background, so the file is deleted once they're done
+  if(asyncWriter)
+    asyncWriter->FinishFile(rdc, [rdc]() { delete rdc; });
+  else
+    delete rdc;
+}
+
+void RenderDoc::FinishCaptureFile(RDCFile *rdc, const CaptureFileInfo &info)
 {
   RenderDoc::Inst().SetProgress(CaptureProgress::FileWriting, 0.0f);
 
   if(rdc)
   {
     // add the resolve database if we were capturing callstacks.
-    if(m_Options.captureCallstacks)
+    if(info.includeResolveDatabase)
     {
       SectionProperties props = {};
       props.type = SectionType::ResolveDatabase;
       props.version = 1;
       StreamWriter *w = rdc->WriteSection(props);
 
-      size_t sz = 0;
-      Callstack::GetLoadedModules(NULL, sz);
-
-      byte *buf = new byte[sz];
-      Callstack::GetLoadedModules(buf, sz);
-
-      w->Write(buf, sz);
+      w->Write(info.resolveDatabase.data(), info.resolveDatabase.size());
 
       w->Finish();
 
@@ -2036,15 +2476,14 @@ void RenderDoc::FinishCaptureWriting(RDCFile *rdc, uint32_t frameNumber)
       delete w;
     }
 
-    RDCLOG("Written to disk: %s", m_CurrentLogFile.c_str());
+    RDCLOG("Written to disk: %s", info.path.c_str());
 
     CaptureData cap;
-    cap.path = m_CurrentLogFile;
-    cap.title = m_CaptureTitle;
+    cap.path = info.path;
+    cap.title = info.title;
     cap.timestamp = Timing::GetUnixTimestamp();
     cap.driver = rdc->GetDriver();
-    cap.frameNumber = frameNumber;
-    m_CaptureTitle.clear();
+    cap.frameNumber = info.frameNumber;
     {
       SCOPED_LOCK(m_CaptureLock);
       m_Captures.push_back(cap);
@@ -2054,7 +2493,7 @@ void RenderDoc::FinishCaptureWriting(RDCFile *rdc, uint32_t frameNumber)
   }
   else
   {
-    RDCLOG("Discarded capture, Frame %u", frameNumber);
+    RDCLOG("Discarded capture, Frame %u", info.frameNumber);
   }
 
   RenderDoc::Inst().SetProgress(CaptureProgress::FileWriting, 1.0f);
@@ -2407,4 +2846,112 @@ TEST_CASE("Check ResamplePixels", "[core][resamplepixels]")
   }
 }
 
+TEST_CASE("Check asynchronous capture writing", "[core][asyncwrite]")
+{
+  rdcstr filename = FileIO::GetTempFolderFilename() + "/asyncwrite.rdc";
+
+  // large enough to need several blocks and hit the memory budget
+  bytebuf captureData;
+  captureData.resize(19 * 1024 * 1024 + 123);
+  for(size_t i = 0; i < captureData.size(); i++)
+    captureData[i] = byte((i * 37) ^ (i >> 12));
+
+  bytebuf extraData;
+  extraData.resize(1000);
+  for(size_t i = 0; i < extraData.size(); i++)
+    extraData[i] = byte(i);
+
+  int32_t finished = 0;
+
+  {
+    // the budget is clamped to two blocks so writing will have to wait for the background thread
+    AsyncCaptureWriter writer(1);
+
+    RDCFile *rdc = new RDCFile;
+    rdc->SetData(RDCDriver::Unknown, "Test", 0, NULL, 0, 1.0);
+    rdc->Create(filename);
+    REQUIRE(rdc->Error().code == ResultCode::Succeeded);
+
+    {
+      SectionProperties props;
+      props.flags = SectionFlags::LZ4Compressed | SectionFlags::BlockIndexed;
+      props.type = SectionType::FrameCapture;
+      props.version = 1;
+
+      StreamWriter *w = writer.WriteSection(rdc, filename, props);
+
+      // write in odd-sized pieces that straddle blocks
+      size_t offs = 0;
+      while(offs < captureData.size())
+      {
+        size_t size = RDCMIN(captureData.size() - offs, (size_t)777777);
+        w->Write(captureData.data() + offs, size);
+        offs += size;
+      }
+
+      CHECK(w->GetOffset() == captureData.size());
+
+      w->Finish();
+      delete w;
+    }
+
+    CHECK(writer.IsWriting(rdc));
+    CHECK(writer.IsWriting(filename));
+
+    {
+      SectionProperties props;
+      props.type = SectionType::ResolveDatabase;
+      props.version = 1;
+
+      StreamWriter *w = writer.WriteSection(rdc, filename, props);
+      w->Write(extraData.data(), extraData.size());
+      w->Finish();
+      delete w;
+    }
+
+    writer.FinishFile(rdc, [rdc, &finished]() {
+      Atomic::Inc32(&finished);
+      delete rdc;
+    });
+
+    writer.Drain();
+
+    CHECK(finished == 1);
+    CHECK_FALSE(writer.IsWriting(rdc));
+    CHECK_FALSE(writer.IsWriting(filename));
+  }
+
+  RDCFile rdc;
+  rdc.Open(filename);
+  REQUIRE(rdc.Error().code == ResultCode::Succeeded);
+  REQUIRE(rdc.NumSections() == 2);
+
+  int idx = rdc.SectionIndex(SectionType::FrameCapture);
+  REQUIRE(idx == 0);
+
+  {
+    StreamReader *reader = rdc.ReadSection(idx);
+    REQUIRE(reader->GetSize() == captureData.size());
+
+    bytebuf readData;
+    readData.resize(captureData.size());
+    reader->Read(readData.data(), readData.size());
+    CHECK(!reader->IsErrored());
+    CHECK(readData == captureData);
+    delete reader;
+  }
+
+  idx = rdc.SectionIndex(SectionType::ResolveDatabase);
+  REQUIRE(idx == 1);
+
+  {
+    StreamReader *reader = rdc.ReadSection(idx);
+    bytebuf readData;
+    readData.resize(extraData.size());
+    reader->Read(readData.data(), readData.size());
+    CHECK(readData == extraData);
+    delete reader;
+  }
+}
+
 #endif
@@ -51,8 +51,11 @@ class IRemoteDriver;
 class IReplayDriver;
 
 class StreamReader;
+class StreamWriter;
 class RDCFile;
+class AsyncCaptureWriter;
 struct SDFile;
+struct SectionProperties;
 enum class VulkanLayerFlags : uint32_t;
 
 namespace Callstack
@@ -480,7 +483,13 @@ public:
   void ResamplePixels(const FramePixels &in, RDCThumb &out);
   void EncodeThumbPixels(const RDCThumb &in, RDCThumb &out);
   RDCFile *CreateRDC(RDCDriver driver, uint32_t frameNum, const FramePixels &fp);
+  // returns a writer for a section of a capture created with CreateRDC. When capture writing is
+  // asynchronous the data is buffered and the section is compressed and written on a background
+  // thread, so the writer returns as soon as the data is queued.
+  StreamWriter *WriteCaptureSection(RDCFile *rdc, const SectionProperties &props);
   void FinishCaptureWriting(RDCFile *rdc, uint32_t frameNumber);
+  // abandons a capture that failed while being written, in place of FinishCaptureWriting
+  void DiscardCaptureWriting(RDCFile *rdc);
 
   void AddChildProcess(uint32_t pid, uint32_t ident);
   rdcarray<rdcpair<uint32_t, uint32_t>> GetChildProcesses();
@@ -620,6 +629,19 @@ private:
 
   void SyncAvailableGPUThread();
 
+  // the state of a capture needed to finish writing its file. This is taken on the capturing thread
+  // since the file may be finished later on the async writer's thread
+  struct CaptureFileInfo
+  {
+    uint32_t frameNumber = 0;
+    rdcstr path;
+    rdcstr title;
+    bool includeResolveDatabase = false;
+    bytebuf resolveDatabase;
+  };
+
+  void FinishCaptureFile(RDCFile *rdc, const CaptureFileInfo &info);
+
   bool m_Replay;
 
   uint32_t m_Cap;
@@ -641,7 +663,6 @@ private:
   rdcstr m_Target;
   rdcstr m_CaptureFileTemplate;
   rdcstr m_CaptureTitle;
-  rdcstr m_CurrentLogFile;
   CaptureOptions m_Options;
   uint32_t m_Overlay;
 
@@ -662,6 +683,8 @@ private:
 
   Threading::CriticalSection m_CaptureLock;
   rdcarray<CaptureData> m_Captures;
+  // created on first use when capture writing is asynchronous, protected by m_CaptureLock
+  AsyncCaptureWriter *m_AsyncCaptureWriter = NULL;
 
   Threading::CriticalSection m_ChildLock;
   rdcarray<rdcpair<uint32_t, uint32_t>> m_Children;
@@ -200,6 +200,8 @@ void GPUAddressRangeTracker::AddRangeAtIndex(size_t idx, const GPUAddressRange &
 
   addresses.insert(idx, newNode);
 
+  InvalidateSnapshot();
+
   // reverse to the first range with the same start, ignoring size
   while(idx > 0 && addresses[idx - 1].start == range.start)
     idx--;
@@ -226,6 +228,8 @@ void GPUAddressRangeTracker::RemoveRangeAtIndex(size_t idx)
   DeleteWholeList(&addresses[idx]);
   addresses.erase(idx);
 
+  InvalidateSnapshot();
+
   // reverse to the first range with the same start
   while(idx > 0 && addresses[idx - 1].start == range.start)
     idx--;
@@ -274,6 +278,10 @@ void GPUAddressRangeTracker::Clear()
   // clear addresses list. Linked lists will be deleted in batch below
   addresses.clear();
 
+  // we can't free the snapshots here as lock-free readers may still be in them, but they won't be
+  // used again until a new one is published
+  InvalidateSnapshot();
+
   for(size_t i = 0; i < batchNodeAllocs.size(); i++)
     delete[] batchNodeAllocs[i];
   batchNodeAllocs.clear();
@@ -314,16 +322,18 @@ rdcarray<ResourceId> GPUAddressRangeTracker::GetIDs()
   return ret;
 }
 
-size_t GPUAddressRangeTracker::FindLastRangeBeforeOrAtAddress(GPUAddressRange::Address addr)
+template <typename RangeType>
+size_t GPUAddressRangeTracker::FindLastRangeBeforeOrAtAddress(const rdcarray<RangeType> &ranges,
+                                                              GPUAddressRange::Address addr)
 {
-  // the caller must lock.
+  // the caller must lock, or be reading from a snapshot.
 
-  if(addresses.empty())
+  if(ranges.empty())
     return ~0U;
 
   // start looking at the whole range
   size_t first = 0;
-  size_t count = addresses.size();
+  size_t count = ranges.size();
 
   while(count > 1)
   {
@@ -332,7 +342,7 @@ size_t GPUAddressRangeTracker::FindLastRangeBeforeOrAtAddress(GPUAddressRange::A
     size_t mid = first + halfrange;
 
     // if the midpoint is after our address, bisect down to the lower half and exclude the midpoint
-    if(addr < addresses[mid].start)
+    if(addr < ranges[mid].start)
     {
       count = halfrange;
     }
@@ -345,7 +355,7 @@ size_t GPUAddressRangeTracker::FindLastRangeBeforeOrAtAddress(GPUAddressRange::A
   }
 
   // if first is 0 and the address range doesn't match, indicate that by returning ~0U
-  if(first == 0 && addr < addresses[first].start)
+  if(first == 0 && addr < ranges[first].start)
     return ~0U;
 
   return first;
@@ -362,26 +372,31 @@ void GPUAddressRangeTracker::GetResIDFromAddr(GPUAddressRange::Address addr, Res
     return;
 
   GPUAddressRange range;
+  bool found;
 
+  int32_t *slot = NULL;
+  const rdcarray<LookupEntry> *snapshot = BeginSnapshotRead(slot);
+  if(snapshot)
   {
-    SCOPED_READLOCK(addressLock);
-
-    // search for the address. This will return the largest range which starts before or at this address
-    size_t idx = FindLastRangeBeforeOrAtAddress(addr);
-
-    // ~0U is returned if the address is before the first range in our list. That means no match
-    if(idx == ~0U)
-      return;
-
-    // this range is already the largest before or at the address by virtue of our sorting and search
-    range = addresses[idx];
+    found = FindRangeForAddress(*snapshot, addr, range);
+    EndSnapshotRead(slot);
+  }
+  else
+  {
+    bool publish;
+    {
+      SCOPED_READLOCK(addressLock);
+      found = FindRangeForAddress(addresses, addr, range);
+      publish = CountLockedLookup();
+    }
 
-    // if this is out of the range and we have a next list of overextensions, go to the first one in
-    // the list immediately and try with that. It may still fail but it has the best chance to succeed
-    if(addr >= range.realEnd && addresses[idx].next)
-      range = *addresses[idx].next;
+    if(publish)
+      PublishSnapshot();
   }
 
+  if(!found)
+    return;
+
   // this should not happen, it's just for safety/readability. The only time the found range would
   // be after the address is if the address is before all ranges which would return above after
   // FindLastRangeBeforeOrAtAddress() fails
@@ -403,6 +418,30 @@ void GPUAddressRangeTracker::GetResIDFromAddr(GPUAddressRange::Address addr, Res
   offs = addr - range.start;
 }
 
+template <typename RangeType>
+bool GPUAddressRangeTracker::FindRangeForAddress(const rdcarray<RangeType> &ranges,
+                                                 GPUAddressRange::Address addr,
+                                                 GPUAddressRange &range)
+{
+  // search for the address. This will return the largest range which starts before or at this address
+  size_t idx = FindLastRangeBeforeOrAtAddress(ranges, addr);
+
+  // ~0U is returned if the address is before the first range in our list. That means no match
+  if(idx == ~0U)
+    return false;
+
+  // this range is already the largest before or at the address by virtue of our sorting and search
+  range = ranges[idx];
+
+  // if this is out of the range and we have a next list of overextensions, go to the first one in
+  // the list immediately and try with that. It may still fail but it has the best chance to succeed
+  const GPUAddressRange *overextend = GetOverextension(ranges[idx]);
+  if(addr >= range.realEnd && overextend)
+    range = *overextend;
+
+  return true;
+}
+
 template void GPUAddressRangeTracker::GetResIDFromAddr<false>(GPUAddressRange::Address addr,
                                                               ResourceId &id, uint64_t &offs);
 template void GPUAddressRangeTracker::GetResIDFromAddr<true>(GPUAddressRange::Address addr,
@@ -419,43 +458,159 @@ void GPUAddressRangeTracker::GetResIDBoundForAddr(GPUAddressRange::Address addr,
   if(addr == 0)
     return;
 
+  int32_t *slot = NULL;
+  const rdcarray<LookupEntry> *snapshot = BeginSnapshotRead(slot);
+  if(snapshot)
+  {
+    FindBoundsForAddress(*snapshot, addr, lower, lowerVA, upper, upperVA);
+    EndSnapshotRead(slot);
+    return;
+  }
+
+  bool publish;
   {
     SCOPED_READLOCK(addressLock);
+    FindBoundsForAddress(addresses, addr, lower, lowerVA, upper, upperVA);
+    publish = CountLockedLookup();
+  }
 
-    if(addresses.empty())
-      return;
+  if(publish)
+    PublishSnapshot();
+}
 
-    size_t idx = FindLastRangeBeforeOrAtAddress(addr);
+template <typename RangeType>
+void GPUAddressRangeTracker::FindBoundsForAddress(const rdcarray<RangeType> &ranges,
+                                                  GPUAddressRange::Address addr, ResourceId &lower,
+                                                  GPUAddressRange::Address &lowerVA,
+                                                  ResourceId &upper,
+                                                  GPUAddressRange::Address &upperVA)
+{
+  if(ranges.empty())
+    return;
 
-    // if the addr is before first known range, it's bounded on upper only
-    if(idx == ~0U)
-    {
-      upper = addresses[0].id;
-      upperVA = addresses[0].start;
-      return;
-    }
+  size_t idx = FindLastRangeBeforeOrAtAddress(ranges, addr);
 
-    lower = addresses[idx].id;
-    lowerVA = addresses[idx].start;
+  // if the addr is before first known range, it's bounded on upper only
+  if(idx == ~0U)
+  {
+    upper = ranges[0].id;
+    upperVA = ranges[0].start;
+    return;
+  }
 
-    // if this range contains the address exactly, return it as a tight bound
-    if(addresses[idx].realEnd > addr)
-    {
-      upper = addresses[idx].id;
-      upperVA = addresses[idx].realEnd;
-      return;
-    }
+  lower = ranges[idx].id;
+  lowerVA = ranges[idx].start;
 
-    // otherwise the address is past its end but before the next. Move one allocation along - we
-    // already know that we picked the largest allocation that covers this address
-    idx++;
+  // if this range contains the address exactly, return it as a tight bound
+  if(ranges[idx].realEnd > addr)
+  {
+    upper = ranges[idx].id;
+    upperVA = ranges[idx].realEnd;
+    return;
+  }
 
-    // if this wasn't the end, return the upper bound
-    if(idx < addresses.size())
-    {
-      upper = addresses[idx].id;
-      upperVA = addresses[idx].start;
-    }
+  // otherwise the address is past its end but before the next. Move one allocation along - we
+  // already know that we picked the largest allocation that covers this address
+  idx++;
+
+  // if this wasn't the end, return the upper bound
+  if(idx < ranges.size())
+  {
+    upper = ranges[idx].id;
+    upperVA = ranges[idx].start;
+  }
+}
+
+const rdcarray<GPUAddressRangeTracker::LookupEntry> *GPUAddressRangeTracker::BeginSnapshotRead(
+    int32_t *&slot)
+{
+  if(Atomic::Load32(&snapshotValid) == 0)
+    return NULL;
+
+  // thread IDs are often aligned pointers, so mix the bits before picking a slot
+  uint64_t hash = Threading::GetCurrentID() * 0x9E3779B97F4A7C15ULL;
+  ReaderSlot &readerSlot = readerSlots[(hash >> 32) % NumReaderSlots];
+
+  int32_t epoch;
+  for(;;)
+  {
+    epoch = Atomic::Load32(&snapshotEpoch);
+    slot = &readerSlot.active[epoch & 1];
+
+    Atomic::Inc32(slot);
+
+    // if the epoch didn't flip while we registered, the publisher will wait for us before reusing
+    // this snapshot. Otherwise back out and try again with the new epoch
+    if(Atomic::Load32(&snapshotEpoch) == epoch)
+      break;
+
+    Atomic::Dec32(slot);
+  }
+
+  // the snapshot may have been invalidated since we checked, but it's still a consistent view from
+  // before that modification and it can't be freed while we're registered.
+  return snapshots[epoch & 1];
+}
+
+void GPUAddressRangeTracker::EndSnapshotRead(int32_t *slot)
+{
+  Atomic::Dec32(slot);
+}
+
+bool GPUAddressRangeTracker::CountLockedLookup()
+{
+  // the caller must hold the read lock.
+
+  return Atomic::Inc64(&lockedLookups) >= publishThreshold;
+}
+
+void GPUAddressRangeTracker::InvalidateSnapshot()
+{
+  // the caller must hold the write lock.
+
+  Atomic::CmpExch32(&snapshotValid, 1, 0);
+}
+
+void GPUAddressRangeTracker::PublishSnapshot()
+{
+  SCOPED_WRITELOCK(addressLock);
+
+  // another thread may have published it while we were waiting for the lock
+  if(snapshotValid)
+    return;
+
+  // only publishers modify the epoch, and they're serialised by the lock
+  int32_t epoch = snapshotEpoch;
+
+  // readers of this snapshot were all drained by the previous publish
+  rdcarray<LookupEntry> *&snapshot = snapshots[(epoch + 1) & 1];
+  if(!snapshot)
+    snapshot = new rdcarray<LookupEntry>;
+
+  snapshot->resize(addresses.size());
+  for(size_t i = 0; i < addresses.size(); i++)
+  {
+    LookupEntry &entry = snapshot->at(i);
+    static_cast<GPUAddressRange &>(entry) = addresses[i];
+    entry.hasOverextend = addresses[i].next != NULL;
+    if(entry.hasOverextend)
+      entry.overextend = *addresses[i].next;
+  }
+
+  // flipping the epoch is a full barrier, so the snapshot contents are visible before any reader
+  // can see the new epoch
+  Atomic::Inc32(&snapshotEpoch);
+  Atomic::CmpExch32(&snapshotValid, 0, 1);
+
+  // don't rebuild again until enough lookups have gone through the lock to pay for it
+  publishThreshold = lockedLookups + int64_t(addresses.size() / 4) + 16;
+
+  // wait for readers still in the previous snapshot, so the next publish can overwrite it. New
+  // readers all register against the new epoch so this can't be starved.
+  for(uint32_t i = 0; i < NumReaderSlots; i++)
+  {
+    while(Atomic::Load32(&readerSlots[i].active[epoch & 1]) != 0)
+      Threading::Sleep(0);
   }
 }
 
@@ -465,6 +620,7 @@ void GPUAddressRangeTracker::GetResIDBoundForAddr(GPUAddressRange::Address addr,
 #undef Always
 
 #include "catch/catch.hpp"
+#include "common/timing.h"
 
 namespace TestIDs
 {
@@ -1429,4 +1585,144 @@ TEST_CASE("Check GPUAddressRangeTracker", "[gpuaddr]")
   CHECK(tracker.GetNumLiveNodes() == 0);
 }
 
+TEST_CASE("Check GPUAddressRangeTracker lookups concurrent with modification", "[gpuaddr]")
+{
+  GPUAddressRangeTracker tracker;
+
+  // stable ranges which are never modified, every 64kb
+  const uint64_t numStable = 512;
+  rdcarray<ResourceId> stableIDs;
+  stableIDs.resize(numStable);
+  for(uint64_t i = 0; i < numStable; i++)
+  {
+    stableIDs[i] = ResourceIDGen::GetNewUniqueID();
+    tracker.AddTo(MakeRange(stableIDs[i], 0x10000 * (i + 1), 0x8000));
+  }
+
+  ResourceId transientID = ResourceIDGen::GetNewUniqueID();
+
+  int32_t stop = 0;
+  int32_t failures = 0;
+
+  rdcarray<Threading::ThreadHandle> threads;
+  for(uint64_t t = 0; t < 4; t++)
+  {
+    threads.push_back(Threading::CreateThread([&, t]() {
+      uint64_t i = t;
+      while(Atomic::CmpExch32(&stop, 0, 0) == 0)
+      {
+        i = (i + 7) % numStable;
+        GPUAddressRange::Address base = 0x10000 * (i + 1);
+
+        // stable ranges must always be found regardless of concurrent modification
+        rdcpair<ResourceId, uint64_t> result = tracker.GetResIDFromAddr(base + 0x123);
+        if(result.first != stableIDs[i] || result.second != 0x123)
+          Atomic::Inc32(&failures);
+
+        // the gap after it may or may not contain a transient range, but nothing else
+        result = tracker.GetResIDFromAddr(base + 0x9100);
+        if(result.first != ResourceId() && (result.first != transientID || result.second != 0x100))
+          Atomic::Inc32(&failures);
+
+        ResourceId lower, upper;
+        GPUAddressRange::Address lowerVA, upperVA;
+        tracker.GetResIDBoundForAddr(base + 0x4000, lower, lowerVA, upper, upperVA);
+        if(lower != stableIDs[i] || upper != stableIDs[i] || lowerVA != base ||
+           upperVA != base + 0x8000)
+          Atomic::Inc32(&failures);
+      }
+    }));
+  }
+
+  // add and remove transient ranges in the gaps, with bursts of lookups in between so that
+  // snapshots are published and retired while the readers are running
+  for(int pass = 0; pass < 50; pass++)
+  {
+    for(uint64_t i = pass % 3; i < numStable; i += 3)
+      tracker.AddTo(MakeRange(transientID, 0x10000 * (i + 1) + 0x9000, 0x1000));
+
+    for(uint64_t i = 0; i < numStable; i++)
+      tracker.GetResIDFromAddr(0x10000 * (i + 1));
+
+    for(uint64_t i = pass % 3; i < numStable; i += 3)
+      tracker.RemoveFrom(0x10000 * (i + 1) + 0x9000, transientID);
+
+    for(uint64_t i = 0; i < numStable; i++)
+      tracker.GetResIDFromAddr(0x10000 * (i + 1));
+  }
+
+  Atomic::Inc32(&stop);
+
+  for(Threading::ThreadHandle t : threads)
+  {
+    Threading::JoinThread(t);
+    Threading::CloseThread(t);
+  }
+
+  CHECK(failures == 0);
+  CHECK(tracker.GetAddresses().size() == numStable);
+
+  for(uint64_t i = 0; i < numStable; i++)
+    tracker.RemoveFrom(0x10000 * (i + 1), stableIDs[i]);
+
+  CHECK(tracker.GetNumLiveNodes() == 0);
+}
+
+TEST_CASE("Benchmark GPUAddressRangeTracker contended lookups", "[.][gpuaddr][benchmark]")
+{
+  GPUAddressRangeTracker tracker;
+
+  const uint64_t numRanges = 16384;
+  for(uint64_t i = 0; i < numRanges; i++)
+    tracker.AddTo(MakeRange(ResourceIDGen::GetNewUniqueID(), 0x10000 * (i + 1), 0x8000));
+
+  const uint64_t lookupsPerThread = 2000000;
+
+  for(uint32_t numThreads : {1, 2, 4, 8})
+  {
+    // modify the tracker so every run starts from the locked path and has to publish a snapshot
+    ResourceId extra = ResourceIDGen::GetNewUniqueID();
+    tracker.AddTo(MakeRange(extra, 0x10000 * (numRanges + 1), 0x8000));
+    tracker.RemoveFrom(0x10000 * (numRanges + 1), extra);
+
+    int32_t found = 0;
+
+    PerformanceTimer timer;
+
+    rdcarray<Threading::ThreadHandle> threads;
+    for(uint32_t t = 0; t < numThreads; t++)
+    {
+      threads.push_back(Threading::CreateThread([&, t]() {
+        uint64_t addr = 0x1234567 * (t + 1);
+        int32_t count = 0;
+        for(uint64_t i = 0; i < lookupsPerThread; i++)
+        {
+          addr = (addr * 6364136223846793005ULL + 1442695040888963407ULL);
+          if(tracker.GetResIDFromAddr(0x10000 + (addr >> 32) % (0x10000 * numRanges)).first !=
+             ResourceId())
+            count++;
+        }
+        // every thread should find some ranges
+        if(count > 0)
+          Atomic::Inc32(&found);
+      }));
+    }
+
+    for(Threading::ThreadHandle t : threads)
+    {
+      Threading::JoinThread(t);
+      Threading::CloseThread(t);
+    }
+
+    double ms = timer.GetMilliseconds();
+
+    CHECK(found == (int32_t)numThreads);
+
+    RDCLOG("%u threads: %.2f ms for %llu lookups, %.1f million lookups/sec", numThreads, ms,
+           lookupsPerThread * numThreads, double(lookupsPerThread * numThreads) / (ms * 1000.0));
+  }
+
+  tracker.Clear();
+}
+
 #endif
@@ -44,7 +44,12 @@ struct GPUAddressRange
 struct GPUAddressRangeTracker
 {
   GPUAddressRangeTracker() {}
-  ~GPUAddressRangeTracker() { Clear(); }
+  ~GPUAddressRangeTracker()
+  {
+    Clear();
+    SAFE_DELETE(snapshots[0]);
+    SAFE_DELETE(snapshots[1]);
+  }
   // no copying
   GPUAddressRangeTracker(const GPUAddressRangeTracker &) = delete;
   GPUAddressRangeTracker &operator=(const GPUAddressRangeTracker &) = delete;
@@ -199,10 +204,77 @@ private:
   rdcarray<OverextendNode> addresses;
   Threading::RWLock addressLock;
 
+  // lookups vastly outnumber modifications once a capture is loaded, and with many threads looking
+  // up addresses even an uncontended read lock bounces its cacheline between cores. To avoid that
+  // we periodically publish an immutable flattened copy of the ranges which lookups can read
+  // without locking.
+  //
+  // Any modification invalidates the snapshot, and lookups fall back to the lock until enough of
+  // them have happened to pay for rebuilding it. That way bursts of creation/destruction don't
+  // rebuild the snapshot for every change.
+  //
+  // Snapshots are double buffered and reclaimed by epoch. A reader registers in a slot for the
+  // current epoch's parity and reads snapshots[epoch & 1]. A publisher (always holding the write
+  // lock) fills the other snapshot, flips the epoch, then waits for readers of the previous parity
+  // to drain so that the next publish can safely overwrite it.
+  struct LookupEntry : public GPUAddressRange
+  {
+    // the head of this range's overextension list, if it had one. Lookups never need more
+    GPUAddressRange overextend;
+    bool hasOverextend;
+  };
+
+  // reader counts are striped across slots so that readers on different threads don't contend.
+  // Each slot is padded to its own cacheline
+  struct ReaderSlot
+  {
+    int32_t active[2];
+    byte padding[64 - sizeof(int32_t) * 2];
+  };
+
+  static const uint32_t NumReaderSlots = 32;
+  ReaderSlot readerSlots[NumReaderSlots] = {};
+
+  rdcarray<LookupEntry> *snapshots[2] = {};
+  int32_t snapshotEpoch = 0;
+  int32_t snapshotValid = 0;
+
+  // count of lookups that went through the lock, and how many there must be before we publish a
+  // new snapshot. Only modified while holding the lock
+  int64_t lockedLookups = 0;
+  int64_t publishThreshold = 0;
+
+  const rdcarray<LookupEntry> *BeginSnapshotRead(int32_t *&slot);
+  void EndSnapshotRead(int32_t *slot);
+  bool CountLockedLookup();
+  void PublishSnapshot();
+  void InvalidateSnapshot();
+
+  static const GPUAddressRange *GetOverextension(const OverextendNode &node) { return node.next; }
+  static const GPUAddressRange *GetOverextension(const LookupEntry &entry)
+  {
+    return entry.hasOverextend ? &entry.overextend : NULL;
+  }
+
   template <bool allowOOB>
   void GetResIDFromAddr(GPUAddressRange::Address addr, ResourceId &id, uint64_t &offs);
 
-  size_t FindLastRangeBeforeOrAtAddress(GPUAddressRange::Address addr);
+  template <typename RangeType>
+  static bool FindRangeForAddress(const rdcarray<RangeType> &ranges,
+                                  GPUAddressRange::Address addr, GPUAddressRange &range);
+  template <typename RangeType>
+  static void FindBoundsForAddress(const rdcarray<RangeType> &ranges,
+                                   GPUAddressRange::Address addr, ResourceId &lower,
+                                   GPUAddressRange::Address &lowerVA, ResourceId &upper,
+                                   GPUAddressRange::Address &upperVA);
+
+  size_t FindLastRangeBeforeOrAtAddress(GPUAddressRange::Address addr)
+  {
+    return FindLastRangeBeforeOrAtAddress(addresses, addr);
+  }
+  template <typename RangeType>
+  static size_t FindLastRangeBeforeOrAtAddress(const rdcarray<RangeType> &ranges,
+                                               GPUAddressRange::Address addr);
   void AddRangeAtIndex(size_t idx, const GPUAddressRange &range);
   void RemoveRangeAtIndex(size_t idx);
 };
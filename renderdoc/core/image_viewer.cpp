@@ -1075,12 +1075,7 @@ void ImageViewer::CreateProxyTexture(TextureDescription &texDetails, read_tex_da
 
       if(convertSupported)
       {
-        uint32_t srcStride = texDetails.format.ElementSize();
-
-        if(texDetails.format.type == ResourceFormatType::D16S8)
-          srcStride = 4;
-        else if(texDetails.format.type == ResourceFormatType::D32S8)
-          srcStride = 8;
+        uint32_t srcStride = GetFormattedTexelStride(texDetails.format);
 
         m_RealTexData.resize(texDetails.arraysize * texDetails.mips);
 
@@ -1102,21 +1097,9 @@ void ImageViewer::CreateProxyTexture(TextureDescription &texDetails, read_tex_da
           convertedData.resize(convertedData.size() + read_data.subresources[i].second);
           byte *converted = convertedData.data() + read_data.subresources[i].first;
 
-          byte *src = old;
-          FloatVector *dst = (FloatVector *)converted;
-
-          for(uint32_t z = 0; z < mipdepth; z++)
-          {
-            for(uint32_t y = 0; y < mipheight; y++)
-            {
-              for(uint32_t x = 0; x < mipwidth; x++)
-              {
-                *dst = DecodeFormattedComponents(texDetails.format, src);
-                dst++;
-                src += srcStride;
-              }
-            }
-          }
+          // each slice's rows are tightly packed one after another
+          DecodeFormattedRows(texDetails.format, old, srcStride * mipwidth, mipwidth,
+                              mipheight * mipdepth, (float *)converted);
         }
 
         read_data.buffer.swap(convertedData);
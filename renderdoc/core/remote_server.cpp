@@ -86,6 +86,7 @@ enum RemoteServerPacket
   eRemoteServer_GetSectionContents,
   eRemoteServer_WriteSection,
   eRemoteServer_GetAvailableGPUs,
+  eRemoteServer_GetResolves,
   eRemoteServer_RemoteServerCount,
 };
 
@@ -130,6 +131,7 @@ rdcstr DoStringise(const RemoteServerPacket &el)
     STRINGISE_ENUM_NAMED(eRemoteServer_GetSectionContents, "GetSectionContents");
     STRINGISE_ENUM_NAMED(eRemoteServer_WriteSection, "WriteSection");
     STRINGISE_ENUM_NAMED(eRemoteServer_GetAvailableGPUs, "GetAvailableGPUs");
+    STRINGISE_ENUM_NAMED(eRemoteServer_GetResolves, "GetResolves");
     STRINGISE_ENUM_NAMED(eRemoteServer_RemoteServerCount, "RemoteServerCount");
   }
   END_ENUM_STRINGISE();
@@ -673,12 +675,11 @@ static void ActiveRemoteClientThread(ClientThread *threadData,
 
       if(resolver)
       {
-        StackFrames.reserve(StackAddresses.size());
-        for(uint64_t frame : StackAddresses)
-        {
-          Callstack::AddressDetails info = resolver->GetAddr(frame);
-          StackFrames.push_back(info.formattedString());
-        }
+        rdcarray<Callstack::AddressDetails> info = resolver->GetAddrs(StackAddresses);
+
+        StackFrames.reserve(info.size());
+        for(Callstack::AddressDetails &frame : info)
+          StackFrames.push_back(frame.formattedString());
       }
       else
       {
@@ -691,6 +692,28 @@ static void ActiveRemoteClientThread(ClientThread *threadData,
         SERIALISE_ELEMENT(StackFrames);
       }
     }
+    else if(type == eRemoteServer_GetResolves)
+    {
+      rdcarray<uint64_t> StackAddresses;
+      rdcarray<uint32_t> CallstackOffsets;
+
+      {
+        READ_DATA_SCOPE();
+        SERIALISE_ELEMENT(StackAddresses);
+        SERIALISE_ELEMENT(CallstackOffsets);
+      }
+
+      reader.EndChunk();
+
+      CallstackFrameTable FrameTable =
+          Callstack::ResolveCallstacks(resolver, StackAddresses, CallstackOffsets);
+
+      {
+        WRITE_DATA_SCOPE();
+        SCOPED_SERIALISE_CHUNK(eRemoteServer_GetResolves);
+        SERIALISE_ELEMENT(FrameTable);
+      }
+    }
     else if(type == eRemoteServer_GetDriverName)
     {
       reader.EndChunk();
@@ -2109,3 +2132,37 @@ rdcarray<rdcstr> RemoteServer::GetResolve(const rdcarray<uint64_t> &callstack)
 
   return StackFrames;
 }
+
+CallstackFrameTable RemoteServer::GetResolves(const rdcarray<uint64_t> &addresses,
+                                              const rdcarray<uint32_t> &callstackOffsets)
+{
+  if(!Connected())
+    return CallstackFrameTable();
+
+  {
+    WRITE_DATA_SCOPE();
+    SCOPED_SERIALISE_CHUNK(eRemoteServer_GetResolves);
+    SERIALISE_ELEMENT(addresses);
+    SERIALISE_ELEMENT(callstackOffsets);
+  }
+
+  CallstackFrameTable FrameTable;
+
+  {
+    READ_DATA_SCOPE();
+    RemoteServerPacket type = ser.ReadChunk<RemoteServerPacket>();
+
+    if(type == eRemoteServer_GetResolves)
+    {
+      SERIALISE_ELEMENT(FrameTable);
+    }
+    else
+    {
+      RDCERR("Unexpected response to resolve request");
+    }
+
+    ser.EndChunk();
+  }
+
+  return FrameTable;
+}
@@ -99,6 +99,8 @@ public:
   virtual ResultDetails InitResolver(bool interactive, RENDERDOC_ProgressCallback progress);
 
   virtual rdcarray<rdcstr> GetResolve(const rdcarray<uint64_t> &callstack);
+  virtual CallstackFrameTable GetResolves(const rdcarray<uint64_t> &addresses,
+                                          const rdcarray<uint32_t> &callstackOffsets);
 
 protected:
   Network::Socket *m_Socket;
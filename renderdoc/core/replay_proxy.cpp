@@ -25,10 +25,19 @@
 
 #include "replay_proxy.h"
 #include <list>
+#include "core/settings.h"
 #include "lz4/lz4.h"
 #include "replay/dummy_driver.h"
 #include "serialise/lz4io.h"
 
+RDOC_CONFIG(uint32_t, Replay_DeltaTransferThreads, 0,
+            "The number of threads to use when comparing resource contents against the previous "
+            "contents for remote replay. 0 selects a number automatically, 1 compares on the "
+            "replay thread.");
+
+// below this size the comparison is quick enough that splitting it across threads isn't worthwhile
+static const size_t MinParallelDeltaSize = 4 * 1024 * 1024;
+
 template <>
 rdcstr DoStringise(const ReplayProxyPacket &el)
 {
@@ -275,6 +284,16 @@ ReplayProxy::~ReplayProxy()
 
   for(auto it = m_ShaderReflectionCache.begin(); it != m_ShaderReflectionCache.end(); ++it)
     delete it->second;
+
+  if(m_DeltaStats.numTransfers > 0)
+  {
+    RDCLOG(
+        "Delta transferred %llu resources (%llu unchanged, %llu sent whole) from %llu bytes: %llu "
+        "delta bytes compressed to %llu bytes. %.2f ms spent comparing, %.2f ms compressing",
+        m_DeltaStats.numTransfers, m_DeltaStats.numUnchanged, m_DeltaStats.numWhole,
+        m_DeltaStats.sourceBytes, m_DeltaStats.deltaBytes, m_DeltaStats.compressedBytes,
+        m_DeltaStats.compareTime, m_DeltaStats.compressTime);
+  }
 }
 
 #pragma region Proxied Functions
@@ -2188,6 +2207,124 @@ void DoSerialise(SerialiserType &ser, DeltaSection &el)
   SERIALISE_MEMBER(contents);
 }
 
+// we only care about large-ish chunks at a time. This prevents us generating lots of tiny deltas
+// where we could batch changes together. This is tuned to not be too large (and thus causing us to
+// miss too many sections we could skip) and not too small (causing us to devolve into lots of
+// byte-wise deltas). The current value as of this comment of 128 is definitely on the small end of
+// the range, but consider e.g. an android image of 1440x2560 and a pixel-wide line that goes
+// vertically from top to bottom. Reading horizontally that will mean 2560 different diffs, and only
+// actually one pixel changed. The larger this value gets, the more redundant data we'll send along
+// with.
+static const size_t DeltaChunkSize = 128;
+
+// diff the whole chunks in [begin, end) of newData against referenceData, appending to deltas.
+static void CalculateChunkDeltas(const byte *newData, const byte *referenceData, size_t begin,
+                                 size_t end, std::list<DeltaSection> &deltas)
+{
+  const byte *src = newData + begin;
+  const byte *dst = referenceData + begin;
+  size_t bytesRemain = end - begin;
+
+  // we use a simple state machine. Start in state 1
+  //
+  // State 1: No active delta. Look at the current chunk, if there's no difference move to the
+  //          next chunk and stay in this state. If there is a difference, push a delta onto
+  //          the list at the current offset. Copy the current chunk into the contents of the
+  //          delta. Move to state 2.
+  // State 2. Active delta. Look at the current chunk, if there is a difference then append
+  //          the current chunk to the last delta's contents, move to the next chunk, and stay
+  //          in this state. If there isn't a difference, move back to state 1 (the delta is
+  //          already 'finished' so we have no need to do anything more on it).
+  //
+  // At any point we can end the loop, both states are 'complete' at all points.
+
+  enum DeltaState
+  {
+    None,
+    Active
+  };
+  DeltaState state = DeltaState::None;
+
+  // loop over whole chunks
+  while(bytesRemain >= DeltaChunkSize)
+  {
+    // check if there's a difference in this chunk.
+    bool chunkDiff = memcmp(src, dst, DeltaChunkSize) != 0;
+
+    // if we're in state 1
+    if(state == DeltaState::None)
+    {
+      // if there's a difference, append a new delta with the current offset and chunk
+      // contents and move to state 2
+      if(chunkDiff)
+      {
+        deltas.push_back(DeltaSection());
+        deltas.back().offs = src - newData;
+        deltas.back().contents.append(src, DeltaChunkSize);
+
+        state = DeltaState::Active;
+      }
+    }
+    // if we're in state 2
+    else if(state == DeltaState::Active)
+    {
+      // continue to append to the delta if there's another difference in this chunk.
+      if(chunkDiff)
+      {
+        deltas.back().contents.append(src, DeltaChunkSize);
+      }
+      else
+      {
+        state = DeltaState::None;
+      }
+    }
+
+    // move to the next chunk
+    bytesRemain -= DeltaChunkSize;
+    src += DeltaChunkSize;
+    dst += DeltaChunkSize;
+  }
+}
+
+// diff the whole chunks in [0, end), splitting the range across threads. The result is identical
+// to diffing serially.
+static void CalculateChunkDeltasParallel(const byte *newData, const byte *referenceData,
+                                         size_t end, uint32_t numThreads,
+                                         std::list<DeltaSection> &deltas)
+{
+  size_t numChunks = end / DeltaChunkSize;
+  size_t chunksPerSlice = (numChunks + numThreads - 1) / numThreads;
+
+  rdcarray<std::list<DeltaSection>> sliceDeltas;
+  sliceDeltas.resize(numThreads);
+
+  auto diffSlice = [&](size_t i) {
+    size_t begin = RDCMIN(numChunks, chunksPerSlice * i) * DeltaChunkSize;
+    size_t sliceEnd = RDCMIN(numChunks, chunksPerSlice * (i + 1)) * DeltaChunkSize;
+    CalculateChunkDeltas(newData, referenceData, begin, sliceEnd, sliceDeltas[i]);
+  };
+
+  Threading::ParallelFor(numThreads, diffSlice, numThreads);
+
+  deltas.splice(deltas.end(), sliceDeltas[0]);
+
+  for(uint32_t i = 1; i < numThreads; i++)
+  {
+    std::list<DeltaSection> &slice = sliceDeltas[i];
+
+    // if a delta ran up to the end of the previous slice and this slice starts with one, the serial
+    // state machine would have produced a single delta. Merge them so the output is the same
+    if(!deltas.empty() && !slice.empty() &&
+       deltas.back().offs + deltas.back().contents.size() == slice.front().offs)
+    {
+      deltas.back().contents.append(slice.front().contents);
+      slice.pop_front();
+    }
+
+    deltas.splice(deltas.end(), slice);
+  }
+}
+
 template <typename SerialiserType>
 void ReplayProxy::DeltaTransferBytes(SerialiserType &xferser, bytebuf &referenceData, bytebuf &newData)
 {
@@ -2277,6 +2414,8 @@ void ReplayProxy::DeltaTransferBytes(SerialiserType &xferser, bytebuf &reference
   {
     uint64_t uncompSize = 0;
 
+    PerformanceTimer timer;
+
     // we use a list so that we don't have to reserve and pushing new sections will never cause
     // previous ones to be reallocated and move around lots of data.
     std::list<DeltaSection> deltasList;
@@ -2302,88 +2441,34 @@ void ReplayProxy::DeltaTransferBytes(SerialiserType &xferser, bytebuf &reference
       {
         // do actual diff.
         const byte *srcBegin = newData.data();
-        const byte *src = srcBegin;
         const byte *dst = referenceData.data();
-        size_t bytesRemain = newData.size();
-
-        // we only care about large-ish chunks at a time. This prevents us generating lots of tiny
-        // deltas where we could batch changes together. This is tuned to not be too large (and
-        // thus causing us to miss too many sections we could skip) and not too small (causing us
-        // to devolve into lots of byte-wise deltas). The current value as of this comment of 128
-        // is definitely on the small end of the range, but consider e.g. an android image of
-        // 1440x2560 and a pixel-wide line that goes vertically from top to bottom. Reading
-        // horizontally that will mean 2560 different diffs, and only actually one pixel changed.
-        // The larger this value gets, the more redundant data we'll send along with.
-        const size_t chunkSize = 128;
-
-        // we use a simple state machine. Start in state 1
-        //
-        // State 1: No active delta. Look at the current chunk, if there's no difference move to the
-        //          next chunk and stay in this state. If there is a difference, push a delta onto
-        //          the list at the current offset. Copy the current chunk into the contents of the
-        //          delta. Move to state 2.
-        // State 2. Active delta. Look at the current chunk, if there is a difference then append
-        //          the current chunk to the last delta's contents, move to the next chunk, and stay
-        //          in this state. If there isn't a difference, move back to state 1 (the delta is
-        //          already 'finished' so we have no need to do anything more on it).
-        //
-        // At any point we can end the loop, both states are 'complete' at all points.
-
-        enum DeltaState
-        {
-          None,
-          Active
-        };
-        DeltaState state = DeltaState::None;
+        size_t size = newData.size();
 
-        // loop over whole chunks
-        while(bytesRemain > chunkSize)
-        {
-          // check if there's a difference in this chunk.
-          bool chunkDiff = memcmp(src, dst, chunkSize) != 0;
+        // compare whole chunks up to but not including the last chunk, which may be partial and is
+        // always diffed on its own below.
+        size_t wholeChunksEnd = 0;
+        if(size > DeltaChunkSize)
+          wholeChunksEnd = ((size - 1) / DeltaChunkSize) * DeltaChunkSize;
 
-          // if we're in state 1
-          if(state == DeltaState::None)
-          {
-            // if there's a difference, append a new delta with the current offset and chunk
-            // contents and move to state 2
-            if(chunkDiff)
-            {
-              deltasList.push_back(DeltaSection());
-              deltasList.back().offs = src - srcBegin;
-              deltasList.back().contents.append(src, chunkSize);
-
-              state = DeltaState::Active;
-            }
-          }
-          // if we're in state 2
-          else if(state == DeltaState::Active)
-          {
-            // continue to append to the delta if there's another difference in this chunk.
-            if(chunkDiff)
-            {
-              deltasList.back().contents.append(src, chunkSize);
-            }
-            else
-            {
-              state = DeltaState::None;
-            }
-          }
+        uint32_t numThreads = Replay_DeltaTransferThreads();
+        if(numThreads == 0)
+          numThreads = RDCCLAMP(Threading::NumberOfCores() / 2, 1U, 8U);
 
-          // move to the next chunk
-          bytesRemain -= chunkSize;
-          src += chunkSize;
-          dst += chunkSize;
-        }
+        if(numThreads > 1 && wholeChunksEnd >= MinParallelDeltaSize)
+          CalculateChunkDeltasParallel(srcBegin, dst, wholeChunksEnd, numThreads, deltasList);
+        else
+          CalculateChunkDeltas(srcBegin, dst, 0, wholeChunksEnd, deltasList);
 
         // if there are still some bytes remaining at the end of the image, smaller than the chunk
         // size, just diff directly and send if needed. We could combine this with the last delta if
         // we ended in the active state.
-        if(bytesRemain > 0 && memcmp(src, dst, bytesRemain) != 0)
+        size_t bytesRemain = size - wholeChunksEnd;
+        if(bytesRemain > 0 &&
+           memcmp(srcBegin + wholeChunksEnd, dst + wholeChunksEnd, bytesRemain) != 0)
         {
           deltasList.push_back(DeltaSection());
-          deltasList.back().offs = src - srcBegin;
-          deltasList.back().contents.append(src, bytesRemain);
+          deltasList.back().offs = wholeChunksEnd;
+          deltasList.back().contents.append(srcBegin + wholeChunksEnd, bytesRemain);
         }
       }
     }
@@ -2402,10 +2487,25 @@ void ReplayProxy::DeltaTransferBytes(SerialiserType &xferser, bytebuf &reference
       }
     }
 
+    double compareTime = timer.GetMilliseconds();
+    uint64_t deltaBytes = 0;
+
+    for(const DeltaSection &delta : deltas)
+      deltaBytes += (uint64_t)delta.contents.size();
+
+    m_DeltaStats.numTransfers++;
+    m_DeltaStats.sourceBytes += (uint64_t)newData.size();
+    m_DeltaStats.deltaBytes += deltaBytes;
+    m_DeltaStats.compareTime += compareTime;
+
+    if(referenceData.size() != newData.size())
+      m_DeltaStats.numWhole++;
+
     // fast path - no changes.
     if(deltas.empty())
     {
       uncompSize = 0;
+      m_DeltaStats.numUnchanged++;
     }
     else
     {
@@ -2421,21 +2521,39 @@ void ReplayProxy::DeltaTransferBytes(SerialiserType &xferser, bytebuf &reference
 
     if(uncompSize > 0)
     {
-      WriteSerialiser ser(new StreamWriter(new LZ4Compressor(xferser.GetWriter(), Ownership::Nothing),
-                                           Ownership::Stream),
-                          Ownership::Stream);
+      timer.Restart();
+      uint64_t compressedStart = xferser.GetWriter()->GetOffset();
 
-      SERIALISE_ELEMENT(deltas);
+      {
+        WriteSerialiser ser(
+            new StreamWriter(new LZ4Compressor(xferser.GetWriter(), Ownership::Nothing),
+                             Ownership::Stream),
+            Ownership::Stream);
 
-      char empty[128] = {};
+        SERIALISE_ELEMENT(deltas);
+
+        char empty[128] = {};
+
+        // add any necessary padding.
+        uint64_t offs = ser.GetWriter()->GetOffset();
+        RDCASSERT(offs <= uncompSize, offs, uncompSize);
+        RDCASSERT(uncompSize - offs < sizeof(empty), offs, uncompSize);
 
-      // add any necessary padding.
-      uint64_t offs = ser.GetWriter()->GetOffset();
-      RDCASSERT(offs <= uncompSize, offs, uncompSize);
-      RDCASSERT(uncompSize - offs < sizeof(empty), offs, uncompSize);
+        if(offs < uncompSize)
+          ser.GetWriter()->Write(empty, uncompSize - offs);
+      }
+
+      double compressTime = timer.GetMilliseconds();
+      uint64_t compressedBytes = xferser.GetWriter()->GetOffset() - compressedStart;
 
-      if(offs < uncompSize)
-        ser.GetWriter()->Write(empty, uncompSize - offs);
+      m_DeltaStats.compressedBytes += compressedBytes;
+      m_DeltaStats.compressTime += compressTime;
+
+      RDCDEBUG(
+          "Sending %u deltas, %llu delta bytes of %llu resource size compressed to %llu bytes. "
+          "%.2f ms comparing, %.2f ms compressing",
+          (uint32_t)deltas.size(), deltaBytes, (uint64_t)newData.size(), compressedBytes,
+          compareTime, compressTime);
     }
 
     // This is the proxy side, so we have the complete newest contents in data. Swap the new data
@@ -3228,3 +3346,55 @@ bool ReplayProxy::Tick(int type)
 
   return true;
 }
+
+#if ENABLED(ENABLE_UNIT_TESTS)
+
+#include "catch/catch.hpp"
+
+TEST_CASE("Check parallel delta calculation matches serial", "[proxy]")
+{
+  const size_t size = 1024 * 1024 + 3 * DeltaChunkSize;
+
+  bytebuf reference, data;
+  reference.resize(size);
+  for(size_t i = 0; i < size; i++)
+    reference[i] = byte(i * 7);
+
+  data = reference;
+
+  // modify single bytes, runs crossing likely slice boundaries, and the first and last chunks
+  uint32_t seed = 0x1234;
+  for(int i = 0; i < 200; i++)
+  {
+    seed = seed * 1103515245 + 12345;
+    data[(seed >> 8) % size] ^= 0xff;
+  }
+  for(size_t i = size / 2 - 1000; i < size / 2 + 1000; i++)
+    data[i]++;
+  data[0]++;
+  data[size - DeltaChunkSize - 1]++;
+
+  std::list<DeltaSection> serial;
+  CalculateChunkDeltas(data.data(), reference.data(), 0, size - DeltaChunkSize, serial);
+
+  CHECK(!serial.empty());
+
+  for(uint32_t numThreads : {2, 3, 4, 7})
+  {
+    std::list<DeltaSection> parallel;
+    CalculateChunkDeltasParallel(data.data(), reference.data(), size - DeltaChunkSize, numThreads,
+                                 parallel);
+
+    REQUIRE(parallel.size() == serial.size());
+
+    auto a = serial.begin();
+    auto b = parallel.begin();
+    for(; a != serial.end(); ++a, ++b)
+    {
+      CHECK(a->offs == b->offs);
+      CHECK(a->contents == b->contents);
+    }
+  }
+}
+
+#endif
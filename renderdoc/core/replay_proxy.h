@@ -730,6 +730,19 @@ private:
   bool m_IsErrored = false;
   RDResult m_FatalError = ResultCode::Succeeded;
 
+  // statistics on the sending side of DeltaTransferBytes, logged on shutdown
+  struct DeltaTransferStats
+  {
+    uint64_t numTransfers = 0;
+    uint64_t numUnchanged = 0;
+    uint64_t numWhole = 0;
+    uint64_t sourceBytes = 0;
+    uint64_t deltaBytes = 0;
+    uint64_t compressedBytes = 0;
+    double compareTime = 0.0;
+    double compressTime = 0.0;
+  } m_DeltaStats;
+
   FrameRecord m_FrameRecord;
   APIProperties m_APIProps;
   std::map<ResourceId, TextureDescription> m_TextureInfo;
@@ -0,0 +1,504 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#pragma once
+
+#include <string.h>
+#include "api/replay/rdcarray.h"
+#include "api/replay/rdcpair.h"
+#include "api/replay/resourceid.h"
+#include "common/common.h"
+
+// Containers keyed by ResourceId that take advantage of IDs being allocated sequentially from a
+// global counter. Instead of hashing, the ID is split into a block, page and slot and looked up
+// directly in a paged table, so lookups are a couple of dependent loads and memory scales with the
+// range of IDs in use rather than with a node per element.
+//
+// IDs cluster in at most a few ranges - capture-time IDs start from 1, and replay IDs are offset by
+// a large constant (see ResourceIDGen::SetReplayResourceIDs) - so the blocks are kept in a small
+// sorted array. Pages are allocated on first use and freed when they become empty.
+//
+// Like the std containers they replace these are not thread-safe, external locking is required.
+namespace ResourceIdTable
+{
+inline uint64_t Key(ResourceId id)
+{
+  RDCCOMPILE_ASSERT(sizeof(id) == sizeof(uint64_t), "ResourceId is no longer 1:1 with uint64_t");
+
+  uint64_t ret;
+  memcpy(&ret, &id, sizeof(ret));
+  return ret;
+}
+
+inline ResourceId FromKey(uint64_t key)
+{
+  ResourceId ret;
+  memcpy(&ret, &key, sizeof(ret));
+  return ret;
+}
+
+static const uint32_t PageBits = 10;
+static const uint32_t PageSize = 1U << PageBits;
+static const uint32_t DirBits = 12;
+static const uint32_t DirSize = 1U << DirBits;
+
+// the paged lookup shared between the map and set. PageType must have a 'count' member which is 0
+// when the page is empty and can be freed.
+template <typename PageType>
+class Pages
+{
+public:
+  Pages() = default;
+  Pages(const Pages &) = delete;
+  Pages &operator=(const Pages &) = delete;
+  ~Pages() { clear(); }
+  void clear()
+  {
+    for(Block *b : m_Blocks)
+    {
+      for(uint32_t p = 0; p < DirSize; p++)
+        delete b->pages[p];
+      delete b;
+    }
+    m_Blocks.clear();
+  }
+
+  PageType *find(uint64_t key) const
+  {
+    const uint64_t base = key >> (PageBits + DirBits);
+
+    // almost always one or two blocks, so a linear search is fine
+    for(const Block *b : m_Blocks)
+    {
+      if(b->base == base)
+        return b->pages[(key >> PageBits) & (DirSize - 1)];
+      if(b->base > base)
+        break;
+    }
+
+    return NULL;
+  }
+
+  PageType *findOrCreate(uint64_t key)
+  {
+    const uint64_t base = key >> (PageBits + DirBits);
+
+    size_t i = 0;
+    for(; i < m_Blocks.size(); i++)
+    {
+      if(m_Blocks[i]->base >= base)
+        break;
+    }
+
+    if(i == m_Blocks.size() || m_Blocks[i]->base != base)
+    {
+      Block *b = new Block;
+      b->base = base;
+      memset(b->pages, 0, sizeof(b->pages));
+      m_Blocks.insert(i, b);
+    }
+
+    PageType *&page = m_Blocks[i]->pages[(key >> PageBits) & (DirSize - 1)];
+    if(page == NULL)
+      page = new PageType();
+    return page;
+  }
+
+  // called when a page's count drops to 0
+  void release(uint64_t key)
+  {
+    const uint64_t base = key >> (PageBits + DirBits);
+
+    for(size_t i = 0; i < m_Blocks.size(); i++)
+    {
+      Block *b = m_Blocks[i];
+      if(b->base != base)
+        continue;
+
+      PageType *&page = b->pages[(key >> PageBits) & (DirSize - 1)];
+      delete page;
+      page = NULL;
+      return;
+    }
+  }
+
+  // for ordered iteration
+  size_t numBlocks() const { return m_Blocks.size(); }
+  uint64_t blockBase(size_t b) const { return m_Blocks[b]->base; }
+  const PageType *page(size_t b, uint32_t p) const { return m_Blocks[b]->pages[p]; }
+private:
+  struct Block
+  {
+    uint64_t base;
+    PageType *pages[DirSize];
+  };
+
+  rdcarray<Block *> m_Blocks;
+};
+};
+
+// Replacement for std::unordered_map<ResourceId, T>. The paged table holds an index into a pool of
+// values, which are stored densely in fixed size chunks so that iteration doesn't have to walk the
+// whole ID range and references stay valid until the element is erased - the same guarantee as
+// std::unordered_map. Erasing during iteration is allowed, via the iterator returned from erase().
+// Iteration order is unspecified.
+template <typename T>
+class ResourceIdMap
+{
+public:
+  typedef rdcpair<ResourceId, T> value_type;
+
+  ResourceIdMap() = default;
+  ResourceIdMap(const ResourceIdMap &) = delete;
+  ResourceIdMap &operator=(const ResourceIdMap &) = delete;
+  ~ResourceIdMap() { clear(); }
+  class iterator
+  {
+  public:
+    iterator() = default;
+    value_type &operator*() const { return m_Map->element(m_Idx); }
+    value_type *operator->() const { return &m_Map->element(m_Idx); }
+    iterator &operator++()
+    {
+      m_Idx = m_Map->nextUsed(m_Idx + 1);
+      return *this;
+    }
+    bool operator==(const iterator &o) const { return m_Idx == o.m_Idx; }
+    bool operator!=(const iterator &o) const { return m_Idx != o.m_Idx; }
+  private:
+    friend class ResourceIdMap;
+    iterator(const ResourceIdMap *map, uint32_t idx) : m_Map(map), m_Idx(idx) {}
+    const ResourceIdMap *m_Map = NULL;
+    uint32_t m_Idx = 0;
+  };
+
+  iterator begin() const { return iterator(this, nextUsed(0)); }
+  iterator end() const { return iterator(this, capacity()); }
+  size_t size() const { return m_Size; }
+  bool empty() const { return m_Size == 0; }
+  iterator find(ResourceId id) const
+  {
+    const uint64_t key = ResourceIdTable::Key(id);
+    const IndexPage *page = m_Index.find(key);
+    if(page)
+    {
+      uint32_t slot = page->slots[key & (ResourceIdTable::PageSize - 1)];
+      if(slot)
+        return iterator(this, slot - 1);
+    }
+
+    return end();
+  }
+
+  T &operator[](ResourceId id)
+  {
+    const uint64_t key = ResourceIdTable::Key(id);
+    IndexPage *page = m_Index.findOrCreate(key);
+    uint32_t &slot = page->slots[key & (ResourceIdTable::PageSize - 1)];
+
+    if(slot == 0)
+    {
+      uint32_t idx = allocate();
+      element(idx).first = id;
+      slot = idx + 1;
+      page->count++;
+      m_Size++;
+    }
+
+    return element(slot - 1).second;
+  }
+
+  size_t erase(ResourceId id)
+  {
+    iterator it = find(id);
+    if(it == end())
+      return 0;
+    erase(it);
+    return 1;
+  }
+
+  // returns the iterator following the erased element
+  iterator erase(iterator it)
+  {
+    const uint32_t idx = it.m_Idx;
+    const uint64_t key = ResourceIdTable::Key(element(idx).first);
+
+    IndexPage *page = m_Index.find(key);
+    page->slots[key & (ResourceIdTable::PageSize - 1)] = 0;
+    if(--page->count == 0)
+      m_Index.release(key);
+
+    ValueChunk *chunk = m_Chunks[idx / ChunkSize];
+    chunk->values[idx % ChunkSize] = value_type();
+    chunk->used[idx % ChunkSize] = false;
+    m_Free.push_back(idx);
+    m_Size--;
+
+    return iterator(this, nextUsed(idx + 1));
+  }
+
+  void clear()
+  {
+    m_Index.clear();
+    for(ValueChunk *c : m_Chunks)
+      delete c;
+    m_Chunks.clear();
+    m_Free.clear();
+    m_Used = 0;
+    m_Size = 0;
+  }
+
+private:
+  static const uint32_t ChunkSize = 256;
+
+  struct IndexPage
+  {
+    // pool index + 1, or 0 if the ID isn't present
+    uint32_t slots[ResourceIdTable::PageSize] = {};
+    uint32_t count = 0;
+  };
+
+  struct ValueChunk
+  {
+    value_type values[ChunkSize];
+    bool used[ChunkSize] = {};
+  };
+
+  uint32_t capacity() const { return uint32_t(m_Chunks.size() * ChunkSize); }
+  value_type &element(uint32_t idx) const
+  {
+    return m_Chunks[idx / ChunkSize]->values[idx % ChunkSize];
+  }
+  uint32_t nextUsed(uint32_t idx) const
+  {
+    const uint32_t cap = capacity();
+    while(idx < cap && !m_Chunks[idx / ChunkSize]->used[idx % ChunkSize])
+      idx++;
+    return idx;
+  }
+
+  uint32_t allocate()
+  {
+    uint32_t idx;
+    if(!m_Free.empty())
+    {
+      idx = m_Free.back();
+      m_Free.pop_back();
+    }
+    else
+    {
+      if(m_Used == capacity())
+        m_Chunks.push_back(new ValueChunk);
+      idx = m_Used++;
+    }
+
+    m_Chunks[idx / ChunkSize]->used[idx % ChunkSize] = true;
+    return idx;
+  }
+
+  ResourceIdTable::Pages<IndexPage> m_Index;
+  rdcarray<ValueChunk *> m_Chunks;
+  rdcarray<uint32_t> m_Free;
+  uint32_t m_Used = 0;
+  size_t m_Size = 0;
+};
+
+// Replacement for std::set<ResourceId> and std::unordered_set<ResourceId>. Stored as a paged
+// bitset, so it iterates in ID order like std::set. Erasing during iteration is allowed, via the
+// iterator returned from erase().
+class ResourceIdSet
+{
+public:
+  ResourceIdSet() = default;
+  ResourceIdSet(const ResourceIdSet &) = delete;
+  ResourceIdSet &operator=(const ResourceIdSet &) = delete;
+
+  class iterator
+  {
+  public:
+    iterator() = default;
+    ResourceId operator*() const { return ResourceIdTable::FromKey(m_Key); }
+    iterator &operator++()
+    {
+      m_Set->advance(*this, m_Block, m_Page, m_Bit + 1);
+      return *this;
+    }
+    bool operator==(const iterator &o) const
+    {
+      return m_Block == o.m_Block && m_Page == o.m_Page && m_Bit == o.m_Bit;
+    }
+    bool operator!=(const iterator &o) const { return !(*this == o); }
+  private:
+    friend class ResourceIdSet;
+    const ResourceIdSet *m_Set = NULL;
+    size_t m_Block = 0;
+    uint32_t m_Page = 0;
+    uint32_t m_Bit = 0;
+    uint64_t m_Key = 0;
+  };
+
+  iterator begin() const
+  {
+    iterator ret;
+    ret.m_Set = this;
+    advance(ret, 0, 0, 0);
+    return ret;
+  }
+  iterator end() const
+  {
+    iterator ret;
+    ret.m_Set = this;
+    ret.m_Block = m_Pages.numBlocks();
+    return ret;
+  }
+  size_t size() const { return m_Size; }
+  bool empty() const { return m_Size == 0; }
+  bool contains(ResourceId id) const
+  {
+    const uint64_t key = ResourceIdTable::Key(id);
+    const BitPage *page = m_Pages.find(key);
+    return page && page->test(key & (ResourceIdTable::PageSize - 1));
+  }
+
+  iterator find(ResourceId id) const
+  {
+    if(!contains(id))
+      return end();
+
+    const uint64_t key = ResourceIdTable::Key(id);
+    const uint64_t base = key >> (ResourceIdTable::PageBits + ResourceIdTable::DirBits);
+
+    size_t b = 0;
+    while(m_Pages.blockBase(b) != base)
+      b++;
+
+    iterator ret;
+    ret.m_Set = this;
+    ret.m_Block = b;
+    ret.m_Page = (key >> ResourceIdTable::PageBits) & (ResourceIdTable::DirSize - 1);
+    ret.m_Bit = key & (ResourceIdTable::PageSize - 1);
+    ret.m_Key = key;
+    return ret;
+  }
+
+  // returns true if the ID was newly inserted
+  bool insert(ResourceId id)
+  {
+    const uint64_t key = ResourceIdTable::Key(id);
+    BitPage *page = m_Pages.findOrCreate(key);
+    const uint32_t bit = key & (ResourceIdTable::PageSize - 1);
+
+    if(page->test(bit))
+      return false;
+
+    page->bits[bit / 64] |= 1ULL << (bit % 64);
+    page->count++;
+    m_Size++;
+    return true;
+  }
+
+  size_t erase(ResourceId id)
+  {
+    const uint64_t key = ResourceIdTable::Key(id);
+    BitPage *page = m_Pages.find(key);
+    const uint32_t bit = key & (ResourceIdTable::PageSize - 1);
+
+    if(!page || !page->test(bit))
+      return 0;
+
+    page->bits[bit / 64] &= ~(1ULL << (bit % 64));
+    if(--page->count == 0)
+      m_Pages.release(key);
+    m_Size--;
+    return 1;
+  }
+
+  // returns the iterator following the erased element
+  iterator erase(iterator it)
+  {
+    iterator next = it;
+    ++next;
+    erase(*it);
+    return next;
+  }
+
+  void clear()
+  {
+    m_Pages.clear();
+    m_Size = 0;
+  }
+
+private:
+  struct BitPage
+  {
+    uint64_t bits[ResourceIdTable::PageSize / 64] = {};
+    uint32_t count = 0;
+
+    bool test(uint32_t bit) const { return (bits[bit / 64] & (1ULL << (bit % 64))) != 0; }
+  };
+
+  // moves the iterator to the first set bit at or after the given position
+  void advance(iterator &it, size_t b, uint32_t p, uint32_t bit) const
+  {
+    const uint32_t blockShift = ResourceIdTable::PageBits + ResourceIdTable::DirBits;
+
+    for(; b < m_Pages.numBlocks(); b++, p = 0)
+    {
+      for(; p < ResourceIdTable::DirSize; p++, bit = 0)
+      {
+        const BitPage *page = m_Pages.page(b, p);
+        if(!page)
+          continue;
+
+        for(; bit < ResourceIdTable::PageSize; bit++)
+        {
+          // skip whole empty words
+          if((bit % 64) == 0 && page->bits[bit / 64] == 0)
+          {
+            bit += 63;
+            continue;
+          }
+
+          if(page->test(bit))
+          {
+            it.m_Block = b;
+            it.m_Page = p;
+            it.m_Bit = bit;
+            it.m_Key = (m_Pages.blockBase(b) << blockShift) |
+                       (uint64_t(p) << ResourceIdTable::PageBits) | bit;
+            return;
+          }
+        }
+      }
+    }
+
+    it.m_Block = m_Pages.numBlocks();
+    it.m_Page = 0;
+    it.m_Bit = 0;
+    it.m_Key = 0;
+  }
+
+  ResourceIdTable::Pages<BitPage> m_Pages;
+  size_t m_Size = 0;
+};
@@ -0,0 +1,295 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "common/globalconfig.h"
+
+#if ENABLED(ENABLE_UNIT_TESTS)
+
+#include "resource_id_map.h"
+#include <set>
+#include <unordered_map>
+#include "common/timing.h"
+
+#include "catch/catch.hpp"
+
+static ResourceId MakeId(uint64_t num)
+{
+  return ResourceIdTable::FromKey(num);
+}
+
+// IDs from the start of the range as well as from the replay range
+static const uint64_t ReplayBase = 1000000000000000000ULL;
+
+TEST_CASE("Test ResourceIdMap", "[resourceid]")
+{
+  SECTION("Insert, find and erase")
+  {
+    ResourceIdMap<uint32_t> map;
+
+    CHECK(map.empty());
+    CHECK((map.begin() == map.end()));
+    CHECK((map.find(MakeId(5)) == map.end()));
+
+    map[MakeId(5)] = 50;
+    map[MakeId(ReplayBase + 5)] = 500;
+    map[MakeId(5000000)] = 5000;
+
+    CHECK(map.size() == 3);
+    REQUIRE((map.find(MakeId(5)) != map.end()));
+    CHECK(map.find(MakeId(5))->first == MakeId(5));
+    CHECK(map.find(MakeId(5))->second == 50);
+    CHECK(map.find(MakeId(ReplayBase + 5))->second == 500);
+    CHECK(map.find(MakeId(5000000))->second == 5000);
+    CHECK((map.find(MakeId(6)) == map.end()));
+    CHECK((map.find(MakeId(ReplayBase + 6)) == map.end()));
+
+    // references are stable as other elements are added
+    uint32_t &ref = map[MakeId(5)];
+    for(uint64_t i = 100; i < 10000; i++)
+      map[MakeId(i)] = uint32_t(i);
+    CHECK(&ref == &map[MakeId(5)]);
+    CHECK(ref == 50);
+
+    CHECK(map.erase(MakeId(5)) == 1);
+    CHECK(map.erase(MakeId(5)) == 0);
+    CHECK((map.find(MakeId(5)) == map.end()));
+    CHECK(map.size() == 2 + 9900);
+
+    // re-inserting default-initialises the value
+    CHECK(map[MakeId(5)] == 0);
+
+    map.clear();
+    CHECK(map.empty());
+    CHECK((map.begin() == map.end()));
+    CHECK((map.find(MakeId(100)) == map.end()));
+
+    map[MakeId(100)] = 1;
+    CHECK(map.size() == 1);
+    CHECK(map.begin()->second == 1);
+  };
+
+  SECTION("Matches std::unordered_map")
+  {
+    ResourceIdMap<uint64_t> map;
+    std::unordered_map<ResourceId, uint64_t> ref;
+
+    uint32_t seed = 12345;
+    auto rand = [&seed]() {
+      seed = seed * 1103515245 + 12345;
+      return seed >> 8;
+    };
+
+    for(int i = 0; i < 50000; i++)
+    {
+      uint64_t num = rand() % 20000;
+      if(rand() % 2)
+        num += ReplayBase;
+      ResourceId id = MakeId(num);
+
+      switch(rand() % 3)
+      {
+        case 0:
+        case 1:
+          map[id] = uint64_t(i);
+          ref[id] = uint64_t(i);
+          break;
+        case 2: CHECK(map.erase(id) == ref.erase(id)); break;
+      }
+    }
+
+    CHECK(map.size() == ref.size());
+
+    size_t count = 0;
+    for(auto it = map.begin(); it != map.end(); ++it)
+    {
+      auto refit = ref.find(it->first);
+      REQUIRE((refit != ref.end()));
+      CHECK(refit->second == it->second);
+      count++;
+    }
+    CHECK(count == ref.size());
+
+    // erase every other element while iterating
+    bool erase = false;
+    for(auto it = map.begin(); it != map.end();)
+    {
+      if(erase)
+      {
+        ref.erase(it->first);
+        it = map.erase(it);
+      }
+      else
+      {
+        ++it;
+      }
+      erase = !erase;
+    }
+
+    CHECK(map.size() == ref.size());
+    for(auto it = ref.begin(); it != ref.end(); ++it)
+    {
+      auto mapit = map.find(it->first);
+      REQUIRE((mapit != map.end()));
+      CHECK(mapit->second == it->second);
+    }
+  };
+};
+
+TEST_CASE("Test ResourceIdSet", "[resourceid]")
+{
+  ResourceIdSet set;
+  std::set<ResourceId> ref;
+
+  CHECK(set.empty());
+  CHECK((set.begin() == set.end()));
+
+  uint32_t seed = 54321;
+  auto rand = [&seed]() {
+    seed = seed * 1103515245 + 12345;
+    return seed >> 8;
+  };
+
+  for(int i = 0; i < 20000; i++)
+  {
+    uint64_t num = rand() % 50000;
+    if(rand() % 4 == 0)
+      num += ReplayBase;
+    ResourceId id = MakeId(num);
+
+    if(rand() % 3)
+      CHECK(set.insert(id) == ref.insert(id).second);
+    else
+      CHECK(set.erase(id) == ref.erase(id));
+  }
+
+  CHECK(set.size() == ref.size());
+
+  // iteration is in ID order, the same as std::set
+  {
+    auto it = set.begin();
+    auto refit = ref.begin();
+    for(; it != set.end() && refit != ref.end(); ++it, ++refit)
+      CHECK(*it == *refit);
+    CHECK((it == set.end()));
+    CHECK((refit == ref.end()));
+  }
+
+  for(ResourceId id : ref)
+  {
+    CHECK(set.contains(id));
+    REQUIRE((set.find(id) != set.end()));
+    CHECK(*set.find(id) == id);
+  }
+
+  CHECK_FALSE(set.contains(MakeId(60000)));
+  CHECK((set.find(MakeId(60000)) == set.end()));
+
+  // erase the odd IDs while iterating
+  for(auto it = set.begin(); it != set.end();)
+  {
+    if(ResourceIdTable::Key(*it) & 1)
+    {
+      ref.erase(*it);
+      it = set.erase(it);
+    }
+    else
+    {
+      ++it;
+    }
+  }
+
+  CHECK(set.size() == ref.size());
+  {
+    auto it = set.begin();
+    auto refit = ref.begin();
+    for(; it != set.end() && refit != ref.end(); ++it, ++refit)
+      CHECK(*it == *refit);
+    CHECK((it == set.end()));
+    CHECK((refit == ref.end()));
+  }
+
+  set.clear();
+  CHECK(set.empty());
+  CHECK((set.begin() == set.end()));
+};
+
+TEST_CASE("Benchmark ResourceIdMap against std::unordered_map", "[.][resourceid][benchmark]")
+{
+  const uint64_t count = 1000000;
+  const uint64_t lookups = 10000000;
+
+  rdcarray<ResourceId> ids;
+  ids.resize(count);
+  for(uint64_t i = 0; i < count; i++)
+    ids[i] = MakeId(i + 1);
+
+  uint32_t seed = 1;
+  rdcarray<ResourceId> lookupIds;
+  lookupIds.resize(lookups);
+  for(uint64_t i = 0; i < lookups; i++)
+  {
+    seed = seed * 1103515245 + 12345;
+    lookupIds[i] = ids[(seed >> 4) % count];
+  }
+
+  uint64_t hashSum = 0, denseSum = 0;
+
+  {
+    std::unordered_map<ResourceId, uint64_t> map;
+
+    PerformanceTimer timer;
+    for(uint64_t i = 0; i < count; i++)
+      map[ids[i]] = i;
+    double insertMs = timer.GetMilliseconds();
+
+    timer.Restart();
+    for(ResourceId id : lookupIds)
+      hashSum += map.find(id)->second;
+    double lookupMs = timer.GetMilliseconds();
+
+    RDCLOG("std::unordered_map: %.2f ms for %llu inserts, %.2f ms for %llu lookups", insertMs,
+           count, lookupMs, lookups);
+  }
+
+  {
+    ResourceIdMap<uint64_t> map;
+
+    PerformanceTimer timer;
+    for(uint64_t i = 0; i < count; i++)
+      map[ids[i]] = i;
+    double insertMs = timer.GetMilliseconds();
+
+    timer.Restart();
+    for(ResourceId id : lookupIds)
+      denseSum += map.find(id)->second;
+    double lookupMs = timer.GetMilliseconds();
+
+    RDCLOG("ResourceIdMap: %.2f ms for %llu inserts, %.2f ms for %llu lookups", insertMs, count,
+           lookupMs, lookups);
+  }
+
+  CHECK(hashSum == denseSum);
+};
+
+#endif    // ENABLED(ENABLE_UNIT_TESTS)
@@ -230,3 +230,84 @@ void ResourceRecord::Delete(ResourceRecordHandler *mgr)
       (*it)->Delete(mgr);
   }
 }
+
+#if ENABLED(ENABLE_UNIT_TESTS)
+
+#include "catch/catch.hpp"
+
+TEST_CASE("Check record chunk merge matches map ordering", "[resourcemanager]")
+{
+  WriteSerialiser ser(new StreamWriter(StreamWriter::DefaultScratchSize), Ownership::Stream);
+
+  uint32_t chunkIdx = 0;
+  auto makeChunk = [&ser, &chunkIdx]() {
+    ser.WriteChunk(1);
+    ser.Serialise("idx"_lit, chunkIdx);
+    ser.EndChunk();
+    chunkIdx++;
+    return Chunk::Create(ser, 1);
+  };
+
+  ResourceRecord a(ResourceIDGen::GetNewUniqueID(), false);
+  ResourceRecord b(ResourceIDGen::GetNewUniqueID(), false);
+  ResourceRecord c(ResourceIDGen::GetNewUniqueID(), false);
+  ResourceRecord parent(ResourceIDGen::GetNewUniqueID(), false);
+  ResourceRecord empty(ResourceIDGen::GetNewUniqueID(), false);
+  ResourceRecord written(ResourceIDGen::GetNewUniqueID(), false);
+
+  ResourceRecord *records[] = {&a, &b, &c, &parent, &empty, &written};
+
+  // interleave chunks between records, so each list is sorted but they overlap
+  for(int i = 0; i < 50; i++)
+  {
+    a.AddChunk(makeChunk());
+    if(i % 3 == 0)
+      b.AddChunk(makeChunk());
+    if(i % 7 == 0)
+      parent.AddChunk(makeChunk());
+    written.AddChunk(makeChunk());
+  }
+
+  // c has out of order IDs, as if chunks were recorded concurrently
+  int64_t base = a.GetLastChunkID();
+  c.AddChunk(makeChunk(), base + 1000);
+  c.AddChunk(makeChunk(), base + 10);
+  c.AddChunk(makeChunk(), base + 500);
+  c.AddChunk(makeChunk(), base + 20);
+
+  a.AddParent(&parent);
+  b.AddParent(&parent);
+  written.DataWritten = true;
+
+  std::map<int64_t, Chunk *> expected;
+  for(ResourceRecord *r : {&a, &b, &c, &written})
+    r->Insert(expected);
+
+  // reset for the merge
+  for(ResourceRecord *r : records)
+    r->DataWritten = false;
+  written.DataWritten = true;
+
+  RecordChunkMerge merge;
+  for(ResourceRecord *r : {&a, &b, &c, &written})
+    r->Insert(merge);
+
+  CHECK(merge.NumChunks() == expected.size());
+
+  rdcarray<Chunk *> actual;
+  for(Chunk *chunk = merge.Next(); chunk; chunk = merge.Next())
+    actual.push_back(chunk);
+
+  REQUIRE(actual.size() == expected.size());
+
+  size_t i = 0;
+  for(auto it = expected.begin(); it != expected.end(); ++it, ++i)
+    CHECK(actual[i] == it->second);
+
+  CHECK(merge.Next() == NULL);
+
+  for(ResourceRecord *r : records)
+    r->DeleteChunks();
+}
+
+#endif    // ENABLED(ENABLE_UNIT_TESTS)
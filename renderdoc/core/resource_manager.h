@@ -34,6 +34,8 @@
 #include "api/replay/resourceid.h"
 #include "common/threading.h"
 #include "core/core.h"
+#include "core/resource_id_map.h"
+#include "core/sharded_wrapper_map.h"
 #include "os/os_specific.h"
 #include "serialise/serialiser.h"
 
@@ -266,9 +268,9 @@ inline InitReqType InitReq(FrameRefType refType, InitPolicy policy, bool initial
 }
 
 // handle marking a resource referenced for read or write and storing RAW access etc.
-template <typename Compose>
-bool MarkReferenced(std::unordered_map<ResourceId, FrameRefType> &refs, ResourceId id,
-                    FrameRefType refType, Compose comp)
+// RefMap is a std::unordered_map or ResourceIdMap of ResourceId to FrameRefType
+template <typename RefMap, typename Compose>
+bool MarkReferenced(RefMap &refs, ResourceId id, FrameRefType refType, Compose comp)
 {
   auto refit = refs.find(id);
   if(refit == refs.end())
@@ -283,8 +285,8 @@ bool MarkReferenced(std::unordered_map<ResourceId, FrameRefType> &refs, Resource
   return false;
 }
 
-inline bool MarkReferenced(std::unordered_map<ResourceId, FrameRefType> &refs, ResourceId id,
-                           FrameRefType refType)
+template <typename RefMap>
+inline bool MarkReferenced(RefMap &refs, ResourceId id, FrameRefType refType)
 {
   return MarkReferenced(refs, id, refType, ComposeFrameRefs);
 }
@@ -300,6 +302,7 @@ void SetReplayResourceIDs();
 };
 
 struct ResourceRecord;
+class RecordChunkMerge;
 
 class ResourceRecordHandler
 {
@@ -391,6 +394,8 @@ struct ResourceRecord
         recordlist[it->id] = it->chunk;
     }
   }
+  // as above, but adds the chunks to a merge instead of sorting them into a map
+  inline void Insert(RecordChunkMerge &merge);
 
   void AddRef() { Atomic::Inc32(&RefCount); }
   int GetRefCount() const { return RefCount; }
@@ -500,6 +505,8 @@ struct ResourceRecord
   bool DataWritten;
 
 protected:
+  friend class RecordChunkMerge;
+
   int32_t RefCount;
 
   byte *DataPtr;
@@ -537,6 +544,120 @@ protected:
   std::unordered_map<ResourceId, FrameRefType> m_FrameRefs;
 };
 
+// Merges the chunks of a set of records into a single stream in chunk ID order - the same order as
+// inserting them all into a map keyed by ID - without allocating anything per chunk.
+//
+// Each record's chunks are stored in the order they were added, which is already ID order except
+// when chunks are added to the same record concurrently. Those lists are rare, so their chunks are
+// gathered and sorted together. We then do a k-way merge with a min-heap holding the next chunk
+// from each list.
+//
+// The records must not be modified until iteration is complete.
+class RecordChunkMerge
+{
+public:
+  // adds the chunks stored in a record, called by ResourceRecord::Insert
+  void AddChunks(const ResourceRecord *record)
+  {
+    const ResourceRecord::StoredChunk *begin = record->m_Chunks.begin();
+    const ResourceRecord::StoredChunk *end = record->m_Chunks.end();
+
+    if(begin == end)
+      return;
+
+    m_NumChunks += end - begin;
+
+    for(const ResourceRecord::StoredChunk *c = begin + 1; c != end; ++c)
+    {
+      if(c->id < (c - 1)->id)
+      {
+        m_Unsorted.append(begin, end - begin);
+        return;
+      }
+    }
+
+    m_Heap.push_back({begin, end});
+  }
+
+  size_t NumChunks() const { return m_NumChunks; }
+
+  // returns the next chunk in ID order, or NULL when all chunks have been returned. Once iteration
+  // has started no more records can be added
+  Chunk *Next()
+  {
+    if(!m_Started)
+      Start();
+
+    if(m_Heap.empty())
+      return NULL;
+
+    // the source with the lowest ID is at the front. Move it to the back, advance it, and re-insert
+    // it into the heap unless it's exhausted.
+    std::pop_heap(m_Heap.begin(), m_Heap.end(), Source::Later);
+
+    Source &src = m_Heap.back();
+    Chunk *ret = src.cur->chunk;
+    src.cur++;
+
+    if(src.cur == src.end)
+      m_Heap.pop_back();
+    else
+      std::push_heap(m_Heap.begin(), m_Heap.end(), Source::Later);
+
+    return ret;
+  }
+
+private:
+  void Start()
+  {
+    m_Started = true;
+
+    if(!m_Unsorted.empty())
+    {
+      std::sort(m_Unsorted.begin(), m_Unsorted.end(),
+                [](const ResourceRecord::StoredChunk &a, const ResourceRecord::StoredChunk &b) {
+                  return a.id < b.id;
+                });
+      m_Heap.push_back({m_Unsorted.begin(), m_Unsorted.end()});
+    }
+
+    std::make_heap(m_Heap.begin(), m_Heap.end(), Source::Later);
+  }
+
+  struct Source
+  {
+    const ResourceRecord::StoredChunk *cur;
+    const ResourceRecord::StoredChunk *end;
+
+    // the heap functions build a max-heap, so order by which source is later to get the earliest
+    // chunk at the front
+    static bool Later(const Source &a, const Source &b) { return a.cur->id > b.cur->id; }
+  };
+
+  rdcarray<Source> m_Heap;
+  rdcarray<ResourceRecord::StoredChunk> m_Unsorted;
+  size_t m_NumChunks = 0;
+  bool m_Started = false;
+};
+
+void ResourceRecord::Insert(RecordChunkMerge &merge)
+{
+  bool dataWritten = DataWritten;
+
+  DataWritten = true;
+
+  for(auto it = Parents.begin(); it != Parents.end(); ++it)
+  {
+    if(!(*it)->DataWritten)
+    {
+      (*it)->Insert(merge);
+    }
+  }
+
+  if(!dataWritten)
+    merge.AddChunks(this);
+}
+
 template <typename Compose>
 bool ResourceRecord::MarkResourceFrameReferenced(ResourceId id, FrameRefType refType, Compose comp)
 {
@@ -717,18 +838,19 @@ protected:
   // we only need to lock during capturing, on replay we have single threaded access.
   bool m_Capturing;
 
-  // easy optimisation win - don't use maps everywhere. It's convenient but not optimal, and
-  // profiling will likely prove that some or all of these could be a problem
+  // maps and sets keyed by ResourceId use the dense paged tables from resource_id_map.h, since IDs
+  // are allocated sequentially.
 
   // used during capture - map from real resource to its wrapper (other way can be done just with an
-  // Unwrap)
-  std::map<RealResourceType, WrappedResourceType> m_WrapperMap;
+  // Unwrap). This is looked up from every thread making API calls so it has its own sharded locks
+  // and is not protected by m_Lock.
+  ShardedWrapperMap<RealResourceType, WrappedResourceType> m_WrapperMap;
 
   // used during capture - holds resources referenced in current frame (and how they're referenced)
-  std::unordered_map<ResourceId, FrameRefType> m_FrameReferencedResources;
+  ResourceIdMap<FrameRefType> m_FrameReferencedResources;
 
   // used during capture - holds resources marked as dirty, needing initial contents
-  std::set<ResourceId> m_DirtyResources;
+  ResourceIdSet m_DirtyResources;
 
   struct InitialContentStorage
   {
@@ -750,34 +872,34 @@ protected:
   };
 
   // used during capture or replay - holds initial contents
-  std::unordered_map<ResourceId, InitialContentStorage> m_InitialContents;
+  ResourceIdMap<InitialContentStorage> m_InitialContents;
 
   // used during capture or replay - map of resources currently alive with their real IDs, used in
   // capture and replay.
-  std::unordered_map<ResourceId, WrappedResourceType> m_CurrentResourceMap;
+  ResourceIdMap<WrappedResourceType> m_CurrentResourceMap;
 
   // used during replay - maps back and forth from original id to live id and vice-versa
-  std::unordered_map<ResourceId, ResourceId> m_OriginalIDs, m_LiveIDs;
+  ResourceIdMap<ResourceId> m_OriginalIDs, m_LiveIDs;
 
   // used during replay - holds resources allocated and the original id that they represent
-  std::unordered_map<ResourceId, WrappedResourceType> m_LiveResourceMap;
+  ResourceIdMap<WrappedResourceType> m_LiveResourceMap;
 
   // used during capture - holds resource records by id.
-  std::unordered_map<ResourceId, RecordType *> m_ResourceRecords;
+  ResourceIdMap<RecordType *> m_ResourceRecords;
   Threading::RWLock m_ResourceRecordLock;
 
   // used during replay - holds current resource replacements
   // replaced -> replacement
-  std::unordered_map<ResourceId, ResourceId> m_Replacements;
+  ResourceIdMap<ResourceId> m_Replacements;
   // replacement -> replaced (for looking up original IDs)
-  std::unordered_map<ResourceId, ResourceId> m_Replaced;
+  ResourceIdMap<ResourceId> m_Replaced;
 
   // During initial resources preparation, persistent resources are
   // postponed until serializing to RDC file.
-  std::unordered_set<ResourceId> m_PostponedResourceIDs;
+  ResourceIdSet m_PostponedResourceIDs;
   // During initial resources preparation, resources that are completely written
   // over are skipped
-  std::unordered_set<ResourceId> m_SkippedResourceIDs;
+  ResourceIdSet m_SkippedResourceIDs;
 
   struct ResourceRefTimes
   {
@@ -925,11 +1047,19 @@ template <typename Compose>
 void ResourceManager<Configuration>::MarkResourceFrameReferenced(ResourceId id,
                                                                  FrameRefType refType, Compose comp)
 {
-  SCOPED_LOCK_OPTIONAL(m_Lock, m_Capturing);
-
   if(id == ResourceId())
     return;
 
+  // outside of a capture only writes are tracked, to age out persistent and skippable resources.
+  // Reads are the bulk of references so they can return without contending on the lock. The state
+  // is changed by the capturing thread so it's loaded atomically here, without the lock
+  RDCCOMPILE_ASSERT(sizeof(CaptureState) == sizeof(int32_t), "CaptureState must be 32-bit");
+  const CaptureState state = (CaptureState)Atomic::Load32((const int32_t *)&m_State);
+  if(IsBackgroundCapturing(state) && !IsDirtyFrameRef(refType))
+    return;
+
+  SCOPED_LOCK_OPTIONAL(m_Lock, m_Capturing);
+
   if(IsActiveCapturing(m_State))
   {
     SkipOrPostponeOrPrepare_InitialState(id, refType);
@@ -1779,8 +1909,6 @@ void ResourceManager<Configuration>::DestroyResourceRecord(ResourceRecord *recor
 template <typename Configuration>
 bool ResourceManager<Configuration>::AddWrapper(WrappedResourceType wrap, RealResourceType real)
 {
-  SCOPED_LOCK_OPTIONAL(m_Lock, m_Capturing);
-
   bool ret = true;
 
   if(wrap == (WrappedResourceType)RecordType::NullResource ||
@@ -1790,60 +1918,52 @@ bool ResourceManager<Configuration>::AddWrapper(WrappedResourceType wrap, RealRe
     ret = false;
   }
 
-  if(m_WrapperMap[real] != (WrappedResourceType)RecordType::NullResource)
+  if(m_WrapperMap.Exchange(real, wrap, (WrappedResourceType)RecordType::NullResource) !=
+     (WrappedResourceType)RecordType::NullResource)
   {
     RDCERR("Overriding wrapper for resource");
     ret = false;
   }
 
-  m_WrapperMap[real] = wrap;
-
   return ret;
 }
 
 template <typename Configuration>
 void ResourceManager<Configuration>::RemoveWrapper(RealResourceType real)
 {
-  SCOPED_LOCK_OPTIONAL(m_Lock, m_Capturing);
-
-  if(real == (RealResourceType)RecordType::NullResource || !HasWrapper(real))
+  if(real == (RealResourceType)RecordType::NullResource || !m_WrapperMap.Erase(real))
   {
     RDCERR(
         "Invalid state removing resource wrapper - real resource is NULL or doesn't have wrapper");
-    return;
   }
-
-  m_WrapperMap.erase(m_WrapperMap.find(real));
 }
 
 template <typename Configuration>
 bool ResourceManager<Configuration>::HasWrapper(RealResourceType real)
 {
-  SCOPED_LOCK_OPTIONAL(m_Lock, m_Capturing);
-
   if(real == (RealResourceType)RecordType::NullResource)
     return false;
 
-  return (m_WrapperMap.find(real) != m_WrapperMap.end());
+  return m_WrapperMap.Contains(real);
 }
 
 template <typename Configuration>
 typename Configuration::WrappedResourceType ResourceManager<Configuration>::GetWrapper(
     RealResourceType real)
 {
-  SCOPED_LOCK_OPTIONAL(m_Lock, m_Capturing);
-
   if(real == (RealResourceType)RecordType::NullResource)
     return (WrappedResourceType)RecordType::NullResource;
 
-  if(real != (RealResourceType)RecordType::NullResource && !HasWrapper(real))
+  WrappedResourceType ret = m_WrapperMap.Find(real, (WrappedResourceType)RecordType::NullResource);
+
+  if(ret == (WrappedResourceType)RecordType::NullResource)
   {
     RDCERR(
         "Invalid state removing resource wrapper - real resource isn't NULL and doesn't have "
         "wrapper");
   }
 
-  return m_WrapperMap[real];
+  return ret;
 }
 
 template <typename Configuration>
@@ -0,0 +1,173 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+#include <map>
+#include "api/replay/rdcarray.h"
+#include "api/replay/rdcpair.h"
+#include "common/threading.h"
+
+// hash used to pick a shard for a real resource handle. Pointer handles are covered here, drivers
+// with other handle types provide an overload next to the type so it's found by argument-dependent
+// lookup.
+template <typename T>
+inline uint64_t WrapperShardHash(T *ptr)
+{
+  return (uint64_t)(uintptr_t)ptr;
+}
+
+// A map from real API handles to their wrappers that can be safely used from many threads at once.
+//
+// Lookups from real to wrapped handles happen on almost every API call that returns or takes a
+// handle, so with a single lock applications that create and look up objects from many threads
+// serialise on it. Instead the map is split into shards selected by a hash of the handle, each with
+// its own read-write lock, so threads only contend when they touch handles in the same shard and
+// lookups in the same shard can still happen concurrently.
+//
+// Each shard is a std::map, so handle types only need operator< and a WrapperShardHash overload.
+template <typename RealType, typename WrappedType>
+class ShardedWrapperMap
+{
+public:
+  ShardedWrapperMap() = default;
+  ShardedWrapperMap(const ShardedWrapperMap &) = delete;
+  ShardedWrapperMap &operator=(const ShardedWrapperMap &) = delete;
+
+  // sets the wrapper for a handle, returning the previous wrapper or defaultValue if there wasn't
+  // one
+  WrappedType Exchange(const RealType &real, WrappedType wrap, WrappedType defaultValue)
+  {
+    Shard &shard = GetShard(real);
+    SCOPED_WRITELOCK(shard.lock);
+
+    auto it = shard.map.find(real);
+    if(it == shard.map.end())
+    {
+      shard.map.insert(it, {real, wrap});
+      return defaultValue;
+    }
+
+    WrappedType ret = it->second;
+    it->second = wrap;
+    return ret;
+  }
+
+  // returns the wrapper for a handle or defaultValue if there isn't one
+  WrappedType Find(const RealType &real, WrappedType defaultValue) const
+  {
+    const Shard &shard = GetShard(real);
+    SCOPED_READLOCK(shard.lock);
+
+    auto it = shard.map.find(real);
+    if(it == shard.map.end())
+      return defaultValue;
+    return it->second;
+  }
+
+  bool Contains(const RealType &real) const
+  {
+    const Shard &shard = GetShard(real);
+    SCOPED_READLOCK(shard.lock);
+
+    return shard.map.find(real) != shard.map.end();
+  }
+
+  // returns true if the handle was present
+  bool Erase(const RealType &real)
+  {
+    Shard &shard = GetShard(real);
+    SCOPED_WRITELOCK(shard.lock);
+
+    return shard.map.erase(real) > 0;
+  }
+
+  // removes every entry that passes the predicate and appends it to out. Each shard is locked in
+  // turn, so this is safe against concurrent access but not atomic across the whole map.
+  template <typename Predicate>
+  void ExtractIf(Predicate pred, rdcarray<rdcpair<RealType, WrappedType>> &out)
+  {
+    for(Shard &shard : m_Shards)
+    {
+      SCOPED_WRITELOCK(shard.lock);
+
+      for(auto it = shard.map.begin(); it != shard.map.end();)
+      {
+        if(pred(it->first, it->second))
+        {
+          out.push_back({it->first, it->second});
+          it = shard.map.erase(it);
+          continue;
+        }
+
+        ++it;
+      }
+    }
+  }
+
+  size_t size() const
+  {
+    size_t ret = 0;
+    for(const Shard &shard : m_Shards)
+    {
+      SCOPED_READLOCK(shard.lock);
+      ret += shard.map.size();
+    }
+    return ret;
+  }
+
+  bool empty() const { return size() == 0; }
+  void clear()
+  {
+    for(Shard &shard : m_Shards)
+    {
+      SCOPED_WRITELOCK(shard.lock);
+      shard.map.clear();
+    }
+  }
+
+private:
+  static const uint32_t ShardBits = 5;
+  static const uint32_t NumShards = 1U << ShardBits;
+
+  struct Shard
+  {
+    mutable Threading::RWLock lock;
+    std::map<RealType, WrappedType> map;
+    // keep neighbouring shards' locks off the same cache line
+    byte padding[64];
+  };
+
+  Shard &GetShard(const RealType &real) { return m_Shards[ShardIndex(real)]; }
+  const Shard &GetShard(const RealType &real) const { return m_Shards[ShardIndex(real)]; }
+  static uint32_t ShardIndex(const RealType &real)
+  {
+    // handles are usually aligned pointers or small sequential integers, so mix all of the bits
+    // into the top ones and use those
+    return uint32_t((WrapperShardHash(real) * 0x9E3779B97F4A7C15ULL) >> (64 - ShardBits));
+  }
+
+  Shard m_Shards[NumShards];
+};
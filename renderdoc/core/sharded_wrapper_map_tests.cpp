@@ -0,0 +1,221 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "common/globalconfig.h"
+
+#if ENABLED(ENABLE_UNIT_TESTS)
+
+#include "sharded_wrapper_map.h"
+#include "common/timing.h"
+#include "os/os_specific.h"
+
+#include "catch/catch.hpp"
+
+// fake handles, spaced like allocations
+static void *RealHandle(uint64_t i)
+{
+  return (void *)(uintptr_t)(0x10000 + i * 64);
+}
+
+static void *WrappedHandle(uint64_t i)
+{
+  return (void *)(uintptr_t)(0x80000000ULL + i * 64);
+}
+
+TEST_CASE("Test ShardedWrapperMap", "[wrappermap]")
+{
+  ShardedWrapperMap<void *, void *> map;
+
+  SECTION("Basic operations")
+  {
+    CHECK(map.empty());
+    CHECK(map.Find(RealHandle(1), NULL) == NULL);
+    CHECK_FALSE(map.Contains(RealHandle(1)));
+
+    for(uint64_t i = 0; i < 1000; i++)
+      CHECK(map.Exchange(RealHandle(i), WrappedHandle(i), NULL) == NULL);
+
+    CHECK(map.size() == 1000);
+
+    for(uint64_t i = 0; i < 1000; i++)
+    {
+      CHECK(map.Contains(RealHandle(i)));
+      CHECK(map.Find(RealHandle(i), NULL) == WrappedHandle(i));
+    }
+
+    // overriding returns the previous wrapper
+    CHECK(map.Exchange(RealHandle(5), WrappedHandle(6), NULL) == WrappedHandle(5));
+    CHECK(map.Find(RealHandle(5), NULL) == WrappedHandle(6));
+
+    CHECK(map.Erase(RealHandle(5)));
+    CHECK_FALSE(map.Erase(RealHandle(5)));
+    CHECK_FALSE(map.Contains(RealHandle(5)));
+    CHECK(map.size() == 999);
+
+    rdcarray<rdcpair<void *, void *>> extracted;
+    map.ExtractIf([](void *real, void *) { return real >= RealHandle(900); }, extracted);
+
+    CHECK(extracted.size() == 100);
+    CHECK(map.size() == 899);
+    for(const rdcpair<void *, void *> &e : extracted)
+    {
+      CHECK(e.first >= RealHandle(900));
+      CHECK_FALSE(map.Contains(e.first));
+    }
+
+    map.clear();
+    CHECK(map.empty());
+  };
+
+  SECTION("Concurrent add, lookup and remove")
+  {
+    const uint32_t numThreads = 16;
+    const uint64_t perThread = 2000;
+    const uint64_t shared = 1000;
+
+    // handles that every thread looks up and that never change
+    for(uint64_t i = 0; i < shared; i++)
+      map.Exchange(RealHandle(i), WrappedHandle(i), NULL);
+
+    int32_t errors = 0;
+
+    rdcarray<Threading::ThreadHandle> threads;
+    for(uint32_t t = 0; t < numThreads; t++)
+    {
+      threads.push_back(Threading::CreateThread([&map, &errors, t, perThread, shared]() {
+        const uint64_t base = shared + t * perThread;
+
+        for(int pass = 0; pass < 4; pass++)
+        {
+          for(uint64_t i = 0; i < perThread; i++)
+          {
+            if(map.Exchange(RealHandle(base + i), WrappedHandle(base + i), NULL) != NULL)
+              Atomic::Inc32(&errors);
+
+            uint64_t s = (i * 7 + t) % shared;
+            if(map.Find(RealHandle(s), NULL) != WrappedHandle(s))
+              Atomic::Inc32(&errors);
+          }
+
+          for(uint64_t i = 0; i < perThread; i++)
+          {
+            if(map.Find(RealHandle(base + i), NULL) != WrappedHandle(base + i))
+              Atomic::Inc32(&errors);
+          }
+
+          // remove all but the last pass' handles
+          if(pass < 3)
+          {
+            for(uint64_t i = 0; i < perThread; i++)
+            {
+              if(!map.Erase(RealHandle(base + i)))
+                Atomic::Inc32(&errors);
+            }
+          }
+        }
+      }));
+    }
+
+    for(Threading::ThreadHandle th : threads)
+    {
+      Threading::JoinThread(th);
+      Threading::CloseThread(th);
+    }
+
+    CHECK(errors == 0);
+    CHECK(map.size() == shared + numThreads * perThread);
+
+    for(uint64_t i = 0; i < shared + numThreads * perThread; i++)
+      CHECK(map.Find(RealHandle(i), NULL) == WrappedHandle(i));
+  };
+};
+
+TEST_CASE("Benchmark ShardedWrapperMap lookup throughput", "[.][wrappermap][benchmark]")
+{
+  const uint64_t numHandles = 100000;
+  const uint64_t lookupsPerThread = 2000000;
+
+  ShardedWrapperMap<void *, void *> sharded;
+  std::map<void *, void *> single;
+  Threading::CriticalSection singleLock;
+
+  for(uint64_t i = 0; i < numHandles; i++)
+  {
+    sharded.Exchange(RealHandle(i), WrappedHandle(i), NULL);
+    single[RealHandle(i)] = WrappedHandle(i);
+  }
+
+  for(uint32_t numThreads : {1U, 4U, 16U})
+  {
+    for(int useSharded = 0; useSharded < 2; useSharded++)
+    {
+      int32_t errors = 0;
+
+      PerformanceTimer timer;
+
+      rdcarray<Threading::ThreadHandle> threads;
+      for(uint32_t t = 0; t < numThreads; t++)
+      {
+        threads.push_back(Threading::CreateThread([&, t]() {
+          uint32_t seed = t + 1;
+          for(uint64_t l = 0; l < lookupsPerThread; l++)
+          {
+            seed = seed * 1103515245 + 12345;
+            uint64_t i = (seed >> 8) % numHandles;
+
+            void *wrapped;
+            if(useSharded)
+            {
+              wrapped = sharded.Find(RealHandle(i), NULL);
+            }
+            else
+            {
+              SCOPED_LOCK(singleLock);
+              wrapped = single[RealHandle(i)];
+            }
+
+            if(wrapped != WrappedHandle(i))
+              Atomic::Inc32(&errors);
+          }
+        }));
+      }
+
+      for(Threading::ThreadHandle th : threads)
+      {
+        Threading::JoinThread(th);
+        Threading::CloseThread(th);
+      }
+
+      double ms = timer.GetMilliseconds();
+
+      CHECK(errors == 0);
+
+      RDCLOG("%s, %u threads: %.2f ms, %.1f million lookups/sec",
+             useSharded ? "sharded" : "single lock", numThreads, ms,
+             double(lookupsPerThread * numThreads) / (ms * 1000.0));
+    }
+  }
+};
+
+#endif    // ENABLED(ENABLE_UNIT_TESTS)
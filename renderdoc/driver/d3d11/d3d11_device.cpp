@@ -1353,6 +1353,7 @@ RDResult WrappedID3D11Device::ReadLogInitialisation(RDCFile *rdc, bool storeStru
   ser.SetUserData(GetResourceManager());
 
   ser.ConfigureStructuredExport(&GetChunkName, storeStructuredBuffers, m_TimeBase, m_TimeFrequency);
+  ser.GetStructuredFile().UseArena();
 
   m_StructuredFile = &ser.GetStructuredFile();
 
@@ -2245,12 +2246,12 @@ bool WrappedID3D11Device::EndFrameCapture(DeviceOwnedWindow devWnd)
     {
       SectionProperties props;
 
-      // Compress with LZ4 so that it's fast
-      props.flags = SectionFlags::LZ4Compressed;
+      // Compress with LZ4 so that it's fast, and index the blocks so tools can seek within it
+      props.flags = SectionFlags::LZ4Compressed | SectionFlags::BlockIndexed;
       props.version = m_SectionVersion;
       props.type = SectionType::FrameCapture;
 
-      captureWriter = rdc->WriteSection(props);
+      captureWriter = RenderDoc::Inst().WriteCaptureSection(rdc, props);
     }
     else
     {
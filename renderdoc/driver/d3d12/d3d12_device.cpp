@@ -3080,12 +3080,12 @@ bool WrappedID3D12Device::EndFrameCapture(DeviceOwnedWindow devWnd)
   {
     SectionProperties props;
 
-    // Compress with LZ4 so that it's fast
-    props.flags = SectionFlags::LZ4Compressed;
+    // Compress with LZ4 so that it's fast, and index the blocks so tools can seek within it
+    props.flags = SectionFlags::LZ4Compressed | SectionFlags::BlockIndexed;
     props.version = m_SectionVersion;
     props.type = SectionType::FrameCapture;
 
-    captureWriter = rdc->WriteSection(props);
+    captureWriter = RenderDoc::Inst().WriteCaptureSection(rdc, props);
   }
   else
   {
@@ -3136,7 +3136,7 @@ bool WrappedID3D12Device::EndFrameCapture(DeviceOwnedWindow devWnd)
     // in capframe (the transition is thread-protected) so nothing will be
     // pushed to the vector
 
-    std::map<int64_t, Chunk *> recordlist;
+    RecordChunkMerge recordlist;
 
     for(auto it = queues.begin(); it != queues.end(); ++it)
     {
@@ -3149,14 +3149,14 @@ bool WrappedID3D12Device::EndFrameCapture(DeviceOwnedWindow devWnd)
 
       for(size_t i = 0; i < cmdListRecords.size(); i++)
       {
-        uint32_t prevSize = (uint32_t)recordlist.size();
+        uint32_t prevSize = (uint32_t)recordlist.NumChunks();
         cmdListRecords[i]->Insert(recordlist);
 
         // prevent complaints in release that prevSize is unused
         (void)prevSize;
 
         RDCDEBUG("Adding %u chunks to file serialiser from command list %s",
-                 (uint32_t)recordlist.size() - prevSize,
+                 (uint32_t)recordlist.NumChunks() - prevSize,
                  ToStr(cmdListRecords[i]->GetResourceID()).c_str());
       }
 
@@ -3166,16 +3166,17 @@ bool WrappedID3D12Device::EndFrameCapture(DeviceOwnedWindow devWnd)
     m_FrameCaptureRecord->Insert(recordlist);
 
     RDCDEBUG("Flushing %u chunks to file serialiser from context record",
-             (uint32_t)recordlist.size());
+             (uint32_t)recordlist.NumChunks());
 
-    float num = float(recordlist.size());
+    float num = float(recordlist.NumChunks());
     float idx = 0.0f;
 
-    for(auto it = recordlist.begin(); it != recordlist.end(); ++it)
+    // stream the chunks out in ID order, merged from each record's list
+    for(Chunk *chunk = recordlist.Next(); chunk; chunk = recordlist.Next())
     {
       RenderDoc::Inst().SetProgress(CaptureProgress::SerialiseFrameContents, idx / num);
       idx += 1.0f;
-      it->second->Write(ser);
+      chunk->Write(ser);
     }
 
     RDCDEBUG("Done");
@@ -3205,7 +3206,7 @@ bool WrappedID3D12Device::EndFrameCapture(DeviceOwnedWindow devWnd)
         props.version = 1;
         props.type = SectionType::D3D12Core;
 
-        captureWriter = rdc->WriteSection(props);
+        captureWriter = RenderDoc::Inst().WriteCaptureSection(rdc, props);
 
         captureWriter->Write(buf.data(), buf.size());
 
@@ -3229,7 +3230,7 @@ bool WrappedID3D12Device::EndFrameCapture(DeviceOwnedWindow devWnd)
         props.version = 1;
         props.type = SectionType::D3D12SDKLayers;
 
-        captureWriter = rdc->WriteSection(props);
+        captureWriter = RenderDoc::Inst().WriteCaptureSection(rdc, props);
 
         captureWriter->Write(buf.data(), buf.size());
 
@@ -5209,6 +5210,7 @@ RDResult WrappedID3D12Device::ReadLogInitialisation(RDCFile *rdc, bool storeStru
   ser.SetUserData(GetResourceManager());
 
   ser.ConfigureStructuredExport(&GetChunkName, storeStructuredBuffers, m_TimeBase, m_TimeFrequency);
+  ser.GetStructuredFile().UseArena();
 
   m_StructuredFile = &ser.GetStructuredFile();
 
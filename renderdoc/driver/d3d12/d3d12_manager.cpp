@@ -3638,21 +3638,15 @@ bool D3D12GpuBufferAllocator::D3D12GpuBufferResource::CreateBufferResource(
 
 void D3D12ResourceManager::ResolveDeferredWrappers()
 {
-  rdcarray<ID3D12DeviceChild *> wrappers;
-  for(auto it = m_WrapperMap.begin(); it != m_WrapperMap.end();)
-  {
-    if((uint64_t)it->first >= m_DummyHandle)
-    {
-      wrappers.push_back(it->second);
-      it = m_WrapperMap.erase(it);
-      continue;
-    }
-
-    ++it;
-  }
-
-  for(ID3D12DeviceChild *wrapper : wrappers)
-    AddWrapper(wrapper, Unwrap(wrapper));
+  rdcarray<rdcpair<ID3D12DeviceChild *, ID3D12DeviceChild *>> wrappers;
+  m_WrapperMap.ExtractIf(
+      [this](ID3D12DeviceChild *real, ID3D12DeviceChild *) {
+        return (uint64_t)real >= m_DummyHandle;
+      },
+      wrappers);
+
+  for(const rdcpair<ID3D12DeviceChild *, ID3D12DeviceChild *> &wrapper : wrappers)
+    AddWrapper(wrapper.second, Unwrap(wrapper.second));
 }
 
 void D3D12ResourceManager::ApplyBarriers(BarrierSet &barriers,
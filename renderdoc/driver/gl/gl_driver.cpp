@@ -2347,12 +2347,12 @@ bool WrappedOpenGL::EndFrameCapture(DeviceOwnedWindow devWnd)
     {
       SectionProperties props;
 
-      // Compress with LZ4 so that it's fast
-      props.flags = SectionFlags::LZ4Compressed;
+      // Compress with LZ4 so that it's fast, and index the blocks so tools can seek within it
+      props.flags = SectionFlags::LZ4Compressed | SectionFlags::BlockIndexed;
       props.version = m_SectionVersion;
       props.type = SectionType::FrameCapture;
 
-      captureWriter = rdc->WriteSection(props);
+      captureWriter = RenderDoc::Inst().WriteCaptureSection(rdc, props);
     }
     else
     {
@@ -3414,6 +3414,7 @@ RDResult WrappedOpenGL::ReadLogInitialisation(RDCFile *rdc, bool storeStructured
   ser.SetUserData(GetResourceManager());
 
   ser.ConfigureStructuredExport(&GetChunkName, storeStructuredBuffers, m_TimeBase, m_TimeFrequency);
+  ser.GetStructuredFile().UseArena();
 
   m_StructuredFile = &ser.GetStructuredFile();
 
@@ -154,6 +154,12 @@ struct GLResource
 
 DECLARE_REFLECTION_STRUCT(GLResource);
 
+// used to pick a shard in the resource manager's wrapper map
+inline uint64_t WrapperShardHash(const GLResource &res)
+{
+  return (uint64_t)(uintptr_t)res.ContextShareGroup ^ ((uint64_t)res.Namespace << 32) ^ res.name;
+}
+
 struct ContextPair
 {
   void *ctx;
@@ -423,7 +423,7 @@ bool WrappedOpenGL::Serialise_glNamedBufferStorageEXT(SerialiserType &ser, GLuin
   SERIALISE_ELEMENT_LOCAL(buffer, BufferRes(GetCtx(), bufferHandle));
 
   SERIALISE_ELEMENT_LOCAL(bytesize, (uint64_t)size);
-  SERIALISE_ELEMENT_ARRAY(data, bytesize);
+  SERIALISE_ELEMENT_ARRAY_NOCOPY(data, bytesize);
 
   if(ser.IsWriting())
   {
@@ -575,7 +575,7 @@ bool WrappedOpenGL::Serialise_glNamedBufferDataEXT(SerialiserType &ser, GLuint b
   SERIALISE_ELEMENT_LOCAL(buffer, BufferRes(GetCtx(), bufferHandle));
 
   SERIALISE_ELEMENT_LOCAL(bytesize, (uint64_t)size);
-  SERIALISE_ELEMENT_ARRAY(data, bytesize);
+  SERIALISE_ELEMENT_ARRAY_NOCOPY(data, bytesize);
 
   if(ser.IsWriting())
   {
@@ -961,7 +961,7 @@ bool WrappedOpenGL::Serialise_glNamedBufferSubDataEXT(SerialiserType &ser, GLuin
   SERIALISE_ELEMENT_LOCAL(offset, (uint64_t)offsetPtr).OffsetOrSize();
 
   SERIALISE_ELEMENT_LOCAL(bytesize, (uint64_t)size).OffsetOrSize();
-  SERIALISE_ELEMENT_ARRAY(data, bytesize).Important();
+  SERIALISE_ELEMENT_ARRAY_NOCOPY(data, bytesize).Important();
 
   SERIALISE_CHECK_READ_ERRORS();
 
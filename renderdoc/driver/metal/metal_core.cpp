@@ -672,12 +672,12 @@ bool WrappedMTLDevice::EndFrameCapture(DeviceOwnedWindow devWnd)
   {
     SectionProperties props;
 
-    // Compress with LZ4 so that it's fast
-    props.flags = SectionFlags::LZ4Compressed;
+    // Compress with LZ4 so that it's fast, and index the blocks so tools can seek within it
+    props.flags = SectionFlags::LZ4Compressed | SectionFlags::BlockIndexed;
     props.version = m_SectionVersion;
     props.type = SectionType::FrameCapture;
 
-    captureWriter = rdc->WriteSection(props);
+    captureWriter = RenderDoc::Inst().WriteCaptureSection(rdc, props);
   }
   else
   {
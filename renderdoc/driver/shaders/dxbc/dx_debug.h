@@ -29,15 +29,15 @@
 
 namespace DXBC
 {
-enum ResourceRetType;
+enum ResourceRetType : uint8_t;
 enum class InterpolationMode : uint8_t;
 class DXBCContainer;
 };
 
 namespace DXBCBytecode
 {
-enum ResourceDimension;
-enum SamplerMode;
+enum ResourceDimension : uint8_t;
+enum SamplerMode : uint8_t;
 };
 
 namespace DXDebug
@@ -27,7 +27,7 @@
 #include "api/replay/rdcarray.h"
 #include "api/replay/rdcstr.h"
 #include "common/common.h"
-#include "driver/dx/official/d3dcommon.h"
+#include "driver/shaders/dxbc/dxbc_d3dcommon.h"
 #include "dxbc_common.h"
 
 namespace DXBC
@@ -523,7 +523,7 @@ enum MinimumPrecision : uint8_t
   NUM_PRECISIONS,
 };
 
-enum SamplerMode
+enum SamplerMode : uint8_t
 {
   SAMPLER_MODE_DEFAULT = 0,
   SAMPLER_MODE_COMPARISON,
@@ -1152,8 +1152,6 @@ public:
   static D3D_PRIMITIVE_TOPOLOGY GetOutputTopology(const byte *bytes, size_t length);
 
 protected:
-  friend class Program;
-
   Program(const rdcarray<uint32_t> &words);
   void DecodeProgram();
   rdcarray<uint32_t> EncodeProgram();
@@ -0,0 +1,96 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2025 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "common/common.h"
+#include "dxbc_common.h"
+
+namespace DXBC
+{
+rdcstr BasicDemangle(const rdcstr &possiblyMangledName)
+{
+  if(possiblyMangledName.size() > 2 && possiblyMangledName[0] == '\x1' &&
+     possiblyMangledName[1] == '?')
+  {
+    int idx = possiblyMangledName.indexOf('@');
+    if(idx > 2)
+      return possiblyMangledName.substr(2, idx - 2);
+  }
+
+  return possiblyMangledName;
+}
+
+ShaderStage GetShaderStage(ShaderType type)
+{
+  switch(type)
+  {
+    case DXBC::ShaderType::Pixel: return ShaderStage::Pixel;
+    case DXBC::ShaderType::Vertex: return ShaderStage::Vertex;
+    case DXBC::ShaderType::Geometry: return ShaderStage::Geometry;
+    case DXBC::ShaderType::Hull: return ShaderStage::Hull;
+    case DXBC::ShaderType::Domain: return ShaderStage::Domain;
+    case DXBC::ShaderType::Compute: return ShaderStage::Compute;
+    case DXBC::ShaderType::Amplification: return ShaderStage::Amplification;
+    case DXBC::ShaderType::Mesh: return ShaderStage::Mesh;
+    case DXBC::ShaderType::RayGeneration: return ShaderStage::RayGen;
+    case DXBC::ShaderType::Intersection: return ShaderStage::Intersection;
+    case DXBC::ShaderType::AnyHit: return ShaderStage::AnyHit;
+    case DXBC::ShaderType::ClosestHit: return ShaderStage::ClosestHit;
+    case DXBC::ShaderType::Miss: return ShaderStage::Miss;
+    case DXBC::ShaderType::Callable: return ShaderStage::Callable;
+    default: RDCERR("Unexpected DXBC shader type %u", type); return ShaderStage::Vertex;
+  }
+}
+
+// DXIL wonderfully provides us with offsets that are completely useless/pointless for structured
+// buffers. We need to recalculate them now based on tight packing
+void RecalculateScalarOffsetsSizes(CBufferVariableType &type)
+{
+  uint32_t offset = 0;
+  uint32_t pendingOffsetIncr = 0;
+  uint32_t lastBitfieldOffset = 0;
+  for(DXBC::CBufferVariable &var : type.members)
+  {
+    // if we encounter a non-bitfield, or the offset goes backwards, apply the 'real' offset now
+    if(var.bitFieldSize == 0 || var.bitFieldOffset < lastBitfieldOffset)
+    {
+      offset += pendingOffsetIncr;
+      pendingOffsetIncr = 0;
+    }
+
+    var.offset = offset;
+
+    // all bitfields share the same offset, which will be incremented at the next bitfield boundary (above)
+    if(var.bitFieldSize > 0)
+    {
+      pendingOffsetIncr = var.type.bytesize;
+      lastBitfieldOffset = var.bitFieldOffset + var.bitFieldSize;
+      continue;
+    }
+
+    offset += var.type.rows * var.type.cols * VarTypeByteSize(var.type.varType) * var.type.elements;
+
+    RecalculateScalarOffsetsSizes(var.type);
+  }
+}
+};
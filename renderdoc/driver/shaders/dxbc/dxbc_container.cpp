@@ -200,19 +200,6 @@ void ResetSearchDirsCache()
   cachedDebugFilesLookup.clear();
 }
 
-rdcstr BasicDemangle(const rdcstr &possiblyMangledName)
-{
-  if(possiblyMangledName.size() > 2 && possiblyMangledName[0] == '\x1' &&
-     possiblyMangledName[1] == '?')
-  {
-    int idx = possiblyMangledName.indexOf('@');
-    if(idx > 2)
-      return possiblyMangledName.substr(2, idx - 2);
-  }
-
-  return possiblyMangledName;
-}
-
 struct RDEFCBufferVariable
 {
   uint32_t nameOffset;
@@ -467,60 +454,6 @@ ShaderBuiltin GetSystemValue(SVSemantic systemValue)
   return ShaderBuiltin::Undefined;
 }
 
-ShaderStage GetShaderStage(ShaderType type)
-{
-  switch(type)
-  {
-    case DXBC::ShaderType::Pixel: return ShaderStage::Pixel;
-    case DXBC::ShaderType::Vertex: return ShaderStage::Vertex;
-    case DXBC::ShaderType::Geometry: return ShaderStage::Geometry;
-    case DXBC::ShaderType::Hull: return ShaderStage::Hull;
-    case DXBC::ShaderType::Domain: return ShaderStage::Domain;
-    case DXBC::ShaderType::Compute: return ShaderStage::Compute;
-    case DXBC::ShaderType::Amplification: return ShaderStage::Amplification;
-    case DXBC::ShaderType::Mesh: return ShaderStage::Mesh;
-    case DXBC::ShaderType::RayGeneration: return ShaderStage::RayGen;
-    case DXBC::ShaderType::Intersection: return ShaderStage::Intersection;
-    case DXBC::ShaderType::AnyHit: return ShaderStage::AnyHit;
-    case DXBC::ShaderType::ClosestHit: return ShaderStage::ClosestHit;
-    case DXBC::ShaderType::Miss: return ShaderStage::Miss;
-    case DXBC::ShaderType::Callable: return ShaderStage::Callable;
-    default: RDCERR("Unexpected DXBC shader type %u", type); return ShaderStage::Vertex;
-  }
-}
-
-// DXIL wonderfully provides us with offsets that are completely useless/pointless for structured
-// buffers. We need to recalculate them now based on tight packing
-void RecalculateScalarOffsetsSizes(CBufferVariableType &type)
-{
-  uint32_t offset = 0;
-  uint32_t pendingOffsetIncr = 0;
-  uint32_t lastBitfieldOffset = 0;
-  for(DXBC::CBufferVariable &var : type.members)
-  {
-    // if we encounter a non-bitfield, or the offset goes backwards, apply the 'real' offset now
-    if(var.bitFieldSize == 0 || var.bitFieldOffset < lastBitfieldOffset)
-    {
-      offset += pendingOffsetIncr;
-      pendingOffsetIncr = 0;
-    }
-
-    var.offset = offset;
-
-    // all bitfields share the same offset, which will be incremented at the next bitfield boundary (above)
-    if(var.bitFieldSize > 0)
-    {
-      pendingOffsetIncr = var.type.bytesize;
-      lastBitfieldOffset = var.bitFieldOffset + var.bitFieldSize;
-      continue;
-    }
-
-    offset += var.type.rows * var.type.cols * VarTypeByteSize(var.type.varType) * var.type.elements;
-
-    RecalculateScalarOffsetsSizes(var.type);
-  }
-}
-
 rdcstr TypeName(CBufferVariableType desc)
 {
   rdcstr ret;
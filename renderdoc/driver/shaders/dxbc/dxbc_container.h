@@ -31,7 +31,7 @@
 #include "api/replay/rdcpair.h"
 #include "api/replay/rdcstr.h"
 #include "common/common.h"
-#include "driver/dx/official/d3dcommon.h"
+#include "driver/shaders/dxbc/dxbc_d3dcommon.h"
 #include "dxbc_common.h"
 
 namespace DXBC
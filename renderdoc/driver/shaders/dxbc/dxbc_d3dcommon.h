@@ -0,0 +1,66 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2025 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#pragma once
+
+#include "common/globalconfig.h"
+
+// the DXBC and DXIL parsers only need a couple of enums from d3dcommon.h. The official header
+// pulls in rpc.h and windows.h, so on other platforms we declare them with the same values.
+#if ENABLED(RDOC_WIN32)
+
+#include "driver/dx/official/d3dcommon.h"
+
+#else
+
+enum D3D_PRIMITIVE_TOPOLOGY
+{
+  D3D_PRIMITIVE_TOPOLOGY_UNDEFINED = 0,
+  D3D_PRIMITIVE_TOPOLOGY_POINTLIST = 1,
+  D3D_PRIMITIVE_TOPOLOGY_LINELIST = 2,
+  D3D_PRIMITIVE_TOPOLOGY_LINESTRIP = 3,
+  D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST = 4,
+  D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP = 5,
+  D3D_PRIMITIVE_TOPOLOGY_TRIANGLEFAN = 6,
+  D3D_PRIMITIVE_TOPOLOGY_LINELIST_ADJ = 10,
+  D3D_PRIMITIVE_TOPOLOGY_LINESTRIP_ADJ = 11,
+  D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST_ADJ = 12,
+  D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP_ADJ = 13,
+  D3D_PRIMITIVE_TOPOLOGY_1_CONTROL_POINT_PATCHLIST = 33,
+  D3D_PRIMITIVE_TOPOLOGY_32_CONTROL_POINT_PATCHLIST = 64,
+};
+
+enum D3D_INTERPOLATION_MODE
+{
+  D3D_INTERPOLATION_UNDEFINED = 0,
+  D3D_INTERPOLATION_CONSTANT = 1,
+  D3D_INTERPOLATION_LINEAR = 2,
+  D3D_INTERPOLATION_LINEAR_CENTROID = 3,
+  D3D_INTERPOLATION_LINEAR_NOPERSPECTIVE = 4,
+  D3D_INTERPOLATION_LINEAR_NOPERSPECTIVE_CENTROID = 5,
+  D3D_INTERPOLATION_LINEAR_SAMPLE = 6,
+  D3D_INTERPOLATION_LINEAR_NOPERSPECTIVE_SAMPLE = 7,
+};
+
+#endif
@@ -334,1874 +334,1879 @@ void Program::ParseConstant(ValueList &values, const LLVMBC::BlockOrRecord &cons
   }
 }
 
+// the state while decoding the module. Records arrive one at a time from the bitcode reader, so
+// anything that spans several records - which blocks we're in, the function being parsed, a
+// pending struct or metadata name - is tracked here.
+struct Program::ParseState : public LLVMBC::BitcodeVisitor
+{
+  ParseState(Program &prog) : prog(prog), values(prog.alloc), metadata(prog.alloc) {}
+
+  void EnterBlock(uint32_t id, uint32_t blockDwordLength) override;
+  void Record(const LLVMBC::BlockOrRecord &record) override;
+  void ExitBlock(uint32_t id) override;
+
+  Program &prog;
+
+  ValueList values;
+  MetadataList metadata;
+
+  rdcarray<size_t> functionDecls;
+
+  // the blocks we're currently inside, starting with MODULE_BLOCK
+  rdcarray<KnownBlock> blocks;
+  // if non-zero, the depth of an unexpected block whose contents are ignored
+  size_t skipDepth = 0;
+  // set when the module can't be parsed any further
+  bool unsupported = false;
+
+  // TYPE_BLOCK
+  rdcstr structname;
+
+  // METADATA_BLOCK
+  size_t nextMeta = 0;
+  NamedMetadata *namedMeta = NULL;
+
+  // FUNCTION_BLOCK
+  Function *func = NULL;
+  size_t curBlock = 0;
+  int32_t debugLocIndex = -1;
+};
+
+void Program::ParseState::EnterBlock(uint32_t id, uint32_t blockDwordLength)
+{
+  blocks.push_back(KnownBlock(id));
+
+  if(skipDepth > 0 || unsupported)
+    return;
+
+  if(blocks.size() == 1)
+  {
+    // the top-level block should be MODULE_BLOCK
+    RDCASSERT(KnownBlock(id) == KnownBlock::MODULE_BLOCK);
+  }
+  else if(blocks.size() == 2)
+  {
+    switch(KnownBlock(id))
+    {
+      // do nothing, this is internal parse data
+      case KnownBlock::BLOCKINFO: skipDepth = blocks.size(); break;
+      case KnownBlock::PARAMATTR_GROUP_BLOCK:
+      case KnownBlock::PARAMATTR_BLOCK:
+      case KnownBlock::TYPE_BLOCK:
+      case KnownBlock::VALUE_SYMTAB_BLOCK: break;
+      case KnownBlock::CONSTANTS_BLOCK: prog.m_CurParseType = NULL; break;
+      case KnownBlock::METADATA_BLOCK:
+        nextMeta = 0;
+        namedMeta = NULL;
+        break;
+      case KnownBlock::FUNCTION_BLOCK: prog.BeginFunctionBlock(*this); break;
+      default:
+        RDCERR("Unknown block ID %u encountered at module scope", id);
+        skipDepth = blocks.size();
+        break;
+    }
+  }
+  else if(blocks.size() == 3 && blocks[1] == KnownBlock::FUNCTION_BLOCK)
+  {
+    switch(KnownBlock(id))
+    {
+      case KnownBlock::CONSTANTS_BLOCK: prog.m_CurParseType = NULL; break;
+      case KnownBlock::METADATA_BLOCK: nextMeta = metadata.size(); break;
+      case KnownBlock::VALUE_SYMTAB_BLOCK:
+      case KnownBlock::METADATA_ATTACHMENT: break;
+      case KnownBlock::USELIST_BLOCK: prog.m_Uselists = true; break;
+      default:
+        RDCERR("Unexpected subblock %u in FUNCTION_BLOCK", id);
+        skipDepth = blocks.size();
+        break;
+    }
+  }
+  else
+  {
+    RDCERR("Unexpected subblock %u in block %u", id, blocks[blocks.size() - 2]);
+    skipDepth = blocks.size();
+  }
+}
+
+void Program::ParseState::Record(const LLVMBC::BlockOrRecord &record)
+{
+  if(skipDepth > 0 || unsupported)
+    return;
+
+  if(blocks.size() == 1)
+  {
+    unsupported = !prog.ParseModuleRecord(*this, record);
+  }
+  else if(blocks.size() == 2)
+  {
+    switch(blocks.back())
+    {
+      case KnownBlock::PARAMATTR_GROUP_BLOCK: prog.ParseAttributeGroup(record); break;
+      case KnownBlock::PARAMATTR_BLOCK: prog.ParseAttributeSet(record); break;
+      case KnownBlock::TYPE_BLOCK: prog.ParseType(*this, record); break;
+      case KnownBlock::CONSTANTS_BLOCK: prog.ParseConstant(values, record); break;
+      case KnownBlock::VALUE_SYMTAB_BLOCK: prog.ParseSymtabEntry(*this, record); break;
+      case KnownBlock::METADATA_BLOCK: prog.ParseMetadata(*this, record); break;
+      case KnownBlock::FUNCTION_BLOCK: prog.ParseFunctionRecord(*this, record); break;
+      default: break;
+    }
+  }
+  else
+  {
+    // only blocks inside a FUNCTION_BLOCK get here, any others are skipped
+    switch(blocks.back())
+    {
+      case KnownBlock::CONSTANTS_BLOCK: prog.ParseConstant(values, record); break;
+      case KnownBlock::METADATA_BLOCK: prog.ParseFunctionMetadata(*this, record); break;
+      case KnownBlock::VALUE_SYMTAB_BLOCK: prog.ParseFunctionSymtabEntry(*this, record); break;
+      case KnownBlock::METADATA_ATTACHMENT: prog.ParseMetadataAttachment(*this, record); break;
+      case KnownBlock::USELIST_BLOCK: prog.ParseUselist(*this, record); break;
+      default: break;
+    }
+  }
+}
+
+void Program::ParseState::ExitBlock(uint32_t id)
+{
+  if(skipDepth == blocks.size())
+    skipDepth = 0;
+  else if(skipDepth == 0 && !unsupported && blocks.size() == 2 &&
+          KnownBlock(id) == KnownBlock::FUNCTION_BLOCK)
+    prog.EndFunctionBlock(*this);
+
+  blocks.pop_back();
+}
+
 Program::Program(const byte *bytes, size_t length) : alloc(32 * 1024)
 {
   const byte *ptr = bytes;
   const ProgramHeader *header = (const ProgramHeader *)ptr;
   RDCASSERT(header->DxilMagic == MAKE_FOURCC('D', 'X', 'I', 'L'));
 
-  m_Bytes.assign(bytes, length);
+  m_Bytes.assign(bytes, length);
+
+  const byte *bitcode = ((const byte *)&header->DxilMagic) + header->BitcodeOffset;
+  RDCASSERT(bitcode + header->BitcodeSize <= ptr + length);
+
+  m_Type = DXBC::ShaderType(header->ProgramType);
+  m_Major = (header->ProgramVersion & 0xf0) >> 4;
+  m_Minor = header->ProgramVersion & 0xf;
+  m_DXILVersion = header->DxilVersion;
+
+  // Input signature and Output signature haven't changed.
+  // Pipeline Runtime Information we have decoded just not implemented here
+
+  ParseState state(*this);
+
+  // records are parsed as they're decoded rather than building the whole module's tree first
+  LLVMBC::BitcodeReader reader(bitcode, header->BitcodeSize);
+  reader.VisitToplevelBlock(state);
+
+  // we should have consumed all bits, only one top-level block
+  RDCASSERT(reader.AtEndOfStream());
+
+  // pointer fixups. This is only needed for global variabls as it has forward references to
+  // constants before we can even reserve the constants.
+  for(GlobalVar *g : m_GlobalVars)
+  {
+    if(g->initialiser)
+    {
+      size_t idx = g->initialiser - (Constant *)NULL;
+      g->initialiser = cast<Constant>(state.values[idx - 1]);
+    }
+  }
+
+  RDCASSERT(state.functionDecls.empty());
+}
+
+bool Program::ParseModuleRecord(ParseState &state, const LLVMBC::BlockOrRecord &rootchild)
+{
+  ValueList &values = state.values;
+
+  if(IS_KNOWN(rootchild.id, ModuleRecord::VERSION))
+  {
+    if(rootchild.ops[0] != 1)
+    {
+      RDCERR("Unsupported LLVM bitcode version %u", rootchild.ops[0]);
+      return false;
+    }
+  }
+  else if(IS_KNOWN(rootchild.id, ModuleRecord::TRIPLE))
+  {
+    m_Triple = rootchild.getString();
+  }
+  else if(IS_KNOWN(rootchild.id, ModuleRecord::DATALAYOUT))
+  {
+    m_Datalayout = rootchild.getString();
+  }
+  else if(IS_KNOWN(rootchild.id, ModuleRecord::GLOBALVAR))
+  {
+    // [pointer type, isconst, initid, linkage, alignment, section, visibility, threadlocal,
+    // unnamed_addr, externally_initialized, dllstorageclass, comdat]
+    GlobalVar *g = values.nextValue<GlobalVar>();
+
+    g->type = m_Types[(size_t)rootchild.ops[0]];
+    if(rootchild.ops[1] & 0x1)
+      g->flags |= GlobalFlags::IsConst;
+
+    Type::PointerAddrSpace addrSpace = g->type->addrSpace;
+    if(rootchild.ops[1] & 0x2)
+      addrSpace = Type::PointerAddrSpace(rootchild.ops[1] >> 2);
+
+    if(rootchild.ops[2])
+      g->initialiser += rootchild.ops[2];
+
+    switch(rootchild.ops[3])
+    {
+      case 0: g->flags |= GlobalFlags::ExternalLinkage; break;
+      case 16: g->flags |= GlobalFlags::WeakAnyLinkage; break;
+      case 2: g->flags |= GlobalFlags::AppendingLinkage; break;
+      case 3: g->flags |= GlobalFlags::InternalLinkage; break;
+      case 18: g->flags |= GlobalFlags::LinkOnceAnyLinkage; break;
+      case 7: g->flags |= GlobalFlags::ExternalWeakLinkage; break;
+      case 8: g->flags |= GlobalFlags::CommonLinkage; break;
+      case 9: g->flags |= GlobalFlags::PrivateLinkage; break;
+      case 17: g->flags |= GlobalFlags::WeakODRLinkage; break;
+      case 19: g->flags |= GlobalFlags::LinkOnceODRLinkage; break;
+      case 12: g->flags |= GlobalFlags::AvailableExternallyLinkage; break;
+      default: break;
+    }
+
+    g->align = (1ULL << rootchild.ops[4]) >> 1;
+
+    g->section = int32_t(rootchild.ops[5]) - 1;
+
+    if(rootchild.ops.size() > 6)
+    {
+      RDCASSERTMSG("global has non-default visibility", rootchild.ops[6] == 0);
+    }
+
+    if(rootchild.ops.size() > 7)
+    {
+      RDCASSERTMSG("global has non-default TLS mode", rootchild.ops[7] == 0);
+    }
+
+    if(rootchild.ops.size() > 8)
+    {
+      if(rootchild.ops[8] == 1)
+        g->flags |= GlobalFlags::GlobalUnnamedAddr;
+      else if(rootchild.ops[8] == 2)
+        g->flags |= GlobalFlags::LocalUnnamedAddr;
+    }
+
+    if(rootchild.ops.size() > 9)
+    {
+      if(rootchild.ops[9])
+        g->flags |= GlobalFlags::ExternallyInitialised;
+    }
+
+    if(rootchild.ops.size() > 10)
+    {
+      RDCASSERTMSG("global has non-default DLL storage class", rootchild.ops[10] == 0);
+    }
+
+    if(rootchild.ops.size() > 11)
+    {
+      // assume no comdat
+      RDCASSERTMSG("global has comdat", rootchild.ops[11] == 0);
+    }
+
+    g->type = GetPointerType(g->type, addrSpace);
+
+    m_GlobalVars.push_back(g);
+    values.addValue();
+  }
+  else if(IS_KNOWN(rootchild.id, ModuleRecord::FUNCTION))
+  {
+    // [type, callingconv, isproto, linkage, paramattrs, alignment, section, visibility, gc,
+    // unnamed_addr, prologuedata, dllstorageclass, comdat, prefixdata]
+    Function *f = new(alloc) Function;
+
+    f->type = m_Types[(size_t)rootchild.ops[0]];
+    // ignore callingconv
+    RDCASSERTMSG("Calling convention is non-default", rootchild.ops[1] == 0);
+    f->external = (rootchild.ops[2] != 0);
+    // ignore linkage
+    if(rootchild.ops[3] == 3)
+      f->internalLinkage = true;
+    else
+      RDCASSERTMSG("Linkage is non-default and not internal", rootchild.ops[3] == 0,
+                   rootchild.ops[3]);
+    if(rootchild.ops[4] > 0 && rootchild.ops[4] - 1 < m_AttributeSets.size())
+      f->attrs = m_AttributeSets[(size_t)rootchild.ops[4] - 1];
+
+    f->align = rootchild.ops[5];
+
+    // ignore rest of properties, assert that if present they are 0
+    for(size_t p = 6; p < rootchild.ops.size(); p++)
+    {
+      // 12, if present, is the comdat index
+      if(p == 12 && rootchild.ops[p] > 0)
+      {
+        RDCASSERT(rootchild.ops[p] - 1 < m_Comdats.size(), rootchild.ops[p], m_Comdats.size());
+        f->comdatIdx = uint32_t(rootchild.ops[p] - 1);
+        continue;
+      }
+
+      RDCASSERT(rootchild.ops[p] == 0, p, rootchild.ops[p]);
+    }
+
+    if(!f->external)
+      state.functionDecls.push_back(m_Functions.size());
+
+    m_Functions.push_back(f);
+    values.addValue(f);
+  }
+  else if(IS_KNOWN(rootchild.id, ModuleRecord::ALIAS))
+  {
+    // [alias type, aliasee val#, linkage, visibility]
+    Alias *a = values.nextValue<Alias>();
+
+    a->type = m_Types[(size_t)rootchild.ops[0]];
+    a->val = values[(size_t)rootchild.ops[1]];
+
+    // ignore rest of properties, assert that if present they are 0
+    for(size_t p = 2; p < rootchild.ops.size(); p++)
+      RDCASSERT(rootchild.ops[p] == 0, p, rootchild.ops[p]);
+
+    m_Aliases.push_back(a);
+    values.addValue();
+  }
+  else if(IS_KNOWN(rootchild.id, ModuleRecord::SECTIONNAME))
+  {
+    m_Sections.push_back(rootchild.getString(0));
+  }
+  else if(IS_KNOWN(rootchild.id, ModuleRecord::COMDAT))
+  {
+    // can ignore the length for now, it's implicit anyway as there's nothing after the string
+    m_Comdats.push_back({rootchild.ops[0], rootchild.getString(2)});
+  }
+  else
+  {
+    RDCERR("Unknown record ID %u encountered at module scope", rootchild.id);
+  }
+
+  return true;
+}
+
+void Program::ParseAttributeGroup(const LLVMBC::BlockOrRecord &attrgroup)
+{
+  if(!IS_KNOWN(attrgroup.id, ParamAttrGroupRecord::ENTRY))
+  {
+    RDCERR("Unexpected attribute group record ID %u", attrgroup.id);
+    return;
+  }
+
+  AttributeGroup *group = alloc.alloc<AttributeGroup>();
+
+  size_t id = (size_t)attrgroup.ops[0];
+  group->slotIndex = (uint32_t)attrgroup.ops[1];
+
+  for(size_t i = 2; i < attrgroup.ops.size(); i++)
+  {
+    switch(attrgroup.ops[i])
+    {
+      case 0:
+      {
+        group->params |= Attribute(1ULL << (attrgroup.ops[i + 1]));
+        i++;
+        break;
+      }
+      case 1:
+      {
+        uint64_t param = attrgroup.ops[i + 2];
+        Attribute attr = Attribute(1ULL << attrgroup.ops[i + 1]);
+        group->params |= attr;
+        switch(attr)
+        {
+          case Attribute::Alignment: group->align = param; break;
+          case Attribute::StackAlignment: group->stackAlign = param; break;
+          case Attribute::Dereferenceable: group->derefBytes = param; break;
+          case Attribute::DereferenceableOrNull: group->derefOrNullBytes = param; break;
+          default: RDCERR("Unexpected attribute %llu with parameter", attr);
+        }
+        i += 2;
+        break;
+      }
+      default:
+      {
+        rdcstr a, b;
+
+        a = attrgroup.getString(i + 1);
+        a.resize(strlen(a.c_str()));
+
+        if(attrgroup.ops[i] == 4)
+        {
+          b = attrgroup.getString(i + 1 + a.size() + 1);
+          b.resize(strlen(b.c_str()));
+          i += a.size() + b.size() + 2;
+        }
+        else
+        {
+          i += a.size() + 1;
+        }
+
+        group->strs.push_back({a, b});
+        break;
+      }
+    }
+  }
+
+  m_AttributeGroups.resize_for_index(id);
+  m_AttributeGroups[id] = group;
+}
+
+void Program::ParseAttributeSet(const LLVMBC::BlockOrRecord &paramattr)
+{
+  if(!IS_KNOWN(paramattr.id, ParamAttrRecord::ENTRY))
+  {
+    RDCERR("Unexpected attribute record ID %u", paramattr.id);
+    return;
+  }
+
+  AttributeSet *attrs = alloc.alloc<AttributeSet>();
+
+  attrs->orderedGroups = paramattr.ops;
+
+  for(uint64_t g : paramattr.ops)
+  {
+    if(g < m_AttributeGroups.size())
+    {
+      const AttributeGroup *group = m_AttributeGroups[(size_t)g];
+      if(group->slotIndex == AttributeGroup::FunctionSlot)
+      {
+        RDCASSERT(attrs->functionSlot == NULL);
+        attrs->functionSlot = group;
+      }
+      else
+      {
+        attrs->groupSlots.resize_for_index(group->slotIndex);
+        attrs->groupSlots[group->slotIndex] = group;
+      }
+    }
+    else
+    {
+      RDCERR("Attribute refers to out of bounds group %llu", g);
+    }
+  }
+
+  m_AttributeSets.push_back(attrs);
+}
+
+void Program::ParseType(ParseState &state, const LLVMBC::BlockOrRecord &typ)
+{
+  rdcstr &structname = state.structname;
+
+  if(IS_KNOWN(typ.id, TypeRecord::NUMENTRY))
+  {
+    RDCASSERT(m_Types.size() < (size_t)typ.ops[0], m_Types.size(), typ.ops[0]);
+    m_Types.reserve((size_t)typ.ops[0]);
+  }
+  else if(IS_KNOWN(typ.id, TypeRecord::VOID))
+  {
+    Type *newType = new(alloc) Type;
+    newType->type = Type::Scalar;
+    newType->scalarType = Type::Void;
+
+    m_Types.push_back(newType);
+    m_VoidType = newType;
+  }
+  else if(IS_KNOWN(typ.id, TypeRecord::LABEL))
+  {
+    Type *newType = new(alloc) Type;
+    newType->type = Type::Label;
+
+    m_Types.push_back(newType);
+    m_LabelType = newType;
+  }
+  else if(IS_KNOWN(typ.id, TypeRecord::METADATA))
+  {
+    Type *newType = new(alloc) Type;
+    newType->type = Type::Metadata;
+
+    m_Types.push_back(newType);
+    m_MetaType = newType;
+  }
+  else if(IS_KNOWN(typ.id, TypeRecord::HALF))
+  {
+    Type *newType = new(alloc) Type;
+    newType->type = Type::Scalar;
+    newType->scalarType = Type::Float;
+    newType->bitWidth = 16;
+
+    m_Types.push_back(newType);
+  }
+  else if(IS_KNOWN(typ.id, TypeRecord::FLOAT))
+  {
+    Type *newType = new(alloc) Type;
+    newType->type = Type::Scalar;
+    newType->scalarType = Type::Float;
+    newType->bitWidth = 32;
+
+    m_Types.push_back(newType);
+  }
+  else if(IS_KNOWN(typ.id, TypeRecord::DOUBLE))
+  {
+    Type *newType = new(alloc) Type;
+    newType->type = Type::Scalar;
+    newType->scalarType = Type::Float;
+    newType->bitWidth = 64;
+
+    m_Types.push_back(newType);
+  }
+  else if(IS_KNOWN(typ.id, TypeRecord::INTEGER))
+  {
+    Type *newType = new(alloc) Type;
+    newType->type = Type::Scalar;
+    newType->scalarType = Type::Int;
+    newType->bitWidth = typ.ops[0] & 0xffffffff;
+
+    m_Types.push_back(newType);
+    if(newType->bitWidth == 1)
+      m_BoolType = newType;
+    else if(newType->bitWidth == 8)
+      m_Int8Type = newType;
+    else if(newType->bitWidth == 32)
+      m_Int32Type = newType;
+  }
+  else if(IS_KNOWN(typ.id, TypeRecord::VECTOR))
+  {
+    Type *newType = new(alloc) Type;
+    newType->type = Type::Vector;
+    newType->elemCount = typ.ops[0] & 0xffffffff;
+    newType->inner = m_Types[(size_t)typ.ops[1]];
+
+    // copy properties out of the inner for convenience
+    newType->scalarType = newType->inner->scalarType;
+    newType->bitWidth = newType->inner->bitWidth;
+
+    m_Types.push_back(newType);
+  }
+  else if(IS_KNOWN(typ.id, TypeRecord::ARRAY))
+  {
+    Type *newType = new(alloc) Type;
+    newType->type = Type::Array;
+    newType->elemCount = typ.ops[0] & 0xffffffff;
+    newType->inner = m_Types[(size_t)typ.ops[1]];
+
+    m_Types.push_back(newType);
+  }
+  else if(IS_KNOWN(typ.id, TypeRecord::POINTER))
+  {
+    Type *newType = new(alloc) Type;
+    newType->type = Type::Pointer;
+    newType->inner = m_Types[(size_t)typ.ops[0]];
+    newType->addrSpace = Type::PointerAddrSpace(typ.ops[1]);
+
+    m_Types.push_back(newType);
+  }
+  else if(IS_KNOWN(typ.id, TypeRecord::OPAQUE))
+  {
+    Type *newType = new(alloc) Type;
+    // pretend opaque types are empty structs
+    newType->type = Type::Struct;
+    newType->opaque = true;
+
+    m_Types.push_back(newType);
+  }
+  else if(IS_KNOWN(typ.id, TypeRecord::STRUCT_NAME))
+  {
+    structname = typ.getString(0);
+  }
+  else if(IS_KNOWN(typ.id, TypeRecord::STRUCT_ANON) || IS_KNOWN(typ.id, TypeRecord::STRUCT_NAMED))
+  {
+    Type *newType = new(alloc) Type;
+    newType->type = Type::Struct;
+    newType->packedStruct = (typ.ops[0] != 0);
+
+    for(size_t o = 1; o < typ.ops.size(); o++)
+      newType->members.push_back(m_Types[(size_t)typ.ops[o]]);
+
+    if(IS_KNOWN(typ.id, TypeRecord::STRUCT_NAMED))
+    {
+      // may we want a reverse map name -> type? probably not, this is only relevant for
+      // disassembly or linking and disassembly we can do just by iterating all types
+      newType->name = structname;
+      structname.clear();
+    }
+
+    m_Types.push_back(newType);
+  }
+  else if(IS_KNOWN(typ.id, TypeRecord::FUNCTION_OLD) || IS_KNOWN(typ.id, TypeRecord::FUNCTION))
+  {
+    Type *newType = new(alloc) Type;
+    newType->type = Type::Function;
+
+    newType->vararg = (typ.ops[0] != 0);
+
+    size_t o = 1;
+
+    // skip attrid
+    if(IS_KNOWN(typ.id, TypeRecord::FUNCTION_OLD))
+      o++;
+
+    // return type
+    newType->inner = m_Types[(size_t)typ.ops[o]];
+    o++;
+
+    for(; o < typ.ops.size(); o++)
+      newType->members.push_back(m_Types[(size_t)typ.ops[o]]);
+
+    m_Types.push_back(newType);
+  }
+  else
+  {
+    RDCERR("Unknown record ID %u encountered in type block", typ.id);
+  }
+}
+
+void Program::ParseSymtabEntry(ParseState &state, const LLVMBC::BlockOrRecord &symtab)
+{
+  ValueList &values = state.values;
+
+  if(!IS_KNOWN(symtab.id, ValueSymtabRecord::ENTRY))
+  {
+    RDCERR("Unexpected symbol table record ID %u", symtab.id);
+    return;
+  }
+
+  size_t vidx = (size_t)symtab.ops[0];
+  if(vidx < values.curValueIndex())
+  {
+    Value *v = values[vidx];
+    rdcstr str = symtab.getString(1);
+
+    SetValueSymtabString(v, str);
+
+    if(!m_ValueSymtabOrder.empty())
+      m_SortedSymtab &= GetValueSymtabString(m_ValueSymtabOrder.back()) < str;
+
+    m_ValueSymtabOrder.push_back(v);
+  }
+  else
+  {
+    RDCERR("Value %zu referenced out of bounds", vidx);
+  }
+}
+
+void Program::ParseMetadata(ParseState &state, const LLVMBC::BlockOrRecord &metaRecord)
+{
+  ValueList &values = state.values;
+  MetadataList &metadata = state.metadata;
+
+  // metadata is numbered by the position of its record in the block
+  size_t i = state.nextMeta++;
+
+  if(state.namedMeta)
+  {
+    // the record after a NAME has the named metadata's children
+    RDCASSERT(IS_KNOWN(metaRecord.id, MetaDataRecord::NAMED_NODE));
+
+    for(uint64_t op : metaRecord.ops)
+      state.namedMeta->children.push_back(metadata[(size_t)op]);
+
+    m_NamedMeta.push_back(state.namedMeta);
+    state.namedMeta = NULL;
+  }
+  else if(IS_KNOWN(metaRecord.id, MetaDataRecord::NAME))
+  {
+    state.namedMeta = new(alloc) NamedMetadata;
+    state.namedMeta->name = metaRecord.getString();
+  }
+  else if(IS_KNOWN(metaRecord.id, MetaDataRecord::KIND))
+  {
+    size_t kind = (size_t)metaRecord.ops[0];
+    m_Kinds.resize_for_index(kind);
+    m_Kinds[kind] = metaRecord.getString(1);
+  }
+  else
+  {
+    Metadata *meta = metadata[i];
+
+    if(IS_KNOWN(metaRecord.id, MetaDataRecord::STRING_OLD))
+    {
+      meta->isConstant = true;
+      meta->isString = true;
+      meta->str = metaRecord.getString();
+    }
+    else if(IS_KNOWN(metaRecord.id, MetaDataRecord::VALUE))
+    {
+      meta->value = values[(size_t)metaRecord.ops[1]];
+      meta->type = m_Types[(size_t)metaRecord.ops[0]];
+      meta->isConstant = true;
+    }
+    else if(IS_KNOWN(metaRecord.id, MetaDataRecord::NODE) ||
+            IS_KNOWN(metaRecord.id, MetaDataRecord::DISTINCT_NODE))
+    {
+      if(IS_KNOWN(metaRecord.id, MetaDataRecord::DISTINCT_NODE))
+        meta->isDistinct = true;
+
+      for(uint64_t op : metaRecord.ops)
+        meta->children.push_back(metadata.getOrNULL(op));
+    }
+    else
+    {
+      bool parsed = ParseDebugMetaRecord(metadata, metaRecord, *meta);
+      if(!parsed)
+      {
+        RDCERR("unhandled metadata type %u", metaRecord.id);
+      }
+    }
+  }
+}
+
+void Program::BeginFunctionBlock(ParseState &state)
+{
+  ValueList &values = state.values;
+
+  Function *f = m_Functions[state.functionDecls[0]];
+  state.functionDecls.erase(0);
+
+  values.beginFunction();
+  state.metadata.beginFunction();
+
+  f->args.reserve(f->type->members.size());
+  for(size_t i = 0; i < f->type->members.size(); i++)
+  {
+    Instruction *arg = values.nextValue<Instruction>();
+    arg->type = f->type->members[i];
+    f->args.push_back(arg);
+    values.addValue();
+  }
+
+  state.func = f;
+  state.curBlock = 0;
+  state.debugLocIndex = -1;
+}
+
+void Program::ParseFunctionMetadata(ParseState &state, const LLVMBC::BlockOrRecord &metaRecord)
+{
+  Metadata *meta = state.metadata[state.nextMeta++];
+
+  if(IS_KNOWN(metaRecord.id, MetaDataRecord::VALUE))
+  {
+    meta->isConstant = true;
+    meta->value = state.values.getOrCreatePlaceholder((size_t)metaRecord.ops[1]);
+    meta->type = m_Types[(size_t)metaRecord.ops[0]];
+  }
+  else
+  {
+    RDCERR("Unexpected record %u in function METADATA_BLOCK", metaRecord.id);
+  }
+}
+
+void Program::ParseFunctionSymtabEntry(ParseState &state, const LLVMBC::BlockOrRecord &symtab)
+{
+  ValueList &values = state.values;
+  Function *f = state.func;
+
+  if(IS_KNOWN(symtab.id, ValueSymtabRecord::ENTRY))
+  {
+    size_t idx = (size_t)symtab.ops[0];
+
+    if(idx >= values.curValueIndex())
+    {
+      RDCERR("Out of bounds symbol index %zu (%s) in function symbol table", idx,
+             symtab.getString(1).c_str());
+      return;
+    }
+
+    Value *v = values[idx];
+    rdcstr str = symtab.getString(1);
+
+    SetValueSymtabString(v, str);
+
+    if(!f->valueSymtabOrder.empty())
+      f->sortedSymtab &= GetValueSymtabString(f->valueSymtabOrder.back()) < str;
+
+    f->valueSymtabOrder.push_back(v);
+  }
+  else if(IS_KNOWN(symtab.id, ValueSymtabRecord::BBENTRY))
+  {
+    Value *v = f->blocks[(size_t)symtab.ops[0]];
+    rdcstr str = symtab.getString(1);
+
+    SetValueSymtabString(v, str);
+
+    if(!f->valueSymtabOrder.empty())
+      f->sortedSymtab &= GetValueSymtabString(f->valueSymtabOrder.back()) < str;
+
+    f->valueSymtabOrder.push_back(v);
+  }
+  else
+  {
+    RDCERR("Unexpected function symbol table record ID %u", symtab.id);
+  }
+}
+
+void Program::ParseMetadataAttachment(ParseState &state, const LLVMBC::BlockOrRecord &meta)
+{
+  MetadataList &metadata = state.metadata;
+  Function *f = state.func;
+
+  if(!IS_KNOWN(meta.id, MetaDataRecord::ATTACHMENT))
+  {
+    RDCERR("Unexpected record %u in METADATA_ATTACHMENT", meta.id);
+    return;
+  }
+
+  size_t idx = 0;
+
+  AttachedMetadata attach;
+
+  if(meta.ops.size() % 2 != 0)
+    idx++;
+
+  for(; idx < meta.ops.size(); idx += 2)
+    attach.push_back(make_rdcpair(meta.ops[idx], metadata.getDirect(meta.ops[idx + 1])));
+
+  if(meta.ops.size() % 2 == 0)
+    f->attachedMeta.swap(attach);
+  else
+    f->instructions[(size_t)meta.ops[0]]->extra(alloc).attachedMeta.swap(attach);
+}
+
+void Program::ParseUselist(ParseState &state, const LLVMBC::BlockOrRecord &uselist)
+{
+  ValueList &values = state.values;
+  Function *f = state.func;
+
+  const bool bb = IS_KNOWN(uselist.id, UselistRecord::BB);
+  if(IS_KNOWN(uselist.id, UselistRecord::DEFAULT) || bb)
+  {
+    UselistEntry u;
+    u.block = bb;
+    u.shuffle = uselist.ops;
+    u.value = values[(size_t)u.shuffle.back()];
+    u.shuffle.pop_back();
+    f->uselist.push_back(u);
+  }
+  else
+  {
+    RDCERR("Unexpected record %u in USELIST_BLOCK", uselist.id);
+  }
+}
+
+void Program::ParseFunctionRecord(ParseState &state, const LLVMBC::BlockOrRecord &funcChild)
+{
+  ValueList &values = state.values;
+  MetadataList &metadata = state.metadata;
+  Function *f = state.func;
+  size_t &curBlock = state.curBlock;
+  int32_t &debugLocIndex = state.debugLocIndex;
+
+  OpReader op(this, values, funcChild);
+
+  if(op.type == FunctionRecord::DECLAREBLOCKS)
+  {
+    f->blocks.resize(op.get<size_t>());
+    for(size_t b = 0; b < f->blocks.size(); b++)
+      f->blocks[b] = new(alloc) Block(m_LabelType);
+
+    curBlock = 0;
+  }
+  else if(op.type == FunctionRecord::DEBUG_LOC)
+  {
+    DebugLocation debugLoc;
+    debugLoc.line = op.get<uint64_t>();
+    debugLoc.col = op.get<uint64_t>();
+    debugLoc.scope = metadata.getOrNULL(op.get<uint64_t>());
+    debugLoc.inlinedAt = metadata.getOrNULL(op.get<uint64_t>());
+
+    debugLocIndex = m_DebugLocations.indexOf(debugLoc);
+
+    if(debugLocIndex < 0)
+    {
+      m_DebugLocations.push_back(debugLoc);
+      debugLocIndex = int32_t(m_DebugLocations.size() - 1);
+    }
+
+    f->instructions.back()->debugLoc = (uint32_t)debugLocIndex;
+  }
+  else if(op.type == FunctionRecord::DEBUG_LOC_AGAIN)
+  {
+    f->instructions.back()->debugLoc = (uint32_t)debugLocIndex;
+  }
+  else if(op.type == FunctionRecord::INST_CALL)
+  {
+    size_t paramAttrs = op.get<size_t>();
+
+    uint64_t callingFlags = op.get<uint64_t>();
+
+    InstructionFlags flags = InstructionFlags::NoFlags;
+
+    if(callingFlags & (1ULL << 17))
+    {
+      flags = op.get<InstructionFlags>();
+      RDCASSERT(flags != InstructionFlags::NoFlags);
+
+      callingFlags &= ~(1ULL << 17);
+    }
+
+    const Type *funcCallType = NULL;
+
+    if(callingFlags & (1ULL << 15))
+    {
+      funcCallType = op.getType();    // funcCallType
+
+      callingFlags &= ~(1ULL << 15);
+    }
+
+    RDCASSERTMSG("Calling flags should only have at most two known bits set", callingFlags == 0,
+                 callingFlags);
+
+    Function *funcCall = cast<Function>(op.getSymbol());
+
+    if(!funcCall)
+    {
+      RDCERR("Unexpected symbol type called in INST_CALL");
+      return;
+    }
+
+    Instruction *inst = NULL;
+
+    bool voidCall = funcCall->type->inner->isVoid();
+
+    if(!voidCall)
+      inst = values.nextValue<Instruction>();
+    else
+      inst = new(alloc) Instruction();
+
+    inst->op = Operation::Call;
+    inst->extra(alloc).funcCall = funcCall;
+    inst->type = funcCall->type->inner;
+    inst->opFlags() = flags;
+    if(paramAttrs > 0)
+      inst->extra(alloc).paramAttrs = m_AttributeSets[paramAttrs - 1];
+
+    if(funcCallType)
+    {
+      RDCASSERT(funcCallType == funcCall->type);
+    }
+
+    for(size_t i = 0; op.remaining() > 0; i++)
+    {
+      Value *arg = NULL;
+      if(funcCall->type->members[i]->type == Type::Metadata)
+      {
+        int32_t offs = (int32_t)op.get<uint32_t>();
+        size_t idx = values.curValueIndex() - offs;
+        arg = metadata[idx];
+      }
+      else
+      {
+        arg = op.getSymbol(false);
+      }
+      inst->args.push_back(arg);
+    }
+
+    RDCASSERTEQUAL(inst->args.size(), funcCall->type->members.size());
+
+    f->instructions.push_back(inst);
+
+    if(!voidCall)
+      values.addValue();
+    if(funcCall->name == "dx.op.createHandleFromHeap")
+      m_directHeapAccessCount++;
+  }
+  else if(op.type == FunctionRecord::INST_CAST)
+  {
+    Instruction *inst = values.nextValue<Instruction>();
+
+    inst->args.push_back(op.getSymbol());
+    inst->type = op.getType();
+
+    uint64_t opcode = op.get<uint64_t>();
+    inst->op = DecodeCast(opcode);
+
+    f->instructions.push_back(inst);
+    values.addValue();
+  }
+  else if(op.type == FunctionRecord::INST_EXTRACTVAL)
+  {
+    Instruction *inst = values.nextValue<Instruction>();
+
+    inst->op = Operation::ExtractVal;
+
+    inst->args.push_back(op.getSymbol());
+    inst->type = inst->args.back()->type;
+    while(op.remaining() > 0)
+    {
+      uint64_t val = op.get<uint64_t>();
+      if(inst->type->type == Type::Array)
+        inst->type = inst->type->inner;
+      else
+        inst->type = inst->type->members[(size_t)val];
+      inst->args.push_back(new(alloc) Literal(val));
+    }
+
+    f->instructions.push_back(inst);
+    values.addValue();
+  }
+  else if(op.type == FunctionRecord::INST_RET)
+  {
+    // even rets returning a value are still void
+    Instruction *inst = new(alloc) Instruction;
+    inst->type = GetVoidType();
+
+    if(op.remaining() != 0)
+      inst->args.push_back(op.getSymbol());
+
+    inst->op = Operation::Ret;
+
+    curBlock++;
+
+    f->instructions.push_back(inst);
+  }
+  else if(op.type == FunctionRecord::INST_BINOP)
+  {
+    Instruction *inst = values.nextValue<Instruction>();
+
+    inst->args.push_back(op.getSymbol());
+    inst->type = inst->args.back()->type;
+    inst->args.push_back(op.getSymbol(false));
+
+    inst->op = DecodeBinOp(inst->type, op.get<uint64_t>());
+
+    if(op.remaining() > 0)
+    {
+      uint64_t flags = op.get<uint64_t>();
+      if(inst->op == Operation::Add || inst->op == Operation::Sub || inst->op == Operation::Mul ||
+         inst->op == Operation::ShiftLeft)
+      {
+        if(flags & 0x2)
+          inst->opFlags() |= InstructionFlags::NoSignedWrap;
+        if(flags & 0x1)
+          inst->opFlags() |= InstructionFlags::NoUnsignedWrap;
+      }
+      else if(inst->op == Operation::SDiv || inst->op == Operation::UDiv ||
+              inst->op == Operation::LogicalShiftRight || inst->op == Operation::ArithShiftRight)
+      {
+        if(flags & 0x1)
+          inst->opFlags() |= InstructionFlags::Exact;
+      }
+      else if(inst->type->scalarType == Type::Float)
+      {
+        // fast math flags overlap
+        inst->opFlags() = InstructionFlags(flags);
+      }
+
+      RDCASSERT(inst->opFlags() != InstructionFlags::NoFlags);
+    }
+
+    f->instructions.push_back(inst);
+    values.addValue();
+  }
+  else if(op.type == FunctionRecord::INST_UNREACHABLE)
+  {
+    Instruction *inst = new(alloc) Instruction;
+
+    inst->op = Operation::Unreachable;
+
+    inst->type = GetVoidType();
+
+    curBlock++;
+
+    f->instructions.push_back(inst);
+  }
+  else if(op.type == FunctionRecord::INST_ALLOCA)
+  {
+    Instruction *inst = values.nextValue<Instruction>();
+
+    inst->op = Operation::Alloca;
+
+    inst->type = op.getType();
+
+    // we now have the inner type, but this instruction returns a pointer to that type so
+    // adjust
+    inst->type = GetPointerType(inst->type, Type::PointerAddrSpace::Default);
+
+    RDCASSERT(inst->type->type == Type::Pointer);
+
+    // type of the size - ignored
+    const Type *sizeType = op.getType();
+    // size
+    inst->args.push_back(op.getSymbolAbsolute());
+
+    RDCASSERT(sizeType == inst->args.back()->type);
+
+    uint64_t align = op.get<uint64_t>();
+
+    if(align & 0x20)
+    {
+      // argument alloca
+      inst->opFlags() |= InstructionFlags::ArgumentAlloca;
+    }
+    if((align & 0x40) == 0)
+    {
+      RDCASSERT(inst->type->type == Type::Pointer);
+      inst->type = inst->type->inner;
+    }
+
+    align &= ~0xE0;
+
+    RDCASSERT(align < 0x100);
+    inst->align = align & 0xff;
+
+    f->instructions.push_back(inst);
+    values.addValue();
+  }
+  else if(op.type == FunctionRecord::INST_INBOUNDS_GEP_OLD ||
+          op.type == FunctionRecord::INST_GEP_OLD || op.type == FunctionRecord::INST_GEP)
+  {
+    Instruction *inst = values.nextValue<Instruction>();
+
+    inst->op = Operation::GetElementPtr;
+
+    if(op.type == FunctionRecord::INST_INBOUNDS_GEP_OLD)
+      inst->opFlags() |= InstructionFlags::InBounds;
+
+    if(op.type == FunctionRecord::INST_GEP)
+    {
+      if(op.get<uint64_t>())
+        inst->opFlags() |= InstructionFlags::InBounds;
+      inst->type = op.getType();
+    }
+
+    while(op.remaining() > 0)
+    {
+      inst->args.push_back(op.getSymbol());
+
+      if(inst->type == NULL && inst->args.size() == 1)
+        inst->type = inst->args.back()->type;
+    }
+
+    // walk the type list to get the return type
+    for(size_t idx = 2; idx < inst->args.size(); idx++)
+    {
+      if(inst->type->type == Type::Vector || inst->type->type == Type::Array)
+      {
+        inst->type = inst->type->inner;
+      }
+      else if(inst->type->type == Type::Struct)
+      {
+        // if it's a struct the index must be constant
+        Constant *c = cast<Constant>(inst->args[idx]);
+        RDCASSERT(c);
+        inst->type = inst->type->members[c->getU32()];
+      }
+      else
+      {
+        RDCERR("Unexpected type %d encountered in GEP", inst->type->type);
+      }
+    }
+
+    // get the pointer type
+    inst->type = GetPointerType(inst->type, inst->args[0]->type->addrSpace);
+
+    RDCASSERT(inst->type->type == Type::Pointer);
+
+    f->instructions.push_back(inst);
+    values.addValue();
+  }
+  else if(op.type == FunctionRecord::INST_LOAD)
+  {
+    Instruction *inst = values.nextValue<Instruction>();
+
+    inst->op = Operation::Load;
+
+    inst->args.push_back(op.getSymbol());
+
+    if(op.remaining() == 3)
+    {
+      inst->type = op.getType();
+    }
+    else
+    {
+      inst->type = inst->args.back()->type;
+      RDCASSERT(inst->type->type == Type::Pointer);
+      inst->type = inst->type->inner;
+    }
+
+    inst->align = op.get<uint8_t>();
+    inst->opFlags() |= (op.get<uint64_t>() != 0) ? InstructionFlags::Volatile
+                                                 : InstructionFlags::NoFlags;
+
+    f->instructions.push_back(inst);
+    values.addValue();
+  }
+  else if(op.type == FunctionRecord::INST_STORE_OLD || op.type == FunctionRecord::INST_STORE)
+  {
+    Instruction *inst = new(alloc) Instruction;
+
+    inst->op = Operation::Store;
+
+    inst->type = GetVoidType();
+
+    inst->args.push_back(op.getSymbol());
+    if(op.type == FunctionRecord::INST_STORE_OLD)
+      inst->args.push_back(op.getSymbol(false));
+    else
+      inst->args.push_back(op.getSymbol());
+
+    inst->align = op.get<uint8_t>();
+    inst->opFlags() |= (op.get<uint64_t>() != 0) ? InstructionFlags::Volatile
+                                                 : InstructionFlags::NoFlags;
+
+    f->instructions.push_back(inst);
+  }
+  else if(op.type == FunctionRecord::INST_CMP || IS_KNOWN(op.type, FunctionRecord::INST_CMP2))
+  {
+    Instruction *inst = values.nextValue<Instruction>();
+
+    // a
+    inst->args.push_back(op.getSymbol());
+
+    const Type *argType = inst->args.back()->type;
+
+    // b
+    inst->args.push_back(op.getSymbol(false));
+
+    uint64_t opcode = op.get<uint64_t>();
+    switch(opcode)
+    {
+      case 0: inst->op = Operation::FOrdFalse; break;
+      case 1: inst->op = Operation::FOrdEqual; break;
+      case 2: inst->op = Operation::FOrdGreater; break;
+      case 3: inst->op = Operation::FOrdGreaterEqual; break;
+      case 4: inst->op = Operation::FOrdLess; break;
+      case 5: inst->op = Operation::FOrdLessEqual; break;
+      case 6: inst->op = Operation::FOrdNotEqual; break;
+      case 7: inst->op = Operation::FOrd; break;
+      case 8: inst->op = Operation::FUnord; break;
+      case 9: inst->op = Operation::FUnordEqual; break;
+      case 10: inst->op = Operation::FUnordGreater; break;
+      case 11: inst->op = Operation::FUnordGreaterEqual; break;
+      case 12: inst->op = Operation::FUnordLess; break;
+      case 13: inst->op = Operation::FUnordLessEqual; break;
+      case 14: inst->op = Operation::FUnordNotEqual; break;
+      case 15: inst->op = Operation::FOrdTrue; break;
+
+      case 32: inst->op = Operation::IEqual; break;
+      case 33: inst->op = Operation::INotEqual; break;
+      case 34: inst->op = Operation::UGreater; break;
+      case 35: inst->op = Operation::UGreaterEqual; break;
+      case 36: inst->op = Operation::ULess; break;
+      case 37: inst->op = Operation::ULessEqual; break;
+      case 38: inst->op = Operation::SGreater; break;
+      case 39: inst->op = Operation::SGreaterEqual; break;
+      case 40: inst->op = Operation::SLess; break;
+      case 41: inst->op = Operation::SLessEqual; break;
+
+      default:
+        inst->op = Operation::FOrdFalse;
+        RDCERR("Unexpected comparison %llu", opcode);
+        break;
+    }
+
+    // fast math flags
+    if(op.remaining() > 0)
+    {
+      inst->opFlags() = op.get<InstructionFlags>();
+
+      RDCASSERTNOTEQUAL((uint64_t)inst->opFlags(), 0);
+    }
+
+    inst->type = GetBoolType();
+
+    // if we're comparing vectors, the return type is an equal sized bool vector
+    if(argType->type == Type::Vector)
+    {
+      for(const Type *t : m_Types)
+      {
+        if(t->type == Type::Vector && t->inner == inst->type && t->elemCount == argType->elemCount)
+        {
+          inst->type = t;
+          break;
+        }
+      }
+    }
+
+    RDCASSERT(inst->type->type == argType->type && inst->type->elemCount == argType->elemCount);
 
-  const byte *bitcode = ((const byte *)&header->DxilMagic) + header->BitcodeOffset;
-  RDCASSERT(bitcode + header->BitcodeSize <= ptr + length);
+    f->instructions.push_back(inst);
+    values.addValue();
+  }
+  else if(op.type == FunctionRecord::INST_SELECT || op.type == FunctionRecord::INST_VSELECT)
+  {
+    Instruction *inst = values.nextValue<Instruction>();
 
-  LLVMBC::BitcodeReader reader(bitcode, header->BitcodeSize);
+    inst->op = Operation::Select;
 
-  LLVMBC::BlockOrRecord root = reader.ReadToplevelBlock();
+    // if true
+    inst->args.push_back(op.getSymbol());
 
-  // the top-level block should be MODULE_BLOCK
-  RDCASSERT(KnownBlock(root.id) == KnownBlock::MODULE_BLOCK);
+    inst->type = inst->args.back()->type;
 
-  // we should have consumed all bits, only one top-level block
-  RDCASSERT(reader.AtEndOfStream());
+    // if false
+    inst->args.push_back(op.getSymbol(false));
+    // selector
+    if(op.type == FunctionRecord::INST_SELECT)
+      inst->args.push_back(op.getSymbol(false));
+    else
+      inst->args.push_back(op.getSymbol());
 
-  m_Type = DXBC::ShaderType(header->ProgramType);
-  m_Major = (header->ProgramVersion & 0xf0) >> 4;
-  m_Minor = header->ProgramVersion & 0xf;
-  m_DXILVersion = header->DxilVersion;
+    f->instructions.push_back(inst);
+    values.addValue();
+  }
+  else if(op.type == FunctionRecord::INST_BR)
+  {
+    Instruction *inst = new(alloc) Instruction;
 
-  ValueList values(alloc);
-  MetadataList metadata(alloc);
+    inst->op = Operation::Branch;
 
-  // Input signature and Output signature haven't changed.
-  // Pipeline Runtime Information we have decoded just not implemented here
+    inst->type = GetVoidType();
 
-  rdcstr datalayout, triple;
+    // true destination
+    uint64_t trueDest = op.get<uint64_t>();
+    inst->args.push_back(f->blocks[(size_t)trueDest]);
+    f->blocks[(size_t)trueDest]->preds.insert(0, f->blocks[curBlock]);
 
-  rdcarray<size_t> functionDecls;
+    if(op.remaining() > 0)
+    {
+      // false destination
+      uint64_t falseDest = op.get<uint64_t>();
+      inst->args.push_back(f->blocks[(size_t)falseDest]);
+      f->blocks[(size_t)falseDest]->preds.insert(0, f->blocks[curBlock]);
 
-  // conservatively resize these so we can take pointers to put in the values array. There aren't
-  // many root entries so this is a reasonable bound
-  m_GlobalVars.reserve(root.children.size());
-  m_Functions.reserve(root.children.size());
-  m_Aliases.reserve(root.children.size());
+      // predicate
+      inst->args.push_back(op.getSymbol(false));
+    }
+
+    curBlock++;
 
-  for(const LLVMBC::BlockOrRecord &rootchild : root.children)
+    f->instructions.push_back(inst);
+  }
+  else if(op.type == FunctionRecord::INST_SWITCH)
   {
-    if(rootchild.IsRecord())
+    Instruction *inst = new(alloc) Instruction;
+
+    inst->op = Operation::Switch;
+
+    inst->type = GetVoidType();
+
+    uint64_t typeIdx = op.get<uint64_t>();
+
+    static const uint64_t SWITCH_INST_MAGIC = 0x4B5;
+    if((typeIdx >> 16) == SWITCH_INST_MAGIC)
+    {
+      // type of condition
+      const Type *condType = op.getType();
+
+      RDCASSERT(condType->bitWidth <= 64);
+
+      // condition
+      inst->args.push_back(op.getSymbol(false));
+
+      // default block
+      size_t defaultDest = op.get<size_t>();
+      inst->args.push_back(f->blocks[defaultDest]);
+      f->blocks[defaultDest]->preds.insert(0, f->blocks[curBlock]);
+
+      RDCERR("Unsupported switch instruction version");
+    }
+    else
     {
-      if(IS_KNOWN(rootchild.id, ModuleRecord::VERSION))
+      // condition
+      inst->args.push_back(op.getSymbol(false));
+
+      // default block
+      size_t defaultDest = op.get<size_t>();
+      inst->args.push_back(f->blocks[defaultDest]);
+      f->blocks[defaultDest]->preds.insert(0, f->blocks[curBlock]);
+
+      uint64_t numCases = op.remaining() / 2;
+
+      for(uint64_t c = 0; c < numCases; c++)
       {
-        if(rootchild.ops[0] != 1)
-        {
-          RDCERR("Unsupported LLVM bitcode version %u", rootchild.ops[0]);
-          break;
-        }
+        // case value, absolute not relative
+        inst->args.push_back(op.getSymbolAbsolute());
+
+        // case block
+        size_t caseDest = op.get<size_t>();
+        inst->args.push_back(f->blocks[caseDest]);
+        f->blocks[caseDest]->preds.insert(0, f->blocks[curBlock]);
       }
-      else if(IS_KNOWN(rootchild.id, ModuleRecord::TRIPLE))
+    }
+
+    curBlock++;
+
+    f->instructions.push_back(inst);
+  }
+  else if(op.type == FunctionRecord::INST_PHI)
+  {
+    Instruction *inst = values.nextValue<Instruction>();
+
+    inst->op = Operation::Phi;
+
+    inst->type = op.getType();
+
+    while(op.remaining() > 0)
+    {
+      int64_t valSrc = LLVMBC::BitReader::svbr(op.get<uint64_t>());
+      uint64_t blockSrc = op.get<uint64_t>();
+
+      if(valSrc < 0)
       {
-        m_Triple = rootchild.getString();
+        inst->args.push_back(values.createPlaceholderValue(values.getRelativeForwards(-valSrc)));
       }
-      else if(IS_KNOWN(rootchild.id, ModuleRecord::DATALAYOUT))
+      else
       {
-        m_Datalayout = rootchild.getString();
+        inst->args.push_back(op.getSymbol((uint64_t)valSrc));
       }
-      else if(IS_KNOWN(rootchild.id, ModuleRecord::GLOBALVAR))
-      {
-        // [pointer type, isconst, initid, linkage, alignment, section, visibility, threadlocal,
-        // unnamed_addr, externally_initialized, dllstorageclass, comdat]
-        GlobalVar *g = values.nextValue<GlobalVar>();
+      inst->args.push_back(f->blocks[(size_t)blockSrc]);
+    }
 
-        g->type = m_Types[(size_t)rootchild.ops[0]];
-        if(rootchild.ops[1] & 0x1)
-          g->flags |= GlobalFlags::IsConst;
+    f->instructions.push_back(inst);
+    values.addValue();
+  }
+  else if(op.type == FunctionRecord::INST_LOADATOMIC)
+  {
+    Instruction *inst = values.nextValue<Instruction>();
 
-        Type::PointerAddrSpace addrSpace = g->type->addrSpace;
-        if(rootchild.ops[1] & 0x2)
-          addrSpace = Type::PointerAddrSpace(rootchild.ops[1] >> 2);
+    inst->op = Operation::LoadAtomic;
 
-        if(rootchild.ops[2])
-          g->initialiser += rootchild.ops[2];
+    inst->args.push_back(op.getSymbol());
 
-        switch(rootchild.ops[3])
-        {
-          case 0: g->flags |= GlobalFlags::ExternalLinkage; break;
-          case 16: g->flags |= GlobalFlags::WeakAnyLinkage; break;
-          case 2: g->flags |= GlobalFlags::AppendingLinkage; break;
-          case 3: g->flags |= GlobalFlags::InternalLinkage; break;
-          case 18: g->flags |= GlobalFlags::LinkOnceAnyLinkage; break;
-          case 7: g->flags |= GlobalFlags::ExternalWeakLinkage; break;
-          case 8: g->flags |= GlobalFlags::CommonLinkage; break;
-          case 9: g->flags |= GlobalFlags::PrivateLinkage; break;
-          case 17: g->flags |= GlobalFlags::WeakODRLinkage; break;
-          case 19: g->flags |= GlobalFlags::LinkOnceODRLinkage; break;
-          case 12: g->flags |= GlobalFlags::AvailableExternallyLinkage; break;
-          default: break;
-        }
+    if(op.remaining() == 5)
+    {
+      inst->type = op.getType();
+    }
+    else
+    {
+      inst->type = inst->args.back()->type;
+      RDCASSERT(inst->type->type == Type::Pointer);
+      inst->type = inst->type->inner;
+    }
 
-        g->align = (1ULL << rootchild.ops[4]) >> 1;
+    inst->align = op.get<uint8_t>();
+    inst->opFlags() |= (op.get<uint64_t>() != 0) ? InstructionFlags::Volatile
+                                                 : InstructionFlags::NoFlags;
 
-        g->section = int32_t(rootchild.ops[5]) - 1;
+    // success ordering
+    uint64_t opcode = op.get<uint64_t>();
+    switch(opcode)
+    {
+      case 0: break;
+      case 1: inst->opFlags() |= InstructionFlags::SuccessUnordered; break;
+      case 2: inst->opFlags() |= InstructionFlags::SuccessMonotonic; break;
+      case 3: inst->opFlags() |= InstructionFlags::SuccessAcquire; break;
+      case 4: inst->opFlags() |= InstructionFlags::SuccessRelease; break;
+      case 5: inst->opFlags() |= InstructionFlags::SuccessAcquireRelease; break;
+      case 6: inst->opFlags() |= InstructionFlags::SuccessSequentiallyConsistent; break;
+      default:
+        RDCERR("Unexpected success ordering %llu", opcode);
+        inst->opFlags() |= InstructionFlags::SuccessSequentiallyConsistent;
+        break;
+    }
 
-        if(rootchild.ops.size() > 6)
-        {
-          RDCASSERTMSG("global has non-default visibility", rootchild.ops[6] == 0);
-        }
+    // synchronisation scope
+    opcode = op.get<uint64_t>();
+    switch(opcode)
+    {
+      case 0: inst->opFlags() |= InstructionFlags::SingleThread; break;
+      case 1: break;
+      default: RDCERR("Unexpected synchronisation scope %llu", opcode); break;
+    }
 
-        if(rootchild.ops.size() > 7)
-        {
-          RDCASSERTMSG("global has non-default TLS mode", rootchild.ops[7] == 0);
-        }
+    f->instructions.push_back(inst);
+    values.addValue();
+  }
+  else if(op.type == FunctionRecord::INST_STOREATOMIC_OLD ||
+          op.type == FunctionRecord::INST_STOREATOMIC)
+  {
+    Instruction *inst = new(alloc) Instruction;
 
-        if(rootchild.ops.size() > 8)
-        {
-          if(rootchild.ops[8] == 1)
-            g->flags |= GlobalFlags::GlobalUnnamedAddr;
-          else if(rootchild.ops[8] == 2)
-            g->flags |= GlobalFlags::LocalUnnamedAddr;
-        }
+    inst->op = Operation::StoreAtomic;
 
-        if(rootchild.ops.size() > 9)
-        {
-          if(rootchild.ops[9])
-            g->flags |= GlobalFlags::ExternallyInitialised;
-        }
+    inst->type = GetVoidType();
 
-        if(rootchild.ops.size() > 10)
-        {
-          RDCASSERTMSG("global has non-default DLL storage class", rootchild.ops[10] == 0);
-        }
+    inst->args.push_back(op.getSymbol());
+    if(op.type == FunctionRecord::INST_STOREATOMIC_OLD)
+      inst->args.push_back(op.getSymbol(false));
+    else
+      inst->args.push_back(op.getSymbol());
 
-        if(rootchild.ops.size() > 11)
-        {
-          // assume no comdat
-          RDCASSERTMSG("global has comdat", rootchild.ops[11] == 0);
-        }
+    inst->align = op.get<uint8_t>();
+    inst->opFlags() |= (op.get<uint64_t>() != 0) ? InstructionFlags::Volatile
+                                                 : InstructionFlags::NoFlags;
 
-        g->type = GetPointerType(g->type, addrSpace);
+    // success ordering
+    uint64_t opcode = op.get<uint64_t>();
+    switch(opcode)
+    {
+      case 0: break;
+      case 1: inst->opFlags() |= InstructionFlags::SuccessUnordered; break;
+      case 2: inst->opFlags() |= InstructionFlags::SuccessMonotonic; break;
+      case 3: inst->opFlags() |= InstructionFlags::SuccessAcquire; break;
+      case 4: inst->opFlags() |= InstructionFlags::SuccessRelease; break;
+      case 5: inst->opFlags() |= InstructionFlags::SuccessAcquireRelease; break;
+      case 6: inst->opFlags() |= InstructionFlags::SuccessSequentiallyConsistent; break;
+      default:
+        RDCERR("Unexpected success ordering %llu", opcode);
+        inst->opFlags() |= InstructionFlags::SuccessSequentiallyConsistent;
+        break;
+    }
 
-        m_GlobalVars.push_back(g);
-        values.addValue();
-      }
-      else if(IS_KNOWN(rootchild.id, ModuleRecord::FUNCTION))
-      {
-        // [type, callingconv, isproto, linkage, paramattrs, alignment, section, visibility, gc,
-        // unnamed_addr, prologuedata, dllstorageclass, comdat, prefixdata]
-        Function *f = new(alloc) Function;
-
-        f->type = m_Types[(size_t)rootchild.ops[0]];
-        // ignore callingconv
-        RDCASSERTMSG("Calling convention is non-default", rootchild.ops[1] == 0);
-        f->external = (rootchild.ops[2] != 0);
-        // ignore linkage
-        if(rootchild.ops[3] == 3)
-          f->internalLinkage = true;
-        else
-          RDCASSERTMSG("Linkage is non-default and not internal", rootchild.ops[3] == 0,
-                       rootchild.ops[3]);
-        if(rootchild.ops[4] > 0 && rootchild.ops[4] - 1 < m_AttributeSets.size())
-          f->attrs = m_AttributeSets[(size_t)rootchild.ops[4] - 1];
+    // synchronisation scope
+    opcode = op.get<uint64_t>();
+    switch(opcode)
+    {
+      case 0: inst->opFlags() |= InstructionFlags::SingleThread; break;
+      case 1: break;
+      default: RDCERR("Unexpected synchronisation scope %llu", opcode); break;
+    }
 
-        f->align = rootchild.ops[5];
+    f->instructions.push_back(inst);
+  }
+  else if(op.type == FunctionRecord::INST_ATOMICRMW)
+  {
+    Instruction *inst = values.nextValue<Instruction>();
 
-        // ignore rest of properties, assert that if present they are 0
-        for(size_t p = 6; p < rootchild.ops.size(); p++)
-        {
-          // 12, if present, is the comdat index
-          if(p == 12 && rootchild.ops[p] > 0)
-          {
-            RDCASSERT(rootchild.ops[p] - 1 < m_Comdats.size(), rootchild.ops[p], m_Comdats.size());
-            f->comdatIdx = uint32_t(rootchild.ops[p] - 1);
-            continue;
-          }
-
-          RDCASSERT(rootchild.ops[p] == 0, p, rootchild.ops[p]);
-        }
+    // pointer to atomically modify
+    inst->args.push_back(op.getSymbol());
 
-        if(!f->external)
-          functionDecls.push_back(m_Functions.size());
+    // type is the pointee of the first argument
+    inst->type = inst->args.back()->type;
+    RDCASSERT(inst->type->type == Type::Pointer);
+    inst->type = inst->type->inner;
 
-        m_Functions.push_back(f);
-        values.addValue(f);
-      }
-      else if(IS_KNOWN(rootchild.id, ModuleRecord::ALIAS))
-      {
-        // [alias type, aliasee val#, linkage, visibility]
-        Alias *a = values.nextValue<Alias>();
+    // parameter value
+    inst->args.push_back(op.getSymbol(false));
 
-        a->type = m_Types[(size_t)rootchild.ops[0]];
-        a->val = values[(size_t)rootchild.ops[1]];
+    uint64_t opcode = op.get<uint64_t>();
+    switch(opcode)
+    {
+      case 0: inst->op = Operation::AtomicExchange; break;
+      case 1: inst->op = Operation::AtomicAdd; break;
+      case 2: inst->op = Operation::AtomicSub; break;
+      case 3: inst->op = Operation::AtomicAnd; break;
+      case 4: inst->op = Operation::AtomicNand; break;
+      case 5: inst->op = Operation::AtomicOr; break;
+      case 6: inst->op = Operation::AtomicXor; break;
+      case 7: inst->op = Operation::AtomicMax; break;
+      case 8: inst->op = Operation::AtomicMin; break;
+      case 9: inst->op = Operation::AtomicUMax; break;
+      case 10: inst->op = Operation::AtomicUMin; break;
+      default:
+        RDCERR("Unhandled atomicrmw op %llu", opcode);
+        inst->op = Operation::AtomicExchange;
+        break;
+    }
 
-        // ignore rest of properties, assert that if present they are 0
-        for(size_t p = 2; p < rootchild.ops.size(); p++)
-          RDCASSERT(rootchild.ops[p] == 0, p, rootchild.ops[p]);
+    if(op.get<uint64_t>())
+      inst->opFlags() |= InstructionFlags::Volatile;
 
-        m_Aliases.push_back(a);
-        values.addValue();
-      }
-      else if(IS_KNOWN(rootchild.id, ModuleRecord::SECTIONNAME))
-      {
-        m_Sections.push_back(rootchild.getString(0));
-      }
-      else if(IS_KNOWN(rootchild.id, ModuleRecord::COMDAT))
-      {
-        // can ignore the length for now, it's implicit anyway as there's nothing after the string
-        m_Comdats.push_back({rootchild.ops[0], rootchild.getString(2)});
-      }
-      else
-      {
-        RDCERR("Unknown record ID %u encountered at module scope", rootchild.id);
-      }
+    // success ordering
+    opcode = op.get<uint64_t>();
+    switch(opcode)
+    {
+      case 0: break;
+      case 1: inst->opFlags() |= InstructionFlags::SuccessUnordered; break;
+      case 2: inst->opFlags() |= InstructionFlags::SuccessMonotonic; break;
+      case 3: inst->opFlags() |= InstructionFlags::SuccessAcquire; break;
+      case 4: inst->opFlags() |= InstructionFlags::SuccessRelease; break;
+      case 5: inst->opFlags() |= InstructionFlags::SuccessAcquireRelease; break;
+      case 6: inst->opFlags() |= InstructionFlags::SuccessSequentiallyConsistent; break;
+      default:
+        RDCERR("Unexpected success ordering %llu", opcode);
+        inst->opFlags() |= InstructionFlags::SuccessSequentiallyConsistent;
+        break;
     }
-    else if(rootchild.IsBlock())
+
+    // synchronisation scope
+    opcode = op.get<uint64_t>();
+    switch(opcode)
     {
-      if(IS_KNOWN(rootchild.id, KnownBlock::BLOCKINFO))
-      {
-        // do nothing, this is internal parse data
-      }
-      else if(IS_KNOWN(rootchild.id, KnownBlock::PARAMATTR_GROUP_BLOCK))
-      {
-        for(const LLVMBC::BlockOrRecord &attrgroup : rootchild.children)
-        {
-          if(attrgroup.IsBlock())
-          {
-            RDCERR("Unexpected subblock in PARAMATTR_GROUP_BLOCK");
-            continue;
-          }
-
-          if(!IS_KNOWN(attrgroup.id, ParamAttrGroupRecord::ENTRY))
-          {
-            RDCERR("Unexpected attribute group record ID %u", attrgroup.id);
-            continue;
-          }
-
-          AttributeGroup *group = alloc.alloc<AttributeGroup>();
-
-          size_t id = (size_t)attrgroup.ops[0];
-          group->slotIndex = (uint32_t)attrgroup.ops[1];
-
-          for(size_t i = 2; i < attrgroup.ops.size(); i++)
-          {
-            switch(attrgroup.ops[i])
-            {
-              case 0:
-              {
-                group->params |= Attribute(1ULL << (attrgroup.ops[i + 1]));
-                i++;
-                break;
-              }
-              case 1:
-              {
-                uint64_t param = attrgroup.ops[i + 2];
-                Attribute attr = Attribute(1ULL << attrgroup.ops[i + 1]);
-                group->params |= attr;
-                switch(attr)
-                {
-                  case Attribute::Alignment: group->align = param; break;
-                  case Attribute::StackAlignment: group->stackAlign = param; break;
-                  case Attribute::Dereferenceable: group->derefBytes = param; break;
-                  case Attribute::DereferenceableOrNull: group->derefOrNullBytes = param; break;
-                  default: RDCERR("Unexpected attribute %llu with parameter", attr);
-                }
-                i += 2;
-                break;
-              }
-              default:
-              {
-                rdcstr a, b;
-
-                a = attrgroup.getString(i + 1);
-                a.resize(strlen(a.c_str()));
-
-                if(attrgroup.ops[i] == 4)
-                {
-                  b = attrgroup.getString(i + 1 + a.size() + 1);
-                  b.resize(strlen(b.c_str()));
-                  i += a.size() + b.size() + 2;
-                }
-                else
-                {
-                  i += a.size() + 1;
-                }
-
-                group->strs.push_back({a, b});
-                break;
-              }
-            }
-          }
-
-          m_AttributeGroups.resize_for_index(id);
-          m_AttributeGroups[id] = group;
-        }
-      }
-      else if(IS_KNOWN(rootchild.id, KnownBlock::PARAMATTR_BLOCK))
-      {
-        for(const LLVMBC::BlockOrRecord &paramattr : rootchild.children)
-        {
-          if(paramattr.IsBlock())
-          {
-            RDCERR("Unexpected subblock in PARAMATTR_BLOCK");
-            continue;
-          }
-
-          if(!IS_KNOWN(paramattr.id, ParamAttrRecord::ENTRY))
-          {
-            RDCERR("Unexpected attribute record ID %u", paramattr.id);
-            continue;
-          }
-
-          AttributeSet *attrs = alloc.alloc<AttributeSet>();
-
-          attrs->orderedGroups = paramattr.ops;
-
-          for(uint64_t g : paramattr.ops)
-          {
-            if(g < m_AttributeGroups.size())
-            {
-              const AttributeGroup *group = m_AttributeGroups[(size_t)g];
-              if(group->slotIndex == AttributeGroup::FunctionSlot)
-              {
-                RDCASSERT(attrs->functionSlot == NULL);
-                attrs->functionSlot = group;
-              }
-              else
-              {
-                attrs->groupSlots.resize_for_index(group->slotIndex);
-                attrs->groupSlots[group->slotIndex] = group;
-              }
-            }
-            else
-            {
-              RDCERR("Attribute refers to out of bounds group %llu", g);
-            }
-          }
-
-          m_AttributeSets.push_back(attrs);
-        }
-      }
-      else if(IS_KNOWN(rootchild.id, KnownBlock::TYPE_BLOCK))
-      {
-        rdcstr structname;
+      case 0: inst->opFlags() |= InstructionFlags::SingleThread; break;
+      case 1: break;
+      default: RDCERR("Unexpected synchronisation scope %llu", opcode); break;
+    }
 
-        if(!rootchild.children.empty() && !IS_KNOWN(rootchild.children[0].id, TypeRecord::NUMENTRY))
-        {
-          RDCWARN("No NUMENTRY record, resizing conservatively to number of records");
-          m_Types.reserve(rootchild.children.size());
-        }
+    f->instructions.push_back(inst);
+    values.addValue();
+  }
+  else if(op.type == FunctionRecord::INST_CMPXCHG || op.type == FunctionRecord::INST_CMPXCHG_OLD)
+  {
+    Instruction *inst = values.nextValue<Instruction>();
 
-        for(const LLVMBC::BlockOrRecord &typ : rootchild.children)
-        {
-          if(typ.IsBlock())
-          {
-            RDCERR("Unexpected subblock in TYPE_BLOCK");
-            continue;
-          }
-
-          if(IS_KNOWN(typ.id, TypeRecord::NUMENTRY))
-          {
-            RDCASSERT(m_Types.size() < (size_t)typ.ops[0], m_Types.size(), typ.ops[0]);
-            m_Types.reserve((size_t)typ.ops[0]);
-          }
-          else if(IS_KNOWN(typ.id, TypeRecord::VOID))
-          {
-            Type *newType = new(alloc) Type;
-            newType->type = Type::Scalar;
-            newType->scalarType = Type::Void;
-
-            m_Types.push_back(newType);
-            m_VoidType = newType;
-          }
-          else if(IS_KNOWN(typ.id, TypeRecord::LABEL))
-          {
-            Type *newType = new(alloc) Type;
-            newType->type = Type::Label;
-
-            m_Types.push_back(newType);
-            m_LabelType = newType;
-          }
-          else if(IS_KNOWN(typ.id, TypeRecord::METADATA))
-          {
-            Type *newType = new(alloc) Type;
-            newType->type = Type::Metadata;
-
-            m_Types.push_back(newType);
-            m_MetaType = newType;
-          }
-          else if(IS_KNOWN(typ.id, TypeRecord::HALF))
-          {
-            Type *newType = new(alloc) Type;
-            newType->type = Type::Scalar;
-            newType->scalarType = Type::Float;
-            newType->bitWidth = 16;
-
-            m_Types.push_back(newType);
-          }
-          else if(IS_KNOWN(typ.id, TypeRecord::FLOAT))
-          {
-            Type *newType = new(alloc) Type;
-            newType->type = Type::Scalar;
-            newType->scalarType = Type::Float;
-            newType->bitWidth = 32;
-
-            m_Types.push_back(newType);
-          }
-          else if(IS_KNOWN(typ.id, TypeRecord::DOUBLE))
-          {
-            Type *newType = new(alloc) Type;
-            newType->type = Type::Scalar;
-            newType->scalarType = Type::Float;
-            newType->bitWidth = 64;
-
-            m_Types.push_back(newType);
-          }
-          else if(IS_KNOWN(typ.id, TypeRecord::INTEGER))
-          {
-            Type *newType = new(alloc) Type;
-            newType->type = Type::Scalar;
-            newType->scalarType = Type::Int;
-            newType->bitWidth = typ.ops[0] & 0xffffffff;
-
-            m_Types.push_back(newType);
-            if(newType->bitWidth == 1)
-              m_BoolType = newType;
-            else if(newType->bitWidth == 8)
-              m_Int8Type = newType;
-            else if(newType->bitWidth == 32)
-              m_Int32Type = newType;
-          }
-          else if(IS_KNOWN(typ.id, TypeRecord::VECTOR))
-          {
-            Type *newType = new(alloc) Type;
-            newType->type = Type::Vector;
-            newType->elemCount = typ.ops[0] & 0xffffffff;
-            newType->inner = m_Types[(size_t)typ.ops[1]];
-
-            // copy properties out of the inner for convenience
-            newType->scalarType = newType->inner->scalarType;
-            newType->bitWidth = newType->inner->bitWidth;
-
-            m_Types.push_back(newType);
-          }
-          else if(IS_KNOWN(typ.id, TypeRecord::ARRAY))
-          {
-            Type *newType = new(alloc) Type;
-            newType->type = Type::Array;
-            newType->elemCount = typ.ops[0] & 0xffffffff;
-            newType->inner = m_Types[(size_t)typ.ops[1]];
-
-            m_Types.push_back(newType);
-          }
-          else if(IS_KNOWN(typ.id, TypeRecord::POINTER))
-          {
-            Type *newType = new(alloc) Type;
-            newType->type = Type::Pointer;
-            newType->inner = m_Types[(size_t)typ.ops[0]];
-            newType->addrSpace = Type::PointerAddrSpace(typ.ops[1]);
-
-            m_Types.push_back(newType);
-          }
-          else if(IS_KNOWN(typ.id, TypeRecord::OPAQUE))
-          {
-            Type *newType = new(alloc) Type;
-            // pretend opaque types are empty structs
-            newType->type = Type::Struct;
-            newType->opaque = true;
-
-            m_Types.push_back(newType);
-          }
-          else if(IS_KNOWN(typ.id, TypeRecord::STRUCT_NAME))
-          {
-            structname = typ.getString(0);
-          }
-          else if(IS_KNOWN(typ.id, TypeRecord::STRUCT_ANON) ||
-                  IS_KNOWN(typ.id, TypeRecord::STRUCT_NAMED))
-          {
-            Type *newType = new(alloc) Type;
-            newType->type = Type::Struct;
-            newType->packedStruct = (typ.ops[0] != 0);
-
-            for(size_t o = 1; o < typ.ops.size(); o++)
-              newType->members.push_back(m_Types[(size_t)typ.ops[o]]);
-
-            if(IS_KNOWN(typ.id, TypeRecord::STRUCT_NAMED))
-            {
-              // may we want a reverse map name -> type? probably not, this is only relevant for
-              // disassembly or linking and disassembly we can do just by iterating all types
-              newType->name = structname;
-              structname.clear();
-            }
-
-            m_Types.push_back(newType);
-          }
-          else if(IS_KNOWN(typ.id, TypeRecord::FUNCTION_OLD) ||
-                  IS_KNOWN(typ.id, TypeRecord::FUNCTION))
-          {
-            Type *newType = new(alloc) Type;
-            newType->type = Type::Function;
-
-            newType->vararg = (typ.ops[0] != 0);
-
-            size_t o = 1;
-
-            // skip attrid
-            if(IS_KNOWN(typ.id, TypeRecord::FUNCTION_OLD))
-              o++;
-
-            // return type
-            newType->inner = m_Types[(size_t)typ.ops[o]];
-            o++;
-
-            for(; o < typ.ops.size(); o++)
-              newType->members.push_back(m_Types[(size_t)typ.ops[o]]);
-
-            m_Types.push_back(newType);
-          }
-          else
-          {
-            RDCERR("Unknown record ID %u encountered in type block", typ.id);
-          }
-        }
-      }
-      else if(IS_KNOWN(rootchild.id, KnownBlock::CONSTANTS_BLOCK))
-      {
-        m_CurParseType = NULL;
+    inst->op = Operation::CompareExchange;
 
-        values.hintExpansion(rootchild.children.size());
+    // pointer to atomically modify
+    inst->args.push_back(op.getSymbol());
 
-        for(const LLVMBC::BlockOrRecord &constant : rootchild.children)
-        {
-          if(constant.IsBlock())
-          {
-            RDCERR("Unexpected subblock in CONSTANTS_BLOCK");
-            continue;
-          }
+    // type is the pointee of the first argument
+    inst->type = inst->args.back()->type;
+    RDCASSERT(inst->type->type == Type::Pointer);
+    inst->type = inst->type->inner;
 
-          ParseConstant(values, constant);
-        }
-      }
-      else if(IS_KNOWN(rootchild.id, KnownBlock::VALUE_SYMTAB_BLOCK))
-      {
-        for(const LLVMBC::BlockOrRecord &symtab : rootchild.children)
-        {
-          if(symtab.IsBlock())
-          {
-            RDCERR("Unexpected subblock in VALUE_SYMTAB_BLOCK");
-            continue;
-          }
-
-          if(!IS_KNOWN(symtab.id, ValueSymtabRecord::ENTRY))
-          {
-            RDCERR("Unexpected symbol table record ID %u", symtab.id);
-            continue;
-          }
-
-          size_t vidx = (size_t)symtab.ops[0];
-          if(vidx < values.curValueIndex())
-          {
-            Value *v = values[vidx];
-            rdcstr str = symtab.getString(1);
-
-            SetValueSymtabString(v, str);
-
-            if(!m_ValueSymtabOrder.empty())
-              m_SortedSymtab &= GetValueSymtabString(m_ValueSymtabOrder.back()) < str;
-
-            m_ValueSymtabOrder.push_back(v);
-          }
-          else
-          {
-            RDCERR("Value %zu referenced out of bounds", vidx);
-          }
-        }
-      }
-      else if(IS_KNOWN(rootchild.id, KnownBlock::METADATA_BLOCK))
+    // combined with a bool, search for a struct like that
+    const Type *boolType = GetBoolType();
+
+    for(const Type *t : m_Types)
+    {
+      if(t->type == Type::Struct && t->members.size() == 2 && t->members[0] == inst->type &&
+         t->members[1] == boolType)
       {
-        metadata.hintExpansion(rootchild.children.size());
-        for(size_t i = 0; i < rootchild.children.size(); i++)
-        {
-          const LLVMBC::BlockOrRecord &metaRecord = rootchild.children[i];
-
-          if(metaRecord.IsBlock())
-          {
-            RDCERR("Unexpected subblock in METADATA_BLOCK");
-            continue;
-          }
-
-          if(IS_KNOWN(metaRecord.id, MetaDataRecord::NAME))
-          {
-            NamedMetadata *meta = new(alloc) NamedMetadata;
-
-            meta->name = metaRecord.getString();
-            i++;
-            const LLVMBC::BlockOrRecord &namedNode = rootchild.children[i];
-            RDCASSERT(IS_KNOWN(namedNode.id, MetaDataRecord::NAMED_NODE));
-
-            for(uint64_t op : namedNode.ops)
-              meta->children.push_back(metadata[(size_t)op]);
-
-            m_NamedMeta.push_back(meta);
-          }
-          else if(IS_KNOWN(metaRecord.id, MetaDataRecord::KIND))
-          {
-            size_t kind = (size_t)metaRecord.ops[0];
-            m_Kinds.resize_for_index(kind);
-            m_Kinds[kind] = metaRecord.getString(1);
-            continue;
-          }
-          else
-          {
-            Metadata *meta = metadata[i];
-
-            if(IS_KNOWN(metaRecord.id, MetaDataRecord::STRING_OLD))
-            {
-              meta->isConstant = true;
-              meta->isString = true;
-              meta->str = metaRecord.getString();
-            }
-            else if(IS_KNOWN(metaRecord.id, MetaDataRecord::VALUE))
-            {
-              meta->value = values[(size_t)metaRecord.ops[1]];
-              meta->type = m_Types[(size_t)metaRecord.ops[0]];
-              meta->isConstant = true;
-            }
-            else if(IS_KNOWN(metaRecord.id, MetaDataRecord::NODE) ||
-                    IS_KNOWN(metaRecord.id, MetaDataRecord::DISTINCT_NODE))
-            {
-              if(IS_KNOWN(metaRecord.id, MetaDataRecord::DISTINCT_NODE))
-                meta->isDistinct = true;
-
-              for(uint64_t op : metaRecord.ops)
-                meta->children.push_back(metadata.getOrNULL(op));
-            }
-            else
-            {
-              bool parsed = ParseDebugMetaRecord(metadata, metaRecord, *meta);
-              if(!parsed)
-              {
-                RDCERR("unhandled metadata type %u", metaRecord.id);
-              }
-            }
-          }
-        }
+        inst->type = t;
+        break;
       }
-      else if(IS_KNOWN(rootchild.id, KnownBlock::FUNCTION_BLOCK))
-      {
-        Function *f = m_Functions[functionDecls[0]];
-        functionDecls.erase(0);
+    }
 
-        // conservative resize here so we can take pointers and have them stay valid
-        f->instructions.reserve(rootchild.children.size());
+    RDCASSERT(inst->type->type == Type::Struct);
 
-        values.beginFunction();
-        metadata.beginFunction();
+    // expect modern encoding with weak parameters.
+    RDCASSERT(funcChild.ops.size() >= 8);
 
-        f->args.reserve(f->type->members.size());
-        for(size_t i = 0; i < f->type->members.size(); i++)
-        {
-          Instruction *arg = values.nextValue<Instruction>();
-          arg->type = f->type->members[i];
-          f->args.push_back(arg);
-          values.addValue();
-        }
+    // compare value
+    if(op.type == FunctionRecord::INST_CMPXCHG_OLD)
+      inst->args.push_back(op.getSymbol(false));
+    else
+      inst->args.push_back(op.getSymbol());
 
-        size_t curBlock = 0;
-        int32_t debugLocIndex = -1;
+    // new replacement value
+    inst->args.push_back(op.getSymbol(false));
 
-        values.hintExpansion(rootchild.children.size());
+    if(op.get<uint64_t>())
+      inst->opFlags() |= InstructionFlags::Volatile;
 
-        for(const LLVMBC::BlockOrRecord &funcChild : rootchild.children)
-        {
-          if(funcChild.IsBlock())
-          {
-            if(IS_KNOWN(funcChild.id, KnownBlock::CONSTANTS_BLOCK))
-            {
-              values.hintExpansion(funcChild.children.size());
-
-              m_CurParseType = NULL;
-              for(const LLVMBC::BlockOrRecord &constant : funcChild.children)
-              {
-                if(constant.IsBlock())
-                {
-                  RDCERR("Unexpected subblock in CONSTANTS_BLOCK");
-                  continue;
-                }
-
-                ParseConstant(values, constant);
-              }
-            }
-            else if(IS_KNOWN(funcChild.id, KnownBlock::METADATA_BLOCK))
-            {
-              metadata.hintExpansion(funcChild.children.size());
-
-              size_t m = metadata.size();
-
-              for(const LLVMBC::BlockOrRecord &metaRecord : funcChild.children)
-              {
-                if(metaRecord.IsBlock())
-                {
-                  RDCERR("Unexpected subblock in function METADATA_BLOCK");
-                  continue;
-                }
-
-                Metadata *meta = metadata[m];
-
-                if(IS_KNOWN(metaRecord.id, MetaDataRecord::VALUE))
-                {
-                  meta->isConstant = true;
-                  meta->value = values.getOrCreatePlaceholder((size_t)metaRecord.ops[1]);
-                  meta->type = m_Types[(size_t)metaRecord.ops[0]];
-                }
-                else
-                {
-                  RDCERR("Unexpected record %u in function METADATA_BLOCK", metaRecord.id);
-                }
-
-                m++;
-              }
-            }
-            else if(IS_KNOWN(funcChild.id, KnownBlock::VALUE_SYMTAB_BLOCK))
-            {
-              for(const LLVMBC::BlockOrRecord &symtab : funcChild.children)
-              {
-                if(symtab.IsBlock())
-                {
-                  RDCERR("Unexpected subblock in function VALUE_SYMTAB_BLOCK");
-                  continue;
-                }
-
-                if(IS_KNOWN(symtab.id, ValueSymtabRecord::ENTRY))
-                {
-                  size_t idx = (size_t)symtab.ops[0];
-
-                  if(idx >= values.curValueIndex())
-                  {
-                    RDCERR("Out of bounds symbol index %zu (%s) in function symbol table", idx,
-                           symtab.getString(1).c_str());
-                    continue;
-                  }
-
-                  Value *v = values[idx];
-                  rdcstr str = symtab.getString(1);
-
-                  SetValueSymtabString(v, str);
-
-                  if(!f->valueSymtabOrder.empty())
-                    f->sortedSymtab &= GetValueSymtabString(f->valueSymtabOrder.back()) < str;
-
-                  f->valueSymtabOrder.push_back(v);
-                }
-                else if(IS_KNOWN(symtab.id, ValueSymtabRecord::BBENTRY))
-                {
-                  Value *v = f->blocks[(size_t)symtab.ops[0]];
-                  rdcstr str = symtab.getString(1);
-
-                  SetValueSymtabString(v, str);
-
-                  if(!f->valueSymtabOrder.empty())
-                    f->sortedSymtab &= GetValueSymtabString(f->valueSymtabOrder.back()) < str;
-
-                  f->valueSymtabOrder.push_back(v);
-                }
-                else
-                {
-                  RDCERR("Unexpected function symbol table record ID %u", symtab.id);
-                  continue;
-                }
-              }
-            }
-            else if(IS_KNOWN(funcChild.id, KnownBlock::METADATA_ATTACHMENT))
-            {
-              for(const LLVMBC::BlockOrRecord &meta : funcChild.children)
-              {
-                if(meta.IsBlock())
-                {
-                  RDCERR("Unexpected subblock in METADATA_ATTACHMENT");
-                  continue;
-                }
-
-                if(!IS_KNOWN(meta.id, MetaDataRecord::ATTACHMENT))
-                {
-                  RDCERR("Unexpected record %u in METADATA_ATTACHMENT", meta.id);
-                  continue;
-                }
-
-                size_t idx = 0;
-
-                AttachedMetadata attach;
-
-                if(meta.ops.size() % 2 != 0)
-                  idx++;
-
-                for(; idx < meta.ops.size(); idx += 2)
-                  attach.push_back(make_rdcpair(meta.ops[idx], metadata.getDirect(meta.ops[idx + 1])));
-
-                if(meta.ops.size() % 2 == 0)
-                  f->attachedMeta.swap(attach);
-                else
-                  f->instructions[(size_t)meta.ops[0]]->extra(alloc).attachedMeta.swap(attach);
-              }
-            }
-            else if(IS_KNOWN(funcChild.id, KnownBlock::USELIST_BLOCK))
-            {
-              m_Uselists = true;
-              for(const LLVMBC::BlockOrRecord &uselist : funcChild.children)
-              {
-                if(uselist.IsBlock())
-                {
-                  RDCERR("Unexpected subblock in USELIST_BLOCK");
-                  continue;
-                }
-
-                const bool bb = IS_KNOWN(uselist.id, UselistRecord::BB);
-                if(IS_KNOWN(uselist.id, UselistRecord::DEFAULT) || bb)
-                {
-                  UselistEntry u;
-                  u.block = bb;
-                  u.shuffle = uselist.ops;
-                  u.value = values[(size_t)u.shuffle.back()];
-                  u.shuffle.pop_back();
-                  f->uselist.push_back(u);
-                }
-                else
-                {
-                  RDCERR("Unexpected record %u in USELIST_BLOCK", uselist.id);
-                  continue;
-                }
-              }
-            }
-            else
-            {
-              RDCERR("Unexpected subblock %u in FUNCTION_BLOCK", funcChild.id);
-              continue;
-            }
-          }
-          else
-          {
-            OpReader op(this, values, funcChild);
-
-            if(op.type == FunctionRecord::DECLAREBLOCKS)
-            {
-              f->blocks.resize(op.get<size_t>());
-              for(size_t b = 0; b < f->blocks.size(); b++)
-                f->blocks[b] = new(alloc) Block(m_LabelType);
-
-              curBlock = 0;
-            }
-            else if(op.type == FunctionRecord::DEBUG_LOC)
-            {
-              DebugLocation debugLoc;
-              debugLoc.line = op.get<uint64_t>();
-              debugLoc.col = op.get<uint64_t>();
-              debugLoc.scope = metadata.getOrNULL(op.get<uint64_t>());
-              debugLoc.inlinedAt = metadata.getOrNULL(op.get<uint64_t>());
-
-              debugLocIndex = m_DebugLocations.indexOf(debugLoc);
-
-              if(debugLocIndex < 0)
-              {
-                m_DebugLocations.push_back(debugLoc);
-                debugLocIndex = int32_t(m_DebugLocations.size() - 1);
-              }
-
-              f->instructions.back()->debugLoc = (uint32_t)debugLocIndex;
-            }
-            else if(op.type == FunctionRecord::DEBUG_LOC_AGAIN)
-            {
-              f->instructions.back()->debugLoc = (uint32_t)debugLocIndex;
-            }
-            else if(op.type == FunctionRecord::INST_CALL)
-            {
-              size_t paramAttrs = op.get<size_t>();
-
-              uint64_t callingFlags = op.get<uint64_t>();
-
-              InstructionFlags flags = InstructionFlags::NoFlags;
-
-              if(callingFlags & (1ULL << 17))
-              {
-                flags = op.get<InstructionFlags>();
-                RDCASSERT(flags != InstructionFlags::NoFlags);
-
-                callingFlags &= ~(1ULL << 17);
-              }
-
-              const Type *funcCallType = NULL;
-
-              if(callingFlags & (1ULL << 15))
-              {
-                funcCallType = op.getType();    // funcCallType
-
-                callingFlags &= ~(1ULL << 15);
-              }
-
-              RDCASSERTMSG("Calling flags should only have at most two known bits set",
-                           callingFlags == 0, callingFlags);
-
-              Function *funcCall = cast<Function>(op.getSymbol());
-
-              if(!funcCall)
-              {
-                RDCERR("Unexpected symbol type called in INST_CALL");
-                continue;
-              }
-
-              Instruction *inst = NULL;
-
-              bool voidCall = funcCall->type->inner->isVoid();
-
-              if(!voidCall)
-                inst = values.nextValue<Instruction>();
-              else
-                inst = new(alloc) Instruction();
-
-              inst->op = Operation::Call;
-              inst->extra(alloc).funcCall = funcCall;
-              inst->type = funcCall->type->inner;
-              inst->opFlags() = flags;
-              if(paramAttrs > 0)
-                inst->extra(alloc).paramAttrs = m_AttributeSets[paramAttrs - 1];
-
-              if(funcCallType)
-              {
-                RDCASSERT(funcCallType == funcCall->type);
-              }
-
-              for(size_t i = 0; op.remaining() > 0; i++)
-              {
-                Value *arg = NULL;
-                if(funcCall->type->members[i]->type == Type::Metadata)
-                {
-                  int32_t offs = (int32_t)op.get<uint32_t>();
-                  size_t idx = values.curValueIndex() - offs;
-                  arg = metadata[idx];
-                }
-                else
-                {
-                  arg = op.getSymbol(false);
-                }
-                inst->args.push_back(arg);
-              }
-
-              RDCASSERTEQUAL(inst->args.size(), funcCall->type->members.size());
-
-              f->instructions.push_back(inst);
-
-              if(!voidCall)
-                values.addValue();
-              if(funcCall->name == "dx.op.createHandleFromHeap")
-                m_directHeapAccessCount++;
-            }
-            else if(op.type == FunctionRecord::INST_CAST)
-            {
-              Instruction *inst = values.nextValue<Instruction>();
-
-              inst->args.push_back(op.getSymbol());
-              inst->type = op.getType();
-
-              uint64_t opcode = op.get<uint64_t>();
-              inst->op = DecodeCast(opcode);
-
-              f->instructions.push_back(inst);
-              values.addValue();
-            }
-            else if(op.type == FunctionRecord::INST_EXTRACTVAL)
-            {
-              Instruction *inst = values.nextValue<Instruction>();
-
-              inst->op = Operation::ExtractVal;
-
-              inst->args.push_back(op.getSymbol());
-              inst->type = inst->args.back()->type;
-              while(op.remaining() > 0)
-              {
-                uint64_t val = op.get<uint64_t>();
-                if(inst->type->type == Type::Array)
-                  inst->type = inst->type->inner;
-                else
-                  inst->type = inst->type->members[(size_t)val];
-                inst->args.push_back(new(alloc) Literal(val));
-              }
-
-              f->instructions.push_back(inst);
-              values.addValue();
-            }
-            else if(op.type == FunctionRecord::INST_RET)
-            {
-              // even rets returning a value are still void
-              Instruction *inst = new(alloc) Instruction;
-              inst->type = GetVoidType();
-
-              if(op.remaining() != 0)
-                inst->args.push_back(op.getSymbol());
-
-              inst->op = Operation::Ret;
-
-              curBlock++;
-
-              f->instructions.push_back(inst);
-            }
-            else if(op.type == FunctionRecord::INST_BINOP)
-            {
-              Instruction *inst = values.nextValue<Instruction>();
-
-              inst->args.push_back(op.getSymbol());
-              inst->type = inst->args.back()->type;
-              inst->args.push_back(op.getSymbol(false));
-
-              inst->op = DecodeBinOp(inst->type, op.get<uint64_t>());
-
-              if(op.remaining() > 0)
-              {
-                uint64_t flags = op.get<uint64_t>();
-                if(inst->op == Operation::Add || inst->op == Operation::Sub ||
-                   inst->op == Operation::Mul || inst->op == Operation::ShiftLeft)
-                {
-                  if(flags & 0x2)
-                    inst->opFlags() |= InstructionFlags::NoSignedWrap;
-                  if(flags & 0x1)
-                    inst->opFlags() |= InstructionFlags::NoUnsignedWrap;
-                }
-                else if(inst->op == Operation::SDiv || inst->op == Operation::UDiv ||
-                        inst->op == Operation::LogicalShiftRight ||
-                        inst->op == Operation::ArithShiftRight)
-                {
-                  if(flags & 0x1)
-                    inst->opFlags() |= InstructionFlags::Exact;
-                }
-                else if(inst->type->scalarType == Type::Float)
-                {
-                  // fast math flags overlap
-                  inst->opFlags() = InstructionFlags(flags);
-                }
-
-                RDCASSERT(inst->opFlags() != InstructionFlags::NoFlags);
-              }
-
-              f->instructions.push_back(inst);
-              values.addValue();
-            }
-            else if(op.type == FunctionRecord::INST_UNREACHABLE)
-            {
-              Instruction *inst = new(alloc) Instruction;
-
-              inst->op = Operation::Unreachable;
-
-              inst->type = GetVoidType();
-
-              curBlock++;
-
-              f->instructions.push_back(inst);
-            }
-            else if(op.type == FunctionRecord::INST_ALLOCA)
-            {
-              Instruction *inst = values.nextValue<Instruction>();
-
-              inst->op = Operation::Alloca;
-
-              inst->type = op.getType();
-
-              // we now have the inner type, but this instruction returns a pointer to that type so
-              // adjust
-              inst->type = GetPointerType(inst->type, Type::PointerAddrSpace::Default);
-
-              RDCASSERT(inst->type->type == Type::Pointer);
-
-              // type of the size - ignored
-              const Type *sizeType = op.getType();
-              // size
-              inst->args.push_back(op.getSymbolAbsolute());
-
-              RDCASSERT(sizeType == inst->args.back()->type);
-
-              uint64_t align = op.get<uint64_t>();
-
-              if(align & 0x20)
-              {
-                // argument alloca
-                inst->opFlags() |= InstructionFlags::ArgumentAlloca;
-              }
-              if((align & 0x40) == 0)
-              {
-                RDCASSERT(inst->type->type == Type::Pointer);
-                inst->type = inst->type->inner;
-              }
-
-              align &= ~0xE0;
-
-              RDCASSERT(align < 0x100);
-              inst->align = align & 0xff;
-
-              f->instructions.push_back(inst);
-              values.addValue();
-            }
-            else if(op.type == FunctionRecord::INST_INBOUNDS_GEP_OLD ||
-                    op.type == FunctionRecord::INST_GEP_OLD || op.type == FunctionRecord::INST_GEP)
-            {
-              Instruction *inst = values.nextValue<Instruction>();
-
-              inst->op = Operation::GetElementPtr;
-
-              if(op.type == FunctionRecord::INST_INBOUNDS_GEP_OLD)
-                inst->opFlags() |= InstructionFlags::InBounds;
-
-              if(op.type == FunctionRecord::INST_GEP)
-              {
-                if(op.get<uint64_t>())
-                  inst->opFlags() |= InstructionFlags::InBounds;
-                inst->type = op.getType();
-              }
-
-              while(op.remaining() > 0)
-              {
-                inst->args.push_back(op.getSymbol());
-
-                if(inst->type == NULL && inst->args.size() == 1)
-                  inst->type = inst->args.back()->type;
-              }
-
-              // walk the type list to get the return type
-              for(size_t idx = 2; idx < inst->args.size(); idx++)
-              {
-                if(inst->type->type == Type::Vector || inst->type->type == Type::Array)
-                {
-                  inst->type = inst->type->inner;
-                }
-                else if(inst->type->type == Type::Struct)
-                {
-                  // if it's a struct the index must be constant
-                  Constant *c = cast<Constant>(inst->args[idx]);
-                  RDCASSERT(c);
-                  inst->type = inst->type->members[c->getU32()];
-                }
-                else
-                {
-                  RDCERR("Unexpected type %d encountered in GEP", inst->type->type);
-                }
-              }
-
-              // get the pointer type
-              inst->type = GetPointerType(inst->type, inst->args[0]->type->addrSpace);
-
-              RDCASSERT(inst->type->type == Type::Pointer);
-
-              f->instructions.push_back(inst);
-              values.addValue();
-            }
-            else if(op.type == FunctionRecord::INST_LOAD)
-            {
-              Instruction *inst = values.nextValue<Instruction>();
-
-              inst->op = Operation::Load;
-
-              inst->args.push_back(op.getSymbol());
-
-              if(op.remaining() == 3)
-              {
-                inst->type = op.getType();
-              }
-              else
-              {
-                inst->type = inst->args.back()->type;
-                RDCASSERT(inst->type->type == Type::Pointer);
-                inst->type = inst->type->inner;
-              }
-
-              inst->align = op.get<uint8_t>();
-              inst->opFlags() |= (op.get<uint64_t>() != 0) ? InstructionFlags::Volatile
-                                                           : InstructionFlags::NoFlags;
-
-              f->instructions.push_back(inst);
-              values.addValue();
-            }
-            else if(op.type == FunctionRecord::INST_STORE_OLD || op.type == FunctionRecord::INST_STORE)
-            {
-              Instruction *inst = new(alloc) Instruction;
-
-              inst->op = Operation::Store;
-
-              inst->type = GetVoidType();
-
-              inst->args.push_back(op.getSymbol());
-              if(op.type == FunctionRecord::INST_STORE_OLD)
-                inst->args.push_back(op.getSymbol(false));
-              else
-                inst->args.push_back(op.getSymbol());
-
-              inst->align = op.get<uint8_t>();
-              inst->opFlags() |= (op.get<uint64_t>() != 0) ? InstructionFlags::Volatile
-                                                           : InstructionFlags::NoFlags;
-
-              f->instructions.push_back(inst);
-            }
-            else if(op.type == FunctionRecord::INST_CMP ||
-                    IS_KNOWN(op.type, FunctionRecord::INST_CMP2))
-            {
-              Instruction *inst = values.nextValue<Instruction>();
-
-              // a
-              inst->args.push_back(op.getSymbol());
-
-              const Type *argType = inst->args.back()->type;
-
-              // b
-              inst->args.push_back(op.getSymbol(false));
-
-              uint64_t opcode = op.get<uint64_t>();
-              switch(opcode)
-              {
-                case 0: inst->op = Operation::FOrdFalse; break;
-                case 1: inst->op = Operation::FOrdEqual; break;
-                case 2: inst->op = Operation::FOrdGreater; break;
-                case 3: inst->op = Operation::FOrdGreaterEqual; break;
-                case 4: inst->op = Operation::FOrdLess; break;
-                case 5: inst->op = Operation::FOrdLessEqual; break;
-                case 6: inst->op = Operation::FOrdNotEqual; break;
-                case 7: inst->op = Operation::FOrd; break;
-                case 8: inst->op = Operation::FUnord; break;
-                case 9: inst->op = Operation::FUnordEqual; break;
-                case 10: inst->op = Operation::FUnordGreater; break;
-                case 11: inst->op = Operation::FUnordGreaterEqual; break;
-                case 12: inst->op = Operation::FUnordLess; break;
-                case 13: inst->op = Operation::FUnordLessEqual; break;
-                case 14: inst->op = Operation::FUnordNotEqual; break;
-                case 15: inst->op = Operation::FOrdTrue; break;
-
-                case 32: inst->op = Operation::IEqual; break;
-                case 33: inst->op = Operation::INotEqual; break;
-                case 34: inst->op = Operation::UGreater; break;
-                case 35: inst->op = Operation::UGreaterEqual; break;
-                case 36: inst->op = Operation::ULess; break;
-                case 37: inst->op = Operation::ULessEqual; break;
-                case 38: inst->op = Operation::SGreater; break;
-                case 39: inst->op = Operation::SGreaterEqual; break;
-                case 40: inst->op = Operation::SLess; break;
-                case 41: inst->op = Operation::SLessEqual; break;
-
-                default:
-                  inst->op = Operation::FOrdFalse;
-                  RDCERR("Unexpected comparison %llu", opcode);
-                  break;
-              }
-
-              // fast math flags
-              if(op.remaining() > 0)
-              {
-                inst->opFlags() = op.get<InstructionFlags>();
-
-                RDCASSERTNOTEQUAL((uint64_t)inst->opFlags(), 0);
-              }
-
-              inst->type = GetBoolType();
-
-              // if we're comparing vectors, the return type is an equal sized bool vector
-              if(argType->type == Type::Vector)
-              {
-                for(const Type *t : m_Types)
-                {
-                  if(t->type == Type::Vector && t->inner == inst->type &&
-                     t->elemCount == argType->elemCount)
-                  {
-                    inst->type = t;
-                    break;
-                  }
-                }
-              }
-
-              RDCASSERT(inst->type->type == argType->type &&
-                        inst->type->elemCount == argType->elemCount);
-
-              f->instructions.push_back(inst);
-              values.addValue();
-            }
-            else if(op.type == FunctionRecord::INST_SELECT || op.type == FunctionRecord::INST_VSELECT)
-            {
-              Instruction *inst = values.nextValue<Instruction>();
-
-              inst->op = Operation::Select;
-
-              // if true
-              inst->args.push_back(op.getSymbol());
-
-              inst->type = inst->args.back()->type;
-
-              // if false
-              inst->args.push_back(op.getSymbol(false));
-              // selector
-              if(op.type == FunctionRecord::INST_SELECT)
-                inst->args.push_back(op.getSymbol(false));
-              else
-                inst->args.push_back(op.getSymbol());
-
-              f->instructions.push_back(inst);
-              values.addValue();
-            }
-            else if(op.type == FunctionRecord::INST_BR)
-            {
-              Instruction *inst = new(alloc) Instruction;
-
-              inst->op = Operation::Branch;
-
-              inst->type = GetVoidType();
-
-              // true destination
-              uint64_t trueDest = op.get<uint64_t>();
-              inst->args.push_back(f->blocks[(size_t)trueDest]);
-              f->blocks[(size_t)trueDest]->preds.insert(0, f->blocks[curBlock]);
-
-              if(op.remaining() > 0)
-              {
-                // false destination
-                uint64_t falseDest = op.get<uint64_t>();
-                inst->args.push_back(f->blocks[(size_t)falseDest]);
-                f->blocks[(size_t)falseDest]->preds.insert(0, f->blocks[curBlock]);
-
-                // predicate
-                inst->args.push_back(op.getSymbol(false));
-              }
-
-              curBlock++;
-
-              f->instructions.push_back(inst);
-            }
-            else if(op.type == FunctionRecord::INST_SWITCH)
-            {
-              Instruction *inst = new(alloc) Instruction;
-
-              inst->op = Operation::Switch;
-
-              inst->type = GetVoidType();
-
-              uint64_t typeIdx = op.get<uint64_t>();
-
-              static const uint64_t SWITCH_INST_MAGIC = 0x4B5;
-              if((typeIdx >> 16) == SWITCH_INST_MAGIC)
-              {
-                // type of condition
-                const Type *condType = op.getType();
-
-                RDCASSERT(condType->bitWidth <= 64);
-
-                // condition
-                inst->args.push_back(op.getSymbol(false));
-
-                // default block
-                size_t defaultDest = op.get<size_t>();
-                inst->args.push_back(f->blocks[defaultDest]);
-                f->blocks[defaultDest]->preds.insert(0, f->blocks[curBlock]);
-
-                RDCERR("Unsupported switch instruction version");
-              }
-              else
-              {
-                // condition
-                inst->args.push_back(op.getSymbol(false));
-
-                // default block
-                size_t defaultDest = op.get<size_t>();
-                inst->args.push_back(f->blocks[defaultDest]);
-                f->blocks[defaultDest]->preds.insert(0, f->blocks[curBlock]);
-
-                uint64_t numCases = op.remaining() / 2;
-
-                for(uint64_t c = 0; c < numCases; c++)
-                {
-                  // case value, absolute not relative
-                  inst->args.push_back(op.getSymbolAbsolute());
-
-                  // case block
-                  size_t caseDest = op.get<size_t>();
-                  inst->args.push_back(f->blocks[caseDest]);
-                  f->blocks[caseDest]->preds.insert(0, f->blocks[curBlock]);
-                }
-              }
-
-              curBlock++;
-
-              f->instructions.push_back(inst);
-            }
-            else if(op.type == FunctionRecord::INST_PHI)
-            {
-              Instruction *inst = values.nextValue<Instruction>();
-
-              inst->op = Operation::Phi;
-
-              inst->type = op.getType();
-
-              while(op.remaining() > 0)
-              {
-                int64_t valSrc = LLVMBC::BitReader::svbr(op.get<uint64_t>());
-                uint64_t blockSrc = op.get<uint64_t>();
-
-                if(valSrc < 0)
-                {
-                  inst->args.push_back(
-                      values.createPlaceholderValue(values.getRelativeForwards(-valSrc)));
-                }
-                else
-                {
-                  inst->args.push_back(op.getSymbol((uint64_t)valSrc));
-                }
-                inst->args.push_back(f->blocks[(size_t)blockSrc]);
-              }
-
-              f->instructions.push_back(inst);
-              values.addValue();
-            }
-            else if(op.type == FunctionRecord::INST_LOADATOMIC)
-            {
-              Instruction *inst = values.nextValue<Instruction>();
-
-              inst->op = Operation::LoadAtomic;
-
-              inst->args.push_back(op.getSymbol());
-
-              if(op.remaining() == 5)
-              {
-                inst->type = op.getType();
-              }
-              else
-              {
-                inst->type = inst->args.back()->type;
-                RDCASSERT(inst->type->type == Type::Pointer);
-                inst->type = inst->type->inner;
-              }
-
-              inst->align = op.get<uint8_t>();
-              inst->opFlags() |= (op.get<uint64_t>() != 0) ? InstructionFlags::Volatile
-                                                           : InstructionFlags::NoFlags;
-
-              // success ordering
-              uint64_t opcode = op.get<uint64_t>();
-              switch(opcode)
-              {
-                case 0: break;
-                case 1: inst->opFlags() |= InstructionFlags::SuccessUnordered; break;
-                case 2: inst->opFlags() |= InstructionFlags::SuccessMonotonic; break;
-                case 3: inst->opFlags() |= InstructionFlags::SuccessAcquire; break;
-                case 4: inst->opFlags() |= InstructionFlags::SuccessRelease; break;
-                case 5: inst->opFlags() |= InstructionFlags::SuccessAcquireRelease; break;
-                case 6: inst->opFlags() |= InstructionFlags::SuccessSequentiallyConsistent; break;
-                default:
-                  RDCERR("Unexpected success ordering %llu", opcode);
-                  inst->opFlags() |= InstructionFlags::SuccessSequentiallyConsistent;
-                  break;
-              }
-
-              // synchronisation scope
-              opcode = op.get<uint64_t>();
-              switch(opcode)
-              {
-                case 0: inst->opFlags() |= InstructionFlags::SingleThread; break;
-                case 1: break;
-                default: RDCERR("Unexpected synchronisation scope %llu", opcode); break;
-              }
-
-              f->instructions.push_back(inst);
-              values.addValue();
-            }
-            else if(op.type == FunctionRecord::INST_STOREATOMIC_OLD ||
-                    op.type == FunctionRecord::INST_STOREATOMIC)
-            {
-              Instruction *inst = new(alloc) Instruction;
-
-              inst->op = Operation::StoreAtomic;
-
-              inst->type = GetVoidType();
-
-              inst->args.push_back(op.getSymbol());
-              if(op.type == FunctionRecord::INST_STOREATOMIC_OLD)
-                inst->args.push_back(op.getSymbol(false));
-              else
-                inst->args.push_back(op.getSymbol());
-
-              inst->align = op.get<uint8_t>();
-              inst->opFlags() |= (op.get<uint64_t>() != 0) ? InstructionFlags::Volatile
-                                                           : InstructionFlags::NoFlags;
-
-              // success ordering
-              uint64_t opcode = op.get<uint64_t>();
-              switch(opcode)
-              {
-                case 0: break;
-                case 1: inst->opFlags() |= InstructionFlags::SuccessUnordered; break;
-                case 2: inst->opFlags() |= InstructionFlags::SuccessMonotonic; break;
-                case 3: inst->opFlags() |= InstructionFlags::SuccessAcquire; break;
-                case 4: inst->opFlags() |= InstructionFlags::SuccessRelease; break;
-                case 5: inst->opFlags() |= InstructionFlags::SuccessAcquireRelease; break;
-                case 6: inst->opFlags() |= InstructionFlags::SuccessSequentiallyConsistent; break;
-                default:
-                  RDCERR("Unexpected success ordering %llu", opcode);
-                  inst->opFlags() |= InstructionFlags::SuccessSequentiallyConsistent;
-                  break;
-              }
-
-              // synchronisation scope
-              opcode = op.get<uint64_t>();
-              switch(opcode)
-              {
-                case 0: inst->opFlags() |= InstructionFlags::SingleThread; break;
-                case 1: break;
-                default: RDCERR("Unexpected synchronisation scope %llu", opcode); break;
-              }
-
-              f->instructions.push_back(inst);
-            }
-            else if(op.type == FunctionRecord::INST_ATOMICRMW)
-            {
-              Instruction *inst = values.nextValue<Instruction>();
-
-              // pointer to atomically modify
-              inst->args.push_back(op.getSymbol());
-
-              // type is the pointee of the first argument
-              inst->type = inst->args.back()->type;
-              RDCASSERT(inst->type->type == Type::Pointer);
-              inst->type = inst->type->inner;
-
-              // parameter value
-              inst->args.push_back(op.getSymbol(false));
-
-              uint64_t opcode = op.get<uint64_t>();
-              switch(opcode)
-              {
-                case 0: inst->op = Operation::AtomicExchange; break;
-                case 1: inst->op = Operation::AtomicAdd; break;
-                case 2: inst->op = Operation::AtomicSub; break;
-                case 3: inst->op = Operation::AtomicAnd; break;
-                case 4: inst->op = Operation::AtomicNand; break;
-                case 5: inst->op = Operation::AtomicOr; break;
-                case 6: inst->op = Operation::AtomicXor; break;
-                case 7: inst->op = Operation::AtomicMax; break;
-                case 8: inst->op = Operation::AtomicMin; break;
-                case 9: inst->op = Operation::AtomicUMax; break;
-                case 10: inst->op = Operation::AtomicUMin; break;
-                default:
-                  RDCERR("Unhandled atomicrmw op %llu", opcode);
-                  inst->op = Operation::AtomicExchange;
-                  break;
-              }
-
-              if(op.get<uint64_t>())
-                inst->opFlags() |= InstructionFlags::Volatile;
-
-              // success ordering
-              opcode = op.get<uint64_t>();
-              switch(opcode)
-              {
-                case 0: break;
-                case 1: inst->opFlags() |= InstructionFlags::SuccessUnordered; break;
-                case 2: inst->opFlags() |= InstructionFlags::SuccessMonotonic; break;
-                case 3: inst->opFlags() |= InstructionFlags::SuccessAcquire; break;
-                case 4: inst->opFlags() |= InstructionFlags::SuccessRelease; break;
-                case 5: inst->opFlags() |= InstructionFlags::SuccessAcquireRelease; break;
-                case 6: inst->opFlags() |= InstructionFlags::SuccessSequentiallyConsistent; break;
-                default:
-                  RDCERR("Unexpected success ordering %llu", opcode);
-                  inst->opFlags() |= InstructionFlags::SuccessSequentiallyConsistent;
-                  break;
-              }
-
-              // synchronisation scope
-              opcode = op.get<uint64_t>();
-              switch(opcode)
-              {
-                case 0: inst->opFlags() |= InstructionFlags::SingleThread; break;
-                case 1: break;
-                default: RDCERR("Unexpected synchronisation scope %llu", opcode); break;
-              }
-
-              f->instructions.push_back(inst);
-              values.addValue();
-            }
-            else if(op.type == FunctionRecord::INST_CMPXCHG ||
-                    op.type == FunctionRecord::INST_CMPXCHG_OLD)
-            {
-              Instruction *inst = values.nextValue<Instruction>();
-
-              inst->op = Operation::CompareExchange;
-
-              // pointer to atomically modify
-              inst->args.push_back(op.getSymbol());
-
-              // type is the pointee of the first argument
-              inst->type = inst->args.back()->type;
-              RDCASSERT(inst->type->type == Type::Pointer);
-              inst->type = inst->type->inner;
-
-              // combined with a bool, search for a struct like that
-              const Type *boolType = GetBoolType();
-
-              for(const Type *t : m_Types)
-              {
-                if(t->type == Type::Struct && t->members.size() == 2 &&
-                   t->members[0] == inst->type && t->members[1] == boolType)
-                {
-                  inst->type = t;
-                  break;
-                }
-              }
-
-              RDCASSERT(inst->type->type == Type::Struct);
-
-              // expect modern encoding with weak parameters.
-              RDCASSERT(funcChild.ops.size() >= 8);
-
-              // compare value
-              if(op.type == FunctionRecord::INST_CMPXCHG_OLD)
-                inst->args.push_back(op.getSymbol(false));
-              else
-                inst->args.push_back(op.getSymbol());
-
-              // new replacement value
-              inst->args.push_back(op.getSymbol(false));
-
-              if(op.get<uint64_t>())
-                inst->opFlags() |= InstructionFlags::Volatile;
-
-              // success ordering
-              uint64_t opcode = op.get<uint64_t>();
-              switch(opcode)
-              {
-                case 0: break;
-                case 1: inst->opFlags() |= InstructionFlags::SuccessUnordered; break;
-                case 2: inst->opFlags() |= InstructionFlags::SuccessMonotonic; break;
-                case 3: inst->opFlags() |= InstructionFlags::SuccessAcquire; break;
-                case 4: inst->opFlags() |= InstructionFlags::SuccessRelease; break;
-                case 5: inst->opFlags() |= InstructionFlags::SuccessAcquireRelease; break;
-                case 6: inst->opFlags() |= InstructionFlags::SuccessSequentiallyConsistent; break;
-                default:
-                  RDCERR("Unexpected success ordering %llu", opcode);
-                  inst->opFlags() |= InstructionFlags::SuccessSequentiallyConsistent;
-                  break;
-              }
-
-              // synchronisation scope
-              opcode = op.get<uint64_t>();
-              switch(opcode)
-              {
-                case 0: inst->opFlags() |= InstructionFlags::SingleThread; break;
-                case 1: break;
-                default: RDCERR("Unexpected synchronisation scope %llu", opcode); break;
-              }
-
-              // failure ordering
-              opcode = op.get<uint64_t>();
-              switch(opcode)
-              {
-                case 0: break;
-                case 1: inst->opFlags() |= InstructionFlags::FailureUnordered; break;
-                case 2: inst->opFlags() |= InstructionFlags::FailureMonotonic; break;
-                case 3: inst->opFlags() |= InstructionFlags::FailureAcquire; break;
-                case 4: inst->opFlags() |= InstructionFlags::FailureRelease; break;
-                case 5: inst->opFlags() |= InstructionFlags::FailureAcquireRelease; break;
-                case 6: inst->opFlags() |= InstructionFlags::FailureSequentiallyConsistent; break;
-                default:
-                  RDCERR("Unexpected failure ordering %llu", opcode);
-                  inst->opFlags() |= InstructionFlags::FailureSequentiallyConsistent;
-                  break;
-              }
-
-              if(op.get<uint64_t>())
-                inst->opFlags() |= InstructionFlags::Weak;
-
-              f->instructions.push_back(inst);
-              values.addValue();
-            }
-            else if(op.type == FunctionRecord::INST_FENCE)
-            {
-              Instruction *inst = new(alloc) Instruction;
-
-              inst->op = Operation::Fence;
-
-              inst->type = GetVoidType();
-
-              // success ordering
-              uint64_t opcode = op.get<uint64_t>();
-              switch(opcode)
-              {
-                case 0: break;
-                case 1: inst->opFlags() |= InstructionFlags::SuccessUnordered; break;
-                case 2: inst->opFlags() |= InstructionFlags::SuccessMonotonic; break;
-                case 3: inst->opFlags() |= InstructionFlags::SuccessAcquire; break;
-                case 4: inst->opFlags() |= InstructionFlags::SuccessRelease; break;
-                case 5: inst->opFlags() |= InstructionFlags::SuccessAcquireRelease; break;
-                case 6: inst->opFlags() |= InstructionFlags::SuccessSequentiallyConsistent; break;
-                default:
-                  RDCERR("Unexpected success ordering %llu", opcode);
-                  inst->opFlags() |= InstructionFlags::SuccessSequentiallyConsistent;
-                  break;
-              }
-
-              // synchronisation scope
-              opcode = op.get<uint64_t>();
-              switch(opcode)
-              {
-                case 0: inst->opFlags() |= InstructionFlags::SingleThread; break;
-                case 1: break;
-                default: RDCERR("Unexpected synchronisation scope %llu", opcode); break;
-              }
-
-              f->instructions.push_back(inst);
-            }
-            else if(op.type == FunctionRecord::INST_EXTRACTELT)
-            {
-              // DXIL claims to be scalarised but lol that's a lie
-
-              Instruction *inst = values.nextValue<Instruction>();
-
-              inst->op = Operation::ExtractElement;
-
-              // vector
-              inst->args.push_back(op.getSymbol());
-
-              // result is the scalar type within the vector
-              inst->type = inst->args.back()->type->inner;
-
-              // index
-              inst->args.push_back(op.getSymbol());
-
-              f->instructions.push_back(inst);
-              values.addValue();
-            }
-            else if(op.type == FunctionRecord::INST_INSERTELT)
-            {
-              // DXIL claims to be scalarised but lol that's a lie
-
-              Instruction *inst = values.nextValue<Instruction>();
-
-              inst->op = Operation::InsertElement;
-
-              // vector
-              inst->args.push_back(op.getSymbol());
-
-              // result is the vector type
-              inst->type = inst->args.back()->type;
-
-              // replacement element
-              inst->args.push_back(op.getSymbol(false));
-              // index
-              inst->args.push_back(op.getSymbol());
-
-              f->instructions.push_back(inst);
-              values.addValue();
-            }
-            else if(op.type == FunctionRecord::INST_SHUFFLEVEC)
-            {
-              // DXIL claims to be scalarised but is not. Surprise surprise!
-
-              Instruction *inst = values.nextValue<Instruction>();
-
-              inst->op = Operation::ShuffleVector;
-
-              // vector 1
-              inst->args.push_back(op.getSymbol());
-
-              const Type *vecType = inst->args.back()->type;
-
-              // vector 2
-              inst->args.push_back(op.getSymbol(false));
-              // indexes
-              inst->args.push_back(op.getSymbol());
-
-              // result is a vector with the inner type of the first two vectors and the element
-              // count of the last vector
-              const Type *maskType = inst->args.back()->type;
-
-              for(const Type *t : m_Types)
-              {
-                if(t->type == Type::Vector && t->inner == vecType->inner &&
-                   t->elemCount == maskType->elemCount)
-                {
-                  inst->type = t;
-                  break;
-                }
-              }
-
-              RDCASSERT(inst->type);
-
-              f->instructions.push_back(inst);
-              values.addValue();
-            }
-            else if(op.type == FunctionRecord::INST_INSERTVAL)
-            {
-              // DXIL claims to be scalarised so should this appear?
-              RDCWARN("Unexpected aggregate instruction insertvalue in DXIL");
-
-              Instruction *inst = values.nextValue<Instruction>();
-
-              inst->op = Operation::InsertValue;
-
-              // aggregate
-              inst->args.push_back(op.getSymbol());
-
-              // result is the aggregate type
-              inst->type = inst->args.back()->type;
-
-              // replacement element
-              inst->args.push_back(op.getSymbol());
-              // indices as literals
-              while(op.remaining() > 0)
-                inst->args.push_back(new(alloc) Literal(op.get<uint64_t>()));
-
-              f->instructions.push_back(inst);
-              values.addValue();
-            }
-            else if(op.type == FunctionRecord::INST_VAARG)
-            {
-              // don't expect vararg instructions
-              RDCERR("Unexpected vararg instruction %u in DXIL", op.type);
-            }
-            else if(op.type == FunctionRecord::INST_LANDINGPAD ||
-                    op.type == FunctionRecord::INST_LANDINGPAD_OLD ||
-                    op.type == FunctionRecord::INST_INVOKE || op.type == FunctionRecord::INST_RESUME)
-            {
-              // don't expect exception handling instructions
-              RDCERR("Unexpected exception handling instruction %u in DXIL", op.type);
-            }
-            else
-            {
-              RDCERR("Unexpected record in FUNCTION_BLOCK");
-              continue;
-            }
-          }
-        }
+    // success ordering
+    uint64_t opcode = op.get<uint64_t>();
+    switch(opcode)
+    {
+      case 0: break;
+      case 1: inst->opFlags() |= InstructionFlags::SuccessUnordered; break;
+      case 2: inst->opFlags() |= InstructionFlags::SuccessMonotonic; break;
+      case 3: inst->opFlags() |= InstructionFlags::SuccessAcquire; break;
+      case 4: inst->opFlags() |= InstructionFlags::SuccessRelease; break;
+      case 5: inst->opFlags() |= InstructionFlags::SuccessAcquireRelease; break;
+      case 6: inst->opFlags() |= InstructionFlags::SuccessSequentiallyConsistent; break;
+      default:
+        RDCERR("Unexpected success ordering %llu", opcode);
+        inst->opFlags() |= InstructionFlags::SuccessSequentiallyConsistent;
+        break;
+    }
+
+    // synchronisation scope
+    opcode = op.get<uint64_t>();
+    switch(opcode)
+    {
+      case 0: inst->opFlags() |= InstructionFlags::SingleThread; break;
+      case 1: break;
+      default: RDCERR("Unexpected synchronisation scope %llu", opcode); break;
+    }
 
-        RDCASSERT(curBlock == f->blocks.size());
+    // failure ordering
+    opcode = op.get<uint64_t>();
+    switch(opcode)
+    {
+      case 0: break;
+      case 1: inst->opFlags() |= InstructionFlags::FailureUnordered; break;
+      case 2: inst->opFlags() |= InstructionFlags::FailureMonotonic; break;
+      case 3: inst->opFlags() |= InstructionFlags::FailureAcquire; break;
+      case 4: inst->opFlags() |= InstructionFlags::FailureRelease; break;
+      case 5: inst->opFlags() |= InstructionFlags::FailureAcquireRelease; break;
+      case 6: inst->opFlags() |= InstructionFlags::FailureSequentiallyConsistent; break;
+      default:
+        RDCERR("Unexpected failure ordering %llu", opcode);
+        inst->opFlags() |= InstructionFlags::FailureSequentiallyConsistent;
+        break;
+    }
 
-        curBlock = 0;
-        for(size_t i = 0; i < f->instructions.size(); i++)
-        {
-          Instruction &inst = *f->instructions[i];
-          if(inst.op == Operation::Branch || inst.op == Operation::Unreachable ||
-             inst.op == Operation::Switch || inst.op == Operation::Ret)
-          {
-            curBlock++;
+    if(op.get<uint64_t>())
+      inst->opFlags() |= InstructionFlags::Weak;
 
-            if(i == f->instructions.size() - 1)
-              break;
+    f->instructions.push_back(inst);
+    values.addValue();
+  }
+  else if(op.type == FunctionRecord::INST_FENCE)
+  {
+    Instruction *inst = new(alloc) Instruction;
 
-            continue;
-          }
+    inst->op = Operation::Fence;
 
-          if(inst.type->isVoid())
-            continue;
+    inst->type = GetVoidType();
 
-          if(!inst.getName().empty())
-            continue;
-        }
+    // success ordering
+    uint64_t opcode = op.get<uint64_t>();
+    switch(opcode)
+    {
+      case 0: break;
+      case 1: inst->opFlags() |= InstructionFlags::SuccessUnordered; break;
+      case 2: inst->opFlags() |= InstructionFlags::SuccessMonotonic; break;
+      case 3: inst->opFlags() |= InstructionFlags::SuccessAcquire; break;
+      case 4: inst->opFlags() |= InstructionFlags::SuccessRelease; break;
+      case 5: inst->opFlags() |= InstructionFlags::SuccessAcquireRelease; break;
+      case 6: inst->opFlags() |= InstructionFlags::SuccessSequentiallyConsistent; break;
+      default:
+        RDCERR("Unexpected success ordering %llu", opcode);
+        inst->opFlags() |= InstructionFlags::SuccessSequentiallyConsistent;
+        break;
+    }
 
-        values.endFunction();
-        metadata.endFunction();
-      }
-      else
+    // synchronisation scope
+    opcode = op.get<uint64_t>();
+    switch(opcode)
+    {
+      case 0: inst->opFlags() |= InstructionFlags::SingleThread; break;
+      case 1: break;
+      default: RDCERR("Unexpected synchronisation scope %llu", opcode); break;
+    }
+
+    f->instructions.push_back(inst);
+  }
+  else if(op.type == FunctionRecord::INST_EXTRACTELT)
+  {
+    // DXIL claims to be scalarised but lol that's a lie
+
+    Instruction *inst = values.nextValue<Instruction>();
+
+    inst->op = Operation::ExtractElement;
+
+    // vector
+    inst->args.push_back(op.getSymbol());
+
+    // result is the scalar type within the vector
+    inst->type = inst->args.back()->type->inner;
+
+    // index
+    inst->args.push_back(op.getSymbol());
+
+    f->instructions.push_back(inst);
+    values.addValue();
+  }
+  else if(op.type == FunctionRecord::INST_INSERTELT)
+  {
+    // DXIL claims to be scalarised but lol that's a lie
+
+    Instruction *inst = values.nextValue<Instruction>();
+
+    inst->op = Operation::InsertElement;
+
+    // vector
+    inst->args.push_back(op.getSymbol());
+
+    // result is the vector type
+    inst->type = inst->args.back()->type;
+
+    // replacement element
+    inst->args.push_back(op.getSymbol(false));
+    // index
+    inst->args.push_back(op.getSymbol());
+
+    f->instructions.push_back(inst);
+    values.addValue();
+  }
+  else if(op.type == FunctionRecord::INST_SHUFFLEVEC)
+  {
+    // DXIL claims to be scalarised but is not. Surprise surprise!
+
+    Instruction *inst = values.nextValue<Instruction>();
+
+    inst->op = Operation::ShuffleVector;
+
+    // vector 1
+    inst->args.push_back(op.getSymbol());
+
+    const Type *vecType = inst->args.back()->type;
+
+    // vector 2
+    inst->args.push_back(op.getSymbol(false));
+    // indexes
+    inst->args.push_back(op.getSymbol());
+
+    // result is a vector with the inner type of the first two vectors and the element
+    // count of the last vector
+    const Type *maskType = inst->args.back()->type;
+
+    for(const Type *t : m_Types)
+    {
+      if(t->type == Type::Vector && t->inner == vecType->inner &&
+         t->elemCount == maskType->elemCount)
       {
-        RDCERR("Unknown block ID %u encountered at module scope", rootchild.id);
+        inst->type = t;
+        break;
       }
     }
+
+    RDCASSERT(inst->type);
+
+    f->instructions.push_back(inst);
+    values.addValue();
   }
+  else if(op.type == FunctionRecord::INST_INSERTVAL)
+  {
+    // DXIL claims to be scalarised so should this appear?
+    RDCWARN("Unexpected aggregate instruction insertvalue in DXIL");
 
-  // pointer fixups. This is only needed for global variabls as it has forward references to
-  // constants before we can even reserve the constants.
-  for(GlobalVar *g : m_GlobalVars)
+    Instruction *inst = values.nextValue<Instruction>();
+
+    inst->op = Operation::InsertValue;
+
+    // aggregate
+    inst->args.push_back(op.getSymbol());
+
+    // result is the aggregate type
+    inst->type = inst->args.back()->type;
+
+    // replacement element
+    inst->args.push_back(op.getSymbol());
+    // indices as literals
+    while(op.remaining() > 0)
+      inst->args.push_back(new(alloc) Literal(op.get<uint64_t>()));
+
+    f->instructions.push_back(inst);
+    values.addValue();
+  }
+  else if(op.type == FunctionRecord::INST_VAARG)
   {
-    if(g->initialiser)
+    // don't expect vararg instructions
+    RDCERR("Unexpected vararg instruction %u in DXIL", op.type);
+  }
+  else if(op.type == FunctionRecord::INST_LANDINGPAD ||
+          op.type == FunctionRecord::INST_LANDINGPAD_OLD ||
+          op.type == FunctionRecord::INST_INVOKE || op.type == FunctionRecord::INST_RESUME)
+  {
+    // don't expect exception handling instructions
+    RDCERR("Unexpected exception handling instruction %u in DXIL", op.type);
+  }
+  else
+  {
+    RDCERR("Unexpected record in FUNCTION_BLOCK");
+  }
+}
+
+void Program::EndFunctionBlock(ParseState &state)
+{
+  Function *f = state.func;
+  size_t &curBlock = state.curBlock;
+
+  RDCASSERT(curBlock == f->blocks.size());
+
+  curBlock = 0;
+  for(size_t i = 0; i < f->instructions.size(); i++)
+  {
+    Instruction &inst = *f->instructions[i];
+    if(inst.op == Operation::Branch || inst.op == Operation::Unreachable ||
+       inst.op == Operation::Switch || inst.op == Operation::Ret)
     {
-      size_t idx = g->initialiser - (Constant *)NULL;
-      g->initialiser = cast<Constant>(values[idx - 1]);
+      curBlock++;
+
+      if(i == f->instructions.size() - 1)
+        break;
+
+      continue;
     }
+
+    if(inst.type->isVoid())
+      continue;
+
+    if(!inst.getName().empty())
+      continue;
   }
 
-  RDCASSERT(functionDecls.empty());
+  state.values.endFunction();
+  state.metadata.endFunction();
 }
 
 rdcstr Program::GetValueSymtabString(Value *v)
@@ -2838,3 +2843,183 @@ void LLVMOrderAccumulator::accumulate(const Metadata *m)
 }
 
 };    // namespace DXIL
+
+#if ENABLED(ENABLE_UNIT_TESTS)
+
+#include "catch/catch.hpp"
+
+TEST_CASE("Check DXIL program parsing", "[dxil]")
+{
+  // a DXBC container with a trivial vertex shader compiled by dxc, so we don't need dxc to test
+  bytebuf dxil = {
+      0x44, 0x58, 0x42, 0x43, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+      0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0xef, 0x05, 0x00, 0x00, 0x06, 0x00,
+      0x00, 0x00, 0x38, 0x00, 0x00, 0x00, 0x48, 0x00, 0x00, 0x00, 0x7f, 0x00, 0x00, 0x00, 0xbb,
+      0x00, 0x00, 0x00, 0x37, 0x01, 0x00, 0x00, 0x53, 0x01, 0x00, 0x00, 0x53, 0x46, 0x49, 0x30,
+      0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x49, 0x53, 0x47,
+      0x31, 0x2f, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00,
+      0x00, 0x00, 0x28, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03,
+      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+      0x49, 0x4e, 0x50, 0x55, 0x54, 0x41, 0x00, 0x4f, 0x53, 0x47, 0x31, 0x34, 0x00, 0x00, 0x00,
+      0x01, 0x00, 0x00, 0x00, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x28, 0x00, 0x00,
+      0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00,
+      0x00, 0x00, 0x0f, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x53, 0x56, 0x5f, 0x50, 0x6f,
+      0x73, 0x69, 0x74, 0x69, 0x6f, 0x6e, 0x00, 0x50, 0x53, 0x56, 0x30, 0x74, 0x00, 0x00, 0x00,
+      0x24, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff, 0x01, 0x00,
+      0x00, 0x00, 0x01, 0x01, 0x00, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x08,
+      0x00, 0x00, 0x00, 0x00, 0x49, 0x4e, 0x50, 0x55, 0x54, 0x41, 0x00, 0x01, 0x00, 0x00, 0x00,
+      0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+      0x00, 0x01, 0x00, 0x41, 0x00, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+      0x00, 0x00, 0x01, 0x00, 0x44, 0x03, 0x03, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x48, 0x41, 0x53, 0x48,
+      0x14, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x22, 0x28, 0x08, 0x8c, 0xa0, 0xf5, 0x45,
+      0x32, 0x63, 0x6a, 0x19, 0x1b, 0xa0, 0xf6, 0xc4, 0x76, 0x44, 0x58, 0x49, 0x4c, 0x94, 0x04,
+      0x00, 0x00, 0x60, 0x00, 0x01, 0x00, 0x25, 0x01, 0x00, 0x00, 0x44, 0x58, 0x49, 0x4c, 0x00,
+      0x01, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00, 0x7c, 0x04, 0x00, 0x00, 0x42, 0x43, 0xc0, 0xde,
+      0x21, 0x0c, 0x00, 0x00, 0x1c, 0x01, 0x00, 0x00, 0x0b, 0x82, 0x20, 0x00, 0x02, 0x00, 0x00,
+      0x00, 0x13, 0x00, 0x00, 0x00, 0x07, 0x81, 0x23, 0x91, 0x41, 0xc8, 0x04, 0x49, 0x06, 0x10,
+      0x32, 0x39, 0x92, 0x01, 0x84, 0x0c, 0x25, 0x05, 0x08, 0x19, 0x1e, 0x04, 0x8b, 0x62, 0x80,
+      0x10, 0x45, 0x02, 0x42, 0x92, 0x0b, 0x42, 0x84, 0x10, 0x32, 0x14, 0x38, 0x08, 0x18, 0x4b,
+      0x0a, 0x32, 0x42, 0x88, 0x48, 0x90, 0x14, 0x20, 0x43, 0x46, 0x88, 0xa5, 0x00, 0x19, 0x32,
+      0x42, 0xe4, 0x48, 0x0e, 0x90, 0x11, 0x22, 0xc4, 0x50, 0x41, 0x51, 0x81, 0x8c, 0xe1, 0x83,
+      0xe5, 0x8a, 0x04, 0x21, 0x46, 0x06, 0x51, 0x18, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00, 0x1b,
+      0x88, 0xe0, 0xff, 0xff, 0xff, 0xff, 0x07, 0x40, 0x02, 0x00, 0x00, 0x49, 0x18, 0x00, 0x00,
+      0x01, 0x00, 0x00, 0x00, 0x13, 0x82, 0x00, 0x00, 0x89, 0x20, 0x00, 0x00, 0x0e, 0x00, 0x00,
+      0x00, 0x32, 0x22, 0x08, 0x09, 0x20, 0x64, 0x85, 0x04, 0x13, 0x22, 0xa4, 0x84, 0x04, 0x13,
+      0x22, 0xe3, 0x84, 0xa1, 0x90, 0x14, 0x12, 0x4c, 0x88, 0x8c, 0x0b, 0x84, 0x84, 0x4c, 0x10,
+      0x28, 0x23, 0x00, 0x25, 0x00, 0x8a, 0x39, 0x02, 0x30, 0x98, 0x23, 0x40, 0x66, 0x00, 0x8a,
+      0x01, 0x33, 0x43, 0x45, 0x36, 0x10, 0x90, 0x03, 0x03, 0x00, 0x00, 0x00, 0x13, 0x14, 0x72,
+      0xc0, 0x87, 0x74, 0x60, 0x87, 0x36, 0x68, 0x87, 0x79, 0x68, 0x03, 0x72, 0xc0, 0x87, 0x0d,
+      0xaf, 0x50, 0x0e, 0x6d, 0xd0, 0x0e, 0x7a, 0x50, 0x0e, 0x6d, 0x00, 0x0f, 0x7a, 0x30, 0x07,
+      0x72, 0xa0, 0x07, 0x73, 0x20, 0x07, 0x6d, 0x90, 0x0e, 0x71, 0xa0, 0x07, 0x73, 0x20, 0x07,
+      0x6d, 0x90, 0x0e, 0x78, 0xa0, 0x07, 0x73, 0x20, 0x07, 0x6d, 0x90, 0x0e, 0x71, 0x60, 0x07,
+      0x7a, 0x30, 0x07, 0x72, 0xd0, 0x06, 0xe9, 0x30, 0x07, 0x72, 0xa0, 0x07, 0x73, 0x20, 0x07,
+      0x6d, 0x90, 0x0e, 0x76, 0x40, 0x07, 0x7a, 0x60, 0x07, 0x74, 0xd0, 0x06, 0xe6, 0x10, 0x07,
+      0x76, 0xa0, 0x07, 0x73, 0x20, 0x07, 0x6d, 0x60, 0x0e, 0x73, 0x20, 0x07, 0x7a, 0x30, 0x07,
+      0x72, 0xd0, 0x06, 0xe6, 0x60, 0x07, 0x74, 0xa0, 0x07, 0x76, 0x40, 0x07, 0x6d, 0xe0, 0x0e,
+      0x78, 0xa0, 0x07, 0x71, 0x60, 0x07, 0x7a, 0x30, 0x07, 0x72, 0xa0, 0x07, 0x76, 0x40, 0x07,
+      0x43, 0x9e, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x86, 0x3c,
+      0x06, 0x10, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x64, 0x81, 0x00, 0x00,
+      0x0b, 0x00, 0x00, 0x00, 0x32, 0x1e, 0x98, 0x10, 0x19, 0x11, 0x4c, 0x90, 0x8c, 0x09, 0x26,
+      0x47, 0xc6, 0x04, 0x43, 0x9a, 0x12, 0x18, 0x01, 0x28, 0x85, 0x62, 0x28, 0x83, 0xf2, 0x20,
+      0x2a, 0x89, 0x11, 0x80, 0x12, 0x28, 0x83, 0x42, 0xa0, 0x1c, 0x6b, 0x08, 0x08, 0x00, 0x00,
+      0x00, 0x00, 0x00, 0x79, 0x18, 0x00, 0x00, 0x45, 0x00, 0x00, 0x00, 0x1a, 0x03, 0x4c, 0x90,
+      0x46, 0x02, 0x13, 0x44, 0x35, 0x18, 0x63, 0x0b, 0x73, 0x3b, 0x03, 0xb1, 0x2b, 0x93, 0x9b,
+      0x4b, 0x7b, 0x73, 0x03, 0x99, 0x71, 0xb9, 0x01, 0x41, 0xa1, 0x0b, 0x3b, 0x9b, 0x7b, 0x91,
+      0x2a, 0x62, 0x2a, 0x0a, 0x9a, 0x2a, 0xfa, 0x9a, 0xb9, 0x81, 0x79, 0x31, 0x4b, 0x73, 0x0b,
+      0x63, 0x4b, 0xd9, 0x10, 0x04, 0x13, 0x84, 0x41, 0x98, 0x20, 0x0c, 0xc3, 0x06, 0x61, 0x20,
+      0x26, 0x08, 0x03, 0xb1, 0x41, 0x18, 0x0c, 0x0a, 0x76, 0x73, 0x13, 0x84, 0xa1, 0xd8, 0x30,
+      0x20, 0x09, 0x31, 0x41, 0x48, 0x9a, 0x0d, 0xc1, 0x32, 0x41, 0x10, 0x00, 0x12, 0x6d, 0x61,
+      0x69, 0x6e, 0x34, 0x92, 0x9c, 0xa0, 0xaa, 0xa8, 0x82, 0x26, 0x08, 0x04, 0x32, 0x41, 0x20,
+      0x92, 0x0d, 0x01, 0x31, 0x41, 0x20, 0x94, 0x0d, 0x0b, 0xf1, 0x40, 0x91, 0x14, 0x0d, 0x13,
+      0x11, 0x01, 0x1b, 0x02, 0x8a, 0xcb, 0x94, 0xd5, 0x17, 0xd4, 0xdb, 0x5c, 0x1a, 0x5d, 0xda,
+      0x9b, 0xdb, 0x04, 0x81, 0x58, 0x26, 0x08, 0x04, 0x33, 0x41, 0x18, 0x8c, 0x09, 0xc2, 0x70,
+      0x6c, 0x10, 0x32, 0x6d, 0xc3, 0x42, 0x58, 0xd0, 0x25, 0x61, 0x03, 0x46, 0x44, 0xdb, 0x86,
+      0x80, 0xdb, 0x30, 0x54, 0x1d, 0xb0, 0xa1, 0x68, 0x1c, 0x0f, 0x00, 0xaa, 0xb0, 0xb1, 0xd9,
+      0xb5, 0xb9, 0xa4, 0x91, 0x95, 0xb9, 0xd1, 0x4d, 0x09, 0x82, 0x2a, 0x64, 0x78, 0x2e, 0x76,
+      0x65, 0x72, 0x73, 0x69, 0x6f, 0x6e, 0x53, 0x02, 0xa2, 0x09, 0x19, 0x9e, 0x8b, 0x5d, 0x18,
+      0x9b, 0x5d, 0x99, 0xdc, 0x94, 0xc0, 0xa8, 0x43, 0x86, 0xe7, 0x32, 0x87, 0x16, 0x46, 0x56,
+      0x26, 0xd7, 0xf4, 0x46, 0x56, 0xc6, 0x36, 0x25, 0x48, 0xea, 0x90, 0xe1, 0xb9, 0xd8, 0xa5,
+      0x95, 0xdd, 0x25, 0x91, 0x4d, 0xd1, 0x85, 0xd1, 0x95, 0x4d, 0x09, 0x96, 0x3a, 0x64, 0x78,
+      0x2e, 0x65, 0x6e, 0x74, 0x72, 0x79, 0x50, 0x6f, 0x69, 0x6e, 0x74, 0x73, 0x53, 0x02, 0x0f,
+      0x00, 0x00, 0x79, 0x18, 0x00, 0x00, 0x4c, 0x00, 0x00, 0x00, 0x33, 0x08, 0x80, 0x1c, 0xc4,
+      0xe1, 0x1c, 0x66, 0x14, 0x01, 0x3d, 0x88, 0x43, 0x38, 0x84, 0xc3, 0x8c, 0x42, 0x80, 0x07,
+      0x79, 0x78, 0x07, 0x73, 0x98, 0x71, 0x0c, 0xe6, 0x00, 0x0f, 0xed, 0x10, 0x0e, 0xf4, 0x80,
+      0x0e, 0x33, 0x0c, 0x42, 0x1e, 0xc2, 0xc1, 0x1d, 0xce, 0xa1, 0x1c, 0x66, 0x30, 0x05, 0x3d,
+      0x88, 0x43, 0x38, 0x84, 0x83, 0x1b, 0xcc, 0x03, 0x3d, 0xc8, 0x43, 0x3d, 0x8c, 0x03, 0x3d,
+      0xcc, 0x78, 0x8c, 0x74, 0x70, 0x07, 0x7b, 0x08, 0x07, 0x79, 0x48, 0x87, 0x70, 0x70, 0x07,
+      0x7a, 0x70, 0x03, 0x76, 0x78, 0x87, 0x70, 0x20, 0x87, 0x19, 0xcc, 0x11, 0x0e, 0xec, 0x90,
+      0x0e, 0xe1, 0x30, 0x0f, 0x6e, 0x30, 0x0f, 0xe3, 0xf0, 0x0e, 0xf0, 0x50, 0x0e, 0x33, 0x10,
+      0xc4, 0x1d, 0xde, 0x21, 0x1c, 0xd8, 0x21, 0x1d, 0xc2, 0x61, 0x1e, 0x66, 0x30, 0x89, 0x3b,
+      0xbc, 0x83, 0x3b, 0xd0, 0x43, 0x39, 0xb4, 0x03, 0x3c, 0xbc, 0x83, 0x3c, 0x84, 0x03, 0x3b,
+      0xcc, 0xf0, 0x14, 0x76, 0x60, 0x07, 0x7b, 0x68, 0x07, 0x37, 0x68, 0x87, 0x72, 0x68, 0x07,
+      0x37, 0x80, 0x87, 0x70, 0x90, 0x87, 0x70, 0x60, 0x07, 0x76, 0x28, 0x07, 0x76, 0xf8, 0x05,
+      0x76, 0x78, 0x87, 0x77, 0x80, 0x87, 0x5f, 0x08, 0x87, 0x71, 0x18, 0x87, 0x72, 0x98, 0x87,
+      0x79, 0x98, 0x81, 0x2c, 0xee, 0xf0, 0x0e, 0xee, 0xe0, 0x0e, 0xf5, 0xc0, 0x0e, 0xec, 0x30,
+      0x03, 0x62, 0xc8, 0xa1, 0x1c, 0xe4, 0xa1, 0x1c, 0xcc, 0xa1, 0x1c, 0xe4, 0xa1, 0x1c, 0xdc,
+      0x61, 0x1c, 0xca, 0x21, 0x1c, 0xc4, 0x81, 0x1d, 0xca, 0x61, 0x06, 0xd6, 0x90, 0x43, 0x39,
+      0xc8, 0x43, 0x39, 0x98, 0x43, 0x39, 0xc8, 0x43, 0x39, 0xb8, 0xc3, 0x38, 0x94, 0x43, 0x38,
+      0x88, 0x03, 0x3b, 0x94, 0xc3, 0x2f, 0xbc, 0x83, 0x3c, 0xfc, 0x82, 0x3b, 0xd4, 0x03, 0x3b,
+      0xb0, 0xc3, 0x0c, 0xc4, 0x21, 0x07, 0x7c, 0x70, 0x03, 0x7a, 0x28, 0x87, 0x76, 0x80, 0x87,
+      0x19, 0xd1, 0x43, 0x0e, 0xf8, 0xe0, 0x06, 0xe4, 0x20, 0x0e, 0xe7, 0xe0, 0x06, 0xf6, 0x10,
+      0x0e, 0xf2, 0xc0, 0x0e, 0xe1, 0x90, 0x0f, 0xef, 0x50, 0x0f, 0xf4, 0x00, 0x00, 0x00, 0x71,
+      0x20, 0x00, 0x00, 0x06, 0x00, 0x00, 0x00, 0x16, 0x50, 0x0d, 0x97, 0xef, 0x3c, 0xbe, 0x34,
+      0x39, 0x11, 0x81, 0x52, 0xd3, 0x43, 0x4d, 0x7e, 0x71, 0xdb, 0x06, 0x40, 0x30, 0x00, 0xd2,
+      0x00, 0x61, 0x20, 0x00, 0x00, 0x18, 0x00, 0x00, 0x00, 0x13, 0x04, 0x41, 0x2c, 0x10, 0x00,
+      0x00, 0x00, 0x09, 0x00, 0x00, 0x00, 0x44, 0x45, 0x40, 0x35, 0x46, 0x00, 0x82, 0x20, 0x88,
+      0x7f, 0x63, 0x04, 0x20, 0x08, 0x82, 0x20, 0x18, 0x8c, 0x11, 0x80, 0x20, 0x08, 0x92, 0x60,
+      0x30, 0x46, 0x00, 0x82, 0x20, 0x88, 0x82, 0x01, 0x00, 0x00, 0x00, 0x00, 0x23, 0x06, 0x09,
+      0x00, 0x82, 0x60, 0x60, 0x48, 0x0f, 0x04, 0x29, 0xc4, 0x88, 0x41, 0x02, 0x80, 0x20, 0x18,
+      0x18, 0xd2, 0x03, 0x41, 0xc9, 0x30, 0x62, 0x90, 0x00, 0x20, 0x08, 0x06, 0x86, 0xf4, 0x40,
+      0x50, 0x21, 0x8c, 0x18, 0x24, 0x00, 0x08, 0x82, 0x81, 0x21, 0x3d, 0x10, 0x84, 0x04, 0x08,
+      0x00, 0x00, 0x00, 0x00,
+  };
+
+  // find the DXIL chunk
+  const byte *bytes = NULL;
+  uint32_t length = 0;
+  const uint32_t numChunks = *(const uint32_t *)(dxil.data() + 28);
+  const uint32_t *chunkOffsets = (const uint32_t *)(dxil.data() + 32);
+  for(uint32_t i = 0; i < numChunks; i++)
+  {
+    const uint32_t *chunk = (const uint32_t *)(dxil.data() + chunkOffsets[i]);
+    if(chunk[0] == MAKE_FOURCC('D', 'X', 'I', 'L'))
+    {
+      bytes = (const byte *)(chunk + 2);
+      length = chunk[1];
+    }
+  }
+
+  REQUIRE(bytes);
+  REQUIRE(DXIL::Program::Valid(bytes, length));
+
+  DXIL::Program program(bytes, length);
+
+  // this is the disassembly from the parser before it was changed to visit records as they are
+  // decoded, instead of building the whole tree first.
+  const rdcstr expected = R"EOF(; Vertex Shader, compiled under SM6.0
+
+target datalayout = "e-m:e-p:32:32-i1:32-i8:32-i16:32-i32:32-i64:64-f16:32-f32:32-f64:64-n8:16:32:64"
+target triple = "dxil-ms-dx"
+
+define void @main() {
+  call void @dx.op.storeOutput.f32(i32 5, i32 0, i32 0, i8 0, float 1.000000e+00)  ; StoreOutput(outputSigId,rowIndex,colIndex,value)
+  call void @dx.op.storeOutput.f32(i32 5, i32 0, i32 0, i8 1, float 2.000000e+00)  ; StoreOutput(outputSigId,rowIndex,colIndex,value)
+  call void @dx.op.storeOutput.f32(i32 5, i32 0, i32 0, i8 2, float 3.000000e+00)  ; StoreOutput(outputSigId,rowIndex,colIndex,value)
+  call void @dx.op.storeOutput.f32(i32 5, i32 0, i32 0, i8 3, float 4.000000e+00)  ; StoreOutput(outputSigId,rowIndex,colIndex,value)
+  ret void
+}
+
+; Function Attrs: nounwind
+declare void @dx.op.storeOutput.f32(i32, i32, i32, i8, float) #0
+
+attributes #0 = { nounwind }
+
+!llvm.ident = !{!0}
+!dx.version = !{!1}
+!dx.valver = !{!2}
+!dx.shaderModel = !{!3}
+!dx.viewIdState = !{!4}
+!dx.entryPoints = !{!5}
+
+!0 = !{!"clang version 3.7 (tags/RELEASE_370/final)"}
+!1 = !{i32 1, i32 0}
+!2 = !{i32 1, i32 5}
+!3 = !{!"vs", i32 6, i32 0}
+!4 = !{[3 x i32] [i32 1, i32 4, i32 0]}
+!5 = !{void ()* @main, !"main", !6, null, null}
+!6 = !{!7, !10, null}
+!7 = !{!8}
+!8 = !{i32 0, !"INPUTA", i8 9, i8 0, !9, i8 0, i32 1, i8 1, i32 0, i8 0, null}
+!9 = !{i32 0}
+!10 = !{!11}
+!11 = !{i32 0, !"SV_Position", i8 9, i8 3, !9, i8 4, i32 1, i8 4, i32 0, i8 0, !12}
+!12 = !{i32 3, i32 15}
+
+)EOF";
+
+  CHECK(program.GetDisassembly(true, NULL) == expected);
+};
+
+#endif    // ENABLED(ENABLE_UNIT_TESTS)
@@ -24,13 +24,14 @@
 
 #pragma once
 
+#include <limits.h>
 #include <stdint.h>
 
 #include "api/replay/apidefs.h"
 #include "api/replay/rdcflatmap.h"
 #include "api/replay/rdcstr.h"
 #include "common/common.h"
-#include "driver/dx/official/d3dcommon.h"
+#include "driver/shaders/dxbc/dxbc_d3dcommon.h"
 #include "driver/shaders/dxbc/dxbc_common.h"
 #include "driver/shaders/dxil/dxil_common.h"
 
@@ -873,7 +874,6 @@ struct ValueList : private rdcarray<Value *>
     RDCASSERT(at(i));
     return at(i);
   }
-  void hintExpansion(size_t newValues) { reserve(lastValue + newValues); }
   void beginFunction() { functionWatermark = lastValue; }
   void endFunction()
   {
@@ -909,7 +909,7 @@ struct ValueList : private rdcarray<Value *>
   T *nextValue()
   {
     RDCASSERT(!pendingValue);
-    RDCCOMPILE_ASSERT(typename T::IsForwardReferenceable,
+    RDCCOMPILE_ASSERT(T::IsForwardReferenceable,
                       "alloc'ing next value for non-forward-referenceable type");
 
     pendingValue = true;
@@ -1277,7 +1277,6 @@ struct MetadataList : private rdcarray<Metadata *>
     at(i) = new(*alloc) Metadata(i);
     return at(i);
   }
-  void hintExpansion(size_t newValues) { reserve(size() + newValues); }
   void beginFunction() { functionWatermark = size(); }
   void endFunction() { resize(functionWatermark); }
   using rdcarray<Metadata *>::size;
@@ -1706,6 +1705,20 @@ protected:
   void MakeDXCDisassemblyString();
   void MakeRDDisassemblyString(const DXBC::Reflection *reflection);
 
+  struct ParseState;
+  bool ParseModuleRecord(ParseState &state, const LLVMBC::BlockOrRecord &rootchild);
+  void ParseAttributeGroup(const LLVMBC::BlockOrRecord &attrgroup);
+  void ParseAttributeSet(const LLVMBC::BlockOrRecord &paramattr);
+  void ParseType(ParseState &state, const LLVMBC::BlockOrRecord &typ);
+  void ParseSymtabEntry(ParseState &state, const LLVMBC::BlockOrRecord &symtab);
+  void ParseMetadata(ParseState &state, const LLVMBC::BlockOrRecord &metaRecord);
+  void BeginFunctionBlock(ParseState &state);
+  void ParseFunctionMetadata(ParseState &state, const LLVMBC::BlockOrRecord &metaRecord);
+  void ParseFunctionSymtabEntry(ParseState &state, const LLVMBC::BlockOrRecord &symtab);
+  void ParseMetadataAttachment(ParseState &state, const LLVMBC::BlockOrRecord &meta);
+  void ParseUselist(ParseState &state, const LLVMBC::BlockOrRecord &uselist);
+  void ParseFunctionRecord(ParseState &state, const LLVMBC::BlockOrRecord &funcChild);
+  void EndFunctionBlock(ParseState &state);
   void ParseConstant(ValueList &values, const LLVMBC::BlockOrRecord &constant);
   bool ParseDebugMetaRecord(MetadataList &metadata, const LLVMBC::BlockOrRecord &metaRecord,
                             Metadata &meta);
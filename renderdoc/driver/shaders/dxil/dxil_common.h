@@ -24,6 +24,9 @@
 
 #pragma once
 
+#include <stdint.h>
+#include "api/replay/replay_enums.h"
+
 namespace DXBC
 {
 enum class ShaderType : uint8_t;
@@ -7791,7 +7791,8 @@ Debugger::~Debugger()
 {
   CHECK_DEBUGGER_THREAD();
   AtomicStore(&atomic_simulationFinished, 1);
-  Threading::JobSystem::SyncAllJobs();
+  Threading::JobSystem::WaitAndFree(m_SimulationJobs);
+  m_SimulationJobs.clear();
   SAFE_DELETE(m_ApiWrapper);
 }
 
@@ -9815,7 +9816,8 @@ ShaderDebugTrace *Debugger::BeginDebug(DebugAPIWrapper *apiWrapper, uint32_t eve
     {
       uint32_t countJobs = RDCMIN(threadsInWorkgroup, Threading::JobSystem::GetCountWorkers() / 2U);
       for(uint32_t i = 0; i < countJobs; ++i)
-        Threading::JobSystem::AddJob([this]() { SimulationJobHelper(); });
+        m_SimulationJobs.push_back(
+            Threading::JobSystem::AddJob([this]() { SimulationJobHelper(); }));
     }
   }
   return ret;
@@ -9983,7 +9985,9 @@ rdcarray<ShaderDebugState> Debugger::ContinueDebug()
   if(active.Finished())
   {
     AtomicStore(&atomic_simulationFinished, 1);
-    Threading::JobSystem::SyncAllJobs();
+    // only wait for our own jobs, not any unrelated work
+    Threading::JobSystem::WaitAndFree(m_SimulationJobs);
+    m_SimulationJobs.clear();
     return ret;
   }
 
@@ -10474,8 +10478,8 @@ void Debugger::QueueJob(uint32_t lane)
   {
     if(D3D12_Hack_ShaderDebugUsesJobSystemJobs())
     {
-      Threading::JobSystem::AddJob(
-          [this, lane]() { StepThread(lane, StepThreadMode::RUN_MULTIPLE_STEPS); });
+      m_SimulationJobs.push_back(Threading::JobSystem::AddJob(
+          [this, lane]() { StepThread(lane, StepThreadMode::RUN_MULTIPLE_STEPS); }));
     }
     else
     {
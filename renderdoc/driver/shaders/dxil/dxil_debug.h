@@ -26,6 +26,7 @@
 
 #include <set>
 #include "common/common.h"
+#include "common/threading.h"
 #include "driver/shaders/dxbc/dx_debug.h"
 #include "driver/shaders/dxbc/dxbc_bytecode.h"
 #include "driver/shaders/dxbc/dxbc_container.h"
@@ -971,6 +972,7 @@ private:
 
   mutable Threading::CriticalSection m_AtomicMemoryLock;
   rdcarray<int32_t> m_QueuedJobs;
+  rdcarray<Threading::JobSystem::Job *> m_SimulationJobs;
   rdcarray<bool> m_QueuedDeviceThreadSteps;
   rdcarray<bool> m_QueuedGpuMathOps;
   rdcarray<bool> m_QueuedGpuSampleGatherOps;
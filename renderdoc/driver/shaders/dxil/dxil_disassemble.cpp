@@ -22,6 +22,7 @@
  * THE SOFTWARE.
  ******************************************************************************/
 
+#include <ctype.h>
 #include <math.h>
 #include <stdlib.h>
 #include <algorithm>
@@ -4578,7 +4579,7 @@ void Program::MakeRDDisassemblyString(const DXBC::Reflection *reflection)
             }
             switch(inst.op)
             {
-              case Operation::Trunc: commentStr += "truncate ";
+              case Operation::Trunc: commentStr += "truncate "; break;
               case Operation::ZExt: commentStr += "zero extend "; break;
               case Operation::SExt: commentStr += "signed extend "; break;
               case Operation::UToF: commentStr += "unsigned "; break;
@@ -4768,7 +4769,7 @@ void Program::MakeRDDisassemblyString(const DXBC::Reflection *reflection)
               commentStr += "inbounds ";
             break;
           }
-          case Operation::LoadAtomic: commentStr += "atomic ";
+          case Operation::LoadAtomic: commentStr += "atomic "; DELIBERATE_FALLTHROUGH();
           case Operation::Load:
           {
             lineStr += "*";
@@ -4787,7 +4788,7 @@ void Program::MakeRDDisassemblyString(const DXBC::Reflection *reflection)
               commentStr += StringFormat::Fmt("align %u ", (1U << inst.align) >> 1);
             break;
           }
-          case Operation::StoreAtomic: commentStr += "atomic ";
+          case Operation::StoreAtomic: commentStr += "atomic "; DELIBERATE_FALLTHROUGH();
           case Operation::Store:
           {
             if(inst.opFlags() & InstructionFlags::Volatile)
@@ -4822,7 +4823,7 @@ void Program::MakeRDDisassemblyString(const DXBC::Reflection *reflection)
               case Operation::FOrdLess: opStr = " < "; break;
               case Operation::FOrdLessEqual: opStr = " <= "; break;
               case Operation::FOrdNotEqual: opStr = " != "; break;
-              case Operation::FUnordEqual: opStr = " == ";
+              case Operation::FUnordEqual: opStr = " == "; break;
               case Operation::FUnordGreater: opStr = " > "; break;
               case Operation::FUnordGreaterEqual: opStr = " >= "; break;
               case Operation::FUnordLess: opStr = " < "; break;
@@ -5606,6 +5607,7 @@ rdcstr Type::toString(bool dxcStyleFormatting) const
             default: return StringFormat::Fmt("fp%u", bitWidth);
           }
       }
+      return "unknown_type";
     }
     case Vector:
     {
@@ -24,7 +24,7 @@
 
 #pragma once
 
-#include "driver/dx/official/d3dcommon.h"
+#include "driver/shaders/dxbc/dxbc_d3dcommon.h"
 #include "driver/shaders/dxbc/dxbc_common.h"
 #include "dxil_common.h"
 
@@ -24,37 +24,50 @@
 
 #pragma once
 
+#include "api/replay/replay_enums.h"
 #include "common/common.h"
 #include "common/formatting.h"
+#include "common/result.h"
+#include "os/os_specific.h"
 
 namespace LLVMBC
 {
+// Bits are consumed LSB-first out of a 64-bit word which is topped up from the stream several bytes
+// at a time, so most reads are only a mask and shift.
 class BitReader
 {
 public:
   BitReader(const byte *bits, size_t length)
-      : m_Bits(bits), m_Start(bits), m_End(bits + length), m_Offset(0)
+      : m_Start(bits), m_End(bits + length), m_Bits(bits), m_Word(0), m_WordBits(0)
   {
   }
-  size_t ByteOffset() const { return m_Bits - m_Start; }
-  size_t BitOffset() const { return ByteOffset() * 8 + m_Offset; }
+  size_t ByteOffset() const { return BitOffset() / 8; }
+  size_t BitOffset() const { return (m_Bits - m_Start) * 8 - m_WordBits; }
   size_t ByteLength() const { return m_End - m_Start; }
   size_t BitLength() const { return (m_End - m_Start) * 8; }
-  bool AtEndOfStream() const { return m_Bits >= m_End; }
-  void SeekByte(size_t byteOffset)
+  size_t BitsRemaining() const
   {
-    m_Bits = m_Start + byteOffset;
-    m_Offset = 0;
+    const size_t offs = BitOffset();
+    return offs < BitLength() ? BitLength() - offs : 0;
   }
+  bool AtEndOfStream() const { return BitOffset() >= BitLength(); }
+  void SeekByte(size_t byteOffset) { SeekBit(byteOffset * 8); }
   void SeekBit(size_t bitOffset)
   {
     m_Bits = m_Start + (bitOffset / 8);
-    m_Offset = (bitOffset % 8);
+    m_Word = 0;
+    m_WordBits = 0;
+
+    // if we're seeking part-way into a byte, load it and skip the bits before the offset
+    if((bitOffset % 8) != 0 && m_Bits < m_End)
+    {
+      Refill();
+      Skip(bitOffset % 8);
+    }
   }
   char c6()
   {
-    byte c = 0;
-    ReadBits(6, &c);
+    byte c = (byte)ReadBits(6);
 
     if(c <= 25)
       return char('a' + c);
@@ -75,40 +88,33 @@ public:
   template <typename T>
   T fixed(const size_t bitWidth)
   {
-    byte scratch[8] = {};
-
     RDCASSERT(bitWidth <= 64);
 
-    ReadBits(bitWidth, scratch);
+    uint64_t val = ReadBits(bitWidth);
 
     T ret;
-    memcpy(&ret, scratch, sizeof(T));
+    memcpy(&ret, &val, sizeof(T));
     return ret;
   }
 
   template <typename T>
   T vbr(const size_t groupBitSize)
   {
-    uint64_t ret = 0;
-
     RDCASSERT(groupBitSize > 1 && "chunk size must be greater than 1");
     RDCASSERT(groupBitSize <= 8 && "Only chunk sizes up to 8 supported");
-    byte scratch = 0;
-
-    const byte hibit = 1 << (groupBitSize - 1);
-    const byte lobits = hibit - 1;
 
-    uint64_t shift = 0;
-    do
-    {
-      ReadBits(groupBitSize, &scratch);
+    uint64_t ret = 0;
 
-      RDCASSERT(shift <= 63);
+    // records are almost entirely vbr6 and vbr8, which are decoded from the buffered word directly
+    // where possible
+    bool decoded = false;
+    if(groupBitSize == 6)
+      decoded = vbrBuffered<6>(ret);
+    else if(groupBitSize == 8)
+      decoded = vbrBuffered<8>(ret);
 
-      ret += (uint64_t(scratch & lobits) << shift);
-
-      shift += uint64_t(groupBitSize - 1);
-    } while(scratch & hibit);
+    if(!decoded)
+      ret = vbrGroups(groupBitSize);
 
     // check for overflow of the return type
     const uint64_t mask = ((1ULL << (sizeof(T) * 8 - 1)) - 1) << 1 | 1;
@@ -129,15 +135,54 @@ public:
   template <typename T>
   T Read()
   {
-    byte scratch[sizeof(T)] = {};
+    RDCCOMPILE_ASSERT(sizeof(T) <= sizeof(uint64_t), "Type is too large to read");
 
-    ReadBits(sizeof(T) * 8, scratch);
+    uint64_t val = ReadBits(sizeof(T) * 8);
 
     T ret;
-    memcpy(&ret, scratch, sizeof(T));
+    memcpy(&ret, &val, sizeof(T));
     return ret;
   }
 
+  // read count values of the same width, as in an abbreviated record's array operand. The stream is
+  // bounds checked once for the whole array instead of for each element.
+  void fixedArray(const size_t bitWidth, uint64_t *dst, size_t count)
+  {
+    RDCASSERT(bitWidth <= 64);
+
+    if(bitWidth > 0 && count > BitsRemaining() / bitWidth)
+    {
+      // let the element reads handle running off the end
+      for(size_t i = 0; i < count; i++)
+        dst[i] = ReadBits(bitWidth);
+      return;
+    }
+
+    for(size_t i = 0; i < count; i++)
+      dst[i] = ReadBitsInBounds(bitWidth);
+  }
+
+  void vbrArray(const size_t groupBitSize, uint64_t *dst, size_t count)
+  {
+    if(groupBitSize == 6)
+    {
+      for(size_t i = 0; i < count; i++)
+        if(!vbrBuffered<6>(dst[i]))
+          dst[i] = vbrGroups(6);
+    }
+    else if(groupBitSize == 8)
+    {
+      for(size_t i = 0; i < count; i++)
+        if(!vbrBuffered<8>(dst[i]))
+          dst[i] = vbrGroups(8);
+    }
+    else
+    {
+      for(size_t i = 0; i < count; i++)
+        dst[i] = vbr<uint64_t>(groupBitSize);
+    }
+  }
+
   void ReadBlob(const byte *&blobptr, size_t &bloblen)
   {
     // get the blob length
@@ -146,189 +191,217 @@ public:
     // align to dword boundary
     align32bits();
 
-    // the blob is at m_Bits now
-    blobptr = m_Bits;
+    // the blob starts at the current byte
+    const size_t byteOffs = ByteOffset();
+    blobptr = m_Start + byteOffs;
 
     // advance by the length, and align up as well
-    m_Bits += bloblen;
+    SeekByte(byteOffs + bloblen);
     align32bits();
   }
 
   void align32bits()
   {
-    // skip the rest of the current byte, if we're part-way through
-    if(m_Offset > 0)
-      Advance(8 - m_Offset);
+    const size_t bitOffs = BitOffset();
+    const size_t alignedBitOffs = AlignUp(bitOffs, (size_t)32);
 
-    const size_t byteOffs = ByteOffset();
-    const size_t alignedByteOffs = (byteOffs + 0x3) & ~0x3;
+    // the padding is usually still in the buffered word
+    if(alignedBitOffs - bitOffs <= m_WordBits)
+      Skip(alignedBitOffs - bitOffs);
+    else
+      SeekBit(alignedBitOffs);
+  }
 
-    // advance by N bytes to dword align the stream
-    m_Bits += (alignedByteOffs - byteOffs);
+  // marks the stream as invalid when its contents don't make sense, and moves to the end so that
+  // any further reads return 0s like reading off the end
+  void SetError(const rdcstr &message)
+  {
+    SET_ERROR_RESULT(m_Error, ResultCode::InternalError, "%s", message.c_str());
+
+    m_Bits = m_End;
+    m_Word = 0;
+    m_WordBits = 0;
   }
 
   bool IsErrored() { return m_Error != ResultCode::Succeeded; }
   RDResult GetError() { return m_Error; }
 
 private:
-  const byte *m_Bits, *m_Start, *m_End;
-  size_t m_Offset;
+  const byte *m_Start, *m_End;
+
+  // the next byte to be loaded into m_Word
+  const byte *m_Bits;
+
+  // the buffered bits, with the next bit to read in the LSB. Only the low m_WordBits bits are valid
+  // and any bits above them are 0
+  uint64_t m_Word;
+  size_t m_WordBits;
 
   // result indicating if an error has been encountered and the stream is now invalid, with details
   // of what happened
   RDResult m_Error;
 
-  void Advance(size_t N)
+  static uint64_t LowMask(size_t bits) { return bits >= 64 ? ~0ULL : (1ULL << bits) - 1; }
+  static uint32_t LowestSetBit(uint64_t val)
   {
-    m_Offset += N;
-    // shouldn't read more than this byte
-    RDCASSERT(m_Offset <= 8);
-
-    // roll over to next byte after consuming all 8 bits
-    if(m_Offset == 8)
-    {
-      m_Bits++;
-      m_Offset = 0;
-    }
+    const uint32_t lo = uint32_t(val & 0xffffffff);
+    if(lo)
+      return Bits::CountTrailingZeroes(lo);
+    return 32 + Bits::CountTrailingZeroes(uint32_t(val >> 32));
   }
 
-  void ReadBits(size_t bitsToRead, byte *dst)
+  // top up the word with as many whole bytes as will fit, leaving at least 57 bits buffered unless
+  // the stream runs out
+  void Refill()
   {
-    if(BitOffset() + bitsToRead > BitLength())
+    if(m_WordBits > 56)
+      return;
+
+    if(m_Bits < m_End && size_t(m_End - m_Bits) >= sizeof(uint64_t))
     {
-      SET_ERROR_RESULT(m_Error, ResultCode::InternalError, "Reading off end of bitstream");
+      uint64_t next;
+      memcpy(&next, m_Bits, sizeof(uint64_t));
 
-      // read 0s off the end of the stream.
-      // set any whole bytes to 0:
-      while(bitsToRead >= 8)
+      const size_t bytes = (63 - m_WordBits) / 8;
+      m_Word |= next << m_WordBits;
+      m_Bits += bytes;
+      m_WordBits += bytes * 8;
+
+      // the load may have brought in part of a byte above what we consumed, clear it
+      m_Word &= LowMask(m_WordBits);
+    }
+    else
+    {
+      while(m_WordBits <= 56 && m_Bits < m_End)
       {
-        *dst = 0;
-        dst++;
-        bitsToRead -= 8;
+        m_Word |= uint64_t(*m_Bits) << m_WordBits;
+        m_Bits++;
+        m_WordBits += 8;
       }
+    }
+  }
 
-      // set any remaining bits to 0:
-      if(bitsToRead)
-        *dst &= ~((1 << bitsToRead) - 1);
+  // discard bits that are already buffered
+  void Skip(size_t bits)
+  {
+    RDCASSERT(bits <= m_WordBits);
+    m_Word = bits < 64 ? m_Word >> bits : 0;
+    m_WordBits -= bits;
+  }
 
-      m_Bits = m_End;
-      m_Offset = 0;
-      return;
+  uint64_t ReadBits(size_t bitsToRead)
+  {
+    if(bitsToRead <= m_WordBits)
+    {
+      const uint64_t ret = m_Word & LowMask(bitsToRead);
+      Skip(bitsToRead);
+      return ret;
     }
 
-    size_t dstoffs = 0;
-
-    // if we're already partway through a byte, read as many bits as we need and we can
-    if(m_Offset != 0)
+    if(BitOffset() + bitsToRead > BitLength())
     {
-      const size_t avail = 8 - m_Offset;
+      // read 0s off the end of the stream, and leave it positioned at the end
+      SetError("Reading off end of bitstream");
+      return 0;
+    }
 
-      if(avail == bitsToRead)
-      {
-        // if we have just enough in this byte, great! shift and mask off, and update the offset
+    return ReadBitsInBounds(bitsToRead);
+  }
 
-        // grab the bits into the low end
-        *dst = (*m_Bits >> m_Offset);
+  // read bits that are known to be within the stream, which may need a refill
+  uint64_t ReadBitsInBounds(size_t bitsToRead)
+  {
+    if(bitsToRead > m_WordBits)
+      Refill();
 
-        Advance(bitsToRead);
+    if(bitsToRead <= m_WordBits)
+    {
+      const uint64_t ret = m_Word & LowMask(bitsToRead);
+      Skip(bitsToRead);
+      return ret;
+    }
 
-        return;
-      }
-      else if(avail > bitsToRead)
-      {
-        // we have more than enough. Similar to above but we need to mask out only the bits we need.
+    // a refill always leaves at least 57 bits, so only the widest reads get here. Take what's
+    // buffered and the rest from a fresh word - the shift is less than 64 since we had fewer bits
+    // than we wanted.
+    uint64_t ret = m_Word;
+    const size_t low = m_WordBits;
+    bitsToRead -= low;
 
-        // grab the bits into the low end and mask
-        *dst = (*m_Bits >> m_Offset) & ((1 << bitsToRead) - 1);
+    m_Word = 0;
+    m_WordBits = 0;
+    Refill();
 
-        Advance(bitsToRead);
+    ret |= (m_Word & LowMask(bitsToRead)) << low;
+    Skip(bitsToRead);
+    return ret;
+  }
 
-        return;
-      }
-      else
-      {
-        // we don't have enough. Consume what we can then continue
-        *dst = (*m_Bits >> m_Offset);
+  // decode a vbr value straight out of the buffered word, without looping over groups one read at
+  // a time. Returns false if the value isn't fully buffered, to fall back to vbrGroups.
+  template <size_t groupBitSize>
+  bool vbrBuffered(uint64_t &ret)
+  {
+    const uint64_t hibit = 1ULL << (groupBitSize - 1);
+    const uint64_t lobits = hibit - 1;
 
-        dstoffs = avail;
-        bitsToRead -= avail;
+    // keep enough buffered that whole values can usually be decoded at once
+    if(m_WordBits < 32)
+      Refill();
 
-        Advance(avail);
-      }
-    }
-    else
+    if(m_WordBits < groupBitSize)
+      return false;
+
+    // most values fit in a single group
+    if((m_Word & hibit) == 0)
     {
-      // ensure if we didn't read any bits that the byte is zeroed out, so we can OR on bits below
-      // without needing to worry
-      *dst = 0;
+      ret = m_Word & lobits;
+      Skip(groupBitSize);
+      return true;
     }
 
-    // we're now at the start of a byte since we read any remainder above.
-    RDCASSERT(m_Offset == 0);
+    // the continuation bit of every group in the word. This is a constant for each group size
+    uint64_t hibits = 0;
+    for(size_t i = groupBitSize - 1; i < 64; i += groupBitSize)
+      hibits |= 1ULL << i;
 
-    // if we have to read whole bytes, do that here.
-    if(bitsToRead >= 8)
-    {
-      if(dstoffs == 0)
-      {
-        // if dstoffs is 0 then it's an easy case, we can just copy all the whole bytes into *dst
-        memcpy(dst, m_Bits, bitsToRead / 8);
+    // the first group with its continuation bit clear is the last one. The bits above m_WordBits
+    // are 0 so mask them to only find groups that are fully buffered.
+    const uint64_t lastGroups = ~m_Word & hibits & LowMask(m_WordBits);
+    if(lastGroups == 0)
+      return false;
 
-        // manual advance
-        m_Bits += (bitsToRead / 8);
-        dst += (bitsToRead / 8);
+    const size_t numGroups = LowestSetBit(lastGroups) / groupBitSize + 1;
 
-        // make sure we read any sub-byte remainder
-        bitsToRead &= 0x7;
-      }
-      else
-      {
-        while(bitsToRead >= 8)
-        {
-          // manual advance
-          const byte cur = *m_Bits;
-          m_Bits++;
-
-          bitsToRead -= 8;
-
-          // dstoffs doesn't change because we wrap around to the same offset in the next byte.
-          // However we do need to shuffle the bits in cur around to add what will fit into the
-          // current byte, and then the remainder into the next byte.
-          *dst |= (cur << dstoffs);
-          dst++;
-          *dst = (cur >> (8 - dstoffs));
-        }
-      }
-    }
+    ret = 0;
+    for(size_t i = 0; i < numGroups; i++)
+      ret |= ((m_Word >> (i * groupBitSize)) & lobits) << (i * (groupBitSize - 1));
 
-    // if nothing remains, return
-    if(bitsToRead == 0)
-      return;
+    Skip(numGroups * groupBitSize);
+    return true;
+  }
+
+  uint64_t vbrGroups(const size_t groupBitSize)
+  {
+    const uint64_t hibit = 1ULL << (groupBitSize - 1);
+    const uint64_t lobits = hibit - 1;
 
-    // we should now have no more than than 7 bits to read
-    RDCASSERT(bitsToRead < 8);
+    uint64_t ret = 0;
+    uint64_t group = 0;
+    uint64_t shift = 0;
+    do
+    {
+      group = ReadBits(groupBitSize);
 
-    // this is the mask to get only the bits we want
-    const byte mask = ((1 << bitsToRead) - 1);
+      RDCASSERT(shift <= 63);
 
-    // take the bits that we want from the next byte (knowing we want the low-order bits), and shift
-    // them into where they should go.
-    byte data = *m_Bits & mask;
+      if(shift <= 63)
+        ret += ((group & lobits) << shift);
 
-    // check if we overlap into the next destination byte
-    if(dstoffs + bitsToRead <= 8)
-    {
-      *dst |= data << dstoffs;
-    }
-    else
-    {
-      *dst |= data << dstoffs;
-      dst++;
-      *dst = data >> (8 - dstoffs);
-    }
+      shift += uint64_t(groupBitSize - 1);
+    } while(group & hibit);
 
-    // consume the bits we used
-    Advance(bitsToRead);
+    return ret;
   }
 };
 
@@ -65,17 +65,52 @@ BitcodeReader::~BitcodeReader()
     delete it->second;
 }
 
+// builds the full tree of blocks and records for ReadToplevelBlock
+struct TreeBuilder : public BitcodeVisitor
+{
+  TreeBuilder(BlockOrRecord &root) : root(root) {}
+
+  void EnterBlock(uint32_t id, uint32_t blockDwordLength) override
+  {
+    BlockOrRecord *block = &root;
+
+    // parent blocks only get new children once this block has been exited, so this pointer stays
+    // valid until then
+    if(!stack.empty())
+    {
+      stack.back()->children.push_back(BlockOrRecord());
+      block = &stack.back()->children.back();
+    }
+
+    block->id = id;
+    block->blockDwordLength = blockDwordLength;
+    stack.push_back(block);
+  }
+
+  void Record(const BlockOrRecord &record) override { stack.back()->children.push_back(record); }
+  void ExitBlock(uint32_t id) override { stack.pop_back(); }
+
+  BlockOrRecord &root;
+  rdcarray<BlockOrRecord *> stack;
+};
+
 BlockOrRecord BitcodeReader::ReadToplevelBlock()
 {
   BlockOrRecord ret;
 
+  TreeBuilder builder(ret);
+  VisitToplevelBlock(builder);
+
+  return ret;
+}
+
+void BitcodeReader::VisitToplevelBlock(BitcodeVisitor &visitor)
+{
   // should hit ENTER_SUBBLOCK first for top-level block
   uint32_t abbrevID = b.fixed<uint32_t>(abbrevSize);
   RDCASSERT(abbrevID == ENTER_SUBBLOCK);
 
-  ReadBlockContents(ret);
-
-  return ret;
+  ReadBlockContents(visitor);
 }
 
 bool BitcodeReader::AtEndOfStream()
@@ -83,15 +118,22 @@ bool BitcodeReader::AtEndOfStream()
   return b.AtEndOfStream();
 }
 
-void BitcodeReader::ReadBlockContents(BlockOrRecord &block)
+bool BitcodeReader::IsErrored()
 {
-  block.id = b.vbr<uint32_t>(8);
+  return b.IsErrored();
+}
+
+void BitcodeReader::ReadBlockContents(BitcodeVisitor &visitor)
+{
+  const uint32_t blockId = b.vbr<uint32_t>(8);
 
   abbrevSize = b.vbr<size_t>(4);
   blockStack.push_back(new BlockContext(abbrevSize));
 
   b.align32bits();
-  block.blockDwordLength = b.Read<uint32_t>();
+  visitor.EnterBlock(blockId, b.Read<uint32_t>());
+
+  BlockOrRecord &r = record;
 
   // used for blockinfo only
   BlockInfo *curBlockInfo = NULL;
@@ -107,11 +149,7 @@ void BitcodeReader::ReadBlockContents(BlockOrRecord &block)
     }
     else if(abbrevID == ENTER_SUBBLOCK)
     {
-      BlockOrRecord sub;
-
-      ReadBlockContents(sub);
-
-      block.children.push_back(sub);
+      ReadBlockContents(visitor);
     }
     else if(abbrevID == DEFINE_ABBREV)
     {
@@ -150,14 +188,15 @@ void BitcodeReader::ReadBlockContents(BlockOrRecord &block)
     }
     else if(abbrevID == UNABBREV_RECORD)
     {
-      BlockOrRecord r;
       r.id = b.vbr<uint32_t>(6);
+      r.blob = NULL;
+      r.blobLength = 0;
       uint32_t numops = b.vbr<uint32_t>(6);
       r.ops.resize(numops);
       for(uint32_t i = 0; i < numops; i++)
         r.ops[i] = b.vbr<uint64_t>(6);
 
-      if(block.id == 0)    // BLOCKINFO is block 0
+      if(blockId == 0)    // BLOCKINFO is block 0
       {
         switch(BlockInfoRecord(r.id))
         {
@@ -193,18 +232,19 @@ void BitcodeReader::ReadBlockContents(BlockOrRecord &block)
         }
       }
 
-      block.children.push_back(r);
+      visitor.Record(r);
     }
     else
     {
-      const AbbrevDesc &a = getAbbrev(block.id, abbrevID);
-
-      BlockOrRecord r;
+      const AbbrevDesc &a = getAbbrev(blockId, abbrevID);
 
       // should have at least one param for the code itself
       RDCASSERT(!a.params.empty());
 
       r.id = (uint32_t)decodeAbbrevParam(a.params[0]);
+      r.ops.clear();
+      r.blob = NULL;
+      r.blobLength = 0;
 
       // process the rest of the operands - since some might be arrays we don't know until we
       // process it how many ops the record will end up with but it will be at least one per
@@ -222,8 +262,32 @@ void BitcodeReader::ReadBlockContents(BlockOrRecord &block)
 
           size_t arrayLen = b.vbr<size_t>(6);
 
-          for(size_t el = 0; el < arrayLen; el++)
-            r.ops.push_back(decodeAbbrevParam(elType));
+          // every element takes at least one bit, so a length that couldn't fit in what's left of
+          // the stream means the stream is corrupt
+          if(elType.encoding != AbbrevEncoding::Literal && arrayLen > b.BitsRemaining())
+          {
+            b.SetError(StringFormat::Fmt("Array of length %zu doesn't fit in %zu remaining bits",
+                                         arrayLen, b.BitsRemaining()));
+            break;
+          }
+
+          const size_t first = r.ops.size();
+          r.ops.resize(first + arrayLen);
+          uint64_t *elements = r.ops.data() + first;
+
+          if(elType.encoding == AbbrevEncoding::Fixed)
+          {
+            b.fixedArray((size_t)elType.value, elements, arrayLen);
+          }
+          else if(elType.encoding == AbbrevEncoding::VBR)
+          {
+            b.vbrArray((size_t)elType.value, elements, arrayLen);
+          }
+          else
+          {
+            for(size_t el = 0; el < arrayLen; el++)
+              elements[el] = decodeAbbrevParam(elType);
+          }
 
           break;
         }
@@ -241,7 +305,11 @@ void BitcodeReader::ReadBlockContents(BlockOrRecord &block)
         }
       }
 
-      block.children.push_back(r);
+      // don't pass on a partially decoded record, and stop decoding this block
+      if(b.IsErrored())
+        break;
+
+      visitor.Record(r);
     }
   } while(abbrevID != END_BLOCK);
 
@@ -249,6 +317,8 @@ void BitcodeReader::ReadBlockContents(BlockOrRecord &block)
   blockStack.erase(blockStack.size() - 1);
 
   abbrevSize = blockStack.empty() ? 2 : blockStack.back()->abbrevSize;
+
+  visitor.ExitBlock(blockId);
 }
 
 uint64_t BitcodeReader::decodeAbbrevParam(const AbbrevParam &param)
@@ -308,6 +378,9 @@ rdcstr BlockOrRecord::getString(size_t startOffset) const
 
 #include "catch/catch.hpp"
 
+#include "common/timing.h"
+#include "llvm_encoder.h"
+
 TEST_CASE("Check LLVM bitreader", "[llvm]")
 {
   SECTION("Check simple reading of bytes")
@@ -935,6 +1008,498 @@ TEST_CASE("Check LLVM bitreader", "[llvm]")
     CHECK(b.ByteOffset() == sizeof(bits));
     CHECK(b.BitOffset() == sizeof(bits) * 8);
   }
+
+  SECTION("Check reads across word boundaries")
+  {
+    // write a long mix of widths so that values straddle every possible position in the reader's
+    // buffered word, then check they all read back
+    struct Value
+    {
+      enum
+      {
+        Fixed,
+        VBR,
+        FixedArray,
+        VBRArray,
+      } type;
+      size_t width;
+      rdcarray<uint64_t> vals;
+    };
+
+    rdcarray<Value> values;
+
+    uint64_t rand = 0x12345678;
+    auto next = [&rand]() {
+      rand = rand * 6364136223846793005ULL + 1442695040888963407ULL;
+      return rand;
+    };
+
+    bytebuf bits;
+    {
+      LLVMBC::BitWriter w(bits);
+
+      for(size_t i = 0; i < 4000; i++)
+      {
+        Value v;
+        v.type = decltype(v.type)(next() % 4);
+
+        // sometimes pick large values that need many vbr groups, otherwise keep them small
+        const uint32_t valueBits = uint32_t(next() % 8 == 0 ? next() % 65 : next() % 12);
+
+        if(v.type == Value::Fixed || v.type == Value::FixedArray)
+          v.width = next() % 65;
+        else
+          v.width = 2 + next() % 7;
+
+        const size_t count =
+            (v.type == Value::FixedArray || v.type == Value::VBRArray) ? next() % 20 : 1;
+
+        for(size_t c = 0; c < count; c++)
+        {
+          uint64_t val = (valueBits >= 64 ? next() : next() & ((1ULL << valueBits) - 1));
+          if(v.type == Value::Fixed || v.type == Value::FixedArray)
+            val &= v.width >= 64 ? ~0ULL : ((1ULL << v.width) - 1);
+          v.vals.push_back(val);
+        }
+
+        if(v.type == Value::FixedArray || v.type == Value::VBRArray)
+          w.vbr(6, v.vals.size());
+
+        for(uint64_t val : v.vals)
+        {
+          if(v.type == Value::Fixed || v.type == Value::FixedArray)
+            w.fixed(v.width, val);
+          else
+            w.vbr(v.width, val);
+        }
+
+        values.push_back(v);
+      }
+
+      w.align32bits();
+    }
+
+    LLVMBC::BitReader b(bits.data(), bits.size());
+
+    for(size_t i = 0; i < values.size(); i++)
+    {
+      const Value &v = values[i];
+
+      INFO("Value " << i << " type " << (int)v.type << " width " << v.width);
+
+      rdcarray<uint64_t> read;
+
+      if(v.type == Value::Fixed)
+      {
+        read.push_back(b.fixed<uint64_t>(v.width));
+      }
+      else if(v.type == Value::VBR)
+      {
+        read.push_back(b.vbr<uint64_t>(v.width));
+      }
+      else
+      {
+        read.resize(b.vbr<size_t>(6));
+        if(v.type == Value::FixedArray)
+          b.fixedArray(v.width, read.data(), read.size());
+        else
+          b.vbrArray(v.width, read.data(), read.size());
+      }
+
+      CHECK(read == v.vals);
+    }
+
+    b.align32bits();
+
+    CHECK(b.AtEndOfStream());
+    CHECK(b.BitOffset() == bits.size() * 8);
+    CHECK(!b.IsErrored());
+  }
+
+  SECTION("Check array reads off the end of the stream")
+  {
+    byte bits[] = {0xff, 0xff, 0xff};
+
+    LLVMBC::BitReader b(bits, sizeof(bits));
+
+    uint64_t vals[4] = {1, 1, 1, 1};
+
+    EXPECT_ERROR();
+
+    // the first two fit, the rest read as 0s
+    b.fixedArray(10, vals, 4);
+
+    CHECK(DID_ERROR_HAPPEN());
+
+    CHECK(vals[0] == 0x3ff);
+    CHECK(vals[1] == 0x3ff);
+    CHECK(vals[2] == 0);
+    CHECK(vals[3] == 0);
+
+    CHECK(b.AtEndOfStream());
+    CHECK(b.IsErrored());
+  }
+}
+
+// build a module with the rough shape of a DXIL program - types, constants, metadata strings and
+// nodes, then functions full of instructions - with the sizes varied by seed
+static bytebuf MakeBenchmarkModule(uint64_t seed, uint32_t numFunctions, uint32_t numInstructions)
+{
+  using namespace LLVMBC;
+
+  uint64_t rand = seed;
+  auto next = [&rand]() {
+    rand = rand * 6364136223846793005ULL + 1442695040888963407ULL;
+    return rand >> 16;
+  };
+
+  bytebuf ret;
+  BitcodeWriter w(ret);
+
+  BitcodeWriter::Config cfg = {};
+  cfg.numTypes = 40;
+  cfg.numGlobalValues = 500;
+  cfg.maxGlobalType = 40;
+  cfg.hasMetaString = true;
+  cfg.hasDebugLoc = true;
+  cfg.hasNamedMeta = true;
+  w.ConfigureSizes(cfg);
+
+  w.BeginBlock(KnownBlock::MODULE_BLOCK);
+
+  w.Record(ModuleRecord::VERSION, 1);
+
+  w.ModuleBlockInfo();
+
+  w.BeginBlock(KnownBlock::TYPE_BLOCK);
+  w.Record(TypeRecord::NUMENTRY, 40);
+  for(uint64_t i = 0; i < 20; i++)
+    w.Record(TypeRecord::INTEGER, 1ULL << (i % 7));
+  for(uint64_t i = 0; i < 20; i++)
+    w.Record(TypeRecord::POINTER, {i, 0});
+  w.EndBlock();
+
+  w.BeginBlock(KnownBlock::CONSTANTS_BLOCK);
+  for(uint64_t i = 0; i < 500; i++)
+  {
+    if(i % 50 == 0)
+      w.Record(ConstantsRecord::SETTYPE, i % 20);
+    w.Record(ConstantsRecord::INTEGER, BitWriter::svbr(int64_t(next() % 100000) - 5000));
+  }
+  w.EndBlock();
+
+  w.BeginBlock(KnownBlock::METADATA_BLOCK);
+  w.EmitMetaDataAbbrev();
+  for(uint64_t i = 0; i < numInstructions / 4; i++)
+  {
+    rdcstr str = StringFormat::Fmt("dx.metadata.string.%llu", next() % 100000);
+    w.Record(MetaDataRecord::STRING_OLD, str);
+
+    rdcarray<uint64_t> node;
+    node.resize(2 + next() % 10);
+    for(uint64_t &n : node)
+      n = next() % (i + 1);
+    w.Record(MetaDataRecord::NODE, node);
+  }
+  w.EndBlock();
+
+  for(uint32_t f = 0; f < numFunctions; f++)
+  {
+    w.BeginBlock(KnownBlock::FUNCTION_BLOCK);
+    w.Record(FunctionRecord::DECLAREBLOCKS, 1 + next() % 8);
+
+    for(uint32_t i = 0; i < numInstructions; i++)
+    {
+      switch(next() % 4)
+      {
+        case 0:
+          w.RecordInstruction(FunctionRecord::INST_BINOP,
+                              {1 + next() % 40, 1 + next() % 40, next() % 16}, false);
+          break;
+        case 1:
+          w.RecordInstruction(FunctionRecord::INST_LOAD, {1 + next() % 40, next() % 40, 4, 0},
+                              false);
+          break;
+        default:
+        {
+          // dx.op calls dominate real DXIL, with a handful of operands referencing earlier values
+          // and constants
+          rdcarray<uint64_t> call;
+          call.resize(4 + next() % 6);
+          for(uint64_t &c : call)
+            c = next() % 600;
+          w.RecordInstruction(FunctionRecord::INST_CALL, call, true);
+          break;
+        }
+      }
+    }
+
+    w.RecordInstruction(FunctionRecord::INST_RET, {}, false);
+
+    w.BeginBlock(KnownBlock::VALUE_SYMTAB_BLOCK);
+    for(uint32_t i = 0; i < 8; i++)
+      w.RecordSymTabEntry(i, StringFormat::Fmt("value_%u_%u", f, i));
+    w.EndBlock();
+
+    w.EndBlock();
+  }
+
+  w.EndBlock();
+
+  return ret;
+}
+
+static size_t CountRecords(const LLVMBC::BlockOrRecord &block)
+{
+  size_t ret = block.IsRecord() ? 1 : 0;
+  for(const LLVMBC::BlockOrRecord &child : block.children)
+    ret += CountRecords(child);
+  return ret;
+}
+
+// flattens the decoded stream into a list of events, so the tree and visitor can be compared
+struct FlattenVisitor : public LLVMBC::BitcodeVisitor
+{
+  void EnterBlock(uint32_t id, uint32_t blockDwordLength) override
+  {
+    events.push_back(StringFormat::Fmt("enter %u %u", id, blockDwordLength));
+  }
+  void Record(const LLVMBC::BlockOrRecord &record) override
+  {
+    rdcstr ev = StringFormat::Fmt("record %u", record.id);
+    for(uint64_t op : record.ops)
+      ev += StringFormat::Fmt(" %llu", op);
+    if(record.blob)
+      ev += StringFormat::Fmt(" blob %zu", record.blobLength);
+    events.push_back(ev);
+  }
+  void ExitBlock(uint32_t id) override { events.push_back(StringFormat::Fmt("exit %u", id)); }
+
+  void Walk(const LLVMBC::BlockOrRecord &block)
+  {
+    if(block.IsRecord())
+    {
+      Record(block);
+      return;
+    }
+
+    EnterBlock(block.id, block.blockDwordLength);
+    for(const LLVMBC::BlockOrRecord &child : block.children)
+      Walk(child);
+    ExitBlock(block.id);
+  }
+
+  rdcarray<rdcstr> events;
+};
+
+// counts records without keeping them, the minimum work any consumer of the visitor will do
+struct CountingVisitor : public LLVMBC::BitcodeVisitor
+{
+  void EnterBlock(uint32_t id, uint32_t blockDwordLength) override {}
+  void Record(const LLVMBC::BlockOrRecord &record) override
+  {
+    numRecords++;
+    numOps += record.ops.size();
+  }
+  void ExitBlock(uint32_t id) override {}
+
+  size_t numRecords = 0;
+  size_t numOps = 0;
+};
+
+TEST_CASE("Check LLVM bitcode visitor", "[llvm]")
+{
+  for(uint32_t seed = 0; seed < 8; seed++)
+  {
+    bytebuf bc = MakeBenchmarkModule(seed, 1 + seed % 3, 20 + seed * 40);
+
+    FlattenVisitor fromTree;
+    {
+      LLVMBC::BitcodeReader reader(bc.data(), bc.size());
+      fromTree.Walk(reader.ReadToplevelBlock());
+      CHECK(reader.AtEndOfStream());
+    }
+
+    FlattenVisitor visited;
+    {
+      LLVMBC::BitcodeReader reader(bc.data(), bc.size());
+      reader.VisitToplevelBlock(visited);
+      CHECK(reader.AtEndOfStream());
+    }
+
+    REQUIRE(!visited.events.empty());
+    CHECK(visited.events.front() == fromTree.events.front());
+    CHECK(visited.events.back() == "exit 8");
+
+    REQUIRE(visited.events.size() == fromTree.events.size());
+    for(size_t i = 0; i < visited.events.size(); i++)
+    {
+      INFO("event " << i);
+      CHECK(visited.events[i] == fromTree.events[i]);
+    }
+  }
+}
+
+TEST_CASE("Check LLVM bitcode with an invalid array length", "[llvm]")
+{
+  using namespace LLVMBC;
+
+  bytebuf bc;
+  {
+    BitWriter w(bc);
+    w.Write(BitcodeMagic);
+
+    w.fixed(2, ENTER_SUBBLOCK);
+    w.vbr(8, 8U);
+    w.vbr(4, 4U);
+    w.align32bits();
+    // length is not checked by the reader
+    w.Write(0U);
+
+    // abbrev with a literal record ID and an array of 8-bit values
+    w.fixed(4, DEFINE_ABBREV);
+    w.vbr(5, 3U);
+    w.fixed(1, true);
+    w.vbr(8, 5U);
+    w.fixed(1, false);
+    w.fixed(3, AbbrevEncoding::Array);
+    w.fixed(1, false);
+    w.fixed(3, AbbrevEncoding::Fixed);
+    w.vbr(5, 8U);
+
+    // a valid record
+    w.fixed(4, APPLICATION_ABBREV);
+    w.vbr(6, 2U);
+    w.fixed(8, 10U);
+    w.fixed(8, 20U);
+
+    // a record claiming far more elements than there are bits left
+    w.fixed(4, APPLICATION_ABBREV);
+    w.vbr(6, 1000000U);
+    w.fixed(8, 30U);
+
+    // a record after it that must not be decoded
+    w.fixed(4, APPLICATION_ABBREV);
+    w.vbr(6, 1U);
+    w.fixed(8, 40U);
+
+    w.fixed(4, END_BLOCK);
+    w.align32bits();
+  }
+
+  FlattenVisitor visited;
+  LLVMBC::BitcodeReader reader(bc.data(), bc.size());
+
+  EXPECT_ERROR();
+
+  reader.VisitToplevelBlock(visited);
+
+  CHECK(DID_ERROR_HAPPEN());
+  CHECK(reader.IsErrored());
+
+  REQUIRE(visited.events.size() == 3);
+  CHECK(visited.events[0] == "enter 8 0");
+  CHECK(visited.events[1] == "record 5 10 20");
+  CHECK(visited.events[2] == "exit 8");
+}
+
+TEST_CASE("Benchmark DXIL bitcode parsing throughput", "[.][llvm][benchmark]")
+{
+  // a corpus of modules from small to large, like the set of shaders in a capture
+  rdcarray<bytebuf> corpus;
+  size_t corpusBytes = 0;
+  for(uint32_t i = 0; i < 400; i++)
+  {
+    corpus.push_back(MakeBenchmarkModule(i, 1 + i % 4, 50 + (i * 37) % 2000));
+    corpusBytes += corpus.back().size();
+  }
+
+  const uint32_t iterations = 5;
+
+  // first time only the bitstream reads, with a stream of the same kinds of values the modules are
+  // made of - abbrev IDs, vbr6 operands and arrays of 8-bit characters
+  {
+    bytebuf bits;
+    uint64_t rand = 0;
+    {
+      LLVMBC::BitWriter w(bits);
+      for(uint32_t i = 0; i < 1000000; i++)
+      {
+        rand = rand * 6364136223846793005ULL + 1442695040888963407ULL;
+        w.fixed(4, 3U);
+        w.vbr(6, (rand >> 20) % ((rand >> 50) % 4 == 0 ? 100000 : 32));
+        w.vbr(6, 4U);
+        for(uint32_t c = 0; c < 4; c++)
+          w.fixed(8, uint32_t(rand >> (c * 8)) & 0xff);
+      }
+      w.align32bits();
+    }
+
+    uint64_t sum = 0;
+    uint64_t arr[4];
+
+    PerformanceTimer timer;
+    for(uint32_t it = 0; it < iterations; it++)
+    {
+      LLVMBC::BitReader b(bits.data(), bits.size());
+      for(uint32_t i = 0; i < 1000000; i++)
+      {
+        sum += b.fixed<uint32_t>(4);
+        sum += b.vbr<uint64_t>(6);
+        b.fixedArray(8, arr, b.vbr<size_t>(6));
+        sum += arr[0] + arr[3];
+      }
+    }
+    double ms = timer.GetMilliseconds() / iterations;
+
+    RDCLOG("Read %.2f MB of bitstream values in %.2f ms: %.1f MB/s (checksum %llu)",
+           double(bits.size()) / (1024.0 * 1024.0), ms,
+           (double(bits.size()) / (1024.0 * 1024.0)) / (ms / 1000.0), sum);
+  }
+
+  size_t numRecords = 0;
+
+  PerformanceTimer timer;
+  for(uint32_t it = 0; it < iterations; it++)
+  {
+    numRecords = 0;
+    for(const bytebuf &bc : corpus)
+    {
+      LLVMBC::BitcodeReader reader(bc.data(), bc.size());
+      LLVMBC::BlockOrRecord module = reader.ReadToplevelBlock();
+      numRecords += CountRecords(module);
+      CHECK(reader.AtEndOfStream());
+    }
+  }
+  double ms = timer.GetMilliseconds() / iterations;
+
+  RDCLOG("Parsed %zu DXIL modules (%.2f MB, %zu records) in %.2f ms: %.1f MB/s", corpus.size(),
+         double(corpusBytes) / (1024.0 * 1024.0), numRecords, ms,
+         (double(corpusBytes) / (1024.0 * 1024.0)) / (ms / 1000.0));
+
+  CHECK(numRecords > 0);
+
+  // the same corpus visited without building the tree
+  CountingVisitor counter;
+
+  timer.Restart();
+  for(uint32_t it = 0; it < iterations; it++)
+  {
+    counter = CountingVisitor();
+    for(const bytebuf &bc : corpus)
+    {
+      LLVMBC::BitcodeReader reader(bc.data(), bc.size());
+      reader.VisitToplevelBlock(counter);
+      CHECK(reader.AtEndOfStream());
+    }
+  }
+  ms = timer.GetMilliseconds() / iterations;
+
+  RDCLOG("Visited %zu DXIL modules (%zu records, %zu operands) in %.2f ms: %.1f MB/s",
+         corpus.size(), counter.numRecords, counter.numOps, ms,
+         (double(corpusBytes) / (1024.0 * 1024.0)) / (ms / 1000.0));
+
+  CHECK(counter.numRecords == numRecords);
 }
 
 #endif
@@ -51,6 +51,18 @@ struct BlockOrRecord
   size_t blobLength = 0;
 };
 
+// receives blocks and records as they're decoded, without building up the whole tree of
+// BlockOrRecord. A record is only valid during the call - its ops are stored in scratch memory that
+// is re-used for the next record - so anything needed afterwards must be copied out.
+class BitcodeVisitor
+{
+public:
+  virtual ~BitcodeVisitor() = default;
+  virtual void EnterBlock(uint32_t id, uint32_t blockDwordLength) = 0;
+  virtual void Record(const BlockOrRecord &record) = 0;
+  virtual void ExitBlock(uint32_t id) = 0;
+};
+
 struct AbbrevParam;
 struct AbbrevDesc;
 struct BlockContext;
@@ -62,7 +74,9 @@ public:
   BitcodeReader(const byte *bitcode, size_t length);
   ~BitcodeReader();
   BlockOrRecord ReadToplevelBlock();
+  void VisitToplevelBlock(BitcodeVisitor &visitor);
   bool AtEndOfStream();
+  bool IsErrored();
 
   static bool Valid(const byte *bitcode, size_t length);
 
@@ -70,12 +84,15 @@ private:
   BitReader b;
   size_t abbrevSize;
 
-  void ReadBlockContents(BlockOrRecord &block);
+  void ReadBlockContents(BitcodeVisitor &visitor);
   const AbbrevDesc &getAbbrev(uint32_t blockId, uint32_t abbrevID);
   uint64_t decodeAbbrevParam(const AbbrevParam &param);
 
   rdcarray<BlockContext *> blockStack;
   std::map<uint32_t, BlockInfo *> blockInfo;
+
+  // storage for the record currently being passed to the visitor
+  BlockOrRecord record;
 };
 
 };    // namespace LLVMBC
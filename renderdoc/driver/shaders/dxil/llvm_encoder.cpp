@@ -987,6 +987,7 @@ void BitcodeWriter::Unabbrev(uint32_t record, bool, const rdcarray<uint64_t> &va
 
 #if ENABLED(ENABLE_UNIT_TESTS)
 
+#include <limits.h>
 #include "catch/catch.hpp"
 
 #include "llvm_decoder.h"
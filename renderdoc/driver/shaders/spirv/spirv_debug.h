@@ -25,6 +25,7 @@
 #pragma once
 
 #include "api/replay/rdcarray.h"
+#include "common/threading.h"
 #include "maths/vec.h"
 #include "shaders/controlflow.h"
 #include "spirv_common.h"
@@ -808,6 +809,7 @@ private:
   rdcarray<bool> queuedDeviceThreadSteps;
   rdcarray<ShaderDebugState> *shaderChangesReturn;
   rdcarray<int32_t> queuedJobs;
+  rdcarray<Threading::JobSystem::Job *> simulationJobs;
 
   bool retireIDs = true;
   ShaderDebugState activeDebugState;
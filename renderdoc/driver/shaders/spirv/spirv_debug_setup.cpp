@@ -298,7 +298,8 @@ Debugger::Debugger() : deviceThreadID(Threading::GetCurrentID())
 Debugger::~Debugger()
 {
   AtomicStore(&atomic_simulationFinished, 1);
-  Threading::JobSystem::SyncAllJobs();
+  Threading::JobSystem::WaitAndFree(simulationJobs);
+  simulationJobs.clear();
   SAFE_DELETE(apiWrapper);
 }
 
@@ -1795,7 +1796,7 @@ ShaderDebugTrace *Debugger::BeginDebug(DebugAPIWrapper *api, const ShaderStage s
     {
       uint32_t countJobs = RDCMIN(threadsInWorkgroup, Threading::JobSystem::GetCountWorkers() / 2U);
       for(uint32_t i = 0; i < countJobs; ++i)
-        Threading::JobSystem::AddJob([this]() { SimulationJobHelper(); });
+        simulationJobs.push_back(Threading::JobSystem::AddJob([this]() { SimulationJobHelper(); }));
     }
   }
   return ret;
@@ -2660,7 +2661,9 @@ rdcarray<ShaderDebugState> Debugger::ContinueDebug()
   if(active.Finished())
   {
     AtomicStore(&atomic_simulationFinished, 1);
-    Threading::JobSystem::SyncAllJobs();
+    // only wait for our own jobs, not any unrelated work
+    Threading::JobSystem::WaitAndFree(simulationJobs);
+    simulationJobs.clear();
     return ret;
   }
 
@@ -4956,8 +4959,8 @@ void Debugger::QueueJob(uint32_t lane)
   {
     if(Vulkan_Hack_ShaderDebugUsesJobSystemJobs())
     {
-      Threading::JobSystem::AddJob(
-          [this, lane]() { StepThread(lane, StepThreadMode::RUN_MULTIPLE_STEPS); });
+      simulationJobs.push_back(Threading::JobSystem::AddJob(
+          [this, lane]() { StepThread(lane, StepThreadMode::RUN_MULTIPLE_STEPS); }));
     }
     else
     {
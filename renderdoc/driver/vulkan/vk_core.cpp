@@ -3067,12 +3067,12 @@ bool WrappedVulkan::EndFrameCapture(DeviceOwnedWindow devWnd)
   {
     SectionProperties props;
 
-    // Compress with LZ4 so that it's fast
-    props.flags = SectionFlags::LZ4Compressed;
+    // Compress with LZ4 so that it's fast, and index the blocks so tools can seek within it
+    props.flags = SectionFlags::LZ4Compressed | SectionFlags::BlockIndexed;
     props.version = m_SectionVersion;
     props.type = SectionType::FrameCapture;
 
-    captureWriter = rdc->WriteSection(props);
+    captureWriter = RenderDoc::Inst().WriteCaptureSection(rdc, props);
   }
   else
   {
@@ -3130,7 +3130,7 @@ bool WrappedVulkan::EndFrameCapture(DeviceOwnedWindow devWnd)
       RDCDEBUG("Flushing %u command buffer records to file serialiser",
                (uint32_t)m_CmdBufferRecords.size());
 
-      std::map<int64_t, Chunk *> recordlist;
+      RecordChunkMerge recordlist;
 
       // ensure all command buffer records within the frame evne if recorded before, but
       // otherwise order must be preserved (vs. queue submits and desc set updates)
@@ -3147,27 +3147,28 @@ bool WrappedVulkan::EndFrameCapture(DeviceOwnedWindow devWnd)
                    ToStr(m_CmdBufferRecords[i]->GetResourceID()).c_str());
         }
 
-        size_t prevSize = recordlist.size();
+        size_t prevSize = recordlist.NumChunks();
         (void)prevSize;
 
         m_CmdBufferRecords[i]->Insert(recordlist);
 
-        RDCDEBUG("Added %zu chunks to file serialiser", recordlist.size() - prevSize);
+        RDCDEBUG("Added %zu chunks to file serialiser", recordlist.NumChunks() - prevSize);
       }
 
       m_FrameCaptureRecord->Insert(recordlist);
 
       RDCDEBUG("Flushing %u chunks to file serialiser from context record",
-               (uint32_t)recordlist.size());
+               (uint32_t)recordlist.NumChunks());
 
-      float num = float(recordlist.size());
+      float num = float(recordlist.NumChunks());
       float idx = 0.0f;
 
-      for(auto it = recordlist.begin(); it != recordlist.end(); ++it)
+      // stream the chunks out in ID order, merged from each record's list
+      for(Chunk *chunk = recordlist.Next(); chunk; chunk = recordlist.Next())
       {
         RenderDoc::Inst().SetProgress(CaptureProgress::SerialiseFrameContents, idx / num);
         idx += 1.0f;
-        it->second->Write(ser);
+        chunk->Write(ser);
       }
 
       m_FrameCaptureRecord->DeleteChunks();
@@ -3181,7 +3182,8 @@ bool WrappedVulkan::EndFrameCapture(DeviceOwnedWindow devWnd)
   if(m_CaptureFailure)
   {
     m_LastCaptureFailed = Timing::GetUnixTimestamp();
-    SAFE_DELETE(rdc);
+    RenderDoc::Inst().DiscardCaptureWriting(rdc);
+    rdc = NULL;
   }
   else
   {
@@ -3464,6 +3466,10 @@ RDResult WrappedVulkan::ReadLogInitialisation(RDCFile *rdc, bool storeStructured
 
   ser.ConfigureStructuredExport(&GetChunkName, storeStructuredBuffers, m_TimeBase, m_TimeFrequency);
 
+  // the structured data for the whole capture is built here and lives as long as the capture is
+  // open, so allocate it all together
+  ser.GetStructuredFile().UseArena();
+
   m_StructuredFile = &ser.GetStructuredFile();
 
   m_StoredStructuredData->version = m_StructuredFile->version = m_SectionVersion;
@@ -341,17 +341,11 @@ public:
   void ResolveDeferredWrappers()
   {
     rdcarray<rdcpair<TypedRealHandle, WrappedVkRes *>> wrappers;
-    for(auto it = m_WrapperMap.begin(); it != m_WrapperMap.end();)
-    {
-      if(it->first.real.handle >= m_DummyHandle)
-      {
-        wrappers.push_back({it->first, it->second});
-        it = m_WrapperMap.erase(it);
-        continue;
-      }
-
-      ++it;
-    }
+    m_WrapperMap.ExtractIf(
+        [this](const TypedRealHandle &real, WrappedVkRes *) {
+          return real.real.handle >= m_DummyHandle;
+        },
+        wrappers);
 
     for(rdcpair<TypedRealHandle, WrappedVkRes *> &wrapper : wrappers)
     {
@@ -155,6 +155,12 @@ struct TypedRealHandle
   bool operator!=(const TypedRealHandle o) const { return !(*this == o); }
 };
 
+// used to pick a shard in the resource manager's wrapper map
+inline uint64_t WrapperShardHash(const TypedRealHandle &h)
+{
+  return h.real.handle;
+}
+
 struct WrappedVkNonDispRes : public WrappedVkRes
 {
   template <typename T>
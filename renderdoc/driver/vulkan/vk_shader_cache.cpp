@@ -250,11 +250,7 @@ struct VkPipeCacheHeader
 VulkanShaderCache::VulkanShaderCache(WrappedVulkan *driver)
 {
   // Load shader cache, if present
-  bool success = LoadShaderCache("vkshaders.cache", m_ShaderCacheMagic, m_ShaderCacheVersion,
-                                 m_ShaderCache, VulkanShaderCacheCallbacks);
-
-  // if we failed to load from the cache
-  m_ShaderCacheDirty = !success;
+  m_ShaderCache.Load("vkshaders.cache", m_ShaderCacheMagic, m_ShaderCacheVersion);
 
   m_pDriver = driver;
   m_Device = driver->GetDev();
@@ -350,8 +346,7 @@ VulkanShaderCache::VulkanShaderCache(WrappedVulkan *driver)
 
         rdcstr err;
 
-        if(m_ShaderCache.find(inputHash) != m_ShaderCache.end())
-          blob = m_ShaderCache[inputHash];
+        m_ShaderCache.Find(inputHash, blob, VulkanShaderCacheCallbacks);
 
         if(blob == NULL)
         {
@@ -361,8 +356,7 @@ VulkanShaderCache::VulkanShaderCache(WrappedVulkan *driver)
           // if we missed the inputHash, make a copy there too.
           if(m_CacheShaders && blob)
           {
-            m_ShaderCache[inputHash] = new rdcarray<uint32_t>(*blob);
-            m_ShaderCacheDirty = true;
+            m_ShaderCache.Insert(inputHash, new rdcarray<uint32_t>(*blob));
           }
         }
 
@@ -483,16 +477,8 @@ VulkanShaderCache::~VulkanShaderCache()
     m_pDriver->vkDestroyPipelineCache(m_Device, m_PipelineCache, NULL);
   }
 
-  if(m_ShaderCacheDirty)
-  {
-    SaveShaderCache("vkshaders.cache", m_ShaderCacheMagic, m_ShaderCacheVersion, m_ShaderCache,
-                    VulkanShaderCacheCallbacks);
-  }
-  else
-  {
-    for(auto it = m_ShaderCache.begin(); it != m_ShaderCache.end(); ++it)
-      VulkanShaderCacheCallbacks.Destroy(it->second);
-  }
+  m_ShaderCache.Save(VulkanShaderCacheCallbacks);
+  m_ShaderCache.Destroy(VulkanShaderCacheCallbacks);
 
   for(size_t i = 0; i < ARRAY_COUNT(m_BuiltinShaderModules); i++)
     for(size_t b = 0; b < ARRAY_COUNT(m_BuiltinShaderModules[0]); b++)
@@ -512,11 +498,8 @@ rdcstr VulkanShaderCache::GetSPIRVBlob(const rdcspv::CompilationSettings &settin
   typestr[1] += (char)settings.lang;
   hash = strhash(typestr, hash);
 
-  if(m_ShaderCache.find(hash) != m_ShaderCache.end())
-  {
-    outBlob = m_ShaderCache[hash];
+  if(m_ShaderCache.Find(hash, outBlob, VulkanShaderCacheCallbacks))
     return "";
-  }
 
   SPIRVBlob spirv = new rdcarray<uint32_t>();
   rdcstr errors = rdcspv::Compile(settings, {src}, *spirv);
@@ -538,8 +521,7 @@ rdcstr VulkanShaderCache::GetSPIRVBlob(const rdcspv::CompilationSettings &settin
 
   if(m_CacheShaders)
   {
-    m_ShaderCache[hash] = spirv;
-    m_ShaderCacheDirty = true;
+    m_ShaderCache.Insert(hash, spirv);
   }
 
   return errors;
@@ -553,12 +535,10 @@ void VulkanShaderCache::GetPipeCacheBlob()
                                             m_pDriver->GetDeviceProps().deviceID)
                               .c_str());
 
-  auto it = m_ShaderCache.find(hash);
+  SPIRVBlob blob = NULL;
 
-  if(it != m_ShaderCache.end())
+  if(m_ShaderCache.Find(hash, blob, VulkanShaderCacheCallbacks))
   {
-    SPIRVBlob blob = it->second;
-
     // first uint32_t is the real byte size, since we rounded up to the nearest uint32 to store in a
     // SPIRVBlob
     uint32_t size = blob->at(0);
@@ -591,8 +571,7 @@ void VulkanShaderCache::SetPipeCacheBlob(bytebuf &blob)
   (*spirvBlob)[0] = (uint32_t)blob.size();
   memcpy(spirvBlob->data() + 1, blob.data(), blob.size());
 
-  m_ShaderCache[hash] = spirvBlob;
-  m_ShaderCacheDirty = true;
+  m_ShaderCache.Insert(hash, spirvBlob);
 }
 
 void VulkanShaderCache::MakeGraphicsPipelineInfo(VkGraphicsPipelineCreateInfo &pipeCreateInfo,
@@ -24,6 +24,7 @@
 
 #pragma once
 
+#include "common/shader_cache.h"
 #include "core/core.h"
 #include "driver/shaders/spirv/spirv_compile.h"
 #include "vk_core.h"
@@ -121,7 +122,7 @@ public:
   void SetCaching(bool enabled) { m_CacheShaders = enabled; }
 private:
   static const uint32_t m_ShaderCacheMagic = 0xf00d00d5;
-  static const uint32_t m_ShaderCacheVersion = 1;
+  static const uint32_t m_ShaderCacheVersion = 2;
 
   void GetPipeCacheBlob();
   void SetPipeCacheBlob(bytebuf &blob);
@@ -138,8 +139,8 @@ private:
 
   bool m_Buffer2MSSupported = false;
 
-  bool m_ShaderCacheDirty = false, m_CacheShaders = false;
-  std::map<uint32_t, SPIRVBlob> m_ShaderCache;
+  bool m_CacheShaders = false;
+  IndexedShaderCache<SPIRVBlob> m_ShaderCache;
 
   SPIRVBlob m_BuiltinShaderBlobs[arraydim<BuiltinShader>()][arraydim<BuiltinShaderBaseType>()]
                                 [arraydim<BuiltinShaderTextureType>()] = {};
@@ -2063,7 +2063,7 @@ bool WrappedVulkan::Serialise_vkCmdUpdateBuffer(SerialiserType &ser, VkCommandBu
 
   // serialise as void* so it goes through as a buffer, not an actual array of integers.
   const void *Data = (const void *)pData;
-  SERIALISE_ELEMENT_ARRAY(Data, dataSize).Important();
+  SERIALISE_ELEMENT_ARRAY_NOCOPY(Data, dataSize).Important();
 
   Serialise_DebugMessages(ser);
 
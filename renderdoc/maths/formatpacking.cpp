@@ -30,6 +30,14 @@
 #include "common/common.h"
 #include "os/os_specific.h"
 
+#if defined(__x86_64__) || defined(_M_X64)
+// SSE2 is always available on x64
+#include <emmintrin.h>
+#define FORMAT_DECODE_SSE2 OPTION_ON
+#else
+#define FORMAT_DECODE_SSE2 OPTION_OFF
+#endif
+
 //	for(int i=0; i < 256; i++)
 //	{
 //		uint8_t comp = i&0xff;
@@ -876,12 +884,463 @@ void DecodePixelData(const ResourceFormat &fmt, const byte *data, PixelValue &ou
   }
 }
 
+// the batched decode below processes a row at a time with the format only inspected once. Each
+// row decoder must give exactly the same results as DecodeFormattedComponents() on every texel, the
+// SIMD paths process 4 texels at a time (or 2 for wider formats) and the scalar tail handles the
+// remainder, as well as platforms without SIMD.
+typedef void (*DecodeRowFunction)(const ResourceFormat &fmt, const byte *src, uint32_t width,
+                                  float *dst);
+
+static inline void StoreTexel(float *dst, float r, float g, float b, float a)
+{
+  dst[0] = r;
+  dst[1] = g;
+  dst[2] = b;
+  dst[3] = a;
+}
+
+// DecodePixelData() defaults alpha to 1 for float formats without an alpha channel
+static inline float DefaultAlpha(const ResourceFormat &fmt)
+{
+  return (fmt.compType == CompType::UInt || fmt.compType == CompType::SInt || fmt.compCount == 4)
+             ? 0.0f
+             : 1.0f;
+}
+
+#if ENABLED(FORMAT_DECODE_SSE2)
+
+static inline __m128i SelectBits(__m128i mask, __m128i a, __m128i b)
+{
+  return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+// extract bits [shift, shift + bits) from each lane and convert to float
+template <int shift, int bits>
+static inline __m128 ExtractBits(__m128i v)
+{
+  return _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(v, shift), _mm_set1_epi32((1 << bits) - 1)));
+}
+
+// extract bits [shift, shift + bits) from each lane as a UNORM value
+template <int shift, int bits>
+static inline __m128 ExtractUNorm(__m128i v)
+{
+  // divide rather than multiplying by the reciprocal, to match the scalar conversion exactly
+  return _mm_div_ps(ExtractBits<shift, bits>(v), _mm_set1_ps(float((1 << bits) - 1)));
+}
+
+// store 4 texels given as separate channels, transposing them to RGBA order
+static inline void StoreTexels(float *dst, __m128 r, __m128 g, __m128 b, __m128 a)
+{
+  _MM_TRANSPOSE4_PS(r, g, b, a);
+  _mm_storeu_ps(dst + 0, r);
+  _mm_storeu_ps(dst + 4, g);
+  _mm_storeu_ps(dst + 8, b);
+  _mm_storeu_ps(dst + 12, a);
+}
+
+// converts unsigned floats with a 5-bit exponent biased by 15 and mantissaBits of mantissa, such
+// as in halfs and R11G11B10, to float bit patterns
+template <int mantissaBits>
+static inline __m128i UnsignedSmallFloatBits(__m128i em)
+{
+  const __m128i m = _mm_and_si128(em, _mm_set1_epi32((1 << mantissaBits) - 1));
+  const __m128i e = _mm_and_si128(_mm_srli_epi32(em, mantissaBits), _mm_set1_epi32(0x1f));
+
+  // normal values rebias the exponent and shift the mantissa up
+  __m128i normal = _mm_or_si128(_mm_slli_epi32(_mm_add_epi32(e, _mm_set1_epi32(127 - 15)), 23),
+                                _mm_slli_epi32(m, 23 - mantissaBits));
+
+  // denormals (and 0) are exactly the mantissa multiplied by 2^(-14 - mantissaBits)
+  __m128i denorm = _mm_castps_si128(_mm_mul_ps(
+      _mm_cvtepi32_ps(m), _mm_castsi128_ps(_mm_set1_epi32((127 - 14 - mantissaBits) << 23))));
+
+  // infinities and NaNs keep their mantissa
+  __m128i infNaN = _mm_or_si128(_mm_set1_epi32(0x7f800000), _mm_slli_epi32(m, 23 - mantissaBits));
+
+  __m128i ret = SelectBits(_mm_cmpeq_epi32(e, _mm_setzero_si128()), denorm, normal);
+  return SelectBits(_mm_cmpeq_epi32(e, _mm_set1_epi32(0x1f)), infNaN, ret);
+}
+
+// converts halfs in the low 16 bits of each lane to floats, the same as ConvertFromHalf()
+static inline __m128 HalfToFloat(__m128i h)
+{
+  const __m128i sign = _mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(0x8000)), 16);
+  const __m128i em = _mm_and_si128(h, _mm_set1_epi32(0x7fff));
+
+  __m128i ret = _mm_or_si128(UnsignedSmallFloatBits<10>(em), sign);
+
+  // NaNs all become the same positive NaN
+  ret = SelectBits(_mm_cmpgt_epi32(em, _mm_set1_epi32(0x7c00)), _mm_set1_epi32(0x7F800001), ret);
+
+  return _mm_castsi128_ps(ret);
+}
+
+#endif
+
+static void DecodeRowRGBA8(const ResourceFormat &fmt, const byte *src, uint32_t width, float *dst)
+{
+  const bool bgra = fmt.BGRAOrder();
+  uint32_t x = 0;
+
+#if ENABLED(FORMAT_DECODE_SSE2)
+  const __m128i zero = _mm_setzero_si128();
+  const __m128 scale = _mm_set1_ps(255.0f);
+
+  // the texels are already in RGBA order, so each group of 4 bytes converts to one texel
+  for(; x + 4 <= width; x += 4)
+  {
+    __m128i bytes = _mm_loadu_si128((const __m128i *)(src + x * 4));
+    __m128i lo = _mm_unpacklo_epi8(bytes, zero);
+    __m128i hi = _mm_unpackhi_epi8(bytes, zero);
+
+    __m128 texels[4] = {
+        _mm_div_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)), scale),
+        _mm_div_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)), scale),
+        _mm_div_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), scale),
+        _mm_div_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)), scale),
+    };
+
+    for(int i = 0; i < 4; i++)
+    {
+      if(bgra)
+        texels[i] = _mm_shuffle_ps(texels[i], texels[i], _MM_SHUFFLE(3, 0, 1, 2));
+      _mm_storeu_ps(dst + (x + i) * 4, texels[i]);
+    }
+  }
+#endif
+
+  for(; x < width; x++)
+  {
+    const byte *t = src + x * 4;
+    StoreTexel(dst + x * 4, float(t[bgra ? 2 : 0]) / 255.0f, float(t[1]) / 255.0f,
+               float(t[bgra ? 0 : 2]) / 255.0f, float(t[3]) / 255.0f);
+  }
+}
+
+static void DecodeRowRGBA8SRGB(const ResourceFormat &fmt, const byte *src, uint32_t width,
+                               float *dst)
+{
+  // no SIMD here, the lookup table is faster than calculating the curve
+  const bool bgra = fmt.BGRAOrder();
+
+  for(uint32_t x = 0; x < width; x++)
+  {
+    const byte *t = src + x * 4;
+    // alpha is never interpreted as sRGB
+    StoreTexel(dst + x * 4, SRGB8_lookuptable[t[bgra ? 2 : 0]], SRGB8_lookuptable[t[1]],
+               SRGB8_lookuptable[t[bgra ? 0 : 2]], float(t[3]) / 255.0f);
+  }
+}
+
+static void DecodeRowHalf4(const ResourceFormat &fmt, const byte *src, uint32_t width, float *dst)
+{
+  const uint16_t *halfs = (const uint16_t *)src;
+  const uint32_t numHalfs = width * 4;
+  uint32_t i = 0;
+
+#if ENABLED(FORMAT_DECODE_SSE2)
+  const __m128i zero = _mm_setzero_si128();
+
+  // each half converts to one float in the same place, so do two texels at a time
+  for(; i + 8 <= numHalfs; i += 8)
+  {
+    __m128i h = _mm_loadu_si128((const __m128i *)(halfs + i));
+    _mm_storeu_ps(dst + i, HalfToFloat(_mm_unpacklo_epi16(h, zero)));
+    _mm_storeu_ps(dst + i + 4, HalfToFloat(_mm_unpackhi_epi16(h, zero)));
+  }
+#endif
+
+  for(; i < numHalfs; i++)
+    dst[i] = ConvertFromHalf(halfs[i]);
+}
+
+static void DecodeRowFloat4(const ResourceFormat &fmt, const byte *src, uint32_t width, float *dst)
+{
+  memcpy(dst, src, width * sizeof(float) * 4);
+}
+
+static void DecodeRowR10G10B10A2(const ResourceFormat &fmt, const byte *src, uint32_t width,
+                                 float *dst)
+{
+  const bool bgra = fmt.BGRAOrder();
+  const uint32_t *texels = (const uint32_t *)src;
+  uint32_t x = 0;
+
+#if ENABLED(FORMAT_DECODE_SSE2)
+  for(; x + 4 <= width; x += 4)
+  {
+    __m128i v = _mm_loadu_si128((const __m128i *)(texels + x));
+    __m128 r = ExtractUNorm<0, 10>(v);
+    __m128 b = ExtractUNorm<20, 10>(v);
+    StoreTexels(dst + x * 4, bgra ? b : r, ExtractUNorm<10, 10>(v), bgra ? r : b,
+                ExtractUNorm<30, 2>(v));
+  }
+#endif
+
+  for(; x < width; x++)
+  {
+    Vec4f v = ConvertFromR10G10B10A2(texels[x]);
+    if(bgra)
+      std::swap(v.x, v.z);
+    StoreTexel(dst + x * 4, v.x, v.y, v.z, v.w);
+  }
+}
+
+static void DecodeRowR11G11B10(const ResourceFormat &fmt, const byte *src, uint32_t width,
+                               float *dst)
+{
+  const float alpha = DefaultAlpha(fmt);
+  const uint32_t *texels = (const uint32_t *)src;
+  uint32_t x = 0;
+
+#if ENABLED(FORMAT_DECODE_SSE2)
+  for(; x + 4 <= width; x += 4)
+  {
+    __m128i v = _mm_loadu_si128((const __m128i *)(texels + x));
+    __m128i r = UnsignedSmallFloatBits<6>(_mm_and_si128(v, _mm_set1_epi32(0x7ff)));
+    __m128i g =
+        UnsignedSmallFloatBits<6>(_mm_and_si128(_mm_srli_epi32(v, 11), _mm_set1_epi32(0x7ff)));
+    __m128i b = UnsignedSmallFloatBits<5>(_mm_srli_epi32(v, 22));
+    StoreTexels(dst + x * 4, _mm_castsi128_ps(r), _mm_castsi128_ps(g), _mm_castsi128_ps(b),
+                _mm_set1_ps(alpha));
+  }
+#endif
+
+  for(; x < width; x++)
+  {
+    Vec3f v = ConvertFromR11G11B10(texels[x]);
+    StoreTexel(dst + x * 4, v.x, v.y, v.z, alpha);
+  }
+}
+
+static void DecodeRowR9G9B9E5(const ResourceFormat &fmt, const byte *src, uint32_t width,
+                              float *dst)
+{
+  const float alpha = DefaultAlpha(fmt);
+  const uint32_t *texels = (const uint32_t *)src;
+  uint32_t x = 0;
+
+#if ENABLED(FORMAT_DECODE_SSE2)
+  for(; x + 4 <= width; x += 4)
+  {
+    __m128i v = _mm_loadu_si128((const __m128i *)(texels + x));
+    __m128i e = _mm_srli_epi32(v, 27);
+
+    // the mantissas have no implicit bit, so they're scaled by 2^(e - 15) / 512. This is a power
+    // of two so the result is exact
+    __m128 scale = _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(e, _mm_set1_epi32(127 - 24)), 23));
+    __m128i isInfNaN = _mm_cmpeq_epi32(e, _mm_set1_epi32(0x1f));
+
+    __m128 rgb[3];
+    for(int i = 0; i < 3; i++)
+    {
+      __m128i m = _mm_and_si128(_mm_srli_epi32(v, i * 9), _mm_set1_epi32(0x1ff));
+      __m128i infNaN = _mm_or_si128(_mm_set1_epi32(0x7f800000), _mm_slli_epi32(m, 23 - 9));
+      __m128i val = _mm_castps_si128(_mm_mul_ps(_mm_cvtepi32_ps(m), scale));
+      rgb[i] = _mm_castsi128_ps(SelectBits(isInfNaN, infNaN, val));
+    }
+
+    StoreTexels(dst + x * 4, rgb[0], rgb[1], rgb[2], _mm_set1_ps(alpha));
+  }
+#endif
+
+  for(; x < width; x++)
+  {
+    Vec3f v = ConvertFromR9G9B9E5(texels[x]);
+    StoreTexel(dst + x * 4, v.x, v.y, v.z, alpha);
+  }
+}
+
+// the 16-bit packed formats are bit-unpacked in BGRA order, so the conversions flip them back if
+// the format isn't BGRA ordered
+static void DecodeRowR5G6B5(const ResourceFormat &fmt, const byte *src, uint32_t width, float *dst)
+{
+  const bool bgra = fmt.BGRAOrder();
+  const float alpha = DefaultAlpha(fmt);
+  const uint16_t *texels = (const uint16_t *)src;
+  uint32_t x = 0;
+
+#if ENABLED(FORMAT_DECODE_SSE2)
+  for(; x + 4 <= width; x += 4)
+  {
+    __m128i v =
+        _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i *)(texels + x)), _mm_setzero_si128());
+    __m128 hi = ExtractUNorm<11, 5>(v);
+    __m128 lo = ExtractUNorm<0, 5>(v);
+    StoreTexels(dst + x * 4, bgra ? hi : lo, ExtractUNorm<5, 6>(v), bgra ? lo : hi,
+                _mm_set1_ps(alpha));
+  }
+#endif
+
+  for(; x < width; x++)
+  {
+    Vec3f v = ConvertFromB5G6R5(texels[x]);
+    if(!bgra)
+      std::swap(v.x, v.z);
+    StoreTexel(dst + x * 4, v.x, v.y, v.z, alpha);
+  }
+}
+
+static void DecodeRowR5G5B5A1(const ResourceFormat &fmt, const byte *src, uint32_t width,
+                              float *dst)
+{
+  const bool bgra = fmt.BGRAOrder();
+  const uint16_t *texels = (const uint16_t *)src;
+  uint32_t x = 0;
+
+#if ENABLED(FORMAT_DECODE_SSE2)
+  for(; x + 4 <= width; x += 4)
+  {
+    __m128i v =
+        _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i *)(texels + x)), _mm_setzero_si128());
+    __m128 hi = ExtractUNorm<10, 5>(v);
+    __m128 lo = ExtractUNorm<0, 5>(v);
+    StoreTexels(dst + x * 4, bgra ? hi : lo, ExtractUNorm<5, 5>(v), bgra ? lo : hi,
+                ExtractBits<15, 1>(v));
+  }
+#endif
+
+  for(; x < width; x++)
+  {
+    Vec4f v = ConvertFromB5G5R5A1(texels[x]);
+    if(!bgra)
+      std::swap(v.x, v.z);
+    StoreTexel(dst + x * 4, v.x, v.y, v.z, v.w);
+  }
+}
+
+static void DecodeRowR4G4B4A4(const ResourceFormat &fmt, const byte *src, uint32_t width,
+                              float *dst)
+{
+  const bool bgra = fmt.BGRAOrder();
+  const uint16_t *texels = (const uint16_t *)src;
+  uint32_t x = 0;
+
+#if ENABLED(FORMAT_DECODE_SSE2)
+  for(; x + 4 <= width; x += 4)
+  {
+    __m128i v =
+        _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i *)(texels + x)), _mm_setzero_si128());
+    __m128 hi = ExtractUNorm<8, 4>(v);
+    __m128 lo = ExtractUNorm<0, 4>(v);
+    StoreTexels(dst + x * 4, bgra ? hi : lo, ExtractUNorm<4, 4>(v), bgra ? lo : hi,
+                ExtractUNorm<12, 4>(v));
+  }
+#endif
+
+  for(; x < width; x++)
+  {
+    Vec4f v = ConvertFromB4G4R4A4(texels[x]);
+    if(!bgra)
+      std::swap(v.x, v.z);
+    StoreTexel(dst + x * 4, v.x, v.y, v.z, v.w);
+  }
+}
+
+static DecodeRowFunction GetRowDecoder(const ResourceFormat &fmt)
+{
+  // integer interpretations of packed formats are rare, leave them to the generic path
+  if(fmt.compType == CompType::UInt || fmt.compType == CompType::SInt)
+    return NULL;
+
+  switch(fmt.type)
+  {
+    case ResourceFormatType::Regular:
+      if(fmt.compCount != 4)
+        return NULL;
+
+      if(fmt.compByteWidth == 1 && fmt.compType == CompType::UNorm)
+        return &DecodeRowRGBA8;
+      if(fmt.compByteWidth == 1 && fmt.compType == CompType::UNormSRGB)
+        return &DecodeRowRGBA8SRGB;
+
+      if(fmt.BGRAOrder() || fmt.compType != CompType::Float)
+        return NULL;
+
+      if(fmt.compByteWidth == 2)
+        return &DecodeRowHalf4;
+      if(fmt.compByteWidth == 4)
+        return &DecodeRowFloat4;
+
+      return NULL;
+    case ResourceFormatType::R10G10B10A2:
+      return fmt.compType == CompType::SNorm ? NULL : &DecodeRowR10G10B10A2;
+    case ResourceFormatType::R11G11B10: return &DecodeRowR11G11B10;
+    case ResourceFormatType::R9G9B9E5: return &DecodeRowR9G9B9E5;
+    case ResourceFormatType::R5G6B5: return &DecodeRowR5G6B5;
+    case ResourceFormatType::R5G5B5A1: return &DecodeRowR5G5B5A1;
+    case ResourceFormatType::R4G4B4A4: return &DecodeRowR4G4B4A4;
+    default: break;
+  }
+
+  return NULL;
+}
+
+uint32_t GetFormattedTexelStride(const ResourceFormat &fmt)
+{
+  // depth-stencil formats are padded out to the natural alignment of the depth
+  if(fmt.type == ResourceFormatType::D16S8)
+    return 4;
+  if(fmt.type == ResourceFormatType::D32S8)
+    return 8;
+
+  uint32_t stride = fmt.ElementSize();
+
+  // 24-bit depth is stored in 4 bytes
+  if(fmt.compType == CompType::Depth && stride == 3)
+    return 4;
+
+  return stride;
+}
+
+void DecodeFormattedRows(const ResourceFormat &fmt, const byte *src, size_t rowPitch,
+                         uint32_t width, uint32_t height, float *dst, bool *success)
+{
+  DecodeRowFunction decodeRow = GetRowDecoder(fmt);
+
+  if(success)
+    *success = true;
+
+  if(decodeRow)
+  {
+    for(uint32_t y = 0; y < height; y++)
+    {
+      decodeRow(fmt, src, width, dst);
+      src += rowPitch;
+      dst += width * 4;
+    }
+
+    return;
+  }
+
+  // check if the format is supported once, up front
+  if(success)
+    DecodeFormattedComponents(fmt, NULL, success);
+
+  const uint32_t stride = GetFormattedTexelStride(fmt);
+
+  for(uint32_t y = 0; y < height; y++)
+  {
+    const byte *texel = src;
+    for(uint32_t x = 0; x < width; x++)
+    {
+      FloatVector v = DecodeFormattedComponents(fmt, texel);
+      StoreTexel(dst, v.x, v.y, v.z, v.w);
+      texel += stride;
+      dst += 4;
+    }
+    src += rowPitch;
+  }
+}
+
 #if ENABLED(ENABLE_UNIT_TESTS)
 
 #undef None
 
 #include "catch/catch.hpp"
 #include "common/formatting.h"
+#include "common/timing.h"
 
 template <>
 rdcstr DoStringise(const FloatVector &el)
@@ -1603,4 +2062,174 @@ TEST_CASE("Check format conversion", "[format]")
   };
 }
 
+static ResourceFormat MakeTestFormat(ResourceFormatType type, CompType compType,
+                                     uint8_t compByteWidth, uint8_t compCount, bool bgra = false)
+{
+  ResourceFormat fmt;
+  fmt.type = type;
+  fmt.compType = compType;
+  fmt.compByteWidth = compByteWidth;
+  fmt.compCount = compCount;
+  fmt.SetBGRAOrder(bgra);
+  return fmt;
+}
+
+TEST_CASE("Check batched row decoding", "[format]")
+{
+  const ResourceFormat formats[] = {
+      MakeTestFormat(ResourceFormatType::Regular, CompType::UNorm, 1, 4),
+      MakeTestFormat(ResourceFormatType::Regular, CompType::UNorm, 1, 4, true),
+      MakeTestFormat(ResourceFormatType::Regular, CompType::UNormSRGB, 1, 4),
+      MakeTestFormat(ResourceFormatType::Regular, CompType::UNormSRGB, 1, 4, true),
+      MakeTestFormat(ResourceFormatType::Regular, CompType::Float, 2, 4),
+      MakeTestFormat(ResourceFormatType::Regular, CompType::Float, 4, 4),
+      MakeTestFormat(ResourceFormatType::R10G10B10A2, CompType::UNorm, 1, 4),
+      MakeTestFormat(ResourceFormatType::R10G10B10A2, CompType::UNorm, 1, 4, true),
+      MakeTestFormat(ResourceFormatType::R11G11B10, CompType::Float, 1, 3),
+      MakeTestFormat(ResourceFormatType::R9G9B9E5, CompType::Float, 1, 3),
+      MakeTestFormat(ResourceFormatType::R5G6B5, CompType::UNorm, 1, 3),
+      MakeTestFormat(ResourceFormatType::R5G6B5, CompType::UNorm, 1, 3, true),
+      MakeTestFormat(ResourceFormatType::R5G5B5A1, CompType::UNorm, 1, 4),
+      MakeTestFormat(ResourceFormatType::R5G5B5A1, CompType::UNorm, 1, 4, true),
+      MakeTestFormat(ResourceFormatType::R4G4B4A4, CompType::UNorm, 1, 4),
+      MakeTestFormat(ResourceFormatType::R4G4B4A4, CompType::UNorm, 1, 4, true),
+      // these go through the generic path
+      MakeTestFormat(ResourceFormatType::Regular, CompType::UNorm, 2, 3),
+      MakeTestFormat(ResourceFormatType::Regular, CompType::SInt, 1, 2),
+      MakeTestFormat(ResourceFormatType::R10G10B10A2, CompType::SNorm, 1, 4),
+      MakeTestFormat(ResourceFormatType::R10G10B10A2, CompType::UInt, 1, 4),
+      MakeTestFormat(ResourceFormatType::D24S8, CompType::Depth, 1, 2),
+  };
+
+  // odd sizes so the SIMD paths have a remainder, and padding at the end of each row
+  const uint32_t width = 37, height = 5;
+
+  for(const ResourceFormat &fmt : formats)
+  {
+    CAPTURE(ToStr(fmt.type));
+    CAPTURE(ToStr(fmt.compType));
+    CAPTURE(fmt.compByteWidth);
+    CAPTURE(fmt.compCount);
+    CAPTURE(fmt.BGRAOrder());
+
+    const uint32_t stride = GetFormattedTexelStride(fmt);
+    const size_t rowPitch = stride * width + 12;
+
+    // random bits, which will include infinities and NaNs for the float formats
+    bytebuf src;
+    src.resize(rowPitch * height);
+    uint32_t seed = 0x12345;
+    for(byte &b : src)
+    {
+      seed = seed * 1664525U + 1013904223U;
+      b = byte(seed >> 24);
+    }
+
+    rdcarray<float> batched;
+    batched.resize(width * height * 4);
+
+    bool success = false;
+    DecodeFormattedRows(fmt, src.data(), rowPitch, width, height, batched.data(), &success);
+    CHECK(success);
+
+    for(uint32_t y = 0; y < height; y++)
+    {
+      for(uint32_t x = 0; x < width; x++)
+      {
+        const byte *texel = src.data() + y * rowPitch + x * stride;
+        FloatVector expected = DecodeFormattedComponents(fmt, texel);
+
+        // compare bitwise so NaNs compare equal
+        uint32_t idx = (y * width + x) * 4;
+        if(memcmp(&expected, &batched[idx], sizeof(expected)) != 0)
+        {
+          CAPTURE(x);
+          CAPTURE(y);
+          CHECK(expected.x == batched[idx + 0]);
+          CHECK(expected.y == batched[idx + 1]);
+          CHECK(expected.z == batched[idx + 2]);
+          CHECK(expected.w == batched[idx + 3]);
+          FAIL("Batched decode doesn't match");
+        }
+      }
+    }
+  }
+
+  SECTION("Half conversion for every value")
+  {
+    rdcarray<uint16_t> halfs;
+    halfs.resize(0x10000);
+    for(uint32_t i = 0; i <= 0xffff; i++)
+      halfs[i] = uint16_t(i);
+
+    rdcarray<float> floats;
+    floats.resize(halfs.size());
+
+    ResourceFormat fmt = MakeTestFormat(ResourceFormatType::Regular, CompType::Float, 2, 4);
+    DecodeFormattedRows(fmt, (const byte *)halfs.data(), 0, 0x10000 / 4, 1, floats.data());
+
+    for(uint32_t i = 0; i <= 0xffff; i++)
+    {
+      float expected = ConvertFromHalf(uint16_t(i));
+      if(memcmp(&expected, &floats[i], sizeof(float)) != 0)
+      {
+        CAPTURE(i);
+        FAIL("Half conversion doesn't match");
+      }
+    }
+  };
+
+  SECTION("Unsupported formats")
+  {
+    ResourceFormat fmt = MakeTestFormat(ResourceFormatType::BC1, CompType::UNorm, 1, 4);
+
+    bool success = true;
+    float dst[4];
+    DecodeFormattedRows(fmt, NULL, 0, 0, 0, dst, &success);
+    CHECK_FALSE(success);
+  };
+}
+
+// not run by default, this is for comparing the batched and per-texel paths
+TEST_CASE("Benchmark batched row decoding", "[.][format][benchmark]")
+{
+  const uint32_t width = 3840, height = 2160;
+
+  const ResourceFormat formats[] = {
+      MakeTestFormat(ResourceFormatType::Regular, CompType::Float, 2, 4),
+      MakeTestFormat(ResourceFormatType::Regular, CompType::UNorm, 1, 4),
+      MakeTestFormat(ResourceFormatType::R10G10B10A2, CompType::UNorm, 1, 4),
+      MakeTestFormat(ResourceFormatType::R11G11B10, CompType::Float, 1, 3),
+  };
+
+  rdcarray<float> dst;
+  dst.resize(width * height * 4);
+
+  for(const ResourceFormat &fmt : formats)
+  {
+    const uint32_t stride = GetFormattedTexelStride(fmt);
+
+    bytebuf src;
+    src.resize(stride * width * height);
+    for(size_t i = 0; i < src.size(); i++)
+      src[i] = byte(i * 7 + (i >> 8));
+
+    PerformanceTimer timer;
+
+    FloatVector *out = (FloatVector *)dst.data();
+    for(uint32_t i = 0; i < width * height; i++)
+      out[i] = DecodeFormattedComponents(fmt, src.data() + i * stride);
+
+    double perTexel = timer.GetMilliseconds();
+    timer.Restart();
+
+    DecodeFormattedRows(fmt, src.data(), stride * width, width, height, dst.data());
+
+    double batched = timer.GetMilliseconds();
+
+    RDCLOG("%s %s: per-texel %.2f ms, batched %.2f ms", ToStr(fmt.type).c_str(),
+           ToStr(fmt.compType).c_str(), perTexel, batched);
+  }
+}
+
 #endif
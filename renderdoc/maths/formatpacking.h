@@ -186,3 +186,12 @@ void EncodeFormattedComponents(const ResourceFormat &fmt, FloatVector v, byte *d
 
 void DecodePixelData(const ResourceFormat &srcFmt, const byte *data, PixelValue &out,
                      bool *success = NULL);
+
+// decodes height rows of width texels each, rowPitch bytes apart, to tightly packed RGBA floats in
+// dst. The results are identical to calling DecodeFormattedComponents() on each texel, but common
+// formats are converted in bulk.
+void DecodeFormattedRows(const ResourceFormat &fmt, const byte *src, size_t rowPitch,
+                         uint32_t width, uint32_t height, float *dst, bool *success = NULL);
+
+// the distance between texels of the given format when tightly packed in a row
+uint32_t GetFormattedTexelStride(const ResourceFormat &fmt);
@@ -24,7 +24,10 @@
  ******************************************************************************/
 
 #include "os/os_specific.h"
+#include <algorithm>
+#include <map>
 #include "api/replay/control_types.h"
+#include "common/common.h"
 #include "common/formatting.h"
 #include "strings/string_utils.h"
 
@@ -146,6 +149,111 @@ rdcstr Callstack::AddressDetails::formattedString(const rdcstr &commonPath)
     return function;
 }
 
+CallstackFrameTable Callstack::ResolveCallstacks(StackResolver *resolver,
+                                                 const rdcarray<uint64_t> &addresses,
+                                                 const rdcarray<uint32_t> &callstackOffsets)
+{
+  CallstackFrameTable ret;
+
+  if(callstackOffsets.empty())
+  {
+    ret.callstackOffsets = {0, (uint32_t)addresses.size()};
+  }
+  else
+  {
+    bool valid = callstackOffsets[0] == 0 && callstackOffsets.back() == addresses.size();
+    for(size_t i = 1; valid && i < callstackOffsets.size(); i++)
+      valid = callstackOffsets[i - 1] <= callstackOffsets[i];
+
+    if(!valid)
+    {
+      RDCERR("Invalid callstack offsets for %zu addresses", addresses.size());
+      return ret;
+    }
+
+    ret.callstackOffsets = callstackOffsets;
+  }
+
+  if(addresses.empty())
+    return ret;
+
+  // the same frames show up over and over across a capture's callstacks, so only resolve each
+  // address once
+  rdcarray<uint64_t> unique = addresses;
+  std::sort(unique.begin(), unique.end());
+  unique.resize(std::unique(unique.begin(), unique.end()) - unique.begin());
+
+  rdcarray<AddressDetails> details;
+  if(resolver)
+    details = resolver->GetAddrs(unique);
+  else
+    details.resize(unique.size());
+
+  // different addresses can still format to the same frame, e.g. two calls on one line
+  std::map<rdcstr, uint32_t> frameLookup;
+  rdcarray<uint32_t> uniqueFrames;
+  uniqueFrames.resize(unique.size());
+
+  for(size_t i = 0; i < unique.size(); i++)
+  {
+    rdcstr frame = details[i].formattedString();
+
+    auto it = frameLookup.find(frame);
+    if(it == frameLookup.end())
+    {
+      it = frameLookup.insert(std::make_pair(frame, (uint32_t)ret.frames.size())).first;
+      ret.frames.push_back(frame);
+    }
+
+    uniqueFrames[i] = it->second;
+  }
+
+  ret.frameIndices.resize(addresses.size());
+  for(size_t i = 0; i < addresses.size(); i++)
+  {
+    size_t idx = std::lower_bound(unique.begin(), unique.end(), addresses[i]) - unique.begin();
+    ret.frameIndices[i] = uniqueFrames[idx];
+  }
+
+  return ret;
+}
+
+void Threading::ParallelFor(size_t count, std::function<void(size_t)> func, uint32_t maxThreads)
+{
+  if(count == 0)
+    return;
+
+  if(maxThreads == 0)
+    maxThreads = RDCCLAMP(NumberOfCores(), 1U, 16U);
+
+  int64_t next = 0;
+
+  auto worker = [&next, count, &func]() {
+    for(;;)
+    {
+      size_t idx = (size_t)Atomic::Inc64(&next) - 1;
+      if(idx >= count)
+        break;
+
+      func(idx);
+    }
+  };
+
+  size_t numThreads = RDCMIN((size_t)maxThreads, count);
+
+  rdcarray<ThreadHandle> threads;
+  for(size_t i = 1; i < numThreads; i++)
+    threads.push_back(CreateThread(worker));
+
+  worker();
+
+  for(ThreadHandle t : threads)
+  {
+    JoinThread(t);
+    CloseThread(t);
+  }
+}
+
 rdcstr OSUtility::MakeMachineIdentString(uint64_t ident)
 {
   rdcstr ret = "";
@@ -615,6 +723,25 @@ TEST_CASE("Test OS-specific functions", "[osspecific]")
     CHECK(value == numValues * numThreads - 1);
   };
 
+  SECTION("Parallel for")
+  {
+    int32_t values[totalCount] = {0};
+
+    Threading::ParallelFor(totalCount, [&values](size_t i) { Atomic::Inc32(&values[i]); },
+                           numThreads);
+
+    // every index is visited exactly once
+    for(int i = 0; i < totalCount; i++)
+      CHECK(values[i] == 1);
+
+    // more threads than work, and the default thread count
+    int32_t value = 0;
+    Threading::ParallelFor(3, [&value](size_t) { Atomic::Inc32(&value); }, 16);
+    Threading::ParallelFor(0, [&value](size_t) { Atomic::Inc32(&value); });
+    Threading::ParallelFor(numValues, [&value](size_t) { Atomic::Inc32(&value); });
+    CHECK(value == 3 + numValues);
+  };
+
   SECTION("Locks")
   {
     // check that holding the lock prevents a thread from modifying the value
@@ -707,4 +834,76 @@ TEST_CASE("Test OS-specific functions", "[osspecific]")
   };
 };
 
+TEST_CASE("Resolve callstacks into a frame table", "[callstack]")
+{
+  // resolves each address to a function named after it, except that addresses in the same 0x10
+  // block share a line and so format identically
+  struct TestResolver : public Callstack::StackResolver
+  {
+    Callstack::AddressDetails GetAddr(uint64_t addr)
+    {
+      lookups.push_back(addr);
+
+      Callstack::AddressDetails ret;
+      ret.function = StringFormat::Fmt("func_%llx", addr >> 4);
+      ret.filename = "file.cpp";
+      ret.line = uint32_t(addr >> 4);
+      return ret;
+    }
+
+    rdcarray<uint64_t> lookups;
+  };
+
+  TestResolver resolver;
+
+  SECTION("Shared frames")
+  {
+    rdcarray<uint64_t> addresses = {0x100, 0x200, 0x300, 0x200, 0x300, 0x104, 0x300};
+    rdcarray<uint32_t> offsets = {0, 3, 5, 5, 7};
+
+    CallstackFrameTable table = Callstack::ResolveCallstacks(&resolver, addresses, offsets);
+
+    // each address is only looked up once
+    CHECK(resolver.lookups.size() == 4);
+
+    // 0x100 and 0x104 are the same frame
+    REQUIRE(table.frames.size() == 3);
+    REQUIRE(table.frameIndices.size() == addresses.size());
+    CHECK(table.callstackOffsets == offsets);
+
+    for(size_t i = 0; i < addresses.size(); i++)
+    {
+      Callstack::AddressDetails expected = resolver.GetAddr(addresses[i]);
+      CHECK(table.frames[table.frameIndices[i]] == expected.formattedString());
+    }
+
+    CHECK(table.frameIndices[0] == table.frameIndices[5]);
+    CHECK(table.frameIndices[1] == table.frameIndices[3]);
+    CHECK(table.frameIndices[2] == table.frameIndices[6]);
+  };
+
+  SECTION("Single callstack")
+  {
+    rdcarray<uint64_t> addresses = {0x500, 0x600};
+
+    CallstackFrameTable table = Callstack::ResolveCallstacks(&resolver, addresses, {});
+
+    CHECK(table.frames.size() == 2);
+    CHECK(table.frameIndices == rdcarray<uint32_t>({0, 1}));
+    CHECK(table.callstackOffsets == rdcarray<uint32_t>({0, 2}));
+  };
+
+  SECTION("Invalid offsets")
+  {
+    rdcarray<uint64_t> addresses = {0x500, 0x600};
+
+    CallstackFrameTable table = Callstack::ResolveCallstacks(&resolver, addresses, {0, 1});
+
+    CHECK(table.frames.empty());
+    CHECK(table.frameIndices.empty());
+    CHECK(table.callstackOffsets.empty());
+    CHECK(resolver.lookups.empty());
+  };
+};
+
 #endif    // ENABLED(ENABLE_UNIT_TESTS)
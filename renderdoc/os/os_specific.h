@@ -42,6 +42,7 @@
 #include "common/globalconfig.h"
 #include "common/result.h"
 
+struct CallstackFrameTable;
 struct CaptureOptions;
 struct EnvironmentModification;
 struct PathEntry;
@@ -170,6 +171,12 @@ void DetachThread(ThreadHandle handle);
 void CloseThread(ThreadHandle handle);
 void Sleep(uint32_t milliseconds);
 
+// calls func for every index in [0, count), spread over up to maxThreads threads including the
+// calling thread. Indices are handed out one at a time so uneven work balances out. This creates
+// its own threads, so it can be used when the job system isn't running. If maxThreads is 0 the
+// number of cores is used, up to 16.
+void ParallelFor(size_t count, std::function<void(size_t)> func, uint32_t maxThreads = 0);
+
 // kind of windows specific, to handle this case:
 // http://blogs.msdn.com/b/oldnewthing/archive/2013/11/05/10463645.aspx
 void KeepModuleAlive();
@@ -246,6 +253,9 @@ int64_t Inc64(int64_t *i);
 int64_t Dec64(int64_t *i);
 int64_t ExchAdd64(int64_t *i, int64_t a);
 int32_t CmpExch32(int32_t *dest, int32_t oldVal, int32_t newVal);
+int64_t CmpExch64(int64_t *dest, int64_t oldVal, int64_t newVal);
+// read a value with acquire semantics, without taking the cacheline exclusively like CmpExch would
+int32_t Load32(const int32_t *i);
 };
 
 namespace Callstack
@@ -275,6 +285,16 @@ class StackResolver
 public:
   virtual ~StackResolver() {}
   virtual AddressDetails GetAddr(uint64_t addr) = 0;
+
+  // resolves many addresses at once, which implementations can spread across threads
+  virtual rdcarray<AddressDetails> GetAddrs(const rdcarray<uint64_t> &addrs)
+  {
+    rdcarray<AddressDetails> ret;
+    ret.reserve(addrs.size());
+    for(uint64_t addr : addrs)
+      ret.push_back(GetAddr(addr));
+    return ret;
+  }
 };
 
 void Init();
@@ -285,6 +305,12 @@ Stackwalk *Create();
 StackResolver *MakeResolver(bool interactive, byte *moduleDB, size_t DBSize,
                             RENDERDOC_ProgressCallback);
 
+// resolves a list of callstacks laid out one after another in addresses, with callstackOffsets as
+// described on CallstackFrameTable. Each unique address is only resolved once, and identical frames
+// are merged in the returned table.
+CallstackFrameTable ResolveCallstacks(StackResolver *resolver, const rdcarray<uint64_t> &addresses,
+                                      const rdcarray<uint32_t> &callstackOffsets);
+
 bool GetLoadedModules(byte *buf, size_t &size);
 };    // namespace Callstack
 
@@ -341,6 +367,12 @@ void fseek64(FILE *f, uint64_t offset, int origin);
 
 void ftruncateat(FILE *f, uint64_t length);
 
+// map the whole of an open file read-only into memory, returning NULL if that's not possible in
+// which case the file should be read normally. The mapping remains valid until it's unmapped, but
+// the file must not be modified or truncated while it's mapped.
+const byte *MapFileForRead(FILE *f, uint64_t &size);
+void UnmapFile(const byte *mapping, uint64_t size);
+
 bool fflush(FILE *f);
 
 bool feof(FILE *f);
@@ -31,10 +31,17 @@
 #include <link.h>
 #include <stdio.h>
 #include <string.h>
+#include <algorithm>
 #include <map>
 #include "common/common.h"
 #include "common/formatting.h"
+#include "core/settings.h"
 #include "os/os_specific.h"
+#include "linux_symbols.h"
+
+RDOC_CONFIG(bool, Linux_Callstacks_UseAddr2line, false,
+            "Resolve callstack addresses by running addr2line once per address, instead of reading "
+            "each module's symbols and line tables directly.");
 
 void *renderdocBase = NULL;
 void *renderdocEnd = NULL;
@@ -191,105 +198,189 @@ struct LookupModule
   char path[2048];
 };
 
-class LinuxResolver : public Callstack::StackResolver
+static void Addr2Line(const LookupModule &mod, uint64_t relative, Callstack::AddressDetails &ret)
 {
-public:
-  LinuxResolver(rdcarray<LookupModule> modules) { m_Modules = modules; }
-  Callstack::AddressDetails GetAddr(uint64_t addr)
-  {
-    EnsureCached(addr);
+  rdcstr cmd = StringFormat::Fmt("addr2line -fCe \"%s\" 0x%llx", mod.path, relative);
 
-    return m_Cache[addr];
-  }
+  RDCLOG(": %s", cmd.c_str());
 
-private:
-  void EnsureCached(uint64_t addr)
+  FILE *f = ::popen(cmd.c_str(), "r");
+
+  char result[2048] = {0};
+  fread(result, 1, 2047, f);
+
+  ::pclose(f);
+
+  char *line2 = strchr(result, '\n');
+  if(line2)
   {
-    auto it = m_Cache.insert(
-        std::pair<uint64_t, Callstack::AddressDetails>(addr, Callstack::AddressDetails()));
-    if(!it.second)
-      return;
+    *line2 = 0;
+    line2++;
+  }
 
-    Callstack::AddressDetails &ret = it.first->second;
+  ret.function = result;
+
+  if(line2)
+  {
+    char *linenum = line2 + strlen(line2) - 1;
+    while(linenum > line2 && *linenum != ':')
+      linenum--;
 
-    ret.filename = "Unknown";
     ret.line = 0;
-    ret.function = StringFormat::Fmt("0x%08llx", addr);
 
-    for(size_t i = 0; i < m_Modules.size(); i++)
+    if(*linenum == ':')
     {
-      if(addr >= m_Modules[i].base && addr < m_Modules[i].end)
+      *linenum = 0;
+      linenum++;
+
+      while(*linenum >= '0' && *linenum <= '9')
       {
-        RDCLOG("%llx relative to module %llx-%llx, with offset %llx", addr, m_Modules[i].base,
-               m_Modules[i].end, m_Modules[i].offset);
-        uint64_t relative = addr - m_Modules[i].base + m_Modules[i].offset;
-        rdcstr cmd = StringFormat::Fmt("addr2line -fCe \"%s\" 0x%llx", m_Modules[i].path, relative);
+        ret.line *= 10;
+        ret.line += (uint32_t(*linenum) - uint32_t('0'));
+        linenum++;
+      }
+    }
 
-        RDCLOG(": %s", cmd.c_str());
+    ret.filename = line2;
+  }
+}
 
-        FILE *f = ::popen(cmd.c_str(), "r");
+class LinuxResolver : public Callstack::StackResolver
+{
+public:
+  LinuxResolver(rdcarray<LookupModule> modules)
+  {
+    m_Modules = modules;
+    m_Symbols.resize(m_Modules.size());
+  }
 
-        char result[2048] = {0};
-        fread(result, 1, 2047, f);
+  ~LinuxResolver()
+  {
+    for(ModuleSymbols &mod : m_Symbols)
+      SAFE_DELETE(mod.symbols);
+  }
 
-        ::pclose(f);
+  Callstack::AddressDetails GetAddr(uint64_t addr) { return GetAddrs({addr})[0]; }
+  rdcarray<Callstack::AddressDetails> GetAddrs(const rdcarray<uint64_t> &addrs)
+  {
+    // each address that isn't cached yet, once
+    rdcarray<uint64_t> missing;
+    for(uint64_t addr : addrs)
+      if(m_Cache.find(addr) == m_Cache.end())
+        missing.push_back(addr);
+
+    std::sort(missing.begin(), missing.end());
+    missing.resize(std::unique(missing.begin(), missing.end()) - missing.begin());
+
+    if(!missing.empty())
+    {
+      rdcarray<int32_t> moduleIndices;
+      moduleIndices.resize(missing.size());
+
+      // load the symbols for each module we need that hasn't been loaded yet. This is the slow part
+      // so it's spread across threads, after which lookups are cheap
+      rdcarray<int32_t> toLoad;
 
-        char *line2 = strchr(result, '\n');
-        if(line2)
+      for(size_t i = 0; i < missing.size(); i++)
+      {
+        int32_t mod = FindModule(missing[i]);
+        moduleIndices[i] = mod;
+
+        if(mod >= 0 && !m_Symbols[mod].loaded && !Linux_Callstacks_UseAddr2line())
         {
-          *line2 = 0;
-          line2++;
+          m_Symbols[mod].loaded = true;
+          toLoad.push_back(mod);
         }
+      }
 
-        ret.function = result;
+      Threading::ParallelFor(toLoad.size(), [this, &toLoad](size_t i) { LoadSymbols(toLoad[i]); });
 
-        if(line2)
-        {
-          char *linenum = line2 + strlen(line2) - 1;
-          while(linenum > line2 && *linenum != ':')
-            linenum--;
+      rdcarray<Callstack::AddressDetails> resolved;
+      resolved.resize(missing.size());
 
-          ret.line = 0;
+      Threading::ParallelFor(missing.size(), [this, &missing, &moduleIndices, &resolved](size_t i) {
+        Resolve(missing[i], moduleIndices[i], resolved[i]);
+      });
 
-          if(*linenum == ':')
-          {
-            *linenum = 0;
-            linenum++;
+      for(size_t i = 0; i < missing.size(); i++)
+        m_Cache[missing[i]] = resolved[i];
+    }
 
-            while(*linenum >= '0' && *linenum <= '9')
-            {
-              ret.line *= 10;
-              ret.line += (uint32_t(*linenum) - uint32_t('0'));
-              linenum++;
-            }
-          }
+    rdcarray<Callstack::AddressDetails> ret;
+    ret.reserve(addrs.size());
+    for(uint64_t addr : addrs)
+      ret.push_back(m_Cache[addr]);
+    return ret;
+  }
 
-          ret.filename = line2;
-        }
+private:
+  struct ModuleSymbols
+  {
+    bool loaded = false;
+    // NULL if the module couldn't be read, in which case we fall back to addr2line
+    ELFSymbols *symbols = NULL;
+  };
 
-        break;
-      }
+  int32_t FindModule(uint64_t addr) const
+  {
+    for(size_t i = 0; i < m_Modules.size(); i++)
+    {
+      if(addr >= m_Modules[i].base && addr < m_Modules[i].end)
+        return (int32_t)i;
     }
+
+    return -1;
   }
 
-  rdcarray<LookupModule> m_Modules;
-  std::map<uint64_t, Callstack::AddressDetails> m_Cache;
-};
+  void LoadSymbols(int32_t mod)
+  {
+    ELFSymbols *symbols = new ELFSymbols;
 
-StackResolver *MakeResolver(bool interactive, byte *moduleDB, size_t DBSize,
-                            RENDERDOC_ProgressCallback progress)
-{
-  // we look in the original locations for the files, we don't prompt if we can't
-  // find the file, or the file doesn't have symbols (and we don't validate that
-  // the file is the right version). A good option for doing this would be
-  // http://github.com/mlabbe/nativefiledialog
+    if(symbols->Load(m_Modules[mod].path))
+    {
+      RDCLOG("Read %zu symbols and %zu lines from %s", symbols->NumSymbols(),
+             symbols->NumLines(), m_Modules[mod].path);
+      m_Symbols[mod].symbols = symbols;
+    }
+    else
+    {
+      RDCWARN("Couldn't read symbols from %s, falling back to addr2line", m_Modules[mod].path);
+      delete symbols;
+    }
+  }
 
-  if(DBSize < 8 || memcmp(moduleDB, "LNUXCALL", 8))
+  void Resolve(uint64_t addr, int32_t mod, Callstack::AddressDetails &ret) const
   {
-    RDCWARN("Can't load callstack resolve for this log. Possibly from another platform?");
-    return NULL;
+    ret.filename = "Unknown";
+    ret.line = 0;
+    ret.function = StringFormat::Fmt("0x%08llx", addr);
+
+    if(mod < 0)
+      return;
+
+    const LookupModule &module = m_Modules[mod];
+    uint64_t relative = addr - module.base + module.offset;
+
+    if(m_Symbols[mod].symbols)
+    {
+      m_Symbols[mod].symbols->Resolve(relative, ret);
+      return;
+    }
+
+    RDCLOG("%llx relative to module %llx-%llx, with offset %llx", addr, module.base, module.end,
+           module.offset);
+
+    Addr2Line(module, relative, ret);
   }
 
+  rdcarray<LookupModule> m_Modules;
+  rdcarray<ModuleSymbols> m_Symbols;
+  std::map<uint64_t, Callstack::AddressDetails> m_Cache;
+};
+
+static rdcarray<LookupModule> ParseModuleDB(byte *moduleDB, size_t DBSize,
+                                            RENDERDOC_ProgressCallback progress)
+{
   char *start = (char *)(moduleDB + 8);
   char *search = start;
   char *dbend = (char *)(moduleDB + DBSize);
@@ -360,6 +451,136 @@ StackResolver *MakeResolver(bool interactive, byte *moduleDB, size_t DBSize,
       search++;
   }
 
-  return new LinuxResolver(modules);
+  return modules;
+}
+
+StackResolver *MakeResolver(bool interactive, byte *moduleDB, size_t DBSize,
+                            RENDERDOC_ProgressCallback progress)
+{
+  // we look in the original locations for the files, we don't prompt if we can't
+  // find the file, or the file doesn't have symbols (and we don't validate that
+  // the file is the right version). A good option for doing this would be
+  // http://github.com/mlabbe/nativefiledialog
+
+  if(DBSize < 8 || memcmp(moduleDB, "LNUXCALL", 8))
+  {
+    RDCWARN("Can't load callstack resolve for this log. Possibly from another platform?");
+    return NULL;
+  }
+
+  return new LinuxResolver(ParseModuleDB(moduleDB, DBSize, progress));
 }
 };
+
+#if ENABLED(ENABLE_UNIT_TESTS)
+
+#include "catch/catch.hpp"
+#include "common/timing.h"
+
+static rdcarray<Callstack::LookupModule> GetTestModules()
+{
+  size_t size = 0;
+  Callstack::GetLoadedModules(NULL, size);
+
+  bytebuf db;
+  db.resize(size);
+  Callstack::GetLoadedModules(db.data(), size);
+
+  return Callstack::ParseModuleDB(db.data(), db.size(), NULL);
+}
+
+TEST_CASE("Resolve callstack addresses in-process", "[callstack]")
+{
+  rdcarray<Callstack::LookupModule> modules = GetTestModules();
+
+  // a return address somewhere inside a function in this module
+  const uint64_t addr = (uint64_t)(void *)&Callstack::GetLoadedModules + 4;
+
+  const Callstack::LookupModule *mod = NULL;
+  for(const Callstack::LookupModule &m : modules)
+    if(addr >= m.base && addr < m.end)
+      mod = &m;
+
+  REQUIRE(mod);
+
+  Callstack::LinuxResolver resolver(modules);
+
+  rdcarray<Callstack::AddressDetails> details = resolver.GetAddrs({addr, addr, 0x10});
+  REQUIRE(details.size() == 3);
+
+  CHECK(details[0].function.beginsWith("Callstack::GetLoadedModules("));
+  CHECK(details[1].function == details[0].function);
+  CHECK(details[2].function == "0x00000010");
+  CHECK(details[2].filename == "Unknown");
+
+  if(!FileIO::FindFileInPath("addr2line").empty())
+  {
+    Callstack::AddressDetails expected;
+    Callstack::Addr2Line(*mod, addr - mod->base + mod->offset, expected);
+
+    CHECK(details[0].function == expected.function);
+
+    // without debug info addr2line doesn't know the file and line either
+    if(!expected.filename.empty() && expected.filename != "??")
+    {
+      CHECK(details[0].filename == expected.filename);
+      CHECK(details[0].line == expected.line);
+    }
+  }
+}
+
+TEST_CASE("Benchmark callstack resolution against addr2line", "[.][callstack][benchmark]")
+{
+  rdcarray<Callstack::LookupModule> modules = GetTestModules();
+
+  const uint64_t self = (uint64_t)(void *)&Callstack::GetLoadedModules;
+
+  const Callstack::LookupModule *mod = NULL;
+  for(const Callstack::LookupModule &m : modules)
+    if(self >= m.base && self < m.end)
+      mod = &m;
+
+  REQUIRE(mod);
+
+  // spread addresses over the whole of this module's code, with each one repeated a few times as
+  // hot frames are in real captures
+  const size_t numUnique = 100000;
+  rdcarray<uint64_t> addrs;
+  for(size_t i = 0; i < numUnique * 4; i++)
+    addrs.push_back(mod->base + ((i % numUnique) * (mod->end - mod->base)) / numUnique);
+
+  PerformanceTimer timer;
+
+  {
+    Callstack::LinuxResolver resolver(modules);
+    resolver.GetAddrs(addrs);
+  }
+
+  double inProcess = timer.GetMilliseconds();
+
+  if(FileIO::FindFileInPath("addr2line").empty())
+  {
+    RDCLOG("In-process: %.2f ms for %zu addresses, addr2line not available", inProcess,
+           addrs.size());
+    return;
+  }
+
+  // addr2line is far too slow to run on every address
+  const size_t numAddr2Line = 200;
+
+  timer.Restart();
+
+  for(size_t i = 0; i < numAddr2Line; i++)
+  {
+    Callstack::AddressDetails details;
+    Callstack::Addr2Line(*mod, addrs[i] - mod->base + mod->offset, details);
+  }
+
+  double perAddr2Line = timer.GetMilliseconds() / numAddr2Line;
+
+  RDCLOG("In-process: %.2f ms for %zu addresses (%zu unique). addr2line: %.2f ms per address, "
+         "~%.0f ms for the unique addresses",
+         inProcess, addrs.size(), numUnique, perAddr2Line, perAddr2Line * numUnique);
+}
+
+#endif    // ENABLED(ENABLE_UNIT_TESTS)
@@ -0,0 +1,1210 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "linux_symbols.h"
+#include <cxxabi.h>
+#include <elf.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <map>
+#include "common/common.h"
+#include "common/formatting.h"
+#include "miniz/miniz.h"
+#include "strings/string_utils.h"
+
+// the subset of DWARF constants needed to read line tables
+enum
+{
+  DW_LNS_copy = 1,
+  DW_LNS_advance_pc = 2,
+  DW_LNS_advance_line = 3,
+  DW_LNS_set_file = 4,
+  DW_LNS_const_add_pc = 8,
+  DW_LNS_fixed_advance_pc = 9,
+
+  DW_LNE_end_sequence = 1,
+  DW_LNE_set_address = 2,
+  DW_LNE_define_file = 3,
+
+  DW_LNCT_path = 1,
+  DW_LNCT_directory_index = 2,
+
+  DW_FORM_data2 = 0x05,
+  DW_FORM_data4 = 0x06,
+  DW_FORM_data8 = 0x07,
+  DW_FORM_string = 0x08,
+  DW_FORM_block = 0x09,
+  DW_FORM_data1 = 0x0b,
+  DW_FORM_strp = 0x0e,
+  DW_FORM_udata = 0x0f,
+  DW_FORM_data16 = 0x1e,
+  DW_FORM_line_strp = 0x1f,
+};
+
+namespace
+{
+// reads section headers and section contents from an ELF file, without loading the whole file
+class ELFFile
+{
+public:
+  ~ELFFile()
+  {
+    if(m_File)
+      FileIO::fclose(m_File);
+  }
+
+  bool Open(const rdcstr &path)
+  {
+    m_File = FileIO::fopen(path, FileIO::ReadBinary);
+    if(!m_File)
+      return false;
+
+    FileIO::fseek64(m_File, 0, SEEK_END);
+    m_FileSize = FileIO::ftell64(m_File);
+
+    Elf64_Ehdr ehdr;
+    if(!Read(0, &ehdr, sizeof(ehdr)))
+      return false;
+
+    if(memcmp(ehdr.e_ident, ELFMAG, SELFMAG) != 0 || ehdr.e_ident[EI_CLASS] != ELFCLASS64 ||
+       ehdr.e_ident[EI_DATA] != ELFDATA2LSB || ehdr.e_shoff == 0 ||
+       ehdr.e_shentsize != sizeof(Elf64_Shdr))
+      return false;
+
+    // with very many sections the real count and name table index are in the first header
+    Elf64_Shdr first;
+    if(!Read(ehdr.e_shoff, &first, sizeof(first)))
+      return false;
+
+    uint64_t numSections = ehdr.e_shnum ? ehdr.e_shnum : first.sh_size;
+    uint32_t namesIndex = ehdr.e_shstrndx == SHN_XINDEX ? first.sh_link : ehdr.e_shstrndx;
+
+    if(numSections == 0 || numSections > m_FileSize / sizeof(Elf64_Shdr) ||
+       namesIndex >= numSections)
+      return false;
+
+    m_Sections.resize((size_t)numSections);
+    if(!Read(ehdr.e_shoff, m_Sections.data(), m_Sections.byteSize()))
+      return false;
+
+    if(!ReadSectionData(m_Sections[namesIndex], m_SectionNames))
+      return false;
+
+    m_SectionNames.push_back(0);
+    return true;
+  }
+
+  bool ReadSection(const char *name, bytebuf &out)
+  {
+    out.clear();
+
+    for(const Elf64_Shdr &sh : m_Sections)
+    {
+      if(sh.sh_name < m_SectionNames.size() &&
+         strcmp(name, (const char *)m_SectionNames.data() + sh.sh_name) == 0)
+        return ReadSectionData(sh, out);
+    }
+
+    return false;
+  }
+
+  // string tables are NULL terminated after reading, so that any offset into them is safe to use
+  // as a C string
+  bool ReadStringTable(const char *name, bytebuf &out)
+  {
+    bool ret = ReadSection(name, out);
+    out.push_back(0);
+    return ret;
+  }
+
+private:
+  bool Read(uint64_t offset, void *data, uint64_t size)
+  {
+    if(size > m_FileSize || offset > m_FileSize - size)
+      return false;
+
+    FileIO::fseek64(m_File, offset, SEEK_SET);
+    return FileIO::fread(data, 1, (size_t)size, m_File) == size;
+  }
+
+  bool ReadSectionData(const Elf64_Shdr &sh, bytebuf &out)
+  {
+    if(sh.sh_type == SHT_NOBITS)
+      return false;
+
+    // check the section lies within the file before allocating anything for it
+    if(sh.sh_offset > m_FileSize || sh.sh_size > m_FileSize - sh.sh_offset)
+      return false;
+
+    bytebuf contents;
+    contents.resize((size_t)sh.sh_size);
+    if(!Read(sh.sh_offset, contents.data(), contents.size()))
+      return false;
+
+    if((sh.sh_flags & SHF_COMPRESSED) == 0)
+    {
+      out.swap(contents);
+      return true;
+    }
+
+    Elf64_Chdr chdr;
+    if(contents.size() < sizeof(chdr))
+      return false;
+
+    memcpy(&chdr, contents.data(), sizeof(chdr));
+
+    if(chdr.ch_type != ELFCOMPRESS_ZLIB || chdr.ch_size > 0xffffffffULL)
+    {
+      RDCWARN("Unsupported compressed section type %u", chdr.ch_type);
+      return false;
+    }
+
+    // deflate can't expand data by more than ~1032:1, so anything claiming more is corrupt
+    const uint64_t MaxDeflateRatio = 1032;
+    if(chdr.ch_size > (contents.size() - sizeof(chdr)) * MaxDeflateRatio)
+    {
+      RDCWARN("Compressed section claims implausible size %llu from %zu bytes", chdr.ch_size,
+              contents.size() - sizeof(chdr));
+      return false;
+    }
+
+    out.resize((size_t)chdr.ch_size);
+
+    mz_ulong size = (mz_ulong)chdr.ch_size;
+    int ret = mz_uncompress(out.data(), &size, contents.data() + sizeof(chdr),
+                            (mz_ulong)(contents.size() - sizeof(chdr)));
+
+    return ret == MZ_OK && size == chdr.ch_size;
+  }
+
+  FILE *m_File = NULL;
+  uint64_t m_FileSize = 0;
+  rdcarray<Elf64_Shdr> m_Sections;
+  bytebuf m_SectionNames;
+};
+
+// bounds-checked reading of DWARF data. Reading past the end sets the error flag and returns zeros
+struct DWARFReader
+{
+  DWARFReader(const byte *start, const byte *finish) : cur(start), end(finish) {}
+  const byte *cur;
+  const byte *end;
+  bool error = false;
+
+  template <typename T>
+  T Read()
+  {
+    T ret = T();
+    if(size_t(end - cur) < sizeof(T))
+    {
+      error = true;
+      cur = end;
+      return ret;
+    }
+    memcpy(&ret, cur, sizeof(T));
+    cur += sizeof(T);
+    return ret;
+  }
+
+  uint64_t ReadOffset(bool dwarf64) { return dwarf64 ? Read<uint64_t>() : Read<uint32_t>(); }
+  uint64_t ReadULEB()
+  {
+    uint64_t ret = 0;
+    uint32_t shift = 0;
+    byte b = 0;
+    do
+    {
+      if(cur >= end)
+      {
+        error = true;
+        return ret;
+      }
+      b = *cur++;
+      if(shift < 64)
+        ret |= uint64_t(b & 0x7f) << shift;
+      shift += 7;
+    } while(b & 0x80);
+    return ret;
+  }
+
+  int64_t ReadSLEB()
+  {
+    uint64_t ret = 0;
+    uint32_t shift = 0;
+    byte b = 0;
+    do
+    {
+      if(cur >= end)
+      {
+        error = true;
+        return (int64_t)ret;
+      }
+      b = *cur++;
+      if(shift < 64)
+        ret |= uint64_t(b & 0x7f) << shift;
+      shift += 7;
+    } while(b & 0x80);
+
+    if(shift < 64 && (b & 0x40))
+      ret |= ~0ULL << shift;
+
+    return (int64_t)ret;
+  }
+
+  const char *ReadString()
+  {
+    const char *ret = (const char *)cur;
+    while(cur < end && *cur)
+      cur++;
+
+    if(cur >= end)
+    {
+      error = true;
+      return "";
+    }
+
+    cur++;
+    return ret;
+  }
+
+  void Skip(uint64_t bytes)
+  {
+    if(bytes > uint64_t(end - cur))
+    {
+      error = true;
+      cur = end;
+      return;
+    }
+    cur += bytes;
+  }
+};
+
+// reads one field of a DWARF 5 directory or file entry, as a string or number depending on form
+bool ReadEntryField(DWARFReader &r, uint64_t form, bool dwarf64, const bytebuf &lineStr,
+                    const bytebuf &str, rdcstr &strValue, uint64_t &value)
+{
+  switch(form)
+  {
+    case DW_FORM_string: strValue = r.ReadString(); break;
+    case DW_FORM_line_strp:
+    case DW_FORM_strp:
+    {
+      const bytebuf &table = form == DW_FORM_strp ? str : lineStr;
+      uint64_t offs = r.ReadOffset(dwarf64);
+      if(offs >= table.size())
+        return false;
+      strValue = (const char *)table.data() + offs;
+      break;
+    }
+    case DW_FORM_udata: value = r.ReadULEB(); break;
+    case DW_FORM_data1: value = r.Read<uint8_t>(); break;
+    case DW_FORM_data2: value = r.Read<uint16_t>(); break;
+    case DW_FORM_data4: value = r.Read<uint32_t>(); break;
+    case DW_FORM_data8: value = r.Read<uint64_t>(); break;
+    case DW_FORM_data16: r.Skip(16); break;
+    case DW_FORM_block: r.Skip(r.ReadULEB()); break;
+    // string index forms need the unit's string offsets from .debug_info, which we don't read
+    default: return false;
+  }
+
+  return !r.error;
+}
+
+rdcstr JoinPath(const rdcstr &dir, const rdcstr &name)
+{
+  if(dir.empty() || name.beginsWith("/"))
+    return name;
+  return dir + "/" + name;
+}
+
+rdcstr Demangle(const char *name)
+{
+  int status = 0;
+  char *demangled = abi::__cxa_demangle(name, NULL, NULL, &status);
+  if(status != 0 || demangled == NULL)
+    return name;
+
+  rdcstr ret = demangled;
+  free(demangled);
+  return ret;
+}
+
+// finds a separate debug file for a stripped module, the same way gdb does: by build ID first then
+// by the debug link section's filename
+rdcstr FindDebugFile(ELFFile &elf, const rdcstr &path)
+{
+  bytebuf note;
+  if(elf.ReadSection(".note.gnu.build-id", note) && note.size() > sizeof(Elf64_Nhdr))
+  {
+    Elf64_Nhdr nhdr;
+    memcpy(&nhdr, note.data(), sizeof(nhdr));
+
+    uint64_t descOffset = sizeof(nhdr) + AlignUp4(nhdr.n_namesz);
+    if(nhdr.n_type == NT_GNU_BUILD_ID && nhdr.n_descsz >= 2 &&
+       descOffset + nhdr.n_descsz <= note.size())
+    {
+      rdcstr id;
+      for(uint32_t i = 0; i < nhdr.n_descsz; i++)
+        id += StringFormat::Fmt("%02x", note[(size_t)descOffset + i]);
+
+      rdcstr candidate = StringFormat::Fmt("/usr/lib/debug/.build-id/%s/%s.debug",
+                                           id.substr(0, 2).c_str(), id.substr(2).c_str());
+      if(FileIO::exists(candidate))
+        return candidate;
+    }
+  }
+
+  bytebuf link;
+  if(elf.ReadStringTable(".gnu_debuglink", link) && link[0] != 0)
+  {
+    rdcstr name = (const char *)link.data();
+    rdcstr dir = get_dirname(path);
+
+    const rdcstr candidates[] = {
+        dir + "/" + name,
+        dir + "/.debug/" + name,
+        "/usr/lib/debug" + dir + "/" + name,
+    };
+
+    for(const rdcstr &candidate : candidates)
+      if(candidate != path && FileIO::exists(candidate))
+        return candidate;
+  }
+
+  return rdcstr();
+}
+};
+
+const uint32_t ELFSymbols::NoFile;
+
+bool ELFSymbols::Load(const rdcstr &path)
+{
+  ELFFile elf;
+  if(!elf.Open(path))
+    return false;
+
+  bytebuf symtab, strtab;
+  if(elf.ReadSection(".symtab", symtab) && elf.ReadStringTable(".strtab", strtab))
+    AddSymbols(symtab, strtab);
+  else if(elf.ReadSection(".dynsym", symtab) && elf.ReadStringTable(".dynstr", strtab))
+    AddSymbols(symtab, strtab);
+
+  bytebuf debugLine, lineStr, str;
+  if(elf.ReadSection(".debug_line", debugLine))
+  {
+    elf.ReadStringTable(".debug_line_str", lineStr);
+    elf.ReadStringTable(".debug_str", str);
+    AddLines(debugLine, lineStr, str);
+    return true;
+  }
+
+  rdcstr debugPath = FindDebugFile(elf, path);
+
+  ELFFile debug;
+  if(debugPath.empty() || !debug.Open(debugPath))
+    return true;
+
+  // a stripped module only has its dynamic symbols, the debug file has all of them
+  if(debug.ReadSection(".symtab", symtab) && debug.ReadStringTable(".strtab", strtab))
+  {
+    m_Symbols.clear();
+    m_Names.clear();
+    AddSymbols(symtab, strtab);
+  }
+
+  if(debug.ReadSection(".debug_line", debugLine))
+  {
+    debug.ReadStringTable(".debug_line_str", lineStr);
+    debug.ReadStringTable(".debug_str", str);
+    AddLines(debugLine, lineStr, str);
+  }
+
+  return true;
+}
+
+void ELFSymbols::AddSymbols(const bytebuf &symtab, const bytebuf &strtab)
+{
+  const size_t count = symtab.size() / sizeof(Elf64_Sym);
+
+  for(size_t i = 0; i < count; i++)
+  {
+    Elf64_Sym sym;
+    memcpy(&sym, symtab.data() + i * sizeof(sym), sizeof(sym));
+
+    const uint32_t type = ELF64_ST_TYPE(sym.st_info);
+    if((type != STT_FUNC && type != STT_GNU_IFUNC) || sym.st_shndx == SHN_UNDEF ||
+       sym.st_value == 0 || sym.st_name >= strtab.size())
+      continue;
+
+    const char *name = (const char *)strtab.data() + sym.st_name;
+
+    m_Symbols.push_back({sym.st_value, sym.st_size, (uint32_t)m_Names.size()});
+    m_Names.append(name, strlen(name) + 1);
+  }
+
+  std::stable_sort(m_Symbols.begin(), m_Symbols.end(),
+                   [](const Symbol &a, const Symbol &b) { return a.address < b.address; });
+
+  // aliases share an address, keep only the first
+  size_t unique = 0;
+  for(size_t i = 0; i < m_Symbols.size(); i++)
+  {
+    if(unique > 0 && m_Symbols[unique - 1].address == m_Symbols[i].address)
+      continue;
+    m_Symbols[unique++] = m_Symbols[i];
+  }
+  m_Symbols.resize(unique);
+}
+
+void ELFSymbols::AddLines(const bytebuf &debugLine, const bytebuf &lineStr, const bytebuf &str)
+{
+  std::map<rdcstr, uint32_t> fileLookup;
+  auto addFile = [this, &fileLookup](const rdcstr &path) {
+    auto it = fileLookup.find(path);
+    if(it != fileLookup.end())
+      return it->second;
+
+    uint32_t ret = (uint32_t)m_Files.size();
+    m_Files.push_back(path);
+    fileLookup[path] = ret;
+    return ret;
+  };
+
+  DWARFReader units(debugLine.data(), debugLine.data() + debugLine.size());
+
+  rdcarray<LineRow> sequence;
+
+  while(units.cur < units.end && !units.error)
+  {
+    bool dwarf64 = false;
+    uint64_t unitLength = units.Read<uint32_t>();
+    if(unitLength == 0xffffffff)
+    {
+      dwarf64 = true;
+      unitLength = units.Read<uint64_t>();
+    }
+
+    if(units.error || unitLength > uint64_t(units.end - units.cur))
+      break;
+
+    DWARFReader r(units.cur, units.cur + unitLength);
+    units.cur += unitLength;
+
+    const uint16_t version = r.Read<uint16_t>();
+    if(version < 2 || version > 5)
+      continue;
+
+    if(version >= 5)
+    {
+      // address size and segment selector size
+      r.Skip(2);
+    }
+
+    const uint64_t headerLength = r.ReadOffset(dwarf64);
+    if(r.error || headerLength > uint64_t(r.end - r.cur))
+      continue;
+
+    DWARFReader program(r.cur + headerLength, r.end);
+
+    const uint8_t minInstLength = r.Read<uint8_t>();
+    if(version >= 4)
+    {
+      // maximum operations per instruction, only needed for VLIW
+      r.Skip(1);
+    }
+    // default is_stmt
+    r.Skip(1);
+    const int8_t lineBase = r.Read<int8_t>();
+    const uint8_t lineRange = r.Read<uint8_t>();
+    const uint8_t opcodeBase = r.Read<uint8_t>();
+
+    if(r.error || lineRange == 0 || opcodeBase == 0)
+      continue;
+
+    rdcarray<uint8_t> opcodeLengths;
+    opcodeLengths.resize(opcodeBase - 1);
+    for(uint8_t &len : opcodeLengths)
+      len = r.Read<uint8_t>();
+
+    rdcarray<rdcstr> dirs;
+
+    // indices into m_Files for each file in the unit, by the unit's numbering
+    rdcarray<uint32_t> files;
+
+    auto addUnitFile = [&](uint64_t dirIndex, const rdcstr &name) {
+      rdcstr dir = dirIndex < dirs.size() ? dirs[(size_t)dirIndex] : rdcstr();
+      files.push_back(addFile(JoinPath(dir, name)));
+    };
+
+    if(version >= 5)
+    {
+      rdcarray<rdcpair<uint64_t, uint64_t>> formats;
+
+      // directories then files, each a list of formats followed by the entries
+      for(int list = 0; list < 2 && !r.error; list++)
+      {
+        formats.resize(r.Read<uint8_t>());
+        for(rdcpair<uint64_t, uint64_t> &format : formats)
+        {
+          format.first = r.ReadULEB();
+          format.second = r.ReadULEB();
+        }
+
+        const uint64_t count = r.ReadULEB();
+        if(count > 0 && (formats.empty() || count > uint64_t(r.end - r.cur)))
+        {
+          r.error = true;
+          break;
+        }
+
+        for(uint64_t i = 0; i < count && !r.error; i++)
+        {
+          rdcstr path;
+          uint64_t dirIndex = 0;
+
+          for(const rdcpair<uint64_t, uint64_t> &format : formats)
+          {
+            rdcstr strValue;
+            uint64_t value = 0;
+            if(!ReadEntryField(r, format.second, dwarf64, lineStr, str, strValue, value))
+            {
+              r.error = true;
+              break;
+            }
+
+            if(format.first == DW_LNCT_path)
+              path = strValue;
+            else if(format.first == DW_LNCT_directory_index)
+              dirIndex = value;
+          }
+
+          // directory 0 is the compilation directory, which the others may be relative to
+          if(list == 0)
+            dirs.push_back(dirs.empty() ? path : JoinPath(dirs[0], path));
+          else
+            addUnitFile(dirIndex, path);
+        }
+      }
+    }
+    else
+    {
+      // the compilation directory isn't listed before DWARF 5, so paths relative to it are left
+      // relative
+      dirs.push_back(rdcstr());
+      for(;;)
+      {
+        const char *dir = r.ReadString();
+        if(r.error || dir[0] == 0)
+          break;
+        dirs.push_back(dir);
+      }
+
+      // files are numbered from 1
+      files.push_back(NoFile);
+      for(;;)
+      {
+        const char *name = r.ReadString();
+        if(r.error || name[0] == 0)
+          break;
+
+        uint64_t dirIndex = r.ReadULEB();
+        // modification time and length
+        r.ReadULEB();
+        r.ReadULEB();
+
+        addUnitFile(dirIndex, name);
+      }
+    }
+
+    if(r.error)
+      continue;
+
+    uint64_t address = 0;
+    uint64_t file = 1;
+    int64_t line = 1;
+
+    auto addRow = [&](bool endSequence) {
+      LineRow row;
+      row.address = address;
+      row.file = (endSequence || file >= files.size()) ? NoFile : files[(size_t)file];
+      row.line = (uint32_t)RDCCLAMP(line, (int64_t)0, (int64_t)UINT32_MAX);
+      sequence.push_back(row);
+
+      if(!endSequence)
+        return;
+
+      // sequences for code the linker discarded are left at address 0, or at a tombstone value
+      const uint64_t start = sequence[0].address;
+      if(start != 0 && start < ~0ULL - 1)
+        m_Lines.append(sequence);
+
+      sequence.clear();
+      address = 0;
+      file = 1;
+      line = 1;
+    };
+
+    while(program.cur < program.end && !program.error)
+    {
+      const uint8_t opcode = program.Read<uint8_t>();
+
+      if(opcode >= opcodeBase)
+      {
+        const uint8_t adjusted = opcode - opcodeBase;
+        address += (adjusted / lineRange) * minInstLength;
+        line += lineBase + (adjusted % lineRange);
+        addRow(false);
+        continue;
+      }
+
+      switch(opcode)
+      {
+        case 0:
+        {
+          const uint64_t length = program.ReadULEB();
+          if(length == 0 || length > uint64_t(program.end - program.cur))
+          {
+            program.error = true;
+            break;
+          }
+
+          const byte *next = program.cur + length;
+          const uint8_t extended = program.Read<uint8_t>();
+
+          if(extended == DW_LNE_end_sequence)
+          {
+            addRow(true);
+          }
+          else if(extended == DW_LNE_set_address)
+          {
+            if(length - 1 == 8)
+              address = program.Read<uint64_t>();
+            else if(length - 1 == 4)
+              address = program.Read<uint32_t>();
+          }
+          else if(extended == DW_LNE_define_file)
+          {
+            const char *name = program.ReadString();
+            addUnitFile(program.ReadULEB(), name);
+          }
+
+          program.cur = next;
+          break;
+        }
+        case DW_LNS_copy: addRow(false); break;
+        case DW_LNS_advance_pc: address += program.ReadULEB() * minInstLength; break;
+        case DW_LNS_advance_line: line += program.ReadSLEB(); break;
+        case DW_LNS_set_file: file = program.ReadULEB(); break;
+        case DW_LNS_const_add_pc:
+          address += ((255 - opcodeBase) / lineRange) * minInstLength;
+          break;
+        case DW_LNS_fixed_advance_pc: address += program.Read<uint16_t>(); break;
+        default:
+        {
+          // skip the arguments of any opcodes that don't affect the address, file or line
+          for(uint8_t i = 0; i < opcodeLengths[opcode - 1]; i++)
+            program.ReadULEB();
+          break;
+        }
+      }
+    }
+
+    // a sequence that wasn't ended is incomplete, so drop it
+    sequence.clear();
+  }
+
+  // where one sequence ends at the same address another starts, the end comes first so that a
+  // lookup finds the start. Otherwise the original order is kept so the last row for any address
+  // wins, as with addr2line
+  std::stable_sort(m_Lines.begin(), m_Lines.end(), [](const LineRow &a, const LineRow &b) {
+    if(a.address != b.address)
+      return a.address < b.address;
+    return a.file == NoFile && b.file != NoFile;
+  });
+}
+
+bool ELFSymbols::Resolve(uint64_t address, Callstack::AddressDetails &details) const
+{
+  bool found = false;
+
+  const Symbol *sym =
+      std::upper_bound(m_Symbols.begin(), m_Symbols.end(), address,
+                       [](uint64_t addr, const Symbol &s) { return addr < s.address; });
+
+  if(sym != m_Symbols.begin())
+  {
+    sym--;
+
+    // symbols with no size are assumed to extend up to the next one
+    if(sym->size == 0 || address - sym->address < sym->size)
+    {
+      details.function = Demangle(&m_Names[sym->name]);
+      found = true;
+    }
+  }
+
+  const LineRow *row =
+      std::upper_bound(m_Lines.begin(), m_Lines.end(), address,
+                       [](uint64_t addr, const LineRow &r) { return addr < r.address; });
+
+  if(row != m_Lines.begin())
+  {
+    row--;
+
+    if(row->file != NoFile)
+    {
+      details.filename = m_Files[row->file];
+      details.line = row->line;
+      found = true;
+    }
+  }
+
+  return found;
+}
+
+#if ENABLED(ENABLE_UNIT_TESTS)
+
+#include "catch/catch.hpp"
+
+namespace
+{
+struct TestSection
+{
+  rdcstr name;
+  uint32_t type;
+  uint64_t flags;
+  bytebuf data;
+  uint32_t link;
+  uint64_t entsize;
+};
+
+bytebuf MakeTestELF(const rdcarray<TestSection> &sections)
+{
+  bytebuf ret;
+  ret.resize(sizeof(Elf64_Ehdr));
+
+  bytebuf names = {0};
+
+  // the null section, then the given sections, then the section name table
+  rdcarray<Elf64_Shdr> headers;
+  headers.resize(sections.size() + 2);
+  memset(headers.data(), 0, headers.byteSize());
+
+  for(size_t i = 0; i <= sections.size(); i++)
+  {
+    Elf64_Shdr &sh = headers[i + 1];
+
+    const bool isNames = (i == sections.size());
+    const rdcstr name = isNames ? rdcstr(".shstrtab") : sections[i].name;
+    const bytebuf &data = isNames ? names : sections[i].data;
+
+    sh.sh_name = (uint32_t)names.size();
+    names.append((const byte *)name.c_str(), name.size() + 1);
+
+    sh.sh_type = isNames ? SHT_STRTAB : sections[i].type;
+    sh.sh_flags = isNames ? 0 : sections[i].flags;
+    sh.sh_link = isNames ? 0 : sections[i].link;
+    sh.sh_entsize = isNames ? 0 : sections[i].entsize;
+    sh.sh_offset = ret.size();
+    sh.sh_size = data.size();
+    sh.sh_addralign = 1;
+
+    ret.append(data);
+  }
+
+  ret.resize(AlignUp(ret.size(), (size_t)8));
+
+  Elf64_Ehdr ehdr = {};
+  memcpy(ehdr.e_ident, ELFMAG, SELFMAG);
+  ehdr.e_ident[EI_CLASS] = ELFCLASS64;
+  ehdr.e_ident[EI_DATA] = ELFDATA2LSB;
+  ehdr.e_ident[EI_VERSION] = EV_CURRENT;
+  ehdr.e_type = ET_DYN;
+  ehdr.e_machine = EM_X86_64;
+  ehdr.e_version = EV_CURRENT;
+  ehdr.e_shoff = ret.size();
+  ehdr.e_ehsize = sizeof(Elf64_Ehdr);
+  ehdr.e_shentsize = sizeof(Elf64_Shdr);
+  ehdr.e_shnum = (uint16_t)headers.size();
+  ehdr.e_shstrndx = (uint16_t)(headers.size() - 1);
+
+  ret.append((const byte *)headers.data(), headers.byteSize());
+  memcpy(ret.data(), &ehdr, sizeof(ehdr));
+
+  return ret;
+}
+
+template <typename T>
+void Write(bytebuf &buf, T val)
+{
+  buf.append((const byte *)&val, sizeof(T));
+}
+
+void WriteULEB(bytebuf &buf, uint64_t val)
+{
+  do
+  {
+    byte b = val & 0x7f;
+    val >>= 7;
+    buf.push_back(val ? (b | 0x80) : b);
+  } while(val);
+}
+
+void WriteSLEB(bytebuf &buf, int64_t val)
+{
+  for(;;)
+  {
+    byte b = val & 0x7f;
+    val >>= 7;
+    if((val == 0 && (b & 0x40) == 0) || (val == -1 && (b & 0x40) != 0))
+    {
+      buf.push_back(b);
+      return;
+    }
+    buf.push_back(b | 0x80);
+  }
+}
+
+void WriteString(bytebuf &buf, const char *str)
+{
+  buf.append((const byte *)str, strlen(str) + 1);
+}
+
+void WriteSetAddress(bytebuf &buf, uint64_t address)
+{
+  buf.push_back(0);
+  WriteULEB(buf, 9);
+  buf.push_back(DW_LNE_set_address);
+  Write(buf, address);
+}
+
+void WriteEndSequence(bytebuf &buf)
+{
+  buf.push_back(0);
+  WriteULEB(buf, 1);
+  buf.push_back(DW_LNE_end_sequence);
+}
+
+// writes the unit length and header length around a line table unit's contents
+void FinishLineUnit(bytebuf &debugLine, const bytebuf &header, const bytebuf &program,
+                    uint16_t version)
+{
+  bytebuf unit;
+  Write<uint16_t>(unit, version);
+  if(version >= 5)
+  {
+    // address size, segment selector size
+    unit.push_back(8);
+    unit.push_back(0);
+  }
+  Write<uint32_t>(unit, (uint32_t)header.size());
+  unit.append(header);
+  unit.append(program);
+
+  Write<uint32_t>(debugLine, (uint32_t)unit.size());
+  debugLine.append(unit);
+}
+
+void WriteLineParams(bytebuf &header)
+{
+  // min instruction length, max ops, default is_stmt, line base, line range, opcode base
+  const byte params[] = {1, 1, 1, byte(-5), 14, 13, 0, 1, 1, 1, 1, 0, 0, 0, 1, 0, 0, 1};
+  header.append(params, sizeof(params));
+}
+
+byte SpecialOpcode(uint32_t addressAdvance, int32_t lineAdvance)
+{
+  return byte((lineAdvance + 5) + 14 * addressAdvance + 13);
+}
+
+// a DWARF 4 unit covering 0x1000-0x1050, a DWARF 5 unit covering 0x2000-0x2010, and a discarded
+// sequence at 0
+void MakeTestLines(bytebuf &debugLine, bytebuf &lineStr)
+{
+  {
+    bytebuf header, program;
+    WriteLineParams(header);
+    WriteString(header, "/src");
+    header.push_back(0);
+    WriteString(header, "a.cpp");
+    WriteULEB(header, 1);
+    WriteULEB(header, 0);
+    WriteULEB(header, 0);
+    WriteString(header, "/abs/b.h");
+    WriteULEB(header, 0);
+    WriteULEB(header, 0);
+    WriteULEB(header, 0);
+    header.push_back(0);
+
+    WriteSetAddress(program, 0);
+    program.push_back(DW_LNS_copy);
+    program.push_back(DW_LNS_advance_pc);
+    WriteULEB(program, 0x40);
+    WriteEndSequence(program);
+
+    WriteSetAddress(program, 0x1000);
+    program.push_back(DW_LNS_advance_line);
+    WriteSLEB(program, 9);
+    program.push_back(DW_LNS_copy);
+    program.push_back(SpecialOpcode(4, 2));
+    program.push_back(DW_LNS_set_file);
+    WriteULEB(program, 2);
+    program.push_back(DW_LNS_advance_line);
+    WriteSLEB(program, 88);
+    program.push_back(DW_LNS_advance_pc);
+    WriteULEB(program, 0x10);
+    program.push_back(DW_LNS_copy);
+    program.push_back(DW_LNS_set_file);
+    WriteULEB(program, 1);
+    program.push_back(DW_LNS_advance_line);
+    WriteSLEB(program, -86);
+    program.push_back(DW_LNS_advance_pc);
+    WriteULEB(program, 0xc);
+    program.push_back(DW_LNS_copy);
+    program.push_back(DW_LNS_advance_pc);
+    WriteULEB(program, 0x30);
+    WriteEndSequence(program);
+
+    FinishLineUnit(debugLine, header, program, 4);
+  }
+
+  {
+    lineStr.clear();
+    WriteString(lineStr, "/comp");
+    WriteString(lineStr, "inc");
+
+    bytebuf header, program;
+    WriteLineParams(header);
+
+    header.push_back(1);
+    WriteULEB(header, DW_LNCT_path);
+    WriteULEB(header, DW_FORM_line_strp);
+    WriteULEB(header, 2);
+    Write<uint32_t>(header, 0);
+    Write<uint32_t>(header, 6);
+
+    header.push_back(2);
+    WriteULEB(header, DW_LNCT_path);
+    WriteULEB(header, DW_FORM_string);
+    WriteULEB(header, DW_LNCT_directory_index);
+    WriteULEB(header, DW_FORM_udata);
+    WriteULEB(header, 2);
+    WriteString(header, "main.c");
+    WriteULEB(header, 0);
+    WriteString(header, "c.h");
+    WriteULEB(header, 1);
+
+    program.push_back(DW_LNS_set_file);
+    WriteULEB(program, 0);
+    WriteSetAddress(program, 0x2000);
+    program.push_back(DW_LNS_advance_line);
+    WriteSLEB(program, 4);
+    program.push_back(DW_LNS_copy);
+    program.push_back(SpecialOpcode(8, 1));
+    program.push_back(DW_LNS_set_file);
+    WriteULEB(program, 1);
+    program.push_back(DW_LNS_advance_pc);
+    WriteULEB(program, 8);
+    WriteEndSequence(program);
+
+    FinishLineUnit(debugLine, header, program, 5);
+  }
+}
+
+void MakeTestSymbols(bytebuf &symtab, bytebuf &strtab, bool dynamicOnly)
+{
+  symtab.clear();
+  strtab = {0};
+
+  Elf64_Sym null = {};
+  Write(symtab, null);
+
+  auto addSymbol = [&](const char *name, uint64_t address, uint64_t size, uint8_t bind,
+                       uint8_t type) {
+    Elf64_Sym sym = {};
+    sym.st_name = (uint32_t)strtab.size();
+    sym.st_info = ELF64_ST_INFO(bind, type);
+    sym.st_shndx = 1;
+    sym.st_value = address;
+    sym.st_size = size;
+    Write(symtab, sym);
+    WriteString(strtab, name);
+  };
+
+  addSymbol("main", 0x2000, 0x10, STB_GLOBAL, STT_FUNC);
+
+  if(dynamicOnly)
+    return;
+
+  addSymbol("_ZN4Test3FooEv", 0x1000, 0x20, STB_GLOBAL, STT_FUNC);
+  addSymbol("g_data", 0x1008, 0x4, STB_GLOBAL, STT_OBJECT);
+  addSymbol("plain_c", 0x1020, 0x30, STB_LOCAL, STT_FUNC);
+  addSymbol("plain_c_alias", 0x1020, 0x30, STB_GLOBAL, STT_FUNC);
+}
+
+void CheckTestSymbols(const ELFSymbols &symbols)
+{
+  CHECK(symbols.NumSymbols() == 3);
+
+  struct Expected
+  {
+    uint64_t address;
+    rdcstr function;
+    rdcstr filename;
+    uint32_t line;
+  };
+
+  const Expected expected[] = {
+      {0x1000, "Test::Foo()", "/src/a.cpp", 10},   {0x1003, "Test::Foo()", "/src/a.cpp", 10},
+      {0x1004, "Test::Foo()", "/src/a.cpp", 12},   {0x1013, "Test::Foo()", "/src/a.cpp", 12},
+      {0x1014, "Test::Foo()", "/abs/b.h", 100},    {0x1020, "plain_c", "/src/a.cpp", 14},
+      {0x104f, "plain_c", "/src/a.cpp", 14},       {0x2000, "main", "/comp/main.c", 5},
+      {0x2009, "main", "/comp/main.c", 6},
+  };
+
+  for(const Expected &e : expected)
+  {
+    INFO(StringFormat::Fmt("%llx", e.address).c_str());
+
+    Callstack::AddressDetails details;
+    CHECK(symbols.Resolve(e.address, details));
+    CHECK(details.function == e.function);
+    CHECK(details.filename == e.filename);
+    CHECK(details.line == e.line);
+  }
+
+  // the end of a sequence, outside of any symbol, and in a discarded sequence
+  for(uint64_t address : {0x1050ULL, 0x2010ULL, 0x10ULL})
+  {
+    INFO(StringFormat::Fmt("%llx", address).c_str());
+
+    Callstack::AddressDetails details;
+    CHECK_FALSE(symbols.Resolve(address, details));
+  }
+}
+};
+
+TEST_CASE("Read ELF symbols and DWARF line tables", "[callstack]")
+{
+  const rdcstr dir = FileIO::GetTempFolderFilename();
+  const rdcstr path = dir + "/rdoc_symbols_test.so";
+  const rdcstr debugPath = dir + "/rdoc_symbols_test.debug";
+
+  bytebuf symtab, strtab, debugLine, lineStr;
+  MakeTestSymbols(symtab, strtab, false);
+  MakeTestLines(debugLine, lineStr);
+
+  const TestSection text = {".text", SHT_NOBITS, SHF_ALLOC | SHF_EXECINSTR, {}, 0, 0};
+
+  SECTION("Symbols and lines")
+  {
+    FileIO::WriteAll(path, MakeTestELF({
+                               text,
+                               {".symtab", SHT_SYMTAB, 0, symtab, 3, sizeof(Elf64_Sym)},
+                               {".strtab", SHT_STRTAB, 0, strtab, 0, 0},
+                               {".debug_line", SHT_PROGBITS, 0, debugLine, 0, 0},
+                               {".debug_line_str", SHT_PROGBITS, 0, lineStr, 0, 0},
+                           }));
+
+    ELFSymbols symbols;
+    REQUIRE(symbols.Load(path));
+    CheckTestSymbols(symbols);
+  }
+
+  SECTION("Compressed line table")
+  {
+    mz_ulong compressedSize = mz_compressBound((mz_ulong)debugLine.size());
+
+    bytebuf compressed;
+    compressed.resize(sizeof(Elf64_Chdr) + compressedSize);
+
+    Elf64_Chdr chdr = {};
+    chdr.ch_type = ELFCOMPRESS_ZLIB;
+    chdr.ch_size = debugLine.size();
+    chdr.ch_addralign = 1;
+    memcpy(compressed.data(), &chdr, sizeof(chdr));
+
+    int ret = mz_compress(compressed.data() + sizeof(chdr), &compressedSize, debugLine.data(),
+                          (mz_ulong)debugLine.size());
+    REQUIRE(ret == (int)MZ_OK);
+    compressed.resize(sizeof(chdr) + compressedSize);
+
+    FileIO::WriteAll(path, MakeTestELF({
+                               text,
+                               {".symtab", SHT_SYMTAB, 0, symtab, 3, sizeof(Elf64_Sym)},
+                               {".strtab", SHT_STRTAB, 0, strtab, 0, 0},
+                               {".debug_line", SHT_PROGBITS, SHF_COMPRESSED, compressed, 0, 0},
+                               {".debug_line_str", SHT_PROGBITS, 0, lineStr, 0, 0},
+                           }));
+
+    ELFSymbols symbols;
+    REQUIRE(symbols.Load(path));
+    CheckTestSymbols(symbols);
+  }
+
+  SECTION("Separate debug file")
+  {
+    bytebuf dynsym, dynstr;
+    MakeTestSymbols(dynsym, dynstr, true);
+
+    bytebuf debugLink;
+    WriteString(debugLink, "rdoc_symbols_test.debug");
+    debugLink.resize(AlignUp4(debugLink.size()));
+    // the CRC isn't checked
+    Write<uint32_t>(debugLink, 0);
+
+    FileIO::WriteAll(path, MakeTestELF({
+                               text,
+                               {".dynsym", SHT_DYNSYM, 0, dynsym, 3, sizeof(Elf64_Sym)},
+                               {".dynstr", SHT_STRTAB, 0, dynstr, 0, 0},
+                               {".gnu_debuglink", SHT_PROGBITS, 0, debugLink, 0, 0},
+                           }));
+
+    FileIO::WriteAll(debugPath, MakeTestELF({
+                                    text,
+                                    {".symtab", SHT_SYMTAB, 0, symtab, 3, sizeof(Elf64_Sym)},
+                                    {".strtab", SHT_STRTAB, 0, strtab, 0, 0},
+                                    {".debug_line", SHT_PROGBITS, 0, debugLine, 0, 0},
+                                    {".debug_line_str", SHT_PROGBITS, 0, lineStr, 0, 0},
+                                }));
+
+    ELFSymbols symbols;
+    REQUIRE(symbols.Load(path));
+    CheckTestSymbols(symbols);
+  }
+
+  SECTION("Not an ELF file")
+  {
+    FileIO::WriteAll(path, rdcstr("not an ELF file"));
+
+    ELFSymbols symbols;
+    CHECK_FALSE(symbols.Load(path));
+  }
+
+  FileIO::Delete(path);
+  FileIO::Delete(debugPath);
+}
+
+#endif    // ENABLED(ENABLE_UNIT_TESTS)
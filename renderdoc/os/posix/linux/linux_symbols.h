@@ -0,0 +1,75 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#pragma once
+
+#include "api/replay/rdcarray.h"
+#include "api/replay/rdcstr.h"
+#include "os/os_specific.h"
+
+// The function symbols and DWARF line table of one ELF module, read once and kept sorted so that
+// any number of addresses can be looked up without running addr2line for each. Once loaded it's
+// read-only, so lookups can happen on several threads at once.
+class ELFSymbols
+{
+public:
+  // reads the symbols and line table from the ELF file at path. If it has no line table, a separate
+  // debug file found through its build ID or debug link is used instead. Returns false if the file
+  // can't be read as a 64-bit ELF.
+  bool Load(const rdcstr &path);
+
+  // looks up an address in the module's own address space, filling in the function and/or the
+  // file and line. Returns false if nothing is known about the address.
+  bool Resolve(uint64_t address, Callstack::AddressDetails &details) const;
+
+  size_t NumSymbols() const { return m_Symbols.size(); }
+  size_t NumLines() const { return m_Lines.size(); }
+private:
+  struct Symbol
+  {
+    uint64_t address;
+    uint64_t size;
+    // offset into m_Names
+    uint32_t name;
+  };
+
+  struct LineRow
+  {
+    uint64_t address;
+    // index into m_Files, or NoFile for the end of a sequence
+    uint32_t file;
+    uint32_t line;
+  };
+
+  static const uint32_t NoFile = ~0U;
+
+  void AddSymbols(const bytebuf &symtab, const bytebuf &strtab);
+  void AddLines(const bytebuf &debugLine, const bytebuf &lineStr, const bytebuf &str);
+
+  rdcarray<Symbol> m_Symbols;
+  rdcarray<char> m_Names;
+
+  rdcarray<LineRow> m_Lines;
+  rdcarray<rdcstr> m_Files;
+};
@@ -32,6 +32,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/file.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <time.h>
@@ -453,6 +454,36 @@ void ftruncateat(FILE *f, uint64_t length)
   ::ftruncate(fd, (off_t)length);
 }
 
+const byte *MapFileForRead(FILE *f, uint64_t &size)
+{
+  size = 0;
+
+  ::fflush(f);
+  int fd = ::fileno(f);
+
+  struct stat st = {};
+  if(::fstat(fd, &st) != 0 || st.st_size <= 0)
+    return NULL;
+
+  // on 32-bit we might not be able to map the whole file
+  if(uint64_t(st.st_size) > uint64_t(SIZE_MAX))
+    return NULL;
+
+  void *ret = ::mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+  if(ret == MAP_FAILED)
+    return NULL;
+
+  size = (uint64_t)st.st_size;
+  return (const byte *)ret;
+}
+
+void UnmapFile(const byte *mapping, uint64_t size)
+{
+  if(mapping)
+    ::munmap((void *)mapping, (size_t)size);
+}
+
 bool fflush(FILE *f)
 {
   return ::fflush(f) == 0;
@@ -70,6 +70,16 @@ int32_t CmpExch32(int32_t *dest, int32_t oldVal, int32_t newVal)
 {
   return __sync_val_compare_and_swap(dest, oldVal, newVal);
 }
+
+int64_t CmpExch64(int64_t *dest, int64_t oldVal, int64_t newVal)
+{
+  return __sync_val_compare_and_swap(dest, oldVal, newVal);
+}
+
+int32_t Load32(const int32_t *i)
+{
+  return __atomic_load_n(i, __ATOMIC_ACQUIRE);
+}
 };
 
 namespace Threading
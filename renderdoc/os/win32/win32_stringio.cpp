@@ -733,6 +733,44 @@ void ftruncateat(FILE *f, uint64_t length)
   ::_chsize_s(fd, (int64_t)length);
 }
 
+const byte *MapFileForRead(FILE *f, uint64_t &size)
+{
+  size = 0;
+
+  ::fflush(f);
+  HANDLE file = (HANDLE)::_get_osfhandle(::_fileno(f));
+
+  LARGE_INTEGER fileSize = {};
+  if(file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file, &fileSize) || fileSize.QuadPart <= 0)
+    return NULL;
+
+  // on 32-bit we might not be able to map the whole file
+  if(uint64_t(fileSize.QuadPart) > uint64_t(SIZE_MAX))
+    return NULL;
+
+  HANDLE mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+
+  if(mapping == NULL)
+    return NULL;
+
+  void *ret = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+
+  // the view keeps the mapping alive, we don't need the handle anymore
+  CloseHandle(mapping);
+
+  if(ret == NULL)
+    return NULL;
+
+  size = uint64_t(fileSize.QuadPart);
+  return (const byte *)ret;
+}
+
+void UnmapFile(const byte *mapping, uint64_t size)
+{
+  if(mapping)
+    UnmapViewOfFile(mapping);
+}
+
 bool fflush(FILE *f)
 {
   return ::fflush(f) == 0;
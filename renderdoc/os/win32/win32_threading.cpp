@@ -83,6 +83,18 @@ int32_t CmpExch32(int32_t *dest, int32_t oldVal, int32_t newVal)
 {
   return (int32_t)InterlockedCompareExchange((volatile LONG *)dest, newVal, oldVal);
 }
+
+int64_t CmpExch64(int64_t *dest, int64_t oldVal, int64_t newVal)
+{
+  return (int64_t)InterlockedCompareExchange64((volatile LONG64 *)dest, newVal, oldVal);
+}
+
+int32_t Load32(const int32_t *i)
+{
+  int32_t ret = *(const volatile int32_t *)i;
+  MemoryBarrier();
+  return ret;
+}
 };
 
 namespace Threading
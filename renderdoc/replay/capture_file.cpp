@@ -167,6 +167,8 @@ public:
   bool HasCallstacks();
   ResultDetails InitResolver(bool interactive, RENDERDOC_ProgressCallback progress);
   rdcarray<rdcstr> GetResolve(const rdcarray<uint64_t> &callstack);
+  CallstackFrameTable GetResolves(const rdcarray<uint64_t> &addresses,
+                                  const rdcarray<uint32_t> &callstackOffsets);
 
 private:
   ResultDetails Init();
@@ -478,7 +480,7 @@ ResultDetails CaptureFile::Convert(const rdcstr &filename, const rdcstr &filetyp
       return result;
 
     SectionProperties frameCapture;
-    frameCapture.flags = SectionFlags::ZstdCompressed;
+    frameCapture.flags = SectionFlags::ZstdCompressed | SectionFlags::BlockIndexed;
     frameCapture.type = SectionType::FrameCapture;
     frameCapture.name = ToStr(frameCapture.type);
     frameCapture.version = file->version;
@@ -841,16 +843,21 @@ rdcarray<rdcstr> CaptureFile::GetResolve(const rdcarray<uint64_t> &callstack)
     return ret;
   }
 
-  ret.reserve(callstack.size());
-  for(uint64_t frame : callstack)
-  {
-    Callstack::AddressDetails info = m_Resolver->GetAddr(frame);
-    ret.push_back(info.formattedString());
-  }
+  rdcarray<Callstack::AddressDetails> info = m_Resolver->GetAddrs(callstack);
+
+  ret.reserve(info.size());
+  for(Callstack::AddressDetails &frame : info)
+    ret.push_back(frame.formattedString());
 
   return ret;
 }
 
+CallstackFrameTable CaptureFile::GetResolves(const rdcarray<uint64_t> &addresses,
+                                             const rdcarray<uint32_t> &callstackOffsets)
+{
+  return Callstack::ResolveCallstacks(m_Resolver, addresses, callstackOffsets);
+}
+
 extern "C" RENDERDOC_API ICaptureFile *RENDERDOC_CC RENDERDOC_OpenCaptureFile()
 {
   return new CaptureFile();
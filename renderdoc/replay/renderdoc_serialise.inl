@@ -77,6 +77,16 @@ void DoSerialise(SerialiserType &ser, SectionProperties &el)
   SIZE_CHECK(56);
 }
 
+template <class SerialiserType>
+void DoSerialise(SerialiserType &ser, CallstackFrameTable &el)
+{
+  SERIALISE_MEMBER(frames);
+  SERIALISE_MEMBER(frameIndices);
+  SERIALISE_MEMBER(callstackOffsets);
+
+  SIZE_CHECK(72);
+}
+
 template <class SerialiserType>
 void DoSerialise(SerialiserType &ser, EnvironmentModification &el)
 {
@@ -2325,6 +2335,7 @@ void DoSerialise(SerialiserType &ser, VKPipe::State &el)
 
 INSTANTIATE_SERIALISE_TYPE(PathEntry)
 INSTANTIATE_SERIALISE_TYPE(SectionProperties)
+INSTANTIATE_SERIALISE_TYPE(CallstackFrameTable)
 INSTANTIATE_SERIALISE_TYPE(EnvironmentModification)
 INSTANTIATE_SERIALISE_TYPE(CaptureOptions)
 INSTANTIATE_SERIALISE_TYPE(ResourceFormat)
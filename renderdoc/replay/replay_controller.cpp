@@ -1324,12 +1324,17 @@ ResultDetails ReplayController::SaveTexture(const TextureSave &saveData, const r
       if(saveFmt.compType == CompType::Depth && pixStride == 3)
         pixStride = 4;
 
+      rdcarray<FloatVector> row;
+      row.resize(td.width);
+
       for(uint32_t y = 0; y < td.height; y++)
       {
+        DecodeFormattedRows(saveFmt, srcData, pixStride * td.width, td.width, 1, &row[0].x);
+        srcData += pixStride * td.width;
+
         for(uint32_t x = 0; x < td.width; x++)
         {
-          FloatVector pixel = DecodeFormattedComponents(saveFmt, srcData);
-          srcData += pixStride;
+          FloatVector pixel = row[x];
 
           // HDR can't represent negative values
           if(sd.destType == FileType::HDR)
@@ -0,0 +1,1119 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include <map>
+#include "api/replay/structured_data.h"
+#include "common/common.h"
+#include "common/formatting.h"
+#include "serialise/rdcfile.h"
+
+// The columnar format stores the structured data as a set of flat arrays, each holding one column
+// of a table, so that it can be memory mapped and queried by other tools without parsing.
+//
+// The file starts with a ColumnarHeader, which gives the offset and element count of each column.
+// Every column starts 8-byte aligned and all values are little-endian. Columns marked 'count+1'
+// hold offsets into another column, with one more element than their table has rows so that row i
+// spans [col[i], col[i+1]).
+//
+// Strings are stored once and referred to by index everywhere else. Each string is followed by a
+// NULL terminator which isn't included in its length.
+//
+// The chunk table has one row per chunk, in capture order. A chunk's row index is the same as its
+// index in the structured data.
+//
+// Each distinct chunk type (by chunk ID and name) has a row in the chunk type table, which lists
+// the rows of all chunks of that type. The objects for each chunk are stored pre-order in the
+// object table, grouped so that the objects for all chunks of one type are contiguous. An object's
+// parent is an absolute object index, or NoParent for the chunk's own parameters. The types of
+// objects are deduplicated into the object type table.
+//
+// An object's value column holds the raw 64-bit value for basic types - for buffers it's the index
+// into the buffer table. The string column holds the string for strings, or for any object with a
+// custom string such as enums.
+//
+// Buffers and non-capture sections are stored uncompressed in their data columns.
+
+static const uint32_t ColumnarMagic = MAKE_FOURCC('R', 'D', 'C', 'C');
+static const uint32_t ColumnarVersion = 1;
+
+static const uint32_t NoParent = ~0U;
+static const uint32_t NoString = ~0U;
+
+enum class Column : uint32_t
+{
+  // uint64_t, count+1 offsets into StringData
+  StringOffsets,
+  // char
+  StringData,
+
+  // uint32_t
+  ChunkID,
+  // uint32_t string index
+  ChunkName,
+  // uint32_t SDChunkFlags
+  ChunkFlags,
+  // uint64_t
+  ChunkThreadID,
+  // uint64_t
+  ChunkTimestamp,
+  // int64_t
+  ChunkDuration,
+  // uint64_t
+  ChunkLength,
+  // uint32_t, count+1 offsets into Callstacks
+  ChunkCallstackOffsets,
+  // uint32_t, the first object for the chunk
+  ChunkObjectStart,
+  // uint32_t, the number of objects in the chunk including all descendents
+  ChunkObjectCount,
+  // uint64_t
+  Callstacks,
+
+  // uint32_t
+  ChunkTypeID,
+  // uint32_t string index
+  ChunkTypeName,
+  // uint32_t, count+1 offsets into ChunkTypeRows
+  ChunkTypeRowOffsets,
+  // uint32_t chunk rows
+  ChunkTypeRows,
+
+  // uint32_t object index
+  ObjectParent,
+  // uint32_t string index
+  ObjectName,
+  // uint32_t object type index
+  ObjectType,
+  // uint64_t
+  ObjectValue,
+  // uint32_t string index
+  ObjectString,
+  // uint32_t, only direct children
+  ObjectNumChildren,
+
+  // uint32_t SDBasic
+  ObjectTypeBasetype,
+  // uint32_t SDTypeFlags
+  ObjectTypeFlags,
+  // uint64_t
+  ObjectTypeByteSize,
+  // uint32_t string index
+  ObjectTypeName,
+
+  // uint64_t, count+1 offsets into BufferData
+  BufferOffsets,
+  // byte
+  BufferData,
+
+  // uint32_t SectionType
+  SectionType,
+  // uint32_t SectionFlags
+  SectionFlags,
+  // uint64_t
+  SectionVersion,
+  // uint32_t string index
+  SectionName,
+  // uint64_t, count+1 offsets into SectionData
+  SectionOffsets,
+  // byte
+  SectionData,
+
+  // byte
+  Thumbnail,
+
+  Count,
+};
+
+static const uint32_t columnElementSize[] = {
+    // strings
+    8, 1,
+    // chunks
+    4, 4, 4, 8, 8, 8, 8, 4, 4, 4, 8,
+    // chunk types
+    4, 4, 4, 4,
+    // objects
+    4, 4, 4, 8, 4, 4,
+    // object types
+    4, 4, 8, 4,
+    // buffers
+    8, 1,
+    // sections
+    4, 4, 8, 4, 8, 1,
+    // thumbnail
+    1,
+};
+
+RDCCOMPILE_ASSERT(ARRAY_COUNT(columnElementSize) == (size_t)Column::Count,
+                  "Every column must have an element size");
+
+struct ColumnLocation
+{
+  uint64_t offset;
+  uint64_t count;
+};
+
+struct ColumnarHeader
+{
+  uint32_t magic;
+  uint32_t version;
+  uint32_t columnCount;
+  uint32_t driver;
+  uint32_t driverName;
+  uint32_t thumbFormat;
+  uint32_t thumbWidth;
+  uint32_t thumbHeight;
+  uint64_t structuredVersion;
+  uint64_t machineIdent;
+  uint64_t timeBase;
+  double timeFrequency;
+  ColumnLocation columns[(size_t)Column::Count];
+};
+
+class ColumnarWriter
+{
+public:
+  ColumnarWriter() { m_Columns.resize((size_t)Column::Count); }
+  uint32_t AddString(const rdcstr &str)
+  {
+    auto it = m_Strings.find(str);
+    if(it != m_Strings.end())
+      return it->second;
+
+    bytebuf &data = m_Columns[(size_t)Column::StringData];
+
+    uint32_t ret = uint32_t(m_Strings.size());
+    m_Strings[str] = ret;
+
+    Add(Column::StringOffsets, (uint64_t)data.size());
+    data.append((const byte *)str.c_str(), str.size() + 1);
+
+    return ret;
+  }
+
+  uint32_t AddObjectType(const SDType &type)
+  {
+    ObjectTypeKey key = {type.basetype, type.flags, type.byteSize, AddString(type.name)};
+
+    auto it = m_ObjectTypes.find(key);
+    if(it != m_ObjectTypes.end())
+      return it->second;
+
+    uint32_t ret = uint32_t(m_ObjectTypes.size());
+    m_ObjectTypes[key] = ret;
+
+    Add(Column::ObjectTypeBasetype, (uint32_t)type.basetype);
+    Add(Column::ObjectTypeFlags, (uint32_t)type.flags);
+    Add(Column::ObjectTypeByteSize, type.byteSize);
+    Add(Column::ObjectTypeName, key.name);
+
+    return ret;
+  }
+
+  // adds obj and all of its descendents in pre-order, returning the number of objects added
+  uint32_t AddObject(const SDObject &obj, uint32_t parent)
+  {
+    const uint32_t idx = NumObjects();
+
+    Add(Column::ObjectParent, parent);
+    Add(Column::ObjectName, AddString(obj.name));
+    Add(Column::ObjectType, AddObjectType(obj.type));
+    Add(Column::ObjectValue, obj.data.basic.u);
+    Add(Column::ObjectString, obj.data.str.empty() ? NoString : AddString(obj.data.str));
+    Add(Column::ObjectNumChildren, (uint32_t)obj.NumChildren());
+
+    uint32_t count = 1;
+    for(size_t c = 0; c < obj.NumChildren(); c++)
+      count += AddObject(*obj.GetChild(c), idx);
+
+    return count;
+  }
+
+  uint32_t NumObjects() const
+  {
+    return uint32_t(m_Columns[(size_t)Column::ObjectParent].size() / sizeof(uint32_t));
+  }
+
+  template <typename T>
+  void Add(Column col, const T &val)
+  {
+    RDCASSERT(sizeof(T) == columnElementSize[(size_t)col]);
+    m_Columns[(size_t)col].append((const byte *)&val, sizeof(T));
+  }
+
+  bytebuf &Get(Column col) { return m_Columns[(size_t)col]; }
+private:
+  struct ObjectTypeKey
+  {
+    SDBasic basetype;
+    SDTypeFlags flags;
+    uint64_t byteSize;
+    uint32_t name;
+
+    bool operator<(const ObjectTypeKey &o) const
+    {
+      if(basetype != o.basetype)
+        return basetype < o.basetype;
+      if(flags != o.flags)
+        return flags < o.flags;
+      if(byteSize != o.byteSize)
+        return byteSize < o.byteSize;
+      return name < o.name;
+    }
+  };
+
+  rdcarray<bytebuf> m_Columns;
+  std::map<rdcstr, uint32_t> m_Strings;
+  std::map<ObjectTypeKey, uint32_t> m_ObjectTypes;
+};
+
+// pads a column of size bytes that has already been written out to the next column's alignment
+static bool WritePadding(FILE *f, uint64_t size)
+{
+  const byte padding[8] = {};
+  uint64_t pad = AlignUp(size, (uint64_t)8) - size;
+  return pad == 0 || FileIO::fwrite(padding, 1, (size_t)pad, f) == pad;
+}
+
+static bool WriteAligned(FILE *f, const void *data, uint64_t size)
+{
+  if(size > 0 && FileIO::fwrite(data, 1, (size_t)size, f) != size)
+    return false;
+
+  return WritePadding(f, size);
+}
+
+RDResult exportColumnar(const rdcstr &filename, const RDCFile &rdc, const SDFile &structData,
+                        RENDERDOC_ProgressCallback progress)
+{
+  ColumnarWriter writer;
+
+  ColumnarHeader header = {};
+  header.magic = ColumnarMagic;
+  header.version = ColumnarVersion;
+  header.columnCount = (uint32_t)Column::Count;
+  header.driver = (uint32_t)rdc.GetDriver();
+  header.driverName = writer.AddString(rdc.GetDriverName());
+  header.structuredVersion = structData.version;
+  header.machineIdent = rdc.GetMachineIdent();
+  header.timeBase = rdc.GetTimestampBase();
+  header.timeFrequency = rdc.GetTimestampFrequency();
+
+  const RDCThumb &thumb = rdc.GetThumbnail();
+  header.thumbFormat = (uint32_t)thumb.format;
+  header.thumbWidth = thumb.width;
+  header.thumbHeight = thumb.height;
+
+  const StructuredChunkList &chunks = structData.chunks;
+
+  // group the chunks by type, in the order each type first appears
+  rdcarray<rdcarray<uint32_t>> typeRows;
+  {
+    std::map<rdcpair<uint32_t, rdcstr>, uint32_t> types;
+
+    for(uint32_t c = 0; c < (uint32_t)chunks.size(); c++)
+    {
+      const SDChunk *chunk = chunks[c];
+
+      rdcpair<uint32_t, rdcstr> key = {chunk->metadata.chunkID, chunk->name};
+      auto it = types.find(key);
+      if(it == types.end())
+      {
+        it = types.insert(std::make_pair(key, (uint32_t)typeRows.size())).first;
+        typeRows.push_back({});
+
+        writer.Add(Column::ChunkTypeID, chunk->metadata.chunkID);
+        writer.Add(Column::ChunkTypeName, writer.AddString(chunk->name));
+      }
+
+      typeRows[it->second].push_back(c);
+    }
+  }
+
+  rdcarray<uint32_t> objectStart, objectCount;
+  objectStart.resize(chunks.size());
+  objectCount.resize(chunks.size());
+
+  uint32_t typeRowOffset = 0;
+  size_t chunksDone = 0;
+
+  for(const rdcarray<uint32_t> &rows : typeRows)
+  {
+    writer.Add(Column::ChunkTypeRowOffsets, typeRowOffset);
+    typeRowOffset += (uint32_t)rows.size();
+
+    for(uint32_t c : rows)
+    {
+      writer.Add(Column::ChunkTypeRows, c);
+
+      const SDChunk *chunk = chunks[c];
+
+      objectStart[c] = writer.NumObjects();
+      objectCount[c] = 0;
+      for(size_t o = 0; o < chunk->NumChildren(); o++)
+        objectCount[c] += writer.AddObject(*chunk->GetChild(o), NoParent);
+
+      if(progress)
+        progress(0.5f * float(chunksDone++) / float(chunks.size()));
+    }
+  }
+  writer.Add(Column::ChunkTypeRowOffsets, typeRowOffset);
+
+  uint32_t callstackOffset = 0;
+
+  for(uint32_t c = 0; c < (uint32_t)chunks.size(); c++)
+  {
+    const SDChunk *chunk = chunks[c];
+
+    writer.Add(Column::ChunkID, chunk->metadata.chunkID);
+    writer.Add(Column::ChunkName, writer.AddString(chunk->name));
+    writer.Add(Column::ChunkFlags, (uint32_t)chunk->metadata.flags);
+    writer.Add(Column::ChunkThreadID, chunk->metadata.threadID);
+    writer.Add(Column::ChunkTimestamp, chunk->metadata.timestampMicro);
+    writer.Add(Column::ChunkDuration, chunk->metadata.durationMicro);
+    writer.Add(Column::ChunkLength, chunk->metadata.length);
+    writer.Add(Column::ChunkCallstackOffsets, callstackOffset);
+    writer.Add(Column::ChunkObjectStart, objectStart[c]);
+    writer.Add(Column::ChunkObjectCount, objectCount[c]);
+
+    for(uint64_t addr : chunk->metadata.callstack)
+      writer.Add(Column::Callstacks, addr);
+    callstackOffset += (uint32_t)chunk->metadata.callstack.size();
+  }
+  writer.Add(Column::ChunkCallstackOffsets, callstackOffset);
+
+  // the buffer and section data is written directly, only the offsets are needed up front
+  uint64_t bufferOffset = 0;
+  for(const bytebuf *buf : structData.buffers)
+  {
+    writer.Add(Column::BufferOffsets, bufferOffset);
+    bufferOffset += buf->size();
+  }
+  writer.Add(Column::BufferOffsets, bufferOffset);
+
+  rdcarray<int> sections;
+  uint64_t sectionOffset = 0;
+  for(int i = 0; i < rdc.NumSections(); i++)
+  {
+    const SectionProperties &props = rdc.GetSectionProperties(i);
+
+    // the capture itself is only stored as structured data
+    if(props.type == SectionType::FrameCapture)
+      continue;
+
+    sections.push_back(i);
+
+    writer.Add(Column::SectionType, (uint32_t)props.type);
+    writer.Add(Column::SectionFlags, (uint32_t)props.flags);
+    writer.Add(Column::SectionVersion, props.version);
+    writer.Add(Column::SectionName, writer.AddString(props.name));
+    writer.Add(Column::SectionOffsets, sectionOffset);
+    sectionOffset += props.uncompressedSize;
+  }
+  writer.Add(Column::SectionOffsets, sectionOffset);
+
+  writer.Get(Column::Thumbnail) = thumb.pixels;
+
+  // no more strings can be added after this
+  writer.Add(Column::StringOffsets, (uint64_t)writer.Get(Column::StringData).size());
+
+  // now that all columns are complete, lay them out
+  uint64_t offset = AlignUp(sizeof(ColumnarHeader), (size_t)8);
+  for(uint32_t c = 0; c < (uint32_t)Column::Count; c++)
+  {
+    uint64_t size = writer.Get((Column)c).size();
+    if(c == (uint32_t)Column::BufferData)
+      size = bufferOffset;
+    else if(c == (uint32_t)Column::SectionData)
+      size = sectionOffset;
+
+    header.columns[c].offset = offset;
+    header.columns[c].count = size / columnElementSize[c];
+    offset += AlignUp(size, (uint64_t)8);
+  }
+
+  FILE *f = FileIO::fopen(filename, FileIO::WriteBinary);
+
+  if(!f)
+    RETURN_ERROR_RESULT(ResultCode::FileIOFailed, "Failed to open '%s' for write: %s",
+                        filename.c_str(), FileIO::ErrorString().c_str());
+
+  bool success = WriteAligned(f, &header, sizeof(header));
+
+  for(uint32_t c = 0; success && c < (uint32_t)Column::Count; c++)
+  {
+    if(c == (uint32_t)Column::BufferData)
+    {
+      for(size_t b = 0; success && b < structData.buffers.size(); b++)
+      {
+        const bytebuf &buf = *structData.buffers[b];
+        success = buf.empty() || FileIO::fwrite(buf.data(), 1, buf.size(), f) == buf.size();
+      }
+
+      success = success && WritePadding(f, bufferOffset);
+    }
+    else if(c == (uint32_t)Column::SectionData)
+    {
+      for(size_t s = 0; success && s < sections.size(); s++)
+      {
+        StreamReader *reader = rdc.ReadSection(sections[s]);
+
+        bytebuf contents;
+        contents.resize((size_t)reader->GetSize());
+        success = reader->Read(contents.data(), contents.size());
+
+        uint64_t expectedSize = rdc.GetSectionProperties(sections[s]).uncompressedSize;
+        if(contents.size() != expectedSize)
+        {
+          RDCERR("Section %d is %zu bytes, expected %llu", sections[s], contents.size(),
+                 expectedSize);
+          success = false;
+        }
+
+        success = success && (contents.empty() ||
+                              FileIO::fwrite(contents.data(), 1, contents.size(), f) ==
+                                  contents.size());
+
+        delete reader;
+      }
+
+      success = success && WritePadding(f, sectionOffset);
+    }
+    else
+    {
+      const bytebuf &data = writer.Get((Column)c);
+      success = WriteAligned(f, data.data(), data.size());
+    }
+
+    if(progress)
+      progress(0.5f + 0.5f * float(c + 1) / float(Column::Count));
+  }
+
+  FileIO::fclose(f);
+
+  if(!success)
+    RETURN_ERROR_RESULT(ResultCode::FileIOFailed, "Failed to write to '%s': %s", filename.c_str(),
+                        FileIO::ErrorString().c_str());
+
+  return ResultCode::Succeeded;
+}
+
+class ColumnarReader
+{
+public:
+  ColumnarReader(StreamReader &reader, const ColumnarHeader &header)
+      : m_Reader(reader), m_Header(header)
+  {
+  }
+
+  template <typename T>
+  bool Read(Column col, rdcarray<T> &out)
+  {
+    RDCASSERT(sizeof(T) == columnElementSize[(size_t)col]);
+
+    out.clear();
+
+    uint64_t count = Count(col);
+    if(!InBounds(col))
+      return false;
+
+    if(count == 0)
+      return true;
+
+    out.resize((size_t)count);
+    m_Reader.SetOffset(m_Header.columns[(size_t)col].offset);
+    return m_Reader.Read(out.data(), count * sizeof(T));
+  }
+
+  // reads count bytes at offset within a byte column
+  bool ReadBytes(Column col, uint64_t offset, uint64_t count, bytebuf &out)
+  {
+    out.clear();
+
+    if(offset > Count(col) || count > Count(col) - offset)
+      return false;
+
+    if(count == 0)
+      return true;
+
+    out.resize((size_t)count);
+    m_Reader.SetOffset(m_Header.columns[(size_t)col].offset + offset);
+    return m_Reader.Read(out.data(), count);
+  }
+
+  bool InBounds(Column col)
+  {
+    const ColumnLocation &loc = m_Header.columns[(size_t)col];
+    const uint64_t fileSize = m_Reader.GetSize();
+    const uint64_t elemSize = columnElementSize[(size_t)col];
+
+    return loc.count <= fileSize / elemSize && loc.offset <= fileSize - loc.count * elemSize;
+  }
+
+  uint64_t Count(Column col) { return m_Header.columns[(size_t)col].count; }
+private:
+  StreamReader &m_Reader;
+  const ColumnarHeader &m_Header;
+};
+
+// checks that a count+1 offsets column is in order and stays within total
+template <typename T>
+static bool ValidOffsets(const rdcarray<T> &offsets, size_t rows, uint64_t total)
+{
+  if(offsets.size() != rows + 1 || offsets[0] != 0 || offsets.back() > total)
+    return false;
+
+  for(size_t i = 0; i < rows; i++)
+    if(offsets[i] > offsets[i + 1])
+      return false;
+
+  return true;
+}
+
+RDResult importColumnar(const rdcstr &filename, StreamReader &reader, RDCFile *rdc,
+                        SDFile &structData, RENDERDOC_ProgressCallback progress)
+{
+  ColumnarHeader header = {};
+  if(!reader.Read(header))
+    RETURN_ERROR_RESULT(ResultCode::FileCorrupted, "Couldn't read columnar header");
+
+  if(header.magic != ColumnarMagic)
+    RETURN_ERROR_RESULT(ResultCode::FileCorrupted, "Not a columnar structured data file");
+
+  if(header.version != ColumnarVersion || header.columnCount != (uint32_t)Column::Count)
+    RETURN_ERROR_RESULT(ResultCode::FileCorrupted,
+                        "Unsupported columnar file version %u with %u columns", header.version,
+                        header.columnCount);
+
+  ColumnarReader cols(reader, header);
+
+  const uint64_t AnyRows = ~0ULL;
+
+  for(uint32_t c = 0; c < (uint32_t)Column::Count; c++)
+    if(!cols.InBounds((Column)c))
+      RETURN_ERROR_RESULT(ResultCode::FileCorrupted, "Column %u is out of bounds", c);
+
+// reads a column into a local array of the same name, checking its row count unless it's AnyRows
+#define READ_COLUMN(col, type, rows)                                                  \
+  rdcarray<type> col;                                                                 \
+  if(!cols.Read(Column::col, col) || (rows != AnyRows && col.size() != (size_t)rows)) \
+    RETURN_ERROR_RESULT(ResultCode::FileCorrupted, "Column " #col " has %zu rows", col.size());
+
+  // strings
+  READ_COLUMN(StringOffsets, uint64_t, AnyRows);
+  READ_COLUMN(StringData, char, AnyRows);
+
+  const size_t numStrings = StringOffsets.empty() ? 0 : StringOffsets.size() - 1;
+
+  if(!ValidOffsets(StringOffsets, numStrings, StringData.size()))
+    RETURN_ERROR_RESULT(ResultCode::FileCorrupted, "String offsets are malformed");
+
+  rdcarray<rdcstr> strings;
+  strings.resize(numStrings);
+  for(size_t i = 0; i < numStrings; i++)
+  {
+    // don't include the NULL terminator
+    uint64_t len = StringOffsets[i + 1] - StringOffsets[i];
+    if(len > 0)
+      len--;
+    strings[i] = rdcstr(StringData.data() + StringOffsets[i], (size_t)len);
+  }
+
+  StringOffsets.clear();
+  StringData.clear();
+
+  auto getString = [&strings](uint32_t idx, rdcstr &out) {
+    if(idx == NoString)
+    {
+      out.clear();
+      return true;
+    }
+
+    if(idx >= strings.size())
+      return false;
+
+    out = strings[idx];
+    return true;
+  };
+
+  rdcstr driverName;
+  if(!getString(header.driverName, driverName))
+    RETURN_ERROR_RESULT(ResultCode::FileCorrupted, "Driver name is malformed");
+
+  // header and thumbnail
+  {
+    RDCThumb th;
+    th.format = (FileType)header.thumbFormat;
+    th.width = (uint16_t)header.thumbWidth;
+    th.height = (uint16_t)header.thumbHeight;
+
+    RDCThumb *thumb = NULL;
+
+    if(th.width > 0 && th.height > 0 && header.thumbFormat < (uint32_t)FileType::Count &&
+       cols.ReadBytes(Column::Thumbnail, 0, cols.Count(Column::Thumbnail), th.pixels) &&
+       !th.pixels.empty())
+      thumb = &th;
+
+    rdc->SetData((RDCDriver)header.driver, driverName, header.machineIdent, thumb, header.timeBase,
+                 header.timeFrequency);
+  }
+
+  // sections
+  {
+    READ_COLUMN(SectionType, uint32_t, AnyRows);
+    const size_t numSections = SectionType.size();
+
+    READ_COLUMN(SectionFlags, uint32_t, numSections);
+    READ_COLUMN(SectionVersion, uint64_t, numSections);
+    READ_COLUMN(SectionName, uint32_t, numSections);
+    READ_COLUMN(SectionOffsets, uint64_t, numSections + 1);
+
+    if(!ValidOffsets(SectionOffsets, numSections, cols.Count(Column::SectionData)))
+      RETURN_ERROR_RESULT(ResultCode::FileCorrupted, "Section offsets are malformed");
+
+    for(size_t s = 0; s < numSections; s++)
+    {
+      SectionProperties props;
+      props.type = (::SectionType)SectionType[s];
+      props.flags = (::SectionFlags)SectionFlags[s];
+      props.version = SectionVersion[s];
+      if(!getString(SectionName[s], props.name))
+        RETURN_ERROR_RESULT(ResultCode::FileCorrupted, "Section %zu name is malformed", s);
+
+      bytebuf contents;
+      if(!cols.ReadBytes(Column::SectionData, SectionOffsets[s],
+                         SectionOffsets[s + 1] - SectionOffsets[s], contents))
+        RETURN_ERROR_RESULT(ResultCode::FileCorrupted, "Section %zu data is malformed", s);
+
+      StreamWriter *w = rdc->WriteSection(props);
+      w->Write(contents.data(), contents.size());
+      w->Finish();
+      delete w;
+    }
+  }
+
+  // buffers
+  {
+    READ_COLUMN(BufferOffsets, uint64_t, AnyRows);
+    const size_t numBuffers = BufferOffsets.empty() ? 0 : BufferOffsets.size() - 1;
+
+    if(!ValidOffsets(BufferOffsets, numBuffers, cols.Count(Column::BufferData)))
+      RETURN_ERROR_RESULT(ResultCode::FileCorrupted, "Buffer offsets are malformed");
+
+    structData.buffers.reserve(numBuffers);
+    for(size_t b = 0; b < numBuffers; b++)
+    {
+      bytebuf *buf = new bytebuf;
+      structData.buffers.push_back(buf);
+
+      if(!cols.ReadBytes(Column::BufferData, BufferOffsets[b],
+                         BufferOffsets[b + 1] - BufferOffsets[b], *buf))
+        RETURN_ERROR_RESULT(ResultCode::FileCorrupted, "Buffer %zu data is malformed", b);
+    }
+  }
+
+  if(progress)
+    progress(0.2f);
+
+  // object types
+  READ_COLUMN(ObjectTypeBasetype, uint32_t, AnyRows);
+  const size_t numObjectTypes = ObjectTypeBasetype.size();
+
+  READ_COLUMN(ObjectTypeFlags, uint32_t, numObjectTypes);
+  READ_COLUMN(ObjectTypeByteSize, uint64_t, numObjectTypes);
+  READ_COLUMN(ObjectTypeName, uint32_t, numObjectTypes);
+
+  struct ObjectTypeRow
+  {
+    rdcstr name;
+    SDBasic basetype;
+    SDTypeFlags flags;
+    uint64_t byteSize;
+  };
+
+  rdcarray<ObjectTypeRow> objectTypes;
+  objectTypes.resize(numObjectTypes);
+  for(size_t t = 0; t < numObjectTypes; t++)
+  {
+    ObjectTypeRow &type = objectTypes[t];
+
+    // chunks can't be nested inside other objects
+    if(ObjectTypeBasetype[t] > (uint32_t)SDBasic::GPUAddress ||
+       ObjectTypeBasetype[t] == (uint32_t)SDBasic::Chunk)
+      RETURN_ERROR_RESULT(ResultCode::FileCorrupted, "Object type %zu has invalid basetype %u", t,
+                          ObjectTypeBasetype[t]);
+
+    if(!getString(ObjectTypeName[t], type.name))
+      RETURN_ERROR_RESULT(ResultCode::FileCorrupted, "Object type %zu name is malformed", t);
+
+    type.basetype = (SDBasic)ObjectTypeBasetype[t];
+    type.flags = (SDTypeFlags)ObjectTypeFlags[t];
+    type.byteSize = ObjectTypeByteSize[t];
+  }
+
+  // objects
+  READ_COLUMN(ObjectParent, uint32_t, AnyRows);
+  const size_t numObjects = ObjectParent.size();
+
+  READ_COLUMN(ObjectName, uint32_t, numObjects);
+  READ_COLUMN(ObjectType, uint32_t, numObjects);
+  READ_COLUMN(ObjectValue, uint64_t, numObjects);
+  READ_COLUMN(ObjectString, uint32_t, numObjects);
+
+  // chunks
+  READ_COLUMN(ChunkID, uint32_t, AnyRows);
+  const size_t numChunks = ChunkID.size();
+
+  READ_COLUMN(ChunkName, uint32_t, numChunks);
+  READ_COLUMN(ChunkFlags, uint32_t, numChunks);
+  READ_COLUMN(ChunkThreadID, uint64_t, numChunks);
+  READ_COLUMN(ChunkTimestamp, uint64_t, numChunks);
+  READ_COLUMN(ChunkDuration, int64_t, numChunks);
+  READ_COLUMN(ChunkLength, uint64_t, numChunks);
+  READ_COLUMN(ChunkCallstackOffsets, uint32_t, numChunks + 1);
+  READ_COLUMN(ChunkObjectStart, uint32_t, numChunks);
+  READ_COLUMN(ChunkObjectCount, uint32_t, numChunks);
+  READ_COLUMN(Callstacks, uint64_t, AnyRows);
+
+  if(!ValidOffsets(ChunkCallstackOffsets, numChunks, Callstacks.size()))
+    RETURN_ERROR_RESULT(ResultCode::FileCorrupted, "Callstack offsets are malformed");
+
+#undef READ_COLUMN
+
+  rdcarray<SDObject *> objects;
+
+  structData.version = header.structuredVersion;
+  structData.chunks.reserve(numChunks);
+
+  for(size_t c = 0; c < numChunks; c++)
+  {
+    rdcstr name;
+    if(!getString(ChunkName[c], name))
+      RETURN_ERROR_RESULT(ResultCode::FileCorrupted, "Chunk %zu name is malformed", c);
+
+    SDChunk *chunk = new SDChunk(name);
+    structData.chunks.push_back(chunk);
+
+    chunk->metadata.chunkID = ChunkID[c];
+    chunk->metadata.flags = (SDChunkFlags)ChunkFlags[c];
+    chunk->metadata.threadID = ChunkThreadID[c];
+    chunk->metadata.timestampMicro = ChunkTimestamp[c];
+    chunk->metadata.durationMicro = ChunkDuration[c];
+    chunk->metadata.length = ChunkLength[c];
+    chunk->metadata.callstack.assign(Callstacks.data() + ChunkCallstackOffsets[c],
+                                     ChunkCallstackOffsets[c + 1] - ChunkCallstackOffsets[c]);
+
+    const uint32_t start = ChunkObjectStart[c];
+    const uint32_t count = ChunkObjectCount[c];
+
+    if(start > numObjects || count > numObjects - start)
+      RETURN_ERROR_RESULT(ResultCode::FileCorrupted, "Chunk %zu objects are out of bounds", c);
+
+    // objects are stored pre-order, so each object's parent has already been created
+    objects.resize(count);
+    for(uint32_t i = 0; i < count; i++)
+    {
+      const uint32_t o = start + i;
+
+      const uint32_t parent = ObjectParent[o];
+      if(parent != NoParent && (parent < start || parent >= o))
+        RETURN_ERROR_RESULT(ResultCode::FileCorrupted, "Object %u has invalid parent %u", o,
+                            parent);
+
+      if(ObjectType[o] >= numObjectTypes)
+        RETURN_ERROR_RESULT(ResultCode::FileCorrupted, "Object %u has invalid type %u", o,
+                            ObjectType[o]);
+
+      const ObjectTypeRow &type = objectTypes[ObjectType[o]];
+
+      // buffer objects store an index into the buffer list, which later users index directly
+      if(type.basetype == SDBasic::Buffer && ObjectValue[o] >= structData.buffers.size())
+        RETURN_ERROR_RESULT(ResultCode::FileCorrupted, "Object %u has invalid buffer %llu", o,
+                            ObjectValue[o]);
+
+      rdcstr objName;
+      if(!getString(ObjectName[o], objName))
+        RETURN_ERROR_RESULT(ResultCode::FileCorrupted, "Object %u name is malformed", o);
+
+      SDObject *obj = new SDObject(objName, type.name);
+      obj->type.basetype = type.basetype;
+      obj->type.flags = type.flags;
+      obj->type.byteSize = type.byteSize;
+      obj->data.basic.u = ObjectValue[o];
+
+      rdcstr str;
+      if(!getString(ObjectString[o], str))
+      {
+        delete obj;
+        RETURN_ERROR_RESULT(ResultCode::FileCorrupted, "Object %u string is malformed", o);
+      }
+      obj->data.str = str;
+
+      objects[i] = obj;
+
+      if(parent == NoParent)
+        chunk->AddAndOwnChild(obj);
+      else
+        objects[parent - start]->AddAndOwnChild(obj);
+    }
+
+    if(progress)
+      progress(0.2f + 0.8f * float(c) / float(numChunks));
+  }
+
+  return ResultCode::Succeeded;
+}
+
+static ConversionRegistration ColumnarConversionRegistration(
+    &importColumnar, &exportColumnar,
+    {
+        "sdcol",
+        "Columnar structured data",
+        R"(Stores the structured data in flat binary tables, one array per column, with buffers and
+other sections in a separate blob store. The file can be memory mapped and queried directly by
+other tools without parsing.)",
+        true,
+    });
+
+#if ENABLED(ENABLE_UNIT_TESTS)
+
+#include "catch/catch.hpp"
+
+TEST_CASE("Columnar structured data round trip", "[columnar][serialiser]")
+{
+  RDCFile rdc;
+
+  RDCThumb thumb;
+  thumb.format = FileType::Raw;
+  thumb.width = 2;
+  thumb.height = 2;
+  thumb.pixels = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12};
+
+  rdc.SetData(RDCDriver::D3D12, "D3D12", 0x5678, &thumb, 1000, 3.5);
+
+  {
+    SectionProperties props;
+    props.type = SectionType::Notes;
+    props.name = ToStr(SectionType::Notes);
+    props.flags = SectionFlags::ASCIIStored;
+    props.version = 2;
+
+    StreamWriter *w = rdc.WriteSection(props);
+    w->Write("notes", 5);
+    w->Finish();
+    delete w;
+  }
+
+  SDFile sdfile;
+  sdfile.version = 0x99;
+
+  for(uint32_t b = 0; b < 5; b++)
+  {
+    bytebuf *buf = new bytebuf;
+    for(uint32_t i = 0; i < b * 7; i++)
+      buf->push_back(byte(i + b));
+    sdfile.buffers.push_back(buf);
+  }
+
+  for(uint32_t c = 0; c < 40; c++)
+  {
+    // interleave a few chunk types so that the objects are regrouped
+    SDChunk *chunk = new SDChunk(StringFormat::Fmt("Type%u", c % 3));
+    chunk->metadata.chunkID = 100 + (c % 3);
+    chunk->metadata.length = c * 8;
+    chunk->metadata.threadID = c % 2;
+    chunk->metadata.timestampMicro = c * 1000;
+    chunk->metadata.durationMicro = c % 4 == 0 ? -1 : c;
+
+    if(c % 7 == 0)
+    {
+      chunk->metadata.flags |= SDChunkFlags::HasCallstack;
+      for(uint32_t i = 0; i < c % 5 + 1; i++)
+        chunk->metadata.callstack.push_back(0x1000 * c + i);
+    }
+
+    chunk->AddAndOwnChild(makeSDUInt64("u"_lit, c * 0x100000001ULL));
+    chunk->AddAndOwnChild(makeSDString("s"_lit, StringFormat::Fmt("string %u", c % 4)));
+    chunk->AddAndOwnChild(makeSDFloat("f"_lit, c * 0.25f));
+
+    SDObject *arr = chunk->AddAndOwnChild(makeSDArray("arr"_lit));
+    for(uint32_t i = 0; i < c % 3; i++)
+    {
+      SDObject *el = arr->AddAndOwnChild(makeSDStruct("$el"_lit, "Element"_lit));
+      el->AddAndOwnChild(makeSDEnum("e"_lit, i));
+      el->GetChild(0)->data.str = "Enum";
+      el->GetChild(0)->type.flags |= SDTypeFlags::HasCustomString;
+      el->AddAndOwnChild(makeSDBool("b"_lit, i == 1));
+    }
+
+    SDObject *buf = chunk->AddAndOwnChild(new SDObject("buf"_lit, "Byte Buffer"_lit));
+    buf->type.basetype = SDBasic::Buffer;
+    buf->type.byteSize = sdfile.buffers[c % 5]->size();
+    buf->data.basic.u = c % 5;
+
+    sdfile.chunks.push_back(chunk);
+  }
+
+  rdcstr filename = FileIO::GetTempFolderFilename() + "/columnar.sdcol";
+
+  RDResult res = exportColumnar(filename, rdc, sdfile, NULL);
+  REQUIRE(res.code == ResultCode::Succeeded);
+
+  SECTION("Tables are aligned and can be used directly")
+  {
+    bytebuf contents;
+    FileIO::ReadAll(filename, contents);
+
+    REQUIRE(contents.size() >= sizeof(ColumnarHeader));
+    const ColumnarHeader *header = (const ColumnarHeader *)contents.data();
+
+    CHECK(header->magic == ColumnarMagic);
+    CHECK(header->columns[(size_t)Column::ChunkID].count == sdfile.chunks.size());
+    CHECK(header->columns[(size_t)Column::ChunkTypeID].count == 3);
+
+    for(uint32_t c = 0; c < (uint32_t)Column::Count; c++)
+      CHECK((header->columns[c].offset % 8) == 0);
+
+    // look up the durations of all chunks of the second type, without building the structured data
+    auto column = [&](Column col) { return contents.data() + header->columns[(size_t)col].offset; };
+
+    const uint32_t *rowOffsets = (const uint32_t *)column(Column::ChunkTypeRowOffsets);
+    const uint32_t *rows = (const uint32_t *)column(Column::ChunkTypeRows);
+    const int64_t *durations = (const int64_t *)column(Column::ChunkDuration);
+
+    for(uint32_t r = rowOffsets[1]; r < rowOffsets[2]; r++)
+    {
+      CHECK(sdfile.chunks[rows[r]]->metadata.chunkID == 101);
+      CHECK(durations[rows[r]] == sdfile.chunks[rows[r]]->metadata.durationMicro);
+    }
+  }
+
+  SECTION("Import")
+  {
+    StreamReader reader(FileIO::fopen(filename, FileIO::ReadBinary));
+
+    RDCFile imported;
+    SDFile importedData;
+    res = importColumnar(filename, reader, &imported, importedData, NULL);
+    REQUIRE(res.code == ResultCode::Succeeded);
+
+    CHECK((imported.GetDriver() == RDCDriver::D3D12));
+    CHECK(imported.GetDriverName() == "D3D12");
+    CHECK(imported.GetMachineIdent() == 0x5678);
+    CHECK(imported.GetTimestampBase() == 1000);
+    CHECK(imported.GetTimestampFrequency() == 3.5);
+    CHECK(imported.GetThumbnail().width == 2);
+    CHECK(imported.GetThumbnail().pixels == thumb.pixels);
+
+    REQUIRE(imported.NumSections() == 1);
+    CHECK((imported.GetSectionProperties(0).type == SectionType::Notes));
+    CHECK(imported.GetSectionProperties(0).version == 2);
+
+    REQUIRE(importedData.buffers.size() == sdfile.buffers.size());
+    for(size_t b = 0; b < sdfile.buffers.size(); b++)
+      CHECK(*importedData.buffers[b] == *sdfile.buffers[b]);
+
+    CHECK(importedData.version == sdfile.version);
+    REQUIRE(importedData.chunks.size() == sdfile.chunks.size());
+
+    for(size_t c = 0; c < sdfile.chunks.size(); c++)
+    {
+      const SDChunk *a = sdfile.chunks[c];
+      const SDChunk *b = importedData.chunks[c];
+
+      CHECK(a->name == b->name);
+      CHECK(a->metadata.chunkID == b->metadata.chunkID);
+      CHECK(a->metadata.flags == b->metadata.flags);
+      CHECK(a->metadata.length == b->metadata.length);
+      CHECK(a->metadata.threadID == b->metadata.threadID);
+      CHECK(a->metadata.timestampMicro == b->metadata.timestampMicro);
+      CHECK(a->metadata.durationMicro == b->metadata.durationMicro);
+      CHECK(a->metadata.callstack == b->metadata.callstack);
+      CHECK(a->HasEqualValue(b));
+
+      REQUIRE(b->NumChildren() == 5);
+      CHECK(b->GetChild(3)->type.name == a->GetChild(3)->type.name);
+      if(b->GetChild(3)->NumChildren() > 0)
+      {
+        const SDObject *el = b->GetChild(3)->GetChild(0);
+        CHECK(el->type.name == "Element");
+        CHECK(el->GetChild(0)->data.str == "Enum");
+        CHECK(el->GetChild(0)->type.flags == a->GetChild(3)->GetChild(0)->GetChild(0)->type.flags);
+      }
+    }
+  }
+
+  SECTION("Corrupt files are rejected")
+  {
+    bytebuf contents;
+    FileIO::ReadAll(filename, contents);
+
+    ColumnarHeader *header = (ColumnarHeader *)contents.data();
+    header->columns[(size_t)Column::ObjectParent].count = 0xffffffff;
+
+    StreamReader reader(contents);
+
+    RDCFile imported;
+    SDFile importedData;
+    EXPECT_ERROR();
+    res = importColumnar(rdcstr(), reader, &imported, importedData, NULL);
+    CHECK(res.code == ResultCode::FileCorrupted);
+  }
+
+  SECTION("Out of range buffer indices are rejected")
+  {
+    bytebuf contents;
+    FileIO::ReadAll(filename, contents);
+
+    const ColumnarHeader *header = (const ColumnarHeader *)contents.data();
+    auto column = [&](Column col) { return contents.data() + header->columns[(size_t)col].offset; };
+
+    const uint32_t *types = (const uint32_t *)column(Column::ObjectType);
+    const uint32_t *basetypes = (const uint32_t *)column(Column::ObjectTypeBasetype);
+    uint64_t *values = (uint64_t *)column(Column::ObjectValue);
+
+    uint32_t corrupted = 0;
+    for(uint32_t o = 0; o < header->columns[(size_t)Column::ObjectValue].count; o++)
+    {
+      if(basetypes[types[o]] == (uint32_t)SDBasic::Buffer)
+      {
+        values[o] = sdfile.buffers.size();
+        corrupted++;
+      }
+    }
+
+    REQUIRE(corrupted == sdfile.chunks.size());
+
+    StreamReader reader(contents);
+
+    RDCFile imported;
+    SDFile importedData;
+    EXPECT_ERROR();
+    res = importColumnar(rdcstr(), reader, &imported, importedData, NULL);
+    CHECK(res.code == ResultCode::FileCorrupted);
+  }
+
+  FileIO::Delete(filename);
+}
+
+#endif    // ENABLED(ENABLE_UNIT_TESTS)
@@ -32,6 +32,14 @@
 #include "miniz/miniz.h"
 #include "pugixml/pugixml.hpp"
 
+#if defined(__x86_64__) || defined(_M_X64)
+// SSE2 is always available on x64
+#include <emmintrin.h>
+#define XML_HEX_SSE2 OPTION_ON
+#else
+#define XML_HEX_SSE2 OPTION_OFF
+#endif
+
 struct ThumbTypeAndData
 {
   FileType format;
@@ -90,16 +98,254 @@ inline float StructuredProgress(float progress)
   return 0.2f + 0.8f * progress;
 }
 
-struct xml_file_writer : pugi::xml_writer
+// Writes an xml document straight to a stream one element at a time, so that exporting a large
+// capture doesn't need the whole document in memory. The output is formatted the same way as
+// pugixml's default indented output.
+class XMLStreamWriter
 {
-  StreamWriter stream;
+public:
+  XMLStreamWriter(StreamWriter &stream) : m_Stream(stream)
+  {
+    m_Buffer.reserve(BufferSize * 2);
+    Raw("<?xml version=\"1.0\"?>\n");
+  }
+
+  // name must stay valid until the element is ended
+  void BeginElement(const char *name)
+  {
+    if(!m_Elements.empty())
+    {
+      Element &parent = m_Elements.back();
+      RDCASSERT(parent.state != ElementState::Text);
+
+      if(parent.state == ElementState::Start)
+        Raw(">");
+      parent.state = ElementState::Children;
+
+      Raw("\n");
+      Indent(m_Elements.size());
+    }
+
+    Raw("<");
+    Raw(name);
+    m_Elements.push_back({name, ElementState::Start});
+  }
+
+  void EndElement()
+  {
+    const Element &el = m_Elements.back();
+
+    if(el.state == ElementState::Start)
+    {
+      Raw(" />");
+    }
+    else
+    {
+      if(el.state == ElementState::Children)
+      {
+        Raw("\n");
+        Indent(m_Elements.size() - 1);
+      }
+
+      Raw("</");
+      Raw(el.name);
+      Raw(">");
+    }
+
+    m_Elements.pop_back();
+
+    if(m_Elements.empty())
+      Raw("\n");
+
+    if(m_Buffer.size() >= BufferSize)
+      Flush();
+  }
+
+  // attributes can only be added before any text or children
+  void Attribute(const char *name, const char *value)
+  {
+    RDCASSERT(m_Elements.back().state == ElementState::Start);
+
+    Raw(" ");
+    Raw(name);
+    Raw("=\"");
+    Escaped(value, strlen(value), true);
+    Raw("\"");
+  }
+
+  void Attribute(const char *name, uint64_t value)
+  {
+    char str[32];
+    Attribute(name, FormatValue(str, value));
+  }
 
-  xml_file_writer(const rdcstr &filename)
-      : stream(FileIO::fopen(filename, FileIO::WriteBinary), Ownership::Stream)
+  void Attribute(const char *name, int64_t value)
   {
+    char str[32];
+    Attribute(name, FormatValue(str, value));
   }
 
-  void write(const void *data, size_t size) { stream.Write(data, size); }
+  void Attribute(const char *name, double value)
+  {
+    char str[32];
+    Attribute(name, FormatValue(str, value));
+  }
+
+  void Attribute(const char *name, bool value) { Attribute(name, value ? "true" : "false"); }
+  // text can be written in several parts, but an element can't contain both text and children
+  void Text(const char *str, size_t len)
+  {
+    BeginText();
+    Escaped(str, len, false);
+  }
+
+  void Text(const char *str) { Text(str, strlen(str)); }
+  void Text(uint64_t value)
+  {
+    char str[32];
+    Text(FormatValue(str, value));
+  }
+
+  void Text(int64_t value)
+  {
+    char str[32];
+    Text(FormatValue(str, value));
+  }
+
+  void Text(double value)
+  {
+    char str[32];
+    Text(FormatValue(str, value));
+  }
+
+  void Text(bool value) { Text(value ? "true" : "false"); }
+  // for text that's known not to contain anything that needs escaping
+  void RawText(const char *str, size_t len)
+  {
+    BeginText();
+    m_Buffer.append(str, len);
+
+    if(m_Buffer.size() >= BufferSize)
+      Flush();
+  }
+
+  void Flush()
+  {
+    m_Stream.Write(m_Buffer.data(), m_Buffer.size());
+    m_Buffer.clear();
+  }
+
+private:
+  enum class ElementState
+  {
+    Start,
+    Text,
+    Children,
+  };
+
+  struct Element
+  {
+    const char *name;
+    ElementState state;
+  };
+
+  static const size_t BufferSize = 64 * 1024;
+
+  static const char *FormatValue(char (&str)[32], uint64_t value)
+  {
+    char *s = str + sizeof(str) - 1;
+    *s = 0;
+    do
+    {
+      *(--s) = char('0' + (value % 10));
+      value /= 10;
+    } while(value);
+    return s;
+  }
+
+  static const char *FormatValue(char (&str)[32], int64_t value)
+  {
+    if(value >= 0)
+      return FormatValue(str, (uint64_t)value);
+
+    // negate as unsigned so that INT64_MIN doesn't overflow
+    char *s = (char *)FormatValue(str, 0 - (uint64_t)value);
+    *(--s) = '-';
+    return s;
+  }
+
+  static const char *FormatValue(char (&str)[32], double value)
+  {
+    // same precision as pugixml uses, so that doubles round-trip exactly
+    snprintf(str, sizeof(str), "%.17g", value);
+    return str;
+  }
+
+  // the same characters that pugixml escapes
+  static bool NeedsEscape(char c, bool attribute)
+  {
+    if((byte)c < 32)
+      return c != '\t' && (attribute || (c != '\r' && c != '\n'));
+
+    return c == '&' || c == '<' || c == '>' || (attribute && c == '"');
+  }
+
+  void BeginText()
+  {
+    Element &el = m_Elements.back();
+    RDCASSERT(el.state != ElementState::Children);
+
+    if(el.state == ElementState::Start)
+      Raw(">");
+    el.state = ElementState::Text;
+  }
+
+  void Raw(const char *str) { m_Buffer.append(str); }
+  void Indent(size_t depth)
+  {
+    for(size_t i = 0; i < depth; i++)
+      m_Buffer.push_back('\t');
+  }
+
+  void Escaped(const char *str, size_t len, bool attribute)
+  {
+    const char *end = str + len;
+
+    while(str < end)
+    {
+      const char *run = str;
+      while(str < end && !NeedsEscape(*str, attribute))
+        str++;
+
+      m_Buffer.append(run, str - run);
+
+      if(str == end)
+        break;
+
+      const char c = *str++;
+
+      switch(c)
+      {
+        case '&': Raw("&amp;"); break;
+        case '<': Raw("&lt;"); break;
+        case '>': Raw("&gt;"); break;
+        case '"': Raw("&quot;"); break;
+        default:
+        {
+          const char ref[] = {'&', '#', char('0' + c / 10), char('0' + c % 10), ';', 0};
+          Raw(ref);
+          break;
+        }
+      }
+    }
+
+    if(m_Buffer.size() >= BufferSize)
+      Flush();
+  }
+
+  StreamWriter &m_Stream;
+  rdcstr m_Buffer;
+  rdcarray<Element> m_Elements;
 };
 
 // avoid &, <, and > since they throw off the ascii alignment
@@ -121,86 +367,199 @@ static constexpr byte FromHex(const char c)
                                      : (c >= 'a' && c <= 'f' ? byte(c - 'a') + 10 : 0));
 }
 
-static void HexEncode(const bytebuf &in, rdcstr &out)
+// hex dumps are written in lines of 32 bytes, in groups of 4 bytes separated by a space, followed
+// by 3 spaces and the ascii for the line. A partial last line is padded out to the same width.
+static const size_t HexBytesPerLine = 32;
+static const size_t HexBytesPerGroup = 4;
+static const size_t HexGroupsPerLine = HexBytesPerLine / HexBytesPerGroup;
+static const size_t HexAsciiOffset = HexBytesPerLine * 2 + HexGroupsPerLine - 1 + 3;
+static const size_t HexLineLength = HexAsciiOffset + HexBytesPerLine + 1;
+
+static const char hexDigits[] = "0123456789ABCDEF";
+
+static void HexEncodeBytes(const byte *in, size_t len, char *out)
 {
-  const size_t bytesPerLine = 32;
-  const size_t bytesPerGroup = 4;
+  for(size_t i = 0; i < len; i++)
+  {
+    char *hex = out + i * 2 + i / HexBytesPerGroup;
+    hex[0] = hexDigits[in[i] >> 4];
+    hex[1] = hexDigits[in[i] & 0xf];
 
-  const char digit[] = "0123456789ABCDEF";
-  // Reserve rough required size:
-  // - 3 characters per byte (two for hex, 1 for ascii),
-  // - 4 characters per line (3x space between hex and ascii, newline)
-  // - 1 character per group (space)
-  // - 2 characters for leading/trailing newline
-  out.reserve(in.size() * 3 + (in.size() / bytesPerLine) * 4 + (in.size() / bytesPerGroup) + 2);
+    out[HexAsciiOffset + i] = IsXMLPrintable((char)in[i]) ? (char)in[i] : '.';
+  }
+}
 
-  // leading newline
-  out = "\n";
+static void HexEncodeLine(const byte *in, char *out)
+{
+  memset(out, ' ', HexAsciiOffset);
 
-  // accumulate ascii representation for each line
-  rdcstr ascii;
+#if ENABLED(XML_HEX_SSE2)
+  const __m128i nibbleMask = _mm_set1_epi8(0x0f);
+  const __m128i nine = _mm_set1_epi8(9);
+  const __m128i zeroChar = _mm_set1_epi8('0');
+  // the distance from '9' + 1 to 'A'
+  const __m128i letterOffset = _mm_set1_epi8('A' - '9' - 1);
 
-  size_t i = 0;
-  for(byte c : in)
+  for(size_t half = 0; half < 2; half++)
   {
-    out.push_back(digit[(c & 0xf0) >> 4]);
-    out.push_back(digit[(c & 0x0f) >> 0]);
+    const __m128i bytes = _mm_loadu_si128((const __m128i *)(in + half * 16));
 
-    if(IsXMLPrintable((char)c))
-      ascii.push_back((char)c);
-    else
-      ascii.push_back('.');
+    __m128i hi = _mm_and_si128(_mm_srli_epi16(bytes, 4), nibbleMask);
+    __m128i lo = _mm_and_si128(bytes, nibbleMask);
 
-    i++;
-    if((i % bytesPerLine) == 0)
-    {
-      out += StringFormat::Fmt("   %s\n", ascii.c_str());
-      ascii.clear();
-    }
-    else if((i % bytesPerGroup) == 0)
+    hi = _mm_add_epi8(_mm_add_epi8(hi, zeroChar),
+                      _mm_and_si128(_mm_cmpgt_epi8(hi, nine), letterOffset));
+    lo = _mm_add_epi8(_mm_add_epi8(lo, zeroChar),
+                      _mm_and_si128(_mm_cmpgt_epi8(lo, nine), letterOffset));
+
+    // interleave to get the two characters for each byte in order, 2 groups in each register
+    const __m128i chars[2] = {_mm_unpacklo_epi8(hi, lo), _mm_unpackhi_epi8(hi, lo)};
+
+    for(size_t i = 0; i < 2; i++)
     {
-      out.push_back(' ');
+      char *group = out + (half * 4 + i * 2) * (HexBytesPerGroup * 2 + 1);
+      _mm_storel_epi64((__m128i *)group, chars[i]);
+      _mm_storel_epi64((__m128i *)(group + HexBytesPerGroup * 2 + 1), _mm_srli_si128(chars[i], 8));
     }
+
+    // bytes above 0x7f are negative so they fail the first comparison
+    __m128i printable = _mm_and_si128(_mm_cmpgt_epi8(bytes, _mm_set1_epi8(' ' - 1)),
+                                      _mm_cmplt_epi8(bytes, _mm_set1_epi8('~' + 1)));
+    printable = _mm_andnot_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('&')), printable);
+    printable = _mm_andnot_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('<')), printable);
+    printable = _mm_andnot_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('>')), printable);
+
+    const __m128i ascii = _mm_or_si128(_mm_and_si128(printable, bytes),
+                                       _mm_andnot_si128(printable, _mm_set1_epi8('.')));
+    _mm_storeu_si128((__m128i *)(out + HexAsciiOffset + half * 16), ascii);
   }
+#else
+  HexEncodeBytes(in, HexBytesPerLine, out);
+#endif
+
+  out[HexLineLength - 1] = '\n';
+}
 
-  // add remaining part of a line, if we didn't end by completing one
-  size_t lastLineLength = i % bytesPerLine;
+// appends the hex dump of len bytes to out. This can be called repeatedly to encode data in blocks,
+// as long as every block but the last is a whole number of lines.
+static void HexEncode(const byte *in, size_t len, rdcstr &out)
+{
+  const size_t numLines = len / HexBytesPerLine;
+  const size_t lastLineLength = len % HexBytesPerLine;
+
+  size_t offs = out.size();
+  out.resize(offs + numLines * HexLineLength +
+             (lastLineLength > 0 ? HexAsciiOffset + lastLineLength + 1 : 0));
+
+  char *dst = out.data() + offs;
+
+  for(size_t l = 0; l < numLines; l++)
+  {
+    HexEncodeLine(in, dst);
+    in += HexBytesPerLine;
+    dst += HexLineLength;
+  }
+
+  // the last partial line leaves spaces where the remaining bytes would be, and only has ascii for
+  // the bytes present
   if(lastLineLength > 0)
   {
-    for(i = lastLineLength; i < bytesPerLine; i++)
-    {
-      // print 2 spaces where there would be characters
-      out.push_back(' ');
-      out.push_back(' ');
+    memset(dst, ' ', HexAsciiOffset);
+    HexEncodeBytes(in, lastLineLength, dst);
+    dst[HexAsciiOffset + lastLineLength] = '\n';
+  }
+}
 
-      // don't print the group space the first time, since it was already printed, but after that
-      // print the group space
-      if((i % bytesPerGroup) == 0 && i > lastLineLength)
-        out.push_back(' ');
-    }
+#if ENABLED(XML_HEX_SSE2)
+// decodes a whole line in the layout HexEncode writes, returning false without writing anything if
+// it's in any other form
+static bool HexDecodeLine(const char *str, byte *out)
+{
+  for(size_t g = 1; g < HexGroupsPerLine; g++)
+    if(str[g * (HexBytesPerGroup * 2 + 1) - 1] != ' ')
+      return false;
+
+  if(str[HexAsciiOffset - 3] != ' ' || str[HexAsciiOffset - 2] != ' ' ||
+     str[HexAsciiOffset - 1] != ' ' || str[HexLineLength - 1] != '\n')
+    return false;
+
+  __m128i decoded[4];
 
-    // add ascii and final newline
-    out += StringFormat::Fmt("   %s\n", ascii.c_str());
+  for(size_t i = 0; i < 4; i++)
+  {
+    // 2 groups of 8 characters for 8 bytes
+    const char *group = str + i * 2 * (HexBytesPerGroup * 2 + 1);
+    const __m128i chars =
+        _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i *)group),
+                           _mm_loadl_epi64((const __m128i *)(group + HexBytesPerGroup * 2 + 1)));
+
+    const __m128i lower = _mm_or_si128(chars, _mm_set1_epi8(0x20));
+
+    const __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8('0' - 1)),
+                                        _mm_cmplt_epi8(chars, _mm_set1_epi8('9' + 1)));
+    const __m128i letter = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+                                         _mm_cmplt_epi8(lower, _mm_set1_epi8('f' + 1)));
+
+    if(_mm_movemask_epi8(_mm_or_si128(digit, letter)) != 0xffff)
+      return false;
+
+    const __m128i nibbles =
+        _mm_or_si128(_mm_and_si128(digit, _mm_sub_epi8(chars, _mm_set1_epi8('0'))),
+                     _mm_andnot_si128(digit, _mm_sub_epi8(lower, _mm_set1_epi8('a' - 10))));
+
+    // the first character of each byte is in the low half of each 16-bit lane
+    const __m128i hi = _mm_and_si128(nibbles, _mm_set1_epi16(0x00ff));
+    const __m128i lo = _mm_srli_epi16(nibbles, 8);
+
+    decoded[i] = _mm_or_si128(_mm_slli_epi16(hi, 4), lo);
   }
+
+  _mm_storeu_si128((__m128i *)out, _mm_packus_epi16(decoded[0], decoded[1]));
+  _mm_storeu_si128((__m128i *)(out + 16), _mm_packus_epi16(decoded[2], decoded[3]));
+
+  return true;
 }
+#endif
 
-static void HexDecode(const char *str, const char *end, bytebuf &out)
+static void HexDecode(const char *str, const char *end, StreamWriter &writer)
 {
-  out.reserve((end - str) / 2);
+  byte buf[4096];
+  size_t bufUsed = 0;
 
-  if(str[0] == '\n')
+  if(str < end && str[0] == '\n')
     str++;
 
+  bool lineStart = true;
+
   while(str + 1 < end)
   {
+    if(bufUsed + HexBytesPerLine > sizeof(buf))
+    {
+      writer.Write(buf, bufUsed);
+      bufUsed = 0;
+    }
+
+#if ENABLED(XML_HEX_SSE2)
+    // decode whole lines at once when they're well formed, which they will be unless the hex has
+    // been edited by hand
+    if(lineStart && size_t(end - str) >= HexLineLength && HexDecodeLine(str, buf + bufUsed))
+    {
+      bufUsed += HexBytesPerLine;
+      str += HexLineLength;
+      continue;
+    }
+#endif
+
+    lineStart = false;
+
     if(IsHex(str[0]) && IsHex(str[1]))
     {
-      out.push_back(byte((FromHex(str[0]) << 4) | FromHex(str[1])));
+      buf[bufUsed++] = byte((FromHex(str[0]) << 4) | FromHex(str[1]));
 
       str += 2;
 
       // allow a space after hex, as a byte group
-      if(str[0] == ' ')
+      if(str < end && str[0] == ' ')
         str++;
 
       // if we encounter more spaces though, it indicates the end of a line.
@@ -209,7 +568,7 @@ static void HexDecode(const char *str, const char *end, bytebuf &out)
     {
       // on the first non-hex char we encounter, skip to the next newline. This might do nothing if
       // the char itself was a newline.
-      while(str[0] != '\n' && str < end)
+      while(str < end && str[0] != '\n')
         str++;
 
       // the loop above terminates in two ways - when it encounters a newline or when it reaches the
@@ -217,85 +576,82 @@ static void HexDecode(const char *str, const char *end, bytebuf &out)
       // we're already past the end, going further past will still make us fail the loop condition
       // and terminate.
       str++;
+      lineStart = true;
     }
   }
+
+  writer.Write(buf, bufUsed);
 }
 
-static bool Obj2XML(pugi::xml_node &parent, SDObject &child)
+static bool Obj2XML(XMLStreamWriter &xml, const SDObject &child, bool arrayElement)
 {
-  pugi::xml_node obj = parent.append_child(typeNames[(uint32_t)child.type.basetype]);
+  if(child.type.basetype == SDBasic::Chunk)
+  {
+    RDCERR("Cannot contain a chunk within a chunk");
+    return false;
+  }
 
-  obj.append_attribute("name") = child.name.c_str();
+  xml.BeginElement(typeNames[(uint32_t)child.type.basetype]);
 
-  if(!child.type.name.empty())
-    obj.append_attribute("typename") = child.type.name.c_str();
+  // array elements are all named the same, and the array's type name comes from its elements
+  if(!arrayElement)
+    xml.Attribute("name", child.name.c_str());
+
+  if(!child.type.name.empty() &&
+     (child.type.basetype != SDBasic::Array || child.NumChildren() == 0))
+    xml.Attribute("typename", child.type.name.c_str());
 
   if(child.type.basetype == SDBasic::UnsignedInteger ||
      child.type.basetype == SDBasic::SignedInteger || child.type.basetype == SDBasic::Float ||
      child.type.basetype == SDBasic::GPUAddress || child.type.basetype == SDBasic::Resource ||
      child.type.basetype == SDBasic::Enum)
   {
-    obj.append_attribute("width") = child.type.byteSize;
+    xml.Attribute("width", (uint64_t)child.type.byteSize);
   }
 
   if(child.type.flags & SDTypeFlags::Hidden)
-    obj.append_attribute("hidden") = true;
+    xml.Attribute("hidden", true);
 
-  if(child.type.flags & SDTypeFlags::Nullable)
-    obj.append_attribute("nullable") = true;
+  // redundant for null objects
+  if((child.type.flags & SDTypeFlags::Nullable) && child.type.basetype != SDBasic::Null)
+    xml.Attribute("nullable", true);
 
   if(child.type.flags & SDTypeFlags::NullString)
-    obj.append_attribute("nullstring") = true;
+    xml.Attribute("nullstring", true);
 
   if(child.type.flags & SDTypeFlags::FixedArray)
-    obj.append_attribute("fixedarray") = true;
+    xml.Attribute("fixedarray", true);
 
   if(child.type.flags & SDTypeFlags::Union)
-    obj.append_attribute("union") = true;
+    xml.Attribute("union", true);
 
   if(child.type.flags & SDTypeFlags::Important)
-    obj.append_attribute("important") = true;
+    xml.Attribute("important", true);
 
   if(child.type.flags & SDTypeFlags::ImportantChildren)
-    obj.append_attribute("importantchildren") = true;
+    xml.Attribute("importantchildren", true);
 
   if(child.type.flags & SDTypeFlags::HiddenChildren)
-    obj.append_attribute("hiddenchildren") = true;
+    xml.Attribute("hiddenchildren", true);
 
-  if(child.type.basetype == SDBasic::Chunk)
-  {
-    RDCERR("Cannot contain a chunk within a chunk");
-    return false;
-  }
-  else if(child.type.basetype == SDBasic::Null)
+  if(child.type.basetype == SDBasic::Struct || child.type.basetype == SDBasic::Array)
   {
-    // redundant
-    obj.remove_attribute("nullable");
-  }
-  else if(child.type.basetype == SDBasic::Struct || child.type.basetype == SDBasic::Array)
-  {
-    if(child.type.basetype == SDBasic::Array && child.NumChildren() > 0)
-      obj.remove_attribute("typename");
-
     for(size_t o = 0; o < child.NumChildren(); o++)
     {
-      if(!Obj2XML(obj, *child.GetChild(o)))
+      if(!Obj2XML(xml, *child.GetChild(o), child.type.basetype == SDBasic::Array))
         return false;
-
-      if(child.type.basetype == SDBasic::Array)
-        obj.last_child().remove_attribute("name");
     }
   }
   else if(child.type.basetype == SDBasic::Buffer)
   {
-    obj.append_attribute("byteLength") = child.type.byteSize;
-    obj.text() = child.data.basic.u;
+    xml.Attribute("byteLength", child.type.byteSize);
+    xml.Text(child.data.basic.u);
   }
-  else
+  else if(child.type.basetype != SDBasic::Null)
   {
     if(child.type.flags & SDTypeFlags::HasCustomString)
     {
-      obj.append_attribute("string") = child.data.str.c_str();
+      xml.Attribute("string", child.data.str.c_str());
     }
 
     switch(child.type.basetype)
@@ -303,64 +659,73 @@ static bool Obj2XML(pugi::xml_node &parent, SDObject &child)
       case SDBasic::GPUAddress:
       case SDBasic::Resource:
       case SDBasic::Enum:
-      case SDBasic::UnsignedInteger: obj.text() = child.data.basic.u; break;
-      case SDBasic::SignedInteger: obj.text() = child.data.basic.i; break;
-      case SDBasic::String: obj.text() = child.data.str.c_str(); break;
-      case SDBasic::Float: obj.text() = child.data.basic.d; break;
-      case SDBasic::Boolean: obj.text() = child.data.basic.b; break;
+      case SDBasic::UnsignedInteger: xml.Text(child.data.basic.u); break;
+      case SDBasic::SignedInteger: xml.Text(child.data.basic.i); break;
+      case SDBasic::String: xml.Text(child.data.str.c_str()); break;
+      case SDBasic::Float: xml.Text(child.data.basic.d); break;
+      case SDBasic::Boolean: xml.Text(child.data.basic.b); break;
       case SDBasic::Character:
       {
         char str[2] = {child.data.basic.c, '\0'};
-        obj.text().set(str);
+        xml.Text(str);
         break;
       }
       default: RDCERR("Unexpected case");
     }
   }
 
+  xml.EndElement();
+
   return true;
 }
 
 static RDResult Structured2XML(const rdcstr &filename, const RDCFile &file, uint64_t version,
                                const StructuredChunkList &chunks, RENDERDOC_ProgressCallback progress)
 {
-  pugi::xml_document doc;
+  StreamWriter stream(FileIO::fopen(filename, FileIO::WriteBinary), Ownership::Stream);
 
-  pugi::xml_node xRoot = doc.append_child("rdc");
+  XMLStreamWriter xml(stream);
 
-  {
-    pugi::xml_node xHeader = xRoot.append_child("header");
+  xml.BeginElement("rdc");
 
-    pugi::xml_node xDriver = xHeader.append_child("driver");
-    xDriver.append_attribute("id") = (uint32_t)file.GetDriver();
-    xDriver.text() = file.GetDriverName().c_str();
+  {
+    xml.BeginElement("header");
 
-    pugi::xml_node xIdent = xHeader.append_child("machineIdent");
+    xml.BeginElement("driver");
+    xml.Attribute("id", (uint64_t)file.GetDriver());
+    xml.Text(file.GetDriverName().c_str());
+    xml.EndElement();
 
-    xIdent.text().set(file.GetMachineIdent());
+    xml.BeginElement("machineIdent");
+    xml.Text(file.GetMachineIdent());
+    xml.EndElement();
 
-    pugi::xml_node xThumbnail = xHeader.append_child("thumbnail");
+    xml.BeginElement("thumbnail");
 
     const RDCThumb &th = file.GetThumbnail();
     if(!th.pixels.empty() && th.width > 0 && th.height > 0)
     {
-      xThumbnail.append_attribute("width") = th.width;
-      xThumbnail.append_attribute("height") = th.height;
+      xml.Attribute("width", (uint64_t)th.width);
+      xml.Attribute("height", (uint64_t)th.height);
 
       if(th.format == FileType::JPG)
-        xThumbnail.text() = "thumb.jpg";
+        xml.Text("thumb.jpg");
       else if(th.format == FileType::PNG)
-        xThumbnail.text() = "thumb.png";
+        xml.Text("thumb.png");
       else if(th.format == FileType::Raw)
-        xThumbnail.text() = "thumb.raw";
+        xml.Text("thumb.raw");
       else
         RDCERR("Unexpected thumbnail format %s", ToStr(th.format).c_str());
     }
 
-    pugi::xml_node xTimebase = xHeader.append_child("timebase");
+    xml.EndElement();
+
+    xml.BeginElement("timebase");
+    xml.Attribute("base", file.GetTimestampBase());
+    xml.Attribute("frequency", file.GetTimestampFrequency());
+    xml.EndElement();
 
-    xTimebase.append_attribute("base") = file.GetTimestampBase();
-    xTimebase.append_attribute("frequency") = file.GetTimestampFrequency();
+    xml.EndElement();
   }
 
   if(progress)
@@ -385,20 +750,22 @@ static RDResult Structured2XML(const rdcstr &filename, const RDCFile &file, uint
         bool succeeded = reader->SkipBytes(thumbHeader.len) && !reader->IsErrored();
         if(succeeded && (uint32_t)thumbHeader.format < (uint32_t)FileType::Count)
         {
-          pugi::xml_node xExtThumbnail = xRoot.append_child("extended_thumbnail");
+          xml.BeginElement("extended_thumbnail");
 
-          xExtThumbnail.append_attribute("width") = thumbHeader.width;
-          xExtThumbnail.append_attribute("height") = thumbHeader.height;
-          xExtThumbnail.append_attribute("length") = thumbHeader.len;
+          xml.Attribute("width", (uint64_t)thumbHeader.width);
+          xml.Attribute("height", (uint64_t)thumbHeader.height);
+          xml.Attribute("length", (uint64_t)thumbHeader.len);
 
           if(thumbHeader.format == FileType::JPG)
-            xExtThumbnail.text() = "ext_thumb.jpg";
+            xml.Text("ext_thumb.jpg");
           else if(thumbHeader.format == FileType::PNG)
-            xExtThumbnail.text() = "ext_thumb.png";
+            xml.Text("ext_thumb.png");
           else if(thumbHeader.format == FileType::Raw)
-            xExtThumbnail.text() = "ext_thumb.raw";
+            xml.Text("ext_thumb.raw");
           else
             RDCERR("Unexpected extended thumbnail format %s", ToStr(thumbHeader.format).c_str());
+
+          xml.EndElement();
         }
       }
 
@@ -413,8 +780,9 @@ static RDResult Structured2XML(const rdcstr &filename, const RDCFile &file, uint
       {
         if(section.type == props.type)
         {
-          pugi::xml_node xFile = xRoot.append_child(section.chunkName.c_str());
-          xFile.text() = section.filename.c_str();
+          xml.BeginElement(section.chunkName.c_str());
+          xml.Text(section.filename.c_str());
+          xml.EndElement();
 
           delete reader;
           literalSection = true;
@@ -425,93 +793,131 @@ static RDResult Structured2XML(const rdcstr &filename, const RDCFile &file, uint
         continue;
     }
 
-    pugi::xml_node xSection = xRoot.append_child("section");
+    xml.BeginElement("section");
 
     if(props.flags & SectionFlags::ASCIIStored)
-      xSection.append_attribute("ascii");
+      xml.Attribute("ascii", "");
     if(props.flags & SectionFlags::LZ4Compressed)
-      xSection.append_attribute("lz4");
+      xml.Attribute("lz4", "");
     if(props.flags & SectionFlags::ZstdCompressed)
-      xSection.append_attribute("zstd");
+      xml.Attribute("zstd", "");
+    if(props.flags & SectionFlags::BlockIndexed)
+      xml.Attribute("blockindexed", "");
 
-    pugi::xml_node name = xSection.append_child("name");
-    name.text() = props.name.c_str();
+    xml.BeginElement("name");
+    xml.Text(props.name.c_str());
+    xml.EndElement();
 
-    pugi::xml_node secVer = xSection.append_child("version");
-    secVer.text() = props.version;
+    xml.BeginElement("version");
+    xml.Text(props.version);
+    xml.EndElement();
 
-    pugi::xml_node type = xSection.append_child("type");
-    type.text() = (uint32_t)props.type;
+    xml.BeginElement("type");
+    xml.Text((uint64_t)props.type);
+    xml.EndElement();
 
+    xml.BeginElement("data");
+
+    // read the contents a block at a time, a whole number of hex lines so that each block can be
+    // encoded separately
     bytebuf contents;
-    contents.resize((size_t)reader->GetSize());
-    reader->Read(contents.data(), reader->GetSize());
+    contents.resize(HexBytesPerLine * 2048);
 
-    pugi::xml_node data = xSection.append_child("data");
+    rdcstr hexdata;
 
     if(props.flags & SectionFlags::ASCIIStored)
     {
-      // insert the contents literally
-      data.text().set((char *)contents.data());
+      // insert the contents literally, up to the first NULL
+      xml.Text("", 0);
     }
     else
     {
       // encode to simple hex. Not efficient, but easy.
-      rdcstr hexdata;
-      hexdata.reserve(contents.size() * 2);
-      HexEncode(contents, hexdata);
-      data.text().set(hexdata.c_str());
+      xml.RawText("\n", 1);
     }
 
+    while(!reader->AtEnd() && !reader->IsErrored())
+    {
+      size_t size =
+          (size_t)RDCMIN(reader->GetSize() - reader->GetOffset(), (uint64_t)contents.size());
+      if(!reader->Read(contents.data(), size))
+        break;
+
+      if(props.flags & SectionFlags::ASCIIStored)
+      {
+        const byte *end = (const byte *)memchr(contents.data(), 0, size);
+        xml.Text((const char *)contents.data(), end ? end - contents.data() : size);
+
+        if(end)
+          break;
+      }
+      else
+      {
+        hexdata.clear();
+        HexEncode(contents.data(), size, hexdata);
+        xml.RawText(hexdata.c_str(), hexdata.size());
+      }
+    }
+
+    xml.EndElement();
+
+    xml.EndElement();
+
     delete reader;
   }
 
   if(progress)
     progress(StructuredProgress(0.2f));
 
-  pugi::xml_node xChunks = xRoot.append_child("chunks");
+  xml.BeginElement("chunks");
 
-  xChunks.append_attribute("version") = version;
+  xml.Attribute("version", version);
 
   for(size_t c = 0; c < chunks.size(); c++)
   {
-    pugi::xml_node xChunk = xChunks.append_child("chunk");
+    xml.BeginElement("chunk");
     SDChunk *chunk = chunks[c];
 
-    xChunk.append_attribute("id") = chunk->metadata.chunkID;
-    xChunk.append_attribute("chunkIndex") = c;
-    xChunk.append_attribute("name") = chunk->name.c_str();
-    xChunk.append_attribute("length") = chunk->metadata.length;
+    xml.Attribute("id", (uint64_t)chunk->metadata.chunkID);
+    xml.Attribute("chunkIndex", (uint64_t)c);
+    xml.Attribute("name", chunk->name.c_str());
+    xml.Attribute("length", chunk->metadata.length);
     if(chunk->metadata.threadID)
-      xChunk.append_attribute("threadID") = chunk->metadata.threadID;
+      xml.Attribute("threadID", chunk->metadata.threadID);
     if(chunk->metadata.timestampMicro)
-      xChunk.append_attribute("timestamp") = chunk->metadata.timestampMicro;
+      xml.Attribute("timestamp", chunk->metadata.timestampMicro);
     if(chunk->metadata.durationMicro >= 0)
-      xChunk.append_attribute("duration") = chunk->metadata.durationMicro;
+      xml.Attribute("duration", chunk->metadata.durationMicro);
+    if(chunk->metadata.flags & SDChunkFlags::OpaqueChunk)
+      xml.Attribute("opaque", true);
+
     if(chunk->metadata.flags & SDChunkFlags::HasCallstack)
     {
-      pugi::xml_node stack = xChunk.append_child("callstack");
+      xml.BeginElement("callstack");
 
       for(size_t i = 0; i < chunk->metadata.callstack.size(); i++)
       {
-        stack.append_child("address").text() = chunk->metadata.callstack[i];
+        xml.BeginElement("address");
+        xml.Text(chunk->metadata.callstack[i]);
+        xml.EndElement();
       }
+
+      xml.EndElement();
     }
 
     if(chunk->metadata.flags & SDChunkFlags::OpaqueChunk)
     {
-      xChunk.append_attribute("opaque") = true;
-
       RDCASSERT(chunk->NumChildren() > 0);
-      pugi::xml_node opaque = xChunk.append_child("buffer");
-      opaque.append_attribute("byteLength") = chunk->GetChild(0)->type.byteSize;
-      opaque.text() = chunk->GetChild(0)->data.basic.u;
+      xml.BeginElement("buffer");
+      xml.Attribute("byteLength", chunk->GetChild(0)->type.byteSize);
+      xml.Text(chunk->GetChild(0)->data.basic.u);
+      xml.EndElement();
     }
     else
     {
       for(size_t o = 0; o < chunk->NumChildren(); o++)
       {
-        if(!Obj2XML(xChunk, *chunk->GetChild(o)))
+        if(!Obj2XML(xml, *chunk->GetChild(o), false))
         {
           RETURN_ERROR_RESULT(ResultCode::FileCorrupted,
                               "Malformed structured data, couldn't encode chunk child %s",
@@ -520,16 +926,327 @@ static RDResult Structured2XML(const rdcstr &filename, const RDCFile &file, uint
       }
     }
 
+    xml.EndElement();
+
     if(progress)
       progress(StructuredProgress(0.2f + 0.8f * (float(c) / float(chunks.size()))));
   }
 
-  xml_file_writer writer(filename);
-  doc.save(writer);
+  xml.EndElement();
+
+  xml.EndElement();
+
+  xml.Flush();
 
-  return writer.stream.GetError();
+  return stream.GetError();
 }
 
+// Reads an xml document from a stream one element at a time, so that importing a large capture
+// doesn't need the whole document in memory. The document is only split up at the levels that are
+// read here, and each element that's read is parsed on its own by pugixml.
+class XMLStreamReader
+{
+public:
+  XMLStreamReader(StreamReader &reader) : m_Reader(reader) { m_Buffer.resize(BufferSize); }
+  // returns the name of the next child of the current element without reading it, or an empty
+  // string if the current element or the document ends first
+  rdcstr PeekElement()
+  {
+    if(m_EmptyElement)
+      return rdcstr();
+
+    SkipMisc();
+
+    if(!Ensure(2) || m_Buffer[m_Pos] != '<' || m_Buffer[m_Pos + 1] == '/')
+      return rdcstr();
+
+    size_t len = 1;
+    while(Ensure(len + 1) && !IsNameEnd(m_Buffer[m_Pos + len]))
+      len++;
+
+    return rdcstr(&m_Buffer[m_Pos + 1], len - 1);
+  }
+
+  // reads the start of the next child into doc, as an element with no children. The child's own
+  // children are then read in turn until false is returned. Returns false if there are no more
+  // children in the current element, or the next one is malformed.
+  bool OpenElement(pugi::xml_document &doc)
+  {
+    doc.reset();
+
+    if(!NextElement())
+      return false;
+
+    m_Element.clear();
+
+    bool selfClosing = false;
+    if(!ConsumeTag(&m_Element, selfClosing))
+      return Truncated();
+
+    if(selfClosing)
+    {
+      m_EmptyElement = true;
+    }
+    else
+    {
+      size_t len = 1;
+      while(len < m_Element.size() && !IsNameEnd(m_Element[len]))
+        len++;
+
+      rdcstr name(m_Element.c_str() + 1, len - 1);
+      m_Element += "</" + name + ">";
+    }
+
+    return Parse(doc);
+  }
+
+  // reads the whole of the next child into doc. Returns false if there are no more children in the
+  // current element, or the next one is malformed.
+  bool ReadElement(pugi::xml_document &doc)
+  {
+    doc.reset();
+
+    if(!NextElement())
+      return false;
+
+    m_Element.clear();
+
+    int depth = 0;
+    do
+    {
+      bool success = true;
+
+      if(!Ensure(1))
+        success = false;
+      else if(m_Buffer[m_Pos] != '<')
+        ConsumeText(&m_Element);
+      else if(Match("<!--"))
+        success = Consume("-->", &m_Element);
+      else if(Match("<![CDATA["))
+        success = Consume("]]>", &m_Element);
+      else if(Match("<?"))
+        success = Consume("?>", &m_Element);
+      else if(Match("<!"))
+        success = Consume(">", &m_Element);
+      else
+      {
+        const bool closing = Ensure(2) && m_Buffer[m_Pos + 1] == '/';
+
+        bool selfClosing = false;
+        success = ConsumeTag(&m_Element, selfClosing);
+
+        if(closing)
+          depth--;
+        else if(!selfClosing)
+          depth++;
+      }
+
+      if(!success)
+        return Truncated();
+    } while(depth > 0);
+
+    return Parse(doc);
+  }
+
+  bool IsErrored() const { return m_Errored; }
+  float GetProgress()
+  {
+    if(m_Reader.GetSize() == 0)
+      return 1.0f;
+
+    return float(m_Reader.GetOffset() - (m_Size - m_Pos)) / float(m_Reader.GetSize());
+  }
+
+private:
+  static const size_t BufferSize = 64 * 1024;
+
+  static bool IsNameEnd(char c)
+  {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '/' || c == '>';
+  }
+
+  // make sure at least count bytes are buffered past the current position, returns false if the
+  // stream ends first
+  bool Ensure(size_t count)
+  {
+    if(m_Size - m_Pos >= count)
+      return true;
+
+    memmove(m_Buffer.data(), m_Buffer.data() + m_Pos, m_Size - m_Pos);
+    m_Size -= m_Pos;
+    m_Pos = 0;
+
+    size_t size = (size_t)RDCMIN(m_Reader.GetSize() - m_Reader.GetOffset(),
+                                 uint64_t(m_Buffer.size() - m_Size));
+
+    if(size > 0 && m_Reader.Read(m_Buffer.data() + m_Size, size))
+      m_Size += size;
+
+    return m_Size - m_Pos >= count;
+  }
+
+  bool Match(const char *str)
+  {
+    size_t len = strlen(str);
+    return Ensure(len) && memcmp(&m_Buffer[m_Pos], str, len) == 0;
+  }
+
+  // consume everything up to the next tag
+  void ConsumeText(rdcstr *copy)
+  {
+    while(Ensure(1))
+    {
+      const char *start = &m_Buffer[m_Pos];
+      const char *next = (const char *)memchr(start, '<', m_Size - m_Pos);
+      size_t len = next ? next - start : m_Size - m_Pos;
+
+      if(copy)
+        copy->append(start, len);
+      m_Pos += len;
+
+      if(next)
+        return;
+    }
+  }
+
+  // consume everything up to and including the terminator
+  bool Consume(const char *terminator, rdcstr *copy)
+  {
+    const size_t termLen = strlen(terminator);
+
+    while(Ensure(termLen))
+    {
+      const char *start = &m_Buffer[m_Pos];
+
+      if(memcmp(start, terminator, termLen) == 0)
+      {
+        if(copy)
+          copy->append(start, termLen);
+        m_Pos += termLen;
+        return true;
+      }
+
+      // skip to the next place the terminator could start
+      const char *next = (const char *)memchr(start + 1, terminator[0], m_Size - m_Pos - 1);
+      size_t len = next ? next - start : m_Size - m_Pos;
+
+      if(copy)
+        copy->append(start, len);
+      m_Pos += len;
+    }
+
+    return false;
+  }
+
+  // consume a start or end tag, which may contain '>' inside quoted attribute values
+  bool ConsumeTag(rdcstr *copy, bool &selfClosing)
+  {
+    char quote = 0;
+    char prev = 0;
+
+    while(Ensure(1))
+    {
+      const char c = m_Buffer[m_Pos++];
+
+      if(copy)
+        copy->push_back(c);
+
+      if(quote)
+      {
+        if(c == quote)
+          quote = 0;
+      }
+      else if(c == '"' || c == '\'')
+      {
+        quote = c;
+      }
+      else if(c == '>')
+      {
+        selfClosing = (prev == '/');
+        return true;
+      }
+
+      prev = c;
+    }
+
+    return false;
+  }
+
+  // skip whitespace, comments, processing instructions and the doctype between elements
+  void SkipMisc()
+  {
+    for(;;)
+    {
+      ConsumeText(NULL);
+
+      if(Match("<!--"))
+        Consume("-->", NULL);
+      else if(Match("<?"))
+        Consume("?>", NULL);
+      else if(Match("<!"))
+        Consume(">", NULL);
+      else
+        return;
+    }
+  }
+
+  // moves to the next child's start tag, or consumes the end of the current element and returns
+  // false
+  bool NextElement()
+  {
+    if(m_EmptyElement)
+    {
+      m_EmptyElement = false;
+      return false;
+    }
+
+    SkipMisc();
+
+    if(!Ensure(2))
+      return false;
+
+    if(m_Buffer[m_Pos + 1] == '/')
+    {
+      Consume(">", NULL);
+      return false;
+    }
+
+    return true;
+  }
+
+  bool Parse(pugi::xml_document &doc)
+  {
+    pugi::xml_parse_result res = doc.load_buffer(m_Element.c_str(), m_Element.size());
+
+    if(!res)
+    {
+      RDCERR("Malformed xml element at offset %zu: %s", size_t(res.offset), res.description());
+      m_Errored = true;
+      return false;
+    }
+
+    return true;
+  }
+
+  bool Truncated()
+  {
+    RDCERR("Unexpected end of xml document");
+    m_Errored = true;
+    return false;
+  }
+
+  StreamReader &m_Reader;
+  rdcarray<char> m_Buffer;
+  size_t m_Pos = 0, m_Size = 0;
+
+  // the element being read, passed to pugixml to parse
+  rdcstr m_Element;
+
+  // set when the last element opened had no children, so there's no end tag to consume
+  bool m_EmptyElement = false;
+  bool m_Errored = false;
+};
+
 static SDObject *XML2Obj(pugi::xml_node &obj)
 {
   SDObject *ret = new SDObject(rdcstr(obj.attribute("name").as_string()),
@@ -642,22 +1359,24 @@ static SDObject *XML2Obj(pugi::xml_node &obj)
   return ret;
 }
 
-static RDResult XML2Structured(const rdcstr &xml, const ThumbTypeAndData &thumb,
+static RDResult XML2Structured(StreamReader &reader, const ThumbTypeAndData &thumb,
                                const ThumbTypeAndData &extThumb,
                                const std::map<SectionType, bytebuf> &literalFiles,
                                const StructuredBufferList &buffers, RDCFile *rdc, uint64_t &version,
                                StructuredChunkList &chunks, RENDERDOC_ProgressCallback progress)
 {
-  pugi::xml_document doc;
-  doc.load_string(xml.c_str());
+  XMLStreamReader xml(reader);
 
-  pugi::xml_node root = doc.child("rdc");
+  pugi::xml_document doc;
 
-  if(!root)
+  if(!xml.OpenElement(doc) || strcmp(doc.first_child().name(), "rdc") != 0)
     RETURN_ERROR_RESULT(ResultCode::FileCorrupted,
                         "Malformed xml document, couldn't get root <rdc> node");
 
-  pugi::xml_node xHeader = root.first_child();
+  xml.ReadElement(doc);
+
+  // the header comes first, with the sections and chunks after
+  pugi::xml_node xHeader = doc.first_child();
 
   if(strcmp(xHeader.name(), "header") != 0)
     RETURN_ERROR_RESULT(ResultCode::FileCorrupted,
@@ -722,11 +1441,15 @@ static RDResult XML2Structured(const rdcstr &xml, const ThumbTypeAndData &thumb,
     progress(StructuredProgress(0.1f));
 
   // push in other sections
-  pugi::xml_node xSection = xHeader.next_sibling();
-
-  while(!strcmp(xSection.name(), "section") || !strcmp(xSection.name(), "extended_thumbnail") ||
-        isLiteralFileChunkName(xSection.name()))
+  for(rdcstr next = xml.PeekElement();
+      next == "section" || next == "extended_thumbnail" || isLiteralFileChunkName(next);
+      next = xml.PeekElement())
   {
+    if(!xml.ReadElement(doc))
+      break;
+
+    pugi::xml_node xSection = doc.first_child();
+
     if(!strcmp(xSection.name(), "extended_thumbnail"))
     {
       SectionProperties props = {};
@@ -746,7 +1469,6 @@ static RDResult XML2Structured(const rdcstr &xml, const ThumbTypeAndData &thumb,
 
       delete w;
 
-      xSection = xSection.next_sibling();
       continue;
     }
     else
@@ -771,7 +1493,6 @@ static RDResult XML2Structured(const rdcstr &xml, const ThumbTypeAndData &thumb,
 
             delete w;
 
-            xSection = xSection.next_sibling();
             literalSection = true;
           }
         }
@@ -789,12 +1510,13 @@ static RDResult XML2Structured(const rdcstr &xml, const ThumbTypeAndData &thumb,
       props.flags |= SectionFlags::LZ4Compressed;
     if(xSection.attribute("zstd"))
       props.flags |= SectionFlags::ZstdCompressed;
+    if(xSection.attribute("blockindexed"))
+      props.flags |= SectionFlags::BlockIndexed;
 
     pugi::xml_node name = xSection.child("name");
     if(!name)
     {
       RDCERR("Malformed section, expected name node");
-      xSection = xSection.next_sibling();
       continue;
     }
     props.name = name.text().as_string();
@@ -803,7 +1525,6 @@ static RDResult XML2Structured(const rdcstr &xml, const ThumbTypeAndData &thumb,
     if(!secVer)
     {
       RDCERR("Malformed section, expected version node");
-      xSection = xSection.next_sibling();
       continue;
     }
     props.version = secVer.text().as_ullong();
@@ -812,7 +1533,6 @@ static RDResult XML2Structured(const rdcstr &xml, const ThumbTypeAndData &thumb,
     if(!type)
     {
       RDCERR("Malformed section, expected type node");
-      xSection = xSection.next_sibling();
       continue;
     }
     props.type = (SectionType)type.text().as_uint();
@@ -821,7 +1541,6 @@ static RDResult XML2Structured(const rdcstr &xml, const ThumbTypeAndData &thumb,
     if(!data)
     {
       RDCERR("Malformed section, expected data node");
-      xSection = xSection.next_sibling();
       continue;
     }
 
@@ -836,25 +1555,25 @@ static RDResult XML2Structured(const rdcstr &xml, const ThumbTypeAndData &thumb,
     }
     else
     {
-      bytebuf decoded;
-      HexDecode(str, str + len, decoded);
-      writer->Write(decoded.data(), decoded.size());
+      HexDecode(str, str + len, *writer);
     }
 
     writer->Finish();
     delete writer;
-
-    xSection = xSection.next_sibling();
   }
 
+  if(xml.IsErrored())
+    RETURN_ERROR_RESULT(ResultCode::FileCorrupted, "Malformed xml document, reading sections");
+
   if(progress)
     progress(StructuredProgress(0.2f));
 
-  pugi::xml_node xChunks = xSection;
-
-  if(strcmp(xSection.name(), "chunks") != 0)
+  if(!xml.OpenElement(doc) || strcmp(doc.first_child().name(), "chunks") != 0)
     RETURN_ERROR_RESULT(ResultCode::FileCorrupted,
-                        "Malformed xml document, expected <chunks> node, got <%s>", xSection.name());
+                        "Malformed xml document, expected <chunks> node, got <%s>",
+                        doc.first_child().name());
+
+  pugi::xml_node xChunks = doc.first_child();
 
   if(!xChunks.attribute("version"))
     RETURN_ERROR_RESULT(ResultCode::FileCorrupted,
@@ -862,11 +1581,11 @@ static RDResult XML2Structured(const rdcstr &xml, const ThumbTypeAndData &thumb,
 
   version = xChunks.attribute("version").as_ullong();
 
-  size_t chunkIdx = 0;
-  size_t numChunks = std::distance(xChunks.begin(), xChunks.end());
-
-  for(pugi::xml_node xChunk = xChunks.first_child(); xChunk; xChunk = xChunk.next_sibling())
+  // read the chunks one at a time, so only one is parsed in memory at once
+  while(xml.ReadElement(doc))
   {
+    pugi::xml_node xChunk = doc.first_child();
+
     if(strcmp(xChunk.name(), "chunk") != 0)
       RETURN_ERROR_RESULT(ResultCode::FileCorrupted,
                           "Malformed xml document, expected <chunk> child under <chunks>, got <%s>",
@@ -913,6 +1632,10 @@ static RDResult XML2Structured(const rdcstr &xml, const ThumbTypeAndData &thumb,
     {
       for(pugi::xml_node child = xChunk.first_child(); child; child = child.next_sibling())
       {
+        // already read into the metadata above
+        if(child == callstack)
+          continue;
+
         SDObject *obj = XML2Obj(child);
         if(!obj)
         {
@@ -924,14 +1647,51 @@ static RDResult XML2Structured(const rdcstr &xml, const ThumbTypeAndData &thumb,
     }
 
     if(progress)
-      progress(StructuredProgress(0.2f + 0.8f * (float(chunkIdx) / float(numChunks))));
-
-    chunkIdx++;
+      progress(StructuredProgress(0.2f + 0.8f * xml.GetProgress()));
   }
 
+  if(xml.IsErrored())
+    RETURN_ERROR_RESULT(ResultCode::FileCorrupted, "Malformed xml document, reading chunks");
+
   return ResultCode::Succeeded;
 }
 
+// buffers are compressed quickly since there can be a lot of data
+static const mz_uint ZipBufferLevel = 2;
+static const uint64_t MaxZipBatchSize = 256 * 1024 * 1024;
+
+struct CompressedBuffer
+{
+  void *data = NULL;
+  size_t size = 0;
+  mz_uint32 crc = 0;
+};
+
+// compresses buffers [begin, end) to raw deflate streams that can be added to a zip directly. If a
+// buffer is empty or fails to compress, its data is left NULL.
+static void CompressBuffers(const StructuredBufferList &buffers, size_t begin, size_t end,
+                            rdcarray<CompressedBuffer> &compressed)
+{
+  compressed.clear();
+  compressed.resize(end - begin);
+
+  // negative window bits for a raw stream, without the zlib header
+  const mz_uint flags = tdefl_create_comp_flags_from_zip_params(
+      ZipBufferLevel, -MZ_DEFAULT_WINDOW_BITS, MZ_DEFAULT_STRATEGY);
+
+  // this runs without the job system being set up when converting from the command line
+  Threading::ParallelFor(compressed.size(), [&](size_t idx) {
+    const bytebuf &buf = *buffers[begin + idx];
+    CompressedBuffer &comp = compressed[idx];
+
+    if(buf.empty())
+      return;
+
+    comp.crc = (mz_uint32)mz_crc32(MZ_CRC32_INIT, buf.data(), buf.size());
+    comp.data = tdefl_compress_mem_to_heap(buf.data(), buf.size(), &comp.size, flags);
+  });
+}
+
 static RDResult Buffers2ZIP(const rdcstr &filename, const RDCFile &file,
                             const StructuredBufferList &buffers, RENDERDOC_ProgressCallback progress)
 {
@@ -948,12 +1708,38 @@ static RDResult Buffers2ZIP(const rdcstr &filename, const RDCFile &file,
                         zipFile.c_str(), mz_zip_get_error_string(zip.m_last_error));
   }
 
-  for(size_t i = 0; i < buffers.size(); i++)
+  // compress the buffers in parallel a batch at a time, then add them to the zip in order. This
+  // limits how much compressed data is held in memory at once
+  rdcarray<CompressedBuffer> compressed;
+
+  for(size_t batchStart = 0; batchStart < buffers.size();)
   {
-    mz_zip_writer_add_mem(&zip, GetBufferName(i).c_str(), buffers[i]->data(), buffers[i]->size(), 2);
+    size_t batchEnd = batchStart;
+    uint64_t batchSize = 0;
+    while(batchEnd < buffers.size() && (batchEnd == batchStart || batchSize < MaxZipBatchSize))
+      batchSize += buffers[batchEnd++]->size();
 
-    if(progress)
-      progress(BufferProgress(float(i) / float(buffers.size())));
+    CompressBuffers(buffers, batchStart, batchEnd, compressed);
+
+    for(size_t i = batchStart; i < batchEnd; i++)
+    {
+      const CompressedBuffer &comp = compressed[i - batchStart];
+
+      if(comp.data)
+        mz_zip_writer_add_mem_ex(&zip, GetBufferName(i).c_str(), comp.data, comp.size, NULL, 0,
+                                 ZipBufferLevel | MZ_ZIP_FLAG_COMPRESSED_DATA, buffers[i]->size(),
+                                 comp.crc);
+      else
+        mz_zip_writer_add_mem(&zip, GetBufferName(i).c_str(), buffers[i]->data(),
+                              buffers[i]->size(), ZipBufferLevel);
+
+      mz_free(comp.data);
+
+      if(progress)
+        progress(BufferProgress(float(i) / float(buffers.size())));
+    }
+
+    batchStart = batchEnd;
   }
 
   const RDCThumb &th = file.GetThumbnail();
@@ -1131,11 +1917,7 @@ RDResult importXMLZ(const rdcstr &filename, StreamReader &reader, RDCFile *rdc,
       return res;
   }
 
-  rdcstr buf;
-  buf.resize((size_t)reader.GetSize());
-  reader.Read(buf.data(), buf.size());
-
-  return XML2Structured(buf.c_str(), thumb, extThumb, literalFiles, structData.buffers, rdc,
+  return XML2Structured(reader, thumb, extThumb, literalFiles, structData.buffers, rdc,
                         structData.version, structData.chunks, progress);
 }
 
@@ -1182,9 +1964,6 @@ easier to work with but it cannot then be imported.)",
 
 TEST_CASE("XML/SDObject round trip", "[xml serialiser]")
 {
-  pugi::xml_document doc;
-  pugi::xml_node xRoot = doc.append_child("root");
-
   rdcarray<SDObject *> objs;
   SDObject *obj;
 
@@ -1212,11 +1991,23 @@ TEST_CASE("XML/SDObject round trip", "[xml serialiser]")
   obj->data.basic.u = UINT8_MAX;
   objs.push_back(obj);
 
-  for(int i = 0; i < objs.count(); ++i)
+  StreamWriter stream(StreamWriter::DefaultScratchSize);
+
   {
-    Obj2XML(xRoot, *objs[i]);
+    XMLStreamWriter xml(stream);
+    xml.BeginElement("root");
+    for(int i = 0; i < objs.count(); ++i)
+    {
+      Obj2XML(xml, *objs[i], false);
+    }
+    xml.EndElement();
+    xml.Flush();
   }
 
+  pugi::xml_document doc;
+  doc.load_buffer(stream.GetData(), (size_t)stream.GetOffset());
+  pugi::xml_node xRoot = doc.child("root");
+
   for(pugi::xml_node xChild = xRoot.last_child(); xChild; xChild = xChild.previous_sibling())
   {
     SDObject *newObj = XML2Obj(xChild);
@@ -1235,4 +2026,274 @@ TEST_CASE("XML/SDObject round trip", "[xml serialiser]")
   }
 }
 
+
+TEST_CASE("XML hex encoding", "[xml serialiser]")
+{
+  bytebuf data;
+  for(size_t i = 0; i < 1000; i++)
+    data.push_back(byte((i * 37) ^ (i >> 3)));
+
+  SECTION("Layout")
+  {
+    const byte line[] = "0123456789abcdef&<>\x01\x7f\x80\xff XYZ~{}|\t\r\n";
+    rdcstr hex;
+    HexEncode(line, sizeof(line), hex);
+
+    CHECK(hex ==
+          "30313233 34353637 38396162 63646566 263C3E01 7F80FF20 58595A7E 7B7D7C09   "
+          "0123456789abcdef....... XYZ~{}|.\n"
+          "0D0A00                                                                    ...\n");
+  }
+
+  SECTION("Whole lines match the bytewise encoding")
+  {
+    for(size_t offs = 0; offs + HexBytesPerLine <= data.size(); offs += 7)
+    {
+      char line[HexLineLength], reference[HexLineLength];
+
+      HexEncodeLine(data.data() + offs, line);
+
+      memset(reference, ' ', HexAsciiOffset);
+      HexEncodeBytes(data.data() + offs, HexBytesPerLine, reference);
+      reference[HexLineLength - 1] = '\n';
+
+      CHECK(rdcstr(line, HexLineLength) == rdcstr(reference, HexLineLength));
+    }
+  }
+
+  SECTION("Round trip")
+  {
+    for(size_t len : {0, 1, 3, 4, 5, 31, 32, 33, 64, 100, 1000})
+    {
+      rdcstr hex = "\n";
+      HexEncode(data.data(), len, hex);
+
+      StreamWriter decoded(StreamWriter::DefaultScratchSize);
+      HexDecode(hex.c_str(), hex.c_str() + hex.size(), decoded);
+
+      CHECK(bytebuf(decoded.GetData(), (size_t)decoded.GetOffset()) == bytebuf(data.data(), len));
+    }
+  }
+
+  SECTION("Hand edited hex")
+  {
+    rdcstr hex = "\n";
+    HexEncode(data.data(), 100, hex);
+
+    // lower case, and remove the ascii from the second line and the group spaces from the third
+    for(char &c : hex)
+      if(c >= 'A' && c <= 'F')
+        c += 'a' - 'A';
+
+    hex.erase(1 + HexLineLength + HexAsciiOffset - 3, HexBytesPerLine + 3);
+
+    for(size_t i = 0; i < HexGroupsPerLine - 1; i++)
+      hex.erase(1 + HexLineLength * 2 - HexBytesPerLine - 3 + HexBytesPerGroup * 2 * (i + 1), 1);
+
+    StreamWriter decoded(StreamWriter::DefaultScratchSize);
+    HexDecode(hex.c_str(), hex.c_str() + hex.size(), decoded);
+
+    CHECK(bytebuf(decoded.GetData(), (size_t)decoded.GetOffset()) == bytebuf(data.data(), 100));
+  }
+}
+
+TEST_CASE("XML capture export and import", "[xml serialiser]")
+{
+  RDCFile rdc;
+  rdc.SetData(RDCDriver::Vulkan, "Vulkan", 0x1234, NULL, 5000, 2.5);
+
+  bytebuf binary;
+  for(size_t i = 0; i < 1000; i++)
+    binary.push_back(byte(i * 13));
+
+  const rdcstr notes = "Notes with <markup> & \"quotes\"\nover two lines";
+
+  {
+    SectionProperties props;
+    props.type = SectionType::Unknown;
+    props.name = "test/binary";
+    props.version = 3;
+
+    StreamWriter *w = rdc.WriteSection(props);
+    w->Write(binary.data(), binary.size());
+    w->Finish();
+    delete w;
+
+    props.type = SectionType::Notes;
+    props.name = ToStr(SectionType::Notes);
+    props.flags = SectionFlags::ASCIIStored;
+    props.version = 1;
+
+    w = rdc.WriteSection(props);
+    w->Write(notes.c_str(), notes.size());
+    w->Finish();
+    delete w;
+  }
+
+  SDFile sdfile;
+  sdfile.version = 0x42;
+
+  for(uint32_t c = 0; c < 50; c++)
+  {
+    SDChunk *chunk = new SDChunk(StringFormat::Fmt("Chunk<%u>", c));
+    chunk->metadata.chunkID = 1000 + c;
+    chunk->metadata.length = c * 100;
+    chunk->metadata.threadID = c % 3;
+    chunk->metadata.timestampMicro = c * 10;
+    chunk->metadata.durationMicro = c % 2 ? -1 : int64_t(c);
+
+    if(c % 5 == 0)
+    {
+      chunk->metadata.flags |= SDChunkFlags::HasCallstack;
+      chunk->metadata.callstack = {0x1000 + c, 0xffffffffffffffffULL};
+    }
+
+    chunk->AddAndOwnChild(makeSDUInt64("u64"_lit, 0xfffffffffff0ULL + c));
+    chunk->AddAndOwnChild(makeSDInt32("i32"_lit, -int32_t(c)));
+    chunk->AddAndOwnChild(makeSDFloat("f"_lit, 1.0f / (c + 1)));
+    chunk->AddAndOwnChild(makeSDString("s"_lit, StringFormat::Fmt("'string' & <%u>\t\x01", c)));
+    chunk->AddAndOwnChild(makeSDBool("b"_lit, c % 2 == 0));
+
+    SDObject *arr = chunk->AddAndOwnChild(makeSDArray("arr"_lit));
+    for(uint32_t i = 0; i < c % 4; i++)
+      arr->AddAndOwnChild(makeSDUInt32("$el"_lit, i));
+
+    SDObject *str = chunk->AddAndOwnChild(makeSDStruct("struct"_lit, "Struct"_lit));
+    str->AddAndOwnChild(makeSDEnum("e"_lit, c));
+    str->GetChild(0)->data.str = "Value";
+    str->GetChild(0)->type.flags |= SDTypeFlags::HasCustomString;
+
+    SDObject *null = str->AddAndOwnChild(new SDObject("null"_lit, "Null"_lit));
+    null->type.basetype = SDBasic::Null;
+    null->type.flags |= SDTypeFlags::Nullable;
+
+    sdfile.chunks.push_back(chunk);
+  }
+
+  rdcstr filename = FileIO::GetTempFolderFilename() + "/xml_export.xml";
+
+  RDResult res = Structured2XML(filename, rdc, sdfile.version, sdfile.chunks, NULL);
+  REQUIRE(res.code == ResultCode::Succeeded);
+
+  SECTION("Formatted the same as pugixml")
+  {
+    bytebuf written;
+    FileIO::ReadAll(filename, written);
+
+    pugi::xml_document doc;
+    bool loaded = doc.load_buffer(written.data(), written.size());
+    REQUIRE(loaded);
+
+    StreamWriter saved(StreamWriter::DefaultScratchSize);
+    struct stream_writer : pugi::xml_writer
+    {
+      StreamWriter *stream;
+      void write(const void *data, size_t size) { stream->Write(data, size); }
+    } writer;
+    writer.stream = &saved;
+    doc.save(writer);
+
+    CHECK(rdcstr((const char *)saved.GetData(), (size_t)saved.GetOffset()) ==
+          rdcstr((const char *)written.data(), written.size()));
+  }
+
+  SECTION("Import")
+  {
+    StreamReader reader(FileIO::fopen(filename, FileIO::ReadBinary));
+
+    ThumbTypeAndData thumb = {}, extThumb = {};
+    std::map<SectionType, bytebuf> literalFiles;
+
+    RDCFile imported;
+    SDFile importedData;
+    res = XML2Structured(reader, thumb, extThumb, literalFiles, importedData.buffers, &imported,
+                         importedData.version, importedData.chunks, NULL);
+    REQUIRE(res.code == ResultCode::Succeeded);
+
+    CHECK((imported.GetDriver() == RDCDriver::Vulkan));
+    CHECK(imported.GetDriverName() == "Vulkan");
+    CHECK(imported.GetMachineIdent() == 0x1234);
+    CHECK(imported.GetTimestampBase() == 5000);
+    CHECK(imported.GetTimestampFrequency() == 2.5);
+
+    REQUIRE(imported.NumSections() == 2);
+
+    {
+      StreamReader *r = imported.ReadSection(imported.SectionIndex("test/binary"));
+      bytebuf contents;
+      contents.resize((size_t)r->GetSize());
+      r->Read(contents.data(), contents.size());
+      delete r;
+
+      CHECK(contents == binary);
+    }
+
+    {
+      StreamReader *r = imported.ReadSection(imported.SectionIndex(SectionType::Notes));
+      rdcstr contents;
+      contents.resize((size_t)r->GetSize());
+      r->Read(contents.data(), contents.size());
+      delete r;
+
+      CHECK(contents == notes);
+    }
+
+    CHECK(importedData.version == sdfile.version);
+    REQUIRE(importedData.chunks.size() == sdfile.chunks.size());
+
+    for(size_t c = 0; c < sdfile.chunks.size(); c++)
+    {
+      const SDChunk *a = sdfile.chunks[c];
+      const SDChunk *b = importedData.chunks[c];
+
+      CHECK(a->name == b->name);
+      CHECK(a->metadata.chunkID == b->metadata.chunkID);
+      CHECK(a->metadata.length == b->metadata.length);
+      CHECK(a->metadata.threadID == b->metadata.threadID);
+      CHECK(a->metadata.timestampMicro == b->metadata.timestampMicro);
+      CHECK(a->metadata.durationMicro == b->metadata.durationMicro);
+      CHECK(a->metadata.callstack == b->metadata.callstack);
+      CHECK(a->HasEqualValue(b));
+    }
+  }
+
+  SECTION("Buffers")
+  {
+    StructuredBufferList buffers;
+    for(size_t i = 0; i < 20; i++)
+    {
+      bytebuf *buf = new bytebuf;
+      for(size_t b = 0; b < i * i * 100; b++)
+        buf->push_back(byte((b * i) >> 4));
+      buffers.push_back(buf);
+    }
+
+    res = Buffers2ZIP(filename, rdc, buffers, NULL);
+    REQUIRE(res.code == ResultCode::Succeeded);
+
+    ThumbTypeAndData thumb = {}, extThumb = {};
+    std::map<SectionType, bytebuf> literalFiles;
+    StructuredBufferList readBuffers;
+
+    res = ZIP2Buffers(filename, thumb, extThumb, literalFiles, readBuffers, NULL);
+    REQUIRE(res.code == ResultCode::Succeeded);
+
+    REQUIRE(readBuffers.size() == buffers.size());
+    for(size_t i = 0; i < buffers.size(); i++)
+    {
+      REQUIRE(readBuffers[i]);
+      CHECK(*readBuffers[i] == *buffers[i]);
+    }
+
+    for(bytebuf *buf : buffers)
+      delete buf;
+    for(bytebuf *buf : readBuffers)
+      delete buf;
+
+    FileIO::Delete(strip_extension(filename));
+  }
+
+  FileIO::Delete(filename);
+}
+
 #endif    // ENABLED(ENABLE_UNIT_TESTS)
@@ -22,7 +22,9 @@
  * THE SOFTWARE.
  ******************************************************************************/
 
+#include "common/timing.h"
 #include "lz4io.h"
+#include "rdcfile.h"
 #include "serialiser.h"
 #include "zstdio.h"
 
@@ -190,4 +192,305 @@ TEST_CASE("Test ZSTD compression/decompression", "[streamio][zstd]")
   delete[] randomData;
 };
 
+// fills a buffer with data that compresses somewhat but not trivially, with repeats spanning well
+// beyond one block so that history between blocks matters
+static void FillCompressibleData(byte *data, uint64_t size)
+{
+  uint32_t seed = 0x1234567;
+  for(uint64_t i = 0; i < size; i++)
+  {
+    seed = seed * 1664525U + 1013904223U;
+    if((i & 0xffff) < 0x8000 && i >= 0x30000)
+      data[i] = data[i - 0x30000 + 0x100];
+    else if(seed & 0x80000000)
+      data[i] = byte(i & 0x3f);
+    else
+      data[i] = byte(seed >> 24);
+  }
+}
+
+template <typename Comp, typename Decomp>
+static void CheckParallelRoundTrip(uint32_t numThreads)
+{
+  // not a multiple of either block size, to have a partial block at the end
+  const uint64_t size = 9 * 1024 * 1024 + 12345;
+
+  byte *data = new byte[size];
+  FillCompressibleData(data, size);
+
+  StreamWriter serialBuf(StreamWriter::DefaultScratchSize);
+  StreamWriter parallelBuf(StreamWriter::DefaultScratchSize);
+
+  {
+    StreamWriter writer(new Comp(&serialBuf, Ownership::Nothing, 1), Ownership::Stream);
+    writer.Write(data, size);
+    writer.Finish();
+    CHECK_FALSE(writer.IsErrored());
+  }
+
+  {
+    StreamWriter writer(new Comp(&parallelBuf, Ownership::Nothing, numThreads), Ownership::Stream);
+
+    // write in odd-sized pieces to cross page boundaries mid-write
+    uint64_t offs = 0;
+    while(offs < size)
+    {
+      uint64_t chunk = RDCMIN(size - offs, uint64_t(300 * 1024 + 7));
+      writer.Write(data + offs, chunk);
+      offs += chunk;
+    }
+    writer.Finish();
+    CHECK_FALSE(writer.IsErrored());
+    CHECK(writer.GetOffset() == size);
+  }
+
+  // parallel compression can't be quite as good as serial for lz4 since history resets to a
+  // dictionary each block, but it should be close
+  CHECK(parallelBuf.GetOffset() < serialBuf.GetOffset() + serialBuf.GetOffset() / 20);
+
+  {
+    StreamReader reader(new Decomp(new StreamReader(parallelBuf.GetData(), parallelBuf.GetOffset()),
+                                   Ownership::Stream),
+                        size, Ownership::Stream);
+
+    byte *readData = new byte[size];
+    reader.Read(readData, size);
+
+    CHECK_FALSE(reader.IsErrored());
+    CHECK(reader.AtEnd());
+    CHECK_FALSE(memcmp(readData, data, (size_t)size));
+
+    delete[] readData;
+  }
+
+  delete[] data;
+}
+
+TEST_CASE("Test parallel compression is readable by serial decompression", "[streamio][parallel]")
+{
+  uint32_t numThreads = GENERATE(2, 3, 8);
+
+  SECTION("LZ4")
+  {
+    CheckParallelRoundTrip<LZ4Compressor, LZ4Decompressor>(numThreads);
+  };
+
+  SECTION("ZSTD")
+  {
+    CheckParallelRoundTrip<ZSTDCompressor, ZSTDDecompressor>(numThreads);
+  };
+}
+
+template <typename Comp, typename Decomp>
+static void CheckBlockIndexSeeking(uint32_t numThreads)
+{
+  const uint64_t size = 5 * 1024 * 1024 + 4321;
+
+  byte *data = new byte[size];
+  FillCompressibleData(data, size);
+
+  rdcstr filename = FileIO::GetTempFolderFilename() + "/blockindex.bin";
+
+  {
+    Comp *comp = new Comp(
+        new StreamWriter(FileIO::fopen(filename, FileIO::WriteBinary), Ownership::Stream),
+        Ownership::Stream, numThreads);
+    comp->EnableBlockIndex();
+
+    StreamWriter writer(comp, Ownership::Stream);
+    writer.Write(data, size);
+    writer.Finish();
+    CHECK_FALSE(writer.IsErrored());
+  }
+
+  // readers that don't know about the index should still be able to read everything
+  {
+    StreamReader *fileReader = new StreamReader(FileIO::fopen(filename, FileIO::ReadBinary));
+    StreamReader reader(new Decomp(fileReader, Ownership::Stream), size, Ownership::Stream);
+
+    byte *readData = new byte[size];
+    reader.Read(readData, size);
+
+    CHECK_FALSE(reader.IsErrored());
+    CHECK_FALSE(memcmp(readData, data, (size_t)size));
+
+    delete[] readData;
+  }
+
+  {
+    StreamReader *fileReader = new StreamReader(FileIO::fopen(filename, FileIO::ReadBinary));
+    Decomp *decomp = new Decomp(fileReader, Ownership::Stream);
+
+    CHECK(decomp->ReadBlockIndex());
+    CHECK(decomp->CanSeek());
+
+    StreamReader reader(decomp, size, Ownership::Stream);
+
+    // seek around backwards and forwards, within and across blocks
+    const uint64_t offsets[] = {
+        size - 100, 12345, 3 * 1024 * 1024 + 17, 3 * 1024 * 1024 + 1000, 0,
+        1024 * 1024, 2 * 1024 * 1024 - 5, 64, size - 8,
+    };
+
+    for(uint64_t offs : offsets)
+    {
+      reader.SetOffset(offs);
+      CHECK(reader.GetOffset() == offs);
+
+      byte readData[8] = {};
+      reader.Read(readData, sizeof(readData));
+      CHECK_FALSE(memcmp(readData, data + offs, sizeof(readData)));
+    }
+
+    CHECK_FALSE(reader.IsErrored());
+  }
+
+  FileIO::Delete(filename);
+
+  delete[] data;
+}
+
+TEST_CASE("Test seeking in block indexed compressed streams", "[streamio][seek]")
+{
+  uint32_t numThreads = GENERATE(1, 4);
+
+  SECTION("LZ4")
+  {
+    CheckBlockIndexSeeking<LZ4Compressor, LZ4Decompressor>(numThreads);
+  };
+
+  SECTION("ZSTD")
+  {
+    CheckBlockIndexSeeking<ZSTDCompressor, ZSTDDecompressor>(numThreads);
+  };
+}
+
+static void CheckBlockIndexedCapture(SectionFlags compression)
+{
+  const uint64_t size = 3 * 1024 * 1024 + 789;
+
+  byte *data = new byte[size];
+  FillCompressibleData(data, size);
+
+  rdcstr filename = FileIO::GetTempFolderFilename() + "/blockindex.rdc";
+
+  {
+    RDCFile rdc;
+    rdc.SetData(RDCDriver::Unknown, "Test", 0, NULL, 0, 1.0);
+    rdc.Create(filename);
+    REQUIRE(rdc.Error().code == ResultCode::Succeeded);
+
+    SectionProperties props = {};
+    props.type = SectionType::FrameCapture;
+    props.flags = compression | SectionFlags::BlockIndexed;
+    props.version = 1;
+
+    StreamWriter *writer = rdc.WriteSection(props);
+    writer->Write(data, size);
+    writer->Finish();
+    CHECK_FALSE(writer->IsErrored());
+    delete writer;
+  }
+
+  bytebuf contents;
+  REQUIRE(FileIO::ReadAll(filename, contents));
+  FileIO::Delete(filename);
+
+  // the index is written even though nothing asked for it beyond the section flag
+  {
+    RDCFile rdc;
+    rdc.Open(contents);
+    REQUIRE(rdc.Error().code == ResultCode::Succeeded);
+    REQUIRE(rdc.NumSections() == 1);
+    CHECK(rdc.GetSectionProperties(0).flags == (compression | SectionFlags::BlockIndexed));
+    CHECK(rdc.SupportsConcurrentReads(0));
+
+    StreamReader *reader = rdc.ReadSection(0);
+    reader->SetOffset(size - 1000);
+
+    byte readData[16] = {};
+    reader->Read(readData, sizeof(readData));
+    CHECK_FALSE(reader->IsErrored());
+    CHECK_FALSE(memcmp(readData, data + size - 1000, sizeof(readData)));
+    delete reader;
+  }
+
+  // break the footer magic, as if an older build had written the section without an index but
+  // kept the flag. That must not be trusted for seeking, but the section is still readable.
+  const byte magic[] = {'R', 'D', 'B', 'I'};
+  size_t magicOffset = contents.size() - sizeof(magic);
+  while(magicOffset > 0 && memcmp(contents.data() + magicOffset, magic, sizeof(magic)) != 0)
+    magicOffset--;
+  REQUIRE(magicOffset > 0);
+  contents[magicOffset] = 'X';
+
+  {
+    RDCFile rdc;
+    rdc.Open(contents);
+    REQUIRE(rdc.Error().code == ResultCode::Succeeded);
+    CHECK_FALSE(rdc.SupportsConcurrentReads(0));
+
+    StreamReader *reader = rdc.ReadSection(0);
+
+    byte *readData = new byte[size];
+    reader->Read(readData, size);
+    CHECK_FALSE(reader->IsErrored());
+    CHECK_FALSE(memcmp(readData, data, (size_t)size));
+    delete[] readData;
+    delete reader;
+  }
+
+  delete[] data;
+}
+
+TEST_CASE("Test block indexed capture sections", "[streamio][seek]")
+{
+  SECTION("LZ4")
+  {
+    CheckBlockIndexedCapture(SectionFlags::LZ4Compressed);
+  };
+
+  SECTION("ZSTD")
+  {
+    CheckBlockIndexedCapture(SectionFlags::ZstdCompressed);
+  };
+}
+
+template <typename Comp>
+static double CompressionThroughput(const byte *data, uint64_t size, uint32_t numThreads)
+{
+  StreamWriter buf(StreamWriter::DefaultScratchSize);
+
+  PerformanceTimer timer;
+
+  {
+    StreamWriter writer(new Comp(&buf, Ownership::Nothing, numThreads), Ownership::Stream);
+    writer.Write(data, size);
+    writer.Finish();
+  }
+
+  // MB/s
+  return (double(size) / (1024.0 * 1024.0)) / (RDCMAX(timer.GetMilliseconds(), 0.001) / 1000.0);
+}
+
+// not run by default, this is for measuring scaling rather than correctness
+TEST_CASE("Benchmark parallel compression throughput", "[.][streamio][benchmark]")
+{
+  const uint64_t size = 256 * 1024 * 1024;
+
+  byte *data = new byte[size];
+  FillCompressibleData(data, size);
+
+  uint32_t maxThreads = RDCMAX(1U, Threading::NumberOfCores());
+
+  for(uint32_t numThreads = 1; numThreads <= maxThreads; numThreads *= 2)
+  {
+    RDCLOG("%u threads: LZ4 %.1f MB/s, ZSTD %.1f MB/s", numThreads,
+           CompressionThroughput<LZ4Compressor>(data, size, numThreads),
+           CompressionThroughput<ZSTDCompressor>(data, size, numThreads));
+  }
+
+  delete[] data;
+}
+
 #endif    // ENABLED(ENABLE_UNIT_TESTS)
@@ -26,29 +26,81 @@
 
 static const uint64_t lz4BlockSize = 1024 * 1024;
 
-LZ4Compressor::LZ4Compressor(StreamWriter *write, Ownership own) : Compressor(write, own)
+// lz4 can reference up to 64kb back, so that's how much history each block needs in parallel mode
+static const uint64_t lz4HistorySize = 64 * 1024;
+
+LZ4Compressor::LZ4Compressor(StreamWriter *write, Ownership own, uint32_t numThreads)
+    : Compressor(write, own)
 {
+  m_PageOffset = 0;
+
+  if(numThreads > 1)
+  {
+    // each block is compressed with its own stream, primed with the end of the previous block as a
+    // dictionary. That means each block references the same history as when compressing serially,
+    // so the normal streaming decompression works unmodified.
+    m_WorkerLZ4Comp.resize(numThreads);
+    for(uint32_t i = 0; i < numThreads; i++)
+      m_WorkerLZ4Comp[i] = LZ4_createStream();
+
+    m_Parallel = new ParallelCompression(
+        numThreads, lz4BlockSize, LZ4_COMPRESSBOUND(lz4BlockSize), lz4HistorySize,
+        [this](uint32_t worker, const byte *history, uint64_t historySize, const byte *in,
+               uint64_t inSize, byte *out) -> int64_t {
+          LZ4_stream_t *stream = m_WorkerLZ4Comp[worker];
+
+          // loading a dictionary also resets the stream, so we don't carry state from whichever
+          // block this worker compressed last
+          LZ4_loadDict(stream, (const char *)history, (int)historySize);
+
+          return LZ4_compress_fast_continue(stream, (const char *)in, (char *)out, (int)inSize,
+                                            (int)LZ4_COMPRESSBOUND(lz4BlockSize), 20);
+        });
+
+    m_Page[0] = m_Parallel->GetPage();
+    m_Page[1] = m_CompressBuffer = NULL;
+
+    m_LZ4Comp = NULL;
+    return;
+  }
+
   m_Page[0] = AllocAlignedBuffer(lz4BlockSize);
   m_Page[1] = AllocAlignedBuffer(lz4BlockSize);
   m_CompressBuffer = AllocAlignedBuffer(LZ4_COMPRESSBOUND(lz4BlockSize));
 
-  m_PageOffset = 0;
-
   m_LZ4Comp = LZ4_createStream();
 }
 
 LZ4Compressor::~LZ4Compressor()
 {
-  FreeAlignedBuffer(m_Page[0]);
-  FreeAlignedBuffer(m_Page[1]);
-  FreeAlignedBuffer(m_CompressBuffer);
-  LZ4_freeStream(m_LZ4Comp);
+  FreeBuffers();
+
+  // this will wait for any outstanding work, though normally Finish() has already flushed it
+  SAFE_DELETE(m_Parallel);
+
+  for(LZ4_stream_t *stream : m_WorkerLZ4Comp)
+    LZ4_freeStream(stream);
+
+  if(m_LZ4Comp)
+    LZ4_freeStream(m_LZ4Comp);
+}
+
+void LZ4Compressor::FreeBuffers()
+{
+  // in parallel mode the pages are owned by m_Parallel
+  if(!m_Parallel)
+  {
+    FreeAlignedBuffer(m_Page[0]);
+    FreeAlignedBuffer(m_Page[1]);
+    FreeAlignedBuffer(m_CompressBuffer);
+  }
+  m_Page[0] = m_Page[1] = m_CompressBuffer = NULL;
 }
 
 bool LZ4Compressor::Write(const void *data, uint64_t numBytes)
 {
   // if we encountered a stream error this will be NULL
-  if(!m_CompressBuffer)
+  if(!m_Page[0])
     return false;
 
   if(numBytes == 0)
@@ -58,6 +110,7 @@ bool LZ4Compressor::Write(const void *data, uint64_t numBytes)
   // Write into page N incrementally until it is completely full. When full, flush it out to lz4 and
   // swap pages.
   // This keeps lz4 happy with 1 block of history each time it compresses.
+  // In parallel mode m_Page[0] is always the page that will be submitted next, so this is the same.
   // If we are writing some data the crosses the boundary between pages, we write the part that will
   // fit on one page, flush & swap, write the rest into the next page.
 
@@ -115,15 +168,57 @@ bool LZ4Compressor::Finish()
   // uniform in size
   // only the last one can be smaller, so we only write a partial page when finishing.
   // Calling Write() after Finish() is illegal
-  return FlushPage0();
+  bool success = FlushPage0();
+
+  if(m_Parallel && success)
+  {
+    success &= m_Parallel->Flush(m_Write, m_Error);
+
+    if(!success)
+      FreeBuffers();
+  }
+
+  if(m_BlockIndexed && success)
+    success &= WriteBlockIndex(lz4BlockSize);
+
+  return success;
+}
+
+void LZ4Compressor::EnableBlockIndex()
+{
+  Compressor::EnableBlockIndex();
+
+  if(m_Parallel)
+    m_Parallel->SetBlockIndex(&m_BlockOffsets);
 }
 
 bool LZ4Compressor::FlushPage0()
 {
   // if we encountered a stream error this will be NULL
-  if(!m_CompressBuffer)
+  if(!m_Page[0])
     return false;
 
+  if(m_Parallel)
+  {
+    bool success = m_Parallel->SubmitPage(m_PageOffset, m_Write, m_Error);
+
+    if(!success)
+    {
+      FreeBuffers();
+      return false;
+    }
+
+    // continue in the next free page
+    m_Page[0] = m_Parallel->GetPage();
+    m_PageOffset = 0;
+
+    return success;
+  }
+
+  // for an independent block, forget the history of the previous page
+  if(m_BlockIndexed)
+    LZ4_resetStream_fast(m_LZ4Comp);
+
   // m_PageOffset is the amount written, usually equal to lz4BlockSize except the last block.
   int32_t compSize =
       LZ4_compress_fast_continue(m_LZ4Comp, (const char *)m_Page[0], (char *)m_CompressBuffer,
@@ -131,14 +226,13 @@ bool LZ4Compressor::FlushPage0()
 
   if(compSize < 0)
   {
-    FreeAlignedBuffer(m_Page[0]);
-    FreeAlignedBuffer(m_Page[1]);
-    FreeAlignedBuffer(m_CompressBuffer);
-    m_Page[0] = m_Page[1] = m_CompressBuffer = NULL;
+    FreeBuffers();
     SET_ERROR_RESULT(m_Error, ResultCode::CompressionFailed, "LZ4 compression failed: %i", compSize);
     return false;
   }
 
+  RecordBlock();
+
   bool success = true;
 
   success &= m_Write->Write(compSize);
@@ -184,7 +278,7 @@ bool LZ4Decompressor::Recompress(Compressor *comp)
 {
   bool success = true;
 
-  while(success && !m_Read->AtEnd())
+  while(success && !AtDataEnd())
   {
     success &= FillPage0();
     if(success)
@@ -260,6 +354,14 @@ bool LZ4Decompressor::Read(void *data, uint64_t numBytes)
   return success;
 }
 
+void LZ4Decompressor::ResetBlock()
+{
+  LZ4_setStreamDecode(m_LZ4Decomp, NULL, 0);
+
+  m_PageOffset = 0;
+  m_PageLength = 0;
+}
+
 bool LZ4Decompressor::FillPage0()
 {
   // swap pages
@@ -30,20 +30,28 @@
 class LZ4Compressor : public Compressor
 {
 public:
-  LZ4Compressor(StreamWriter *write, Ownership own);
+  // if numThreads is greater than 1, blocks are compressed in parallel on that many threads
+  LZ4Compressor(StreamWriter *write, Ownership own, uint32_t numThreads = 1);
   ~LZ4Compressor();
 
   bool Write(const void *data, uint64_t numBytes);
   bool Finish();
+  void EnableBlockIndex();
 
 private:
   bool FlushPage0();
+  void FreeBuffers();
 
   byte *m_Page[2];
   byte *m_CompressBuffer;
   uint64_t m_PageOffset;
 
   LZ4_stream_t *m_LZ4Comp;
+
+  // only used when compressing in parallel, with one stream per worker thread. m_Page[0] is then
+  // owned by m_Parallel and m_Page[1]/m_CompressBuffer are unused
+  ParallelCompression *m_Parallel = NULL;
+  rdcarray<LZ4_stream_t *> m_WorkerLZ4Comp;
 };
 
 class LZ4Decompressor : public Decompressor
@@ -56,6 +64,7 @@ public:
   bool Read(void *data, uint64_t numBytes);
 
 private:
+  void ResetBlock();
   bool FillPage0();
 
   byte *m_Page[2];
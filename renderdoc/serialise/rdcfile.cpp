@@ -27,11 +27,34 @@
 #include "api/replay/version.h"
 #include "common/dds_readwrite.h"
 #include "common/formatting.h"
+#include "core/settings.h"
 #include "jpeg-compressor/jpge.h"
 #include "stb/stb_image.h"
 #include "lz4io.h"
 #include "zstdio.h"
 
+RDOC_CONFIG(uint32_t, Capture_CompressionThreads, 0,
+            "The number of threads to use when compressing sections written to capture files. "
+            "0 selects a number automatically, 1 compresses on the writing thread.");
+
+RDOC_CONFIG(bool, Replay_ReadAheadDecompression, true,
+            "Decompress large capture sections ahead of reading them on a worker thread, so that "
+            "decompression overlaps with parsing when loading captures.");
+
+// below this size the section is read too quickly for a worker thread to be worthwhile
+static const uint64_t MinReadAheadSectionSize = 4 * 1024 * 1024;
+
+static uint32_t GetCompressionThreads()
+{
+  uint32_t numThreads = Capture_CompressionThreads();
+
+  // don't take too many cores away from the application or replay
+  if(numThreads == 0)
+    numThreads = RDCCLAMP(Threading::NumberOfCores() / 2, 1U, 8U);
+
+  return numThreads;
+}
+
 // not provided by tinyexr, just do by hand
 bool is_exr_file(const byte *headerBuffer, size_t size)
 {
@@ -229,10 +252,25 @@ struct BinarySectionHeader
 
 RDCFile::~RDCFile()
 {
+  UnmapFile();
+
   if(m_File)
     FileIO::fclose(m_File);
 }
 
+void RDCFile::MapFile()
+{
+  if(m_File && !m_Mapping)
+    m_Mapping = FileIO::MapFileForRead(m_File, m_MappingSize);
+}
+
+void RDCFile::UnmapFile()
+{
+  FileIO::UnmapFile(m_Mapping, m_MappingSize);
+  m_Mapping = NULL;
+  m_MappingSize = 0;
+}
+
 void RDCFile::Open(const rdcstr &path)
 {
   // silently fail when opening the empty string, to allow 'releasing' a capture file by opening an
@@ -294,6 +332,9 @@ void RDCFile::Open(const rdcstr &path)
   StreamReader reader(m_File, fileSize, Ownership::Nothing);
 
   Init(reader);
+
+  if(m_Error == ResultCode::Succeeded)
+    MapFile();
 }
 
 void RDCFile::Open(const bytebuf &buffer)
@@ -301,7 +342,7 @@ void RDCFile::Open(const bytebuf &buffer)
   m_Buffer = buffer;
   m_File = NULL;
 
-  StreamReader reader(m_Buffer);
+  StreamReader reader(StreamReader::BorrowedStream, m_Buffer.data(), m_Buffer.size());
 
   Init(reader);
 }
@@ -682,6 +723,8 @@ RDResult RDCFile::CopyFileTo(const rdcstr &filename)
     RETURN_ERROR_RESULT(ResultCode::FileIOFailed, "Capture file '%s' is not currently open",
                         m_Filename.c_str(), errno);
 
+  UnmapFile();
+
   // remember our position and close the file
   uint64_t prevPos = FileIO::ftell64(m_File);
   FileIO::fclose(m_File);
@@ -703,6 +746,8 @@ RDResult RDCFile::CopyFileTo(const rdcstr &filename)
   m_File = FileIO::fopen(m_Filename, FileIO::ReadBinary);
   FileIO::fseek64(m_File, prevPos, SEEK_SET);
 
+  MapFile();
+
   return ret;
 }
 
@@ -865,16 +910,57 @@ int RDCFile::SectionIndex(const rdcstr &name) const
   return -1;
 }
 
-StreamReader *RDCFile::ReadSection(int index) const
+bool RDCFile::SupportsConcurrentReads(int index) const
+{
+  if(m_Error != ResultCode::Succeeded || index < 0 || index >= (int)m_Sections.size())
+    return false;
+
+  // memory sections are independent buffers
+  if(m_File == NULL && index < (int)m_MemorySections.size())
+    return true;
+
+  if((m_File == NULL && m_Buffer.empty()) || index >= (int)m_SectionLocations.size())
+    return false;
+
+  // file sections need to come from the mapping, since readers straight from the file share its
+  // position
+  const SectionLocation &loc = m_SectionLocations[index];
+  if(m_File != NULL && (m_Mapping == NULL || loc.dataOffset + loc.diskLength > m_MappingSize))
+    return false;
+
+  const SectionProperties &props = m_Sections[index];
+
+  // compressed sections can only seek if they were written with a block index. The flag alone isn't
+  // enough, a build that doesn't know about the index could have re-written the section and kept
+  // the flag without writing a new index
+  if(props.flags & (SectionFlags::LZ4Compressed | SectionFlags::ZstdCompressed))
+  {
+    if(!(props.flags & SectionFlags::BlockIndexed))
+      return false;
+
+    const byte *data = m_File ? m_Mapping : m_Buffer.data();
+    StreamReader reader(StreamReader::BorrowedStream, data + loc.dataOffset, loc.diskLength);
+
+    if(props.flags & SectionFlags::LZ4Compressed)
+      return LZ4Decompressor(&reader, Ownership::Nothing).ReadBlockIndex();
+    return ZSTDDecompressor(&reader, Ownership::Nothing).ReadBlockIndex();
+  }
+
+  return true;
+}
+
+StreamReader *RDCFile::ReadSection(int index, bool readAhead) const
 {
   if(m_Error != ResultCode::Succeeded)
     return new StreamReader(StreamReader::InvalidStream, m_Error);
 
-  if(m_File == NULL)
-  {
-    if(index < (int)m_MemorySections.size())
-      return new StreamReader(m_MemorySections[index]);
+  // sections written in memory are stored directly without compression
+  if(m_File == NULL && index < (int)m_MemorySections.size())
+    return new StreamReader(m_MemorySections[index]);
 
+  // if we were opened from a buffer, the sections are in there at the same locations as in a file
+  if((m_File == NULL && m_Buffer.empty()) || index >= (int)m_SectionLocations.size())
+  {
     RDResult res;
     SET_ERROR_RESULT(res, ResultCode::InvalidParameter,
                      "Section %d is not available in this capture file.", index);
@@ -883,27 +969,67 @@ StreamReader *RDCFile::ReadSection(int index) const
 
   const SectionProperties &props = m_Sections[index];
   SectionLocation offsetSize = m_SectionLocations[index];
-  FileIO::fseek64(m_File, offsetSize.dataOffset, SEEK_SET);
 
-  StreamReader *fileReader = new StreamReader(m_File, offsetSize.diskLength, Ownership::Nothing);
+  const bool compressed =
+      bool(props.flags & (SectionFlags::LZ4Compressed | SectionFlags::ZstdCompressed));
 
-  StreamReader *compReader = NULL;
+  readAhead = readAhead && compressed && Replay_ReadAheadDecompression() &&
+              props.uncompressedSize >= MinReadAheadSectionSize;
 
-  if(props.flags & SectionFlags::LZ4Compressed)
+  StreamReader *fileReader = NULL;
+
+  if(m_File == NULL)
   {
-    // the user will delete the compressed reader, and then it will delete the compressor and the
-    // file reader
-    compReader = new StreamReader(new LZ4Decompressor(fileReader, Ownership::Stream),
-                                  props.uncompressedSize, Ownership::Stream);
+    if(offsetSize.dataOffset + offsetSize.diskLength > m_Buffer.size())
+    {
+      RDResult res;
+      SET_ERROR_RESULT(res, ResultCode::FileCorrupted, "Section %d is truncated.", index);
+      return new StreamReader(StreamReader::InvalidStream, res);
+    }
+
+    fileReader = new StreamReader(StreamReader::BorrowedStream,
+                                  m_Buffer.data() + offsetSize.dataOffset, offsetSize.diskLength);
+  }
+  else if(m_Mapping && offsetSize.dataOffset + offsetSize.diskLength <= m_MappingSize)
+  {
+    // uncompressed sections can be read straight out of the mapping, so large buffers inside them
+    // don't need to be copied. Compressed sections also read from here so that readers on
+    // different threads, including read-ahead workers, don't share the file position
+    fileReader = new StreamReader(StreamReader::BorrowedStream, m_Mapping + offsetSize.dataOffset,
+                                  offsetSize.diskLength);
   }
+  else
+  {
+    FileIO::fseek64(m_File, offsetSize.dataOffset, SEEK_SET);
+
+    fileReader = new StreamReader(m_File, offsetSize.diskLength, Ownership::Nothing);
+
+    // the FILE handle is shared with any other section being read, so a worker reading from it
+    // would race with their seeks
+    readAhead = false;
+  }
+
+  Decompressor *decompressor = NULL;
+
+  if(props.flags & SectionFlags::LZ4Compressed)
+    decompressor = new LZ4Decompressor(fileReader, Ownership::Stream);
   else if(props.flags & SectionFlags::ZstdCompressed)
+    decompressor = new ZSTDDecompressor(fileReader, Ownership::Stream);
+
+  if(decompressor)
   {
-    compReader = new StreamReader(new ZSTDDecompressor(fileReader, Ownership::Stream),
-                                  props.uncompressedSize, Ownership::Stream);
+    // load the index if there is one so the reader can seek. If it's invalid the section can still
+    // be read from start to finish
+    if(props.flags & SectionFlags::BlockIndexed)
+      decompressor->ReadBlockIndex();
+
+    // the user will delete the compressed reader, and then it will delete the decompressor and the
+    // file reader
+    return new StreamReader(decompressor, props.uncompressedSize, Ownership::Stream, readAhead);
   }
 
-  // if we're compressing return that writer, otherwise return the file writer directly
-  return compReader ? compReader : fileReader;
+  // if we're not compressing return the file reader directly
+  return fileReader;
 }
 
 StreamWriter *RDCFile::WriteSection(const SectionProperties &props)
@@ -930,6 +1056,9 @@ StreamWriter *RDCFile::WriteSection(const SectionProperties &props)
     return w;
   }
 
+  // the file can't stay mapped while we modify it
+  UnmapFile();
+
   // re-open the file as read-write
   {
     uint64_t offs = FileIO::ftell64(m_File);
@@ -942,6 +1071,7 @@ StreamWriter *RDCFile::WriteSection(const SectionProperties &props)
       m_File = FileIO::fopen(m_Filename, FileIO::ReadBinary);
       if(m_File)
         FileIO::fseek64(m_File, offs, SEEK_SET);
+      MapFile();
       return new StreamWriter(StreamWriter::InvalidStream);
     }
 
@@ -1212,19 +1342,23 @@ StreamWriter *RDCFile::WriteSection(const SectionProperties &props)
   StreamWriter *fileWriter =
       new StreamWriter(FileWriter::MakeThreaded(m_File, Ownership::Nothing), Ownership::Stream);
 
-  StreamWriter *compWriter = NULL;
+  Compressor *compressor = NULL;
 
   if(props.flags & SectionFlags::LZ4Compressed)
+    compressor = new LZ4Compressor(fileWriter, Ownership::Stream, GetCompressionThreads());
+  else if(props.flags & SectionFlags::ZstdCompressed)
+    compressor = new ZSTDCompressor(fileWriter, Ownership::Stream, GetCompressionThreads());
+
+  StreamWriter *compWriter = NULL;
+
+  if(compressor)
   {
+    if(props.flags & SectionFlags::BlockIndexed)
+      compressor->EnableBlockIndex();
+
     // the user will delete the compressed writer, and then it will delete the compressor and the
     // file writer
-    compWriter =
-        new StreamWriter(new LZ4Compressor(fileWriter, Ownership::Stream), Ownership::Stream);
-  }
-  else if(props.flags & SectionFlags::ZstdCompressed)
-  {
-    compWriter =
-        new StreamWriter(new ZSTDCompressor(fileWriter, Ownership::Stream), Ownership::Stream);
+    compWriter = new StreamWriter(compressor, Ownership::Stream);
   }
 
   uint64_t dataOffset = FileIO::ftell64(m_File);
@@ -1287,6 +1421,8 @@ StreamWriter *RDCFile::WriteSection(const SectionProperties &props)
     // re-open the file and re-seek
     m_File = FileIO::fopen(m_Filename, FileIO::ReadBinary);
     FileIO::fseek64(m_File, prevPos, SEEK_SET);
+
+    MapFile();
   });
 
   // if we're compressing return that writer, otherwise return the file writer directly
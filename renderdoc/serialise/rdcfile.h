@@ -75,6 +75,8 @@ public:
   void Create(const rdcstr &filename);
 
   bool IsUntrusted() const { return m_Untrusted; }
+  // empty if the file was opened from memory
+  const rdcstr &GetFilename() const { return m_Filename; }
   const RDResult &Error() const { return m_Error; }
   RDCDriver GetDriver() const { return m_Driver; }
   const rdcstr &GetDriverName() const { return m_DriverName; }
@@ -86,7 +88,12 @@ public:
   int SectionIndex(const rdcstr &name) const;
   int NumSections() const { return int(m_Sections.size()); }
   const SectionProperties &GetSectionProperties(int index) const { return m_Sections[index]; }
-  StreamReader *ReadSection(int index) const;
+  // readAhead allows large compressed sections to be decompressed on a separate thread, which is
+  // only worthwhile when reading most of the section from start to finish
+  StreamReader *ReadSection(int index, bool readAhead = true) const;
+  // returns true if the section can be read through several readers on different threads at once,
+  // and those readers can seek without decompressing everything before the new offset.
+  bool SupportsConcurrentReads(int index) const;
   StreamWriter *WriteSection(const SectionProperties &props);
 
   // Only valid if GetDriver returns RDCDriver::Image, passes over the underlying FILE * for use
@@ -95,11 +102,18 @@ public:
 
 private:
   void Init(StreamReader &reader);
+  void MapFile();
+  void UnmapFile();
 
   FILE *m_File = NULL;
   rdcstr m_Filename;
   bytebuf m_Buffer;
 
+  // read-only mapping of m_File, if possible, so that uncompressed sections can be read without
+  // copying. This is unmapped whenever the file is modified, so readers must not be alive then.
+  const byte *m_Mapping = NULL;
+  uint64_t m_MappingSize = 0;
+
   SectionProperties m_CurrentWritingProps;
 
   uint32_t m_SerVer = 0;
@@ -197,7 +197,8 @@ uint32_t Serialiser<SerialiserMode::Reading>::BeginChunk(uint32_t, uint64_t)
     if(name.empty())
       name = "<Unknown Chunk>";
 
-    SDChunk *chunk = new SDChunk(name);
+    SDObjectArena *arena = m_StructuredFile->GetArena();
+    SDChunk *chunk = arena ? arena->NewChunk(arena->Intern(name)) : new SDChunk(name);
     chunk->metadata = m_ChunkMetadata;
 
     m_StructuredFile->chunks.push_back(chunk);
@@ -219,7 +220,8 @@ void Serialiser<SerialiserMode::Reading>::SkipCurrentChunk()
 
     SDObject &current = *m_StructureStack.back();
 
-    SDObject &obj = *current.AddAndOwnChild(new SDObject("Opaque chunk"_lit, "Byte Buffer"_lit));
+    SDObject &obj =
+        *current.AddAndOwnChild(NewStructuredObject("Opaque chunk"_lit, "Byte Buffer"_lit));
 
     obj.type.basetype = SDBasic::Buffer;
     obj.type.byteSize = m_ChunkMetadata.length;
@@ -1097,68 +1099,149 @@ Chunk *Chunk::Create(Serialiser<SerialiserMode::Writing> &ser, uint16_t chunkTyp
   return ret;
 }
 
+struct ChunkPageNode
+{
+  // the current ID of the page. IDs are odd while the page is held by an allocator and even while
+  // it's free or trimmed. Whoever changes the ID from odd to even moves the page to the free list,
+  // so it can only be freed once.
+  int64_t ID;
+  // this page's index in the pool, and the index + 1 of the next page in the free list
+  int64_t index;
+  int64_t next;
+
+  // NULL if the page has been trimmed
+  byte *bufferBase;
+  byte *chunkBase;
+};
+
 ChunkPagePool::~ChunkPagePool()
 {
-  // all allocated pages are in precisely one list, so just free the contents of both lists
-  for(ChunkPage &p : freePages)
+  // every page has a node, whether it's allocated, free, or trimmed
+  for(ChunkPageNode *node : m_AllPages)
   {
-    FreeAlignedBuffer(p.chunkBase);
-    FreeAlignedBuffer(p.bufferBase);
+    FreeAlignedBuffer(node->chunkBase);
+    FreeAlignedBuffer(node->bufferBase);
+    delete node;
   }
+}
+
+int64_t ChunkPagePool::NewID(bool live)
+{
+  return Atomic::Inc64(&m_ID) * 2 + (live ? 1 : 0);
+}
 
-  for(ChunkPage &p : allocatedPages)
+void ChunkPagePool::PushFreePage(ChunkPageNode *node)
+{
+  int64_t head;
+  do
   {
-    FreeAlignedBuffer(p.chunkBase);
-    FreeAlignedBuffer(p.bufferBase);
-  }
+    head = Atomic::CmpExch64(&m_FreeHead, 0, 0);
+    node->next = head;
+  } while(Atomic::CmpExch64(&m_FreeHead, head, node->index + 1) != head);
+}
+
+ChunkPageNode *ChunkPagePool::PopFreePage()
+{
+  // must be called with m_Lock held. Other threads can push concurrently, but nothing else can pop
+  // so the head page's next pointer can't change underneath us
+  int64_t head;
+  do
+  {
+    head = Atomic::CmpExch64(&m_FreeHead, 0, 0);
+    if(head == 0)
+      return NULL;
+  } while(Atomic::CmpExch64(&m_FreeHead, head, m_AllPages[head - 1]->next) != head);
+
+  return m_AllPages[head - 1];
 }
 
 ChunkPage ChunkPagePool::AllocPage()
 {
-  if(!freePages.empty())
+  rdcarray<ChunkPage> pages;
+  AllocPages(pages, 1);
+  return pages[0];
+}
+
+void ChunkPagePool::AllocPages(rdcarray<ChunkPage> &pages, size_t count)
+{
+  size_t first = pages.size();
+  pages.reserve(first + count);
+
   {
-    // if there's a free page, move it to the allocated list and return it
-    ChunkPage free = freePages.back();
-    freePages.pop_back();
-    allocatedPages.push_back(free);
+    SCOPED_LOCK(m_Lock);
+
+    for(size_t i = 0; i < count; i++)
+    {
+      // if there's a free page, use it. Otherwise re-use a trimmed page or create a new one
+      ChunkPageNode *node = PopFreePage();
+
+      if(!node && !m_TrimmedPages.empty())
+      {
+        node = m_TrimmedPages.back();
+        m_TrimmedPages.pop_back();
+      }
+
+      if(!node)
+      {
+        node = new ChunkPageNode;
+        node->index = (int64_t)m_AllPages.size();
+        node->next = 0;
+        node->bufferBase = node->chunkBase = NULL;
+        m_AllPages.push_back(node);
+      }
+
+      node->ID = NewID(true);
+
+      pages.push_back({node, node->ID, node->bufferBase, node->bufferBase, node->chunkBase,
+                       node->chunkBase});
+    }
   }
-  else
+
+  // allocate memory outside of the lock for any pages that need it. Nothing else can touch these
+  // nodes until we've handed them out
+  for(size_t i = first; i < pages.size(); i++)
   {
-    // otherwise allocate a new one straight into the allocated list
-    byte *buffers = ::AllocAlignedBuffer(BufferPageSize);
-    byte *chunks = ::AllocAlignedBuffer(ChunkPageSize);
-    allocatedPages.push_back({m_ID++, buffers, buffers, chunks, chunks});
+    ChunkPage &p = pages[i];
+    if(p.bufferBase == NULL)
+    {
+      p.node->bufferBase = p.bufferBase = p.bufferHead = ::AllocAlignedBuffer(BufferPageSize);
+      p.node->chunkBase = p.chunkBase = p.chunkHead = ::AllocAlignedBuffer(ChunkPageSize);
+    }
   }
 
-  return allocatedPages.back();
+  Atomic::ExchAdd64(&m_LivePages, (int64_t)count);
 }
 
 void ChunkPagePool::Trim()
 {
+  SCOPED_LOCK(m_Lock);
+
   // truly release any currently free pages back to the system
-  for(ChunkPage &p : freePages)
+  while(ChunkPageNode *node = PopFreePage())
   {
-    FreeAlignedBuffer(p.chunkBase);
-    FreeAlignedBuffer(p.bufferBase);
+    FreeAlignedBuffer(node->chunkBase);
+    FreeAlignedBuffer(node->bufferBase);
+    node->bufferBase = node->chunkBase = NULL;
+    m_TrimmedPages.push_back(node);
   }
-
-  freePages.clear();
 }
 
 void ChunkPagePool::Reset()
 {
-  // forcibly move all allocated pages into the free list
-  freePages.append(allocatedPages);
-  allocatedPages.clear();
+  SCOPED_LOCK(m_Lock);
 
-  for(ChunkPage &p : freePages)
+  // forcibly move all allocated pages into the free list
+  for(ChunkPageNode *node : m_AllPages)
   {
-    // reset head pointers
-    p.bufferHead = p.bufferBase;
-    p.chunkHead = p.chunkBase;
+    int64_t ID = Atomic::CmpExch64(&node->ID, 0, 0);
 
-    // assign a new ID so these pages can't get reset again by any allocator currently holding them
-    p.ID = m_ID++;
+    // assign a new ID so these pages can't get reset again by any allocator currently holding them.
+    // If an allocator is returning this page concurrently, only one of us will succeed
+    if((ID & 1) && Atomic::CmpExch64(&node->ID, ID, NewID(false)) == ID)
+    {
+      PushFreePage(node);
+      Atomic::Dec64(&m_LivePages);
+    }
   }
 }
 
@@ -1167,28 +1250,42 @@ void ChunkPagePool::ResetPageSet(const rdcarray<ChunkPage> &pages)
   // iterate over each page being freed
   for(const ChunkPage &p : pages)
   {
-    // try to find it in the allocated page list. This compares by ID, so if the page was already
-    // freed with a pool reset we won't find it at all because it will have a new ID - that's fine.
-    int32_t idx = allocatedPages.indexOf(p);
-    if(idx >= 0)
+    // this compares by ID, so if the page was already freed with a pool reset we won't change it -
+    // that's fine. Otherwise give it a new ID so it can't be freed again, and move it to the free
+    // list. The head pointers are reset when the page is next handed out.
+    if(Atomic::CmpExch64(&p.node->ID, p.ID, NewID(false)) == p.ID)
     {
-      ChunkPage &alloc = allocatedPages[idx];
-      // give a new ID to be safe
-      alloc.ID = m_ID++;
-      // reset head pointers
-      alloc.bufferHead = alloc.bufferBase;
-      alloc.chunkHead = alloc.chunkBase;
-      // move to free list
-      freePages.push_back(alloc);
-      // allocatedPages is not sorted, swap with the back and pop to avoid expensive erases in the
-      // middle of the list
-      std::swap(allocatedPages[idx], allocatedPages.back());
-      allocatedPages.pop_back();
-      continue;
+      PushFreePage(p.node);
+      Atomic::Dec64(&m_LivePages);
     }
   }
 }
 
+void ChunkPagePool::RecordRetiredPage(size_t wastedBytes)
+{
+  Atomic::Inc64(&m_RetiredPages);
+  Atomic::ExchAdd64(&m_WastedBytes, (int64_t)wastedBytes);
+}
+
+ChunkPagePoolStats ChunkPagePool::GetStats()
+{
+  ChunkPagePoolStats ret = {};
+
+  ret.pageSize = BufferPageSize;
+  ret.retiredPages = (uint64_t)Atomic::CmpExch64(&m_RetiredPages, 0, 0);
+  ret.wastedBytes = (uint64_t)Atomic::CmpExch64(&m_WastedBytes, 0, 0);
+
+  SCOPED_LOCK(m_Lock);
+
+  int64_t live = Atomic::CmpExch64(&m_LivePages, 0, 0);
+  int64_t withMemory = int64_t(m_AllPages.size() - m_TrimmedPages.size());
+
+  ret.livePages = (uint64_t)live;
+  ret.freePages = withMemory > live ? uint64_t(withMemory - live) : 0;
+
+  return ret;
+}
+
 ChunkAllocator::~ChunkAllocator()
 {
   // move any pages we have back to the pool on destruction
@@ -1204,10 +1301,13 @@ void ChunkAllocator::swap(ChunkAllocator &alloc)
         "crashing");
     pages.clear();
     alloc.pages.clear();
+    spares.clear();
+    alloc.spares.clear();
     return;
   }
 
   pages.swap(alloc.pages);
+  spares.swap(alloc.spares);
 }
 
 byte *ChunkAllocator::AllocAlignedBuffer(uint64_t size)
@@ -1225,7 +1325,9 @@ byte *ChunkAllocator::AllocChunk()
 void ChunkAllocator::Reset()
 {
   m_Pool.ResetPageSet(pages);
+  m_Pool.ResetPageSet(spares);
   pages.clear();
+  spares.clear();
 }
 
 byte *ChunkAllocator::AllocateFromPages(bool chunkAlloc, size_t size)
@@ -1235,10 +1337,21 @@ byte *ChunkAllocator::AllocateFromPages(bool chunkAlloc, size_t size)
   if(size > m_Pool.GetBufferPageSize())
     return NULL;
 
-  // if we don't have a current page, or it can't satisfy the allocation, get a new page from the
-  // pool
+  // if we don't have a current page, or it can't satisfy the allocation, get a new page
   if(pages.empty() || GetRemainingBytes(chunkAlloc, pages.back()) < size)
-    pages.push_back(m_Pool.AllocPage());
+  {
+    if(!pages.empty())
+      m_Pool.RecordRetiredPage(GetRemainingBufferBytes(pages.back()) +
+                               GetRemainingChunkBytes(pages.back()));
+
+    // fetch more pages from the pool at once the more pages we've used, so small allocators don't
+    // hold onto pages they won't use
+    if(spares.empty())
+      m_Pool.AllocPages(spares, RDCCLAMP(pages.size(), (size_t)1, (size_t)8));
+
+    pages.push_back(spares.back());
+    spares.pop_back();
+  }
 
   ChunkPage &p = pages.back();
 
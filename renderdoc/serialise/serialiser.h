@@ -57,6 +57,10 @@ enum class SerialiserFlags
 {
   NoFlags = 0x0,
   AllocateMemory = 0x1,
+  // only valid for byte buffers with AllocateMemory, and only safe if the buffer is read-only and
+  // not kept past the scope of a ScopedDeserialiseArray. If the stream is reading from borrowed
+  // memory the buffer will point directly into it instead of being allocated and copied.
+  NoCopy = 0x2,
 };
 
 BITMASK_OPERATORS(SerialiserFlags);
@@ -125,6 +129,8 @@ public:
   }
   StreamWriter *GetWriter() { return m_Write; }
   StreamReader *GetReader() { return m_Read; }
+  // returns true if a buffer deserialised with NoCopy points into the stream and must not be freed
+  bool IsBorrowedBuffer(const void *buf) const { return m_Read && m_Read->IsBorrowedPointer(buf); }
   uint32_t GetChunkMetadataRecording() { return m_ChunkFlags; }
   void SetChunkMetadataRecording(uint32_t flags);
   void SetChunkTimestampBasis(uint64_t base, double freq)
@@ -235,7 +241,7 @@ public:
   {
     if(ExportStructure())
     {
-      m_StructureStack.back()->data.str = ToStr(el);
+      m_StructureStack.back()->data.str = StructuredString(ToStr(el), true);
       m_StructureStack.back()->type.flags |= SDTypeFlags::HasCustomString;
     }
   }
@@ -262,7 +268,7 @@ public:
 
       SDObject &current = *m_StructureStack.back();
 
-      SDObject &obj = *current.AddAndOwnChild(new SDObject(name, TypeName<T>()));
+      SDObject &obj = *current.AddAndOwnChild(NewStructuredObject(name, TypeName<T>()));
       m_StructureStack.push_back(&obj);
 
       obj.type.byteSize = sizeof(T);
@@ -307,7 +313,7 @@ public:
 
       SDObject &current = *m_StructureStack.back();
 
-      SDObject &obj = *current.AddAndOwnChild(new SDObject(name, "Byte Buffer"_lit));
+      SDObject &obj = *current.AddAndOwnChild(NewStructuredObject(name, "Byte Buffer"_lit));
       m_StructureStack.push_back(&obj);
 
       obj.type.basetype = SDBasic::Buffer;
@@ -315,6 +321,7 @@ public:
     }
 
     byte *tempAlloc = NULL;
+    bool alreadyRead = false;
 
     {
       if(IsWriting())
@@ -338,10 +345,25 @@ public:
 #if !defined(__COVERITY__)
         if(!m_Structuriser && (flags & SerialiserFlags::AllocateMemory))
         {
-          if(byteSize > 0)
+          const byte *direct = NULL;
+
+          // if we can point straight into the stream, do that instead of allocating and copying
+          if(byteSize > 0 && (flags & SerialiserFlags::NoCopy))
+            direct = m_Read->ReadDirect(byteSize);
+
+          if(direct)
+          {
+            el = (byte *)direct;
+            alreadyRead = true;
+          }
+          else if(byteSize > 0)
+          {
             el = AllocAlignedBuffer(byteSize);
+          }
           else
+          {
             el = NULL;
+          }
         }
 
         // if we're exporting the buffers, make sure to always alloc space to read the data, so we
@@ -356,7 +378,8 @@ public:
         }
 #endif
 
-        m_Read->Read(el, byteSize);
+        if(!alreadyRead)
+          m_Read->Read(el, byteSize);
       }
     }
 
@@ -416,7 +439,7 @@ public:
 
       SDObject &current = *m_StructureStack.back();
 
-      SDObject &obj = *current.AddAndOwnChild(new SDObject(name, "Byte Buffer"_lit));
+      SDObject &obj = *current.AddAndOwnChild(NewStructuredObject(name, "Byte Buffer"_lit));
       m_StructureStack.push_back(&obj);
 
       obj.type.basetype = SDBasic::Buffer;
@@ -528,7 +551,7 @@ public:
 
       SDObject &parent = *m_StructureStack.back();
 
-      SDObject &arr = *parent.AddAndOwnChild(new SDObject(name, TypeName<T>()));
+      SDObject &arr = *parent.AddAndOwnChild(NewStructuredObject(name, TypeName<T>()));
       m_StructureStack.push_back(&arr);
 
       arr.type.basetype = SDBasic::Array;
@@ -539,7 +562,7 @@ public:
 
       for(size_t i = 0; i < N; i++)
       {
-        SDObject &obj = *arr.AddAndOwnChild(new SDObject("$el"_lit, TypeName<T>()));
+        SDObject &obj = *arr.AddAndOwnChild(NewStructuredObject("$el"_lit, TypeName<T>()));
         m_StructureStack.push_back(&obj);
 
         // default to struct. This will be overwritten if appropriate
@@ -645,7 +668,7 @@ public:
 
       SDObject &parent = *m_StructureStack.back();
 
-      SDObject &arr = *parent.AddAndOwnChild(new SDObject(name, TypeName<T>()));
+      SDObject &arr = *parent.AddAndOwnChild(NewStructuredObject(name, TypeName<T>()));
       m_StructureStack.push_back(&arr);
 
       arr.type.basetype = SDBasic::Array;
@@ -681,7 +704,7 @@ public:
       {
         for(uint64_t i = 0; el && i < arrayCount; i++)
         {
-          SDObject &obj = *arr.AddAndOwnChild(new SDObject("$el"_lit, TypeName<T>()));
+          SDObject &obj = *arr.AddAndOwnChild(NewStructuredObject("$el"_lit, TypeName<T>()));
           m_StructureStack.push_back(&obj);
 
           // default to struct. This will be overwritten if appropriate
@@ -748,7 +771,7 @@ public:
 
       SDObject &parent = *m_StructureStack.back();
 
-      SDObject &arr = *parent.AddAndOwnChild(new SDObject(name, TypeName<U>()));
+      SDObject &arr = *parent.AddAndOwnChild(NewStructuredObject(name, TypeName<U>()));
       m_StructureStack.push_back(&arr);
 
       arr.type.basetype = SDBasic::Array;
@@ -774,7 +797,7 @@ public:
       {
         for(size_t i = 0; i < (size_t)size; i++)
         {
-          SDObject &obj = *arr.AddAndOwnChild(new SDObject("$el"_lit, TypeName<U>()));
+          SDObject &obj = *arr.AddAndOwnChild(NewStructuredObject("$el"_lit, TypeName<U>()));
           m_StructureStack.push_back(&obj);
 
           // default to struct. This will be overwritten if appropriate
@@ -827,7 +850,7 @@ public:
 
       SDObject &parent = *m_StructureStack.back();
 
-      SDObject &arr = *parent.AddAndOwnChild(new SDObject(name, TypeName<U>()));
+      SDObject &arr = *parent.AddAndOwnChild(NewStructuredObject(name, TypeName<U>()));
       m_StructureStack.push_back(&arr);
 
       arr.type.basetype = SDBasic::Array;
@@ -838,7 +861,7 @@ public:
 
       for(size_t i = 0; i < N; i++)
       {
-        SDObject &obj = *arr.AddAndOwnChild(new SDObject("$el"_lit, TypeName<U>()));
+        SDObject &obj = *arr.AddAndOwnChild(NewStructuredObject("$el"_lit, TypeName<U>()));
         m_StructureStack.push_back(&obj);
 
         // default to struct. This will be overwritten if appropriate
@@ -903,7 +926,7 @@ public:
 
       SDObject &parent = *m_StructureStack.back();
 
-      SDObject &arr = *parent.AddAndOwnChild(new SDObject(name, "pair"_lit));
+      SDObject &arr = *parent.AddAndOwnChild(NewStructuredObject(name, "pair"_lit));
       m_StructureStack.push_back(&arr);
 
       arr.type.basetype = SDBasic::Struct;
@@ -912,7 +935,7 @@ public:
       arr.ReserveChildren(2);
 
       {
-        SDObject &obj = *arr.AddAndOwnChild(new SDObject("first"_lit, TypeName<U>()));
+        SDObject &obj = *arr.AddAndOwnChild(NewStructuredObject("first"_lit, TypeName<U>()));
         m_StructureStack.push_back(&obj);
 
         // default to struct. This will be overwritten if appropriate
@@ -925,7 +948,7 @@ public:
       }
 
       {
-        SDObject &obj = *arr.AddAndOwnChild(new SDObject("second"_lit, TypeName<V>()));
+        SDObject &obj = *arr.AddAndOwnChild(NewStructuredObject("second"_lit, TypeName<V>()));
         m_StructureStack.push_back(&obj);
 
         // default to struct. This will be overwritten if appropriate
@@ -1015,7 +1038,7 @@ public:
       {
         SDObject &parent = *m_StructureStack.back();
 
-        SDObject &nullable = *parent.AddAndOwnChild(new SDObject(name, TypeName<T>()));
+        SDObject &nullable = *parent.AddAndOwnChild(NewStructuredObject(name, TypeName<T>()));
 
         nullable.type.basetype = SDBasic::Null;
         nullable.type.byteSize = 0;
@@ -1103,7 +1126,7 @@ public:
 
       SDObject &current = *m_StructureStack.back();
 
-      SDObject &obj = *current.AddAndOwnChild(new SDObject(name, "Byte Buffer"_lit));
+      SDObject &obj = *current.AddAndOwnChild(NewStructuredObject(name, "Byte Buffer"_lit));
       m_StructureStack.push_back(&obj);
 
       obj.type.basetype = SDBasic::Buffer;
@@ -1198,12 +1221,12 @@ public:
       if(current.NumChildren() > 0)
       {
         SDObject *last = current.GetChild(current.NumChildren() - 1);
-        last->type.name = name;
+        last->type.name = StructuredString(name, true);
 
         if(last->type.basetype == SDBasic::Array)
         {
           for(SDObject *obj : *last)
-            obj->type.name = name;
+            obj->type.name = last->type.name;
         }
       }
     }
@@ -1250,7 +1273,7 @@ public:
       SDObject &current = *m_StructureStack.back();
 
       if(current.NumChildren() > 0)
-        current.GetChild(current.NumChildren() - 1)->name = name;
+        current.GetChild(current.NumChildren() - 1)->name = StructuredString(name, true);
     }
 
     return *this;
@@ -1393,7 +1416,7 @@ public:
 
       current.type.basetype = type;
       current.type.byteSize = len;
-      current.data.str = el;
+      current.data.str = StructuredString(el, false);
     }
   }
 
@@ -1447,7 +1470,7 @@ public:
 
       current.type.basetype = type;
       current.type.byteSize = RDCMAX(len, 0);
-      current.data.str = el ? el : "";
+      current.data.str = StructuredString(el ? el : "", true);
       if(len == -1)
         current.type.flags |= SDTypeFlags::NullString;
     }
@@ -1500,7 +1523,7 @@ public:
       {
         for(size_t i = 0; i < (size_t)size; i++)
         {
-          SDObject &obj = *current.AddAndOwnChild(new SDObject("$el"_lit, TypeName<U>()));
+          SDObject &obj = *current.AddAndOwnChild(NewStructuredObject("$el"_lit, TypeName<U>()));
           m_StructureStack.push_back(&obj);
 
           // default to struct. This will be overwritten if appropriate
@@ -1676,6 +1699,25 @@ private:
     return it.first->c_str();
   }
 
+  // structured objects and the strings in them are allocated from the structured file's arena if
+  // it has one, see SDFile::UseArena()
+  SDObject *NewStructuredObject(rdcinflexiblestr &&name, rdcinflexiblestr &&type)
+  {
+    SDObjectArena *arena = m_StructuredFile->GetArena();
+    if(arena)
+      return arena->NewObject(std::move(name), std::move(type));
+    return new SDObject(std::move(name), std::move(type));
+  }
+
+  // intern should be set for strings that are likely to repeat, like names
+  rdcinflexiblestr StructuredString(const rdcstr &str, bool intern)
+  {
+    SDObjectArena *arena = m_StructuredFile->GetArena();
+    if(arena)
+      return intern ? arena->Intern(str) : arena->Copy(str);
+    return str;
+  }
+
   ChunkLookup m_ChunkLookup = NULL;
   FileIO::LogFileHandle *m_DebugDumpLog = NULL;
 };
@@ -1800,12 +1842,15 @@ DECLARE_STRINGISE_TYPE(SDObject *);
 
 class ScopedChunk;
 
+struct ChunkPageNode;
+
 struct ChunkPage
 {
-  // compare just with the ID, so that old pages w hich have been reset in the pool don't get reset
-  // again if an allocator subsequently tries to free them
-  bool operator==(const ChunkPage &o) { return ID == o.ID; }
-  size_t ID;
+  // the pool's record of this page, and the ID it had when it was handed out. If the pool has
+  // since reset the page it will have a new ID, so old pages which have been reset in the pool
+  // don't get reset again if an allocator subsequently tries to free them
+  ChunkPageNode *node;
+  int64_t ID;
 
   // we allocate at two granularities, chunks are 16 bytes, buffers are multiples of 64-bytes
   // to keep things simple we allocate the chunk memory as 16/64 = a quarter the size of the
@@ -1821,10 +1866,28 @@ struct ChunkPage
   byte *chunkHead;
 };
 
+struct ChunkPagePoolStats
+{
+  // the size of the buffer memory in each page
+  uint64_t pageSize;
+  // pages currently held by allocators
+  uint64_t livePages;
+  // pages that have memory allocated but are free to be handed out
+  uint64_t freePages;
+  // how many times an allocator moved on from a page because an allocation didn't fit, and the
+  // total bytes left unused in those pages. wastedBytes / retiredPages is the average waste per
+  // page for tuning the page size.
+  uint64_t retiredPages;
+  uint64_t wastedBytes;
+};
+
 // this is the first level, it allocates whole pages and returns them to allocators for finer
 // grained allocation, and those allocators can return whole pages back. This is necessary because
 // when fine-grained resetting is allowed we need to associate whole pages with objects and if those
 // objects are allocating interleaved we need to immediately associate pages with them.
+//
+// The pool is thread-safe so allocators on different threads can share it. Returning pages never
+// blocks, handing them out takes a short lock.
 class ChunkPagePool
 {
 public:
@@ -1837,6 +1900,9 @@ public:
   // Allocate a page
   ChunkPage AllocPage();
 
+  // Allocate count pages at once, appending them to pages
+  void AllocPages(rdcarray<ChunkPage> &pages, size_t count);
+
   // really free any unused pages
   void Trim();
 
@@ -1846,19 +1912,39 @@ public:
   // reset a page set, other pages will remain in use
   void ResetPageSet(const rdcarray<ChunkPage> &pages);
 
+  // called by allocators when they stop allocating from a page with wastedBytes left unused
+  void RecordRetiredPage(size_t wastedBytes);
+
+  ChunkPagePoolStats GetStats();
+
   size_t GetBufferPageSize() { return BufferPageSize; }
   size_t GetChunkPageSize() { return ChunkPageSize; }
 private:
+  int64_t NewID(bool live);
+  void PushFreePage(ChunkPageNode *node);
+  ChunkPageNode *PopFreePage();
+
   size_t BufferPageSize;
   size_t ChunkPageSize;
 
-  size_t m_ID = 1;
+  int64_t m_ID = 0;
+
+  // every page the pool has created, indexed by ChunkPageNode::index. Pages that have been trimmed
+  // keep their node with no memory, since allocators may still reference it, and it is re-used the
+  // next time a page is needed.
+  // Pages are pushed onto the free list without locking. Popping, creating pages and walking the
+  // list of all pages is done under m_Lock, so only one thread pops at a time which means a page
+  // can't be popped and pushed back while another pop is in progress.
+  rdcarray<ChunkPageNode *> m_AllPages;
+  rdcarray<ChunkPageNode *> m_TrimmedPages;
+  Threading::CriticalSection m_Lock;
+
+  // index + 1 of the first free page, or 0 if there are none
+  int64_t m_FreeHead = 0;
 
-  // a page is in precisely ONE of these arrays at any time.
-  // Reset() will move all allocated pages back to free pages and reclaim all that memory
-  // ResetPageSet() will move any referenced pages from allocatedPages back to freePages
-  rdcarray<ChunkPage> freePages;
-  rdcarray<ChunkPage> allocatedPages;
+  int64_t m_LivePages = 0;
+  int64_t m_RetiredPages = 0;
+  int64_t m_WastedBytes = 0;
 };
 
 // this is the second level, it should only be used by one object (or a group of objects that are
@@ -1888,6 +1974,11 @@ private:
   // currently allocating from.
   rdcarray<ChunkPage> pages;
 
+  // pages fetched from the pool that haven't been started yet. An allocator is only used from one
+  // thread at a time, so this acts as a per-thread cache and lets busy allocators fetch several
+  // pages from the pool at once.
+  rdcarray<ChunkPage> spares;
+
   // given a page and the known page size, how much is left
   inline size_t GetRemainingBufferBytes(const ChunkPage &p)
   {
@@ -2092,7 +2183,7 @@ struct ScopedDeserialiseArray<SerialiserType, void *>
   ScopedDeserialiseArray(const SerialiserType &ser, void **el, uint64_t) : m_Ser(ser), m_El(el) {}
   ~ScopedDeserialiseArray()
   {
-    if(m_Ser.IsReading())
+    if(m_Ser.IsReading() && !m_Ser.IsBorrowedBuffer(*m_El))
       FreeAlignedBuffer((byte *)*m_El);
   }
   const SerialiserType &m_Ser;
@@ -2108,7 +2199,7 @@ struct ScopedDeserialiseArray<SerialiserType, const void *>
   }
   ~ScopedDeserialiseArray()
   {
-    if(m_Ser.IsReading())
+    if(m_Ser.IsReading() && !m_Ser.IsBorrowedBuffer(*m_El))
       FreeAlignedBuffer((byte *)*m_El);
   }
   const SerialiserType &m_Ser;
@@ -2121,7 +2212,7 @@ struct ScopedDeserialiseArray<SerialiserType, byte *>
   ScopedDeserialiseArray(const SerialiserType &ser, byte **el, uint64_t) : m_Ser(ser), m_El(el) {}
   ~ScopedDeserialiseArray()
   {
-    if(m_Ser.IsReading())
+    if(m_Ser.IsReading() && !m_Ser.IsBorrowedBuffer(*m_El))
       FreeAlignedBuffer(*m_El);
   }
   const SerialiserType &m_Ser;
@@ -2172,6 +2263,16 @@ struct ScopedDeserialiseArray<SerialiserType, byte *>
       GET_SERIALISER, &obj, count);                                                               \
   GET_SERIALISER.Serialise(STRING_LITERAL(#obj), obj, count, SerialiserFlags::AllocateMemory)
 
+// for buffers that are only read and not kept past the current scope. When the stream is reading
+// from borrowed memory the buffer points directly into it and isn't allocated or copied.
+#define SERIALISE_ELEMENT_ARRAY_NOCOPY(obj, count)                                                \
+  uint64_t CONCAT(dummy_array_count, __LINE__) = 0;                                               \
+  (void)CONCAT(dummy_array_count, __LINE__);                                                      \
+  ScopedDeserialiseArray<decltype(GET_SERIALISER), decltype(obj)> CONCAT(deserialise_, __LINE__)( \
+      GET_SERIALISER, &obj, count);                                                               \
+  GET_SERIALISER.Serialise(STRING_LITERAL(#obj), obj, count,                                      \
+                           SerialiserFlags::AllocateMemory | SerialiserFlags::NoCopy)
+
 #define SERIALISE_ELEMENT_OPT(obj)                                           \
   ScopedDeserialiseNullable<decltype(GET_SERIALISER), decltype(obj)> CONCAT( \
       deserialise_, __LINE__)(GET_SERIALISER, &obj);                         \
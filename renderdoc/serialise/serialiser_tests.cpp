@@ -23,6 +23,7 @@
  ******************************************************************************/
 
 #include "serialiser.h"
+#include "common/timing.h"
 
 #if ENABLED(ENABLE_UNIT_TESTS)
 
@@ -595,6 +596,74 @@ TEST_CASE("Read/writing large buffers", "[serialiser]")
   FileIO::Delete(filename);
 };
 
+TEST_CASE("Read buffers without copying from borrowed memory", "[serialiser]")
+{
+  StreamWriter *buf = new StreamWriter(StreamWriter::DefaultScratchSize);
+
+  bytebuf contents;
+  contents.resize(1024 * 1024);
+  for(size_t i = 0; i < contents.size(); i++)
+    contents[i] = byte(i * 7);
+
+  {
+    WriteSerialiser ser(buf, Ownership::Nothing);
+
+    ser.WriteChunk(1);
+
+    uint64_t size = contents.size();
+    byte *data = contents.data();
+    SERIALISE_ELEMENT(size);
+    SERIALISE_ELEMENT_ARRAY_NOCOPY(data, size);
+
+    ser.EndChunk();
+  }
+
+  bool borrowed = false;
+
+  SECTION("Copied")
+  {
+    borrowed = false;
+  };
+
+  SECTION("Borrowed")
+  {
+    borrowed = true;
+  };
+
+  {
+    StreamReader *reader = NULL;
+    if(borrowed)
+      reader = new StreamReader(StreamReader::BorrowedStream, buf->GetData(), buf->GetOffset());
+    else
+      reader = new StreamReader(buf->GetData(), buf->GetOffset());
+
+    ReadSerialiser ser(reader, Ownership::Stream);
+
+    CHECK(ser.ReadChunk<uint32_t>() == 1);
+
+    {
+      uint64_t size = 0;
+      byte *data = NULL;
+      SERIALISE_ELEMENT(size);
+      SERIALISE_ELEMENT_ARRAY_NOCOPY(data, size);
+
+      CHECK(size == contents.size());
+      REQUIRE(data != NULL);
+      CHECK_FALSE(memcmp(data, contents.data(), contents.size()));
+
+      // a borrowed buffer points straight into the written data, and won't be freed
+      CHECK(ser.IsBorrowedBuffer(data) == borrowed);
+      CHECK((data >= buf->GetData() && data < buf->GetData() + buf->GetOffset()) == borrowed);
+    }
+
+    ser.EndChunk();
+
+    CHECK_FALSE(ser.IsErrored());
+  }
+
+  delete buf;
+};
+
 TEST_CASE("Read/write chunk metadata", "[serialiser]")
 {
   StreamWriter *buf = new StreamWriter(StreamWriter::DefaultScratchSize);
@@ -840,6 +909,130 @@ TEST_CASE("Verify multiple chunks can be merged", "[serialiser][chunks]")
   delete buf;
 };
 
+TEST_CASE("Allocate chunks from a page pool shared between threads", "[serialiser][chunks]")
+{
+  ChunkPagePool pool(4 * 1024);
+
+  SECTION("Pages are re-used and stats are tracked")
+  {
+    ChunkAllocator alloc(pool);
+
+    // the first allocation fetches a single page
+    byte *first = alloc.AllocAlignedBuffer(3000);
+    REQUIRE(first);
+    CHECK(pool.GetStats().livePages == 1);
+
+    // this doesn't fit, so the first page is retired with its remaining space wasted
+    byte *second = alloc.AllocAlignedBuffer(2000);
+    REQUIRE(second);
+
+    ChunkPagePoolStats stats = pool.GetStats();
+    CHECK(stats.pageSize == 4 * 1024);
+    CHECK(stats.livePages == 1 + 1);
+    CHECK(stats.retiredPages == 1);
+    CHECK(stats.wastedBytes == 4 * 1024 - 3008 + pool.GetChunkPageSize());
+
+    // larger than a page can't be allocated
+    CHECK(alloc.AllocAlignedBuffer(8 * 1024) == NULL);
+
+    alloc.Reset();
+
+    stats = pool.GetStats();
+    CHECK(stats.livePages == 0);
+    CHECK(stats.freePages == 2);
+
+    // pages are re-used after being reset
+    byte *reused = alloc.AllocAlignedBuffer(64);
+    CHECK((reused == first || reused == second));
+    CHECK(pool.GetStats().freePages == 1);
+
+    // after a pool reset, the allocator's reset doesn't free its pages a second time
+    pool.Reset();
+    CHECK(pool.GetStats().freePages == 2);
+    alloc.Reset();
+
+    stats = pool.GetStats();
+    CHECK(stats.livePages == 0);
+    CHECK(stats.freePages == 2);
+
+    pool.Trim();
+    CHECK(pool.GetStats().freePages == 0);
+
+    // trimmed pages get new memory when needed again
+    CHECK(alloc.AllocChunk());
+    CHECK(pool.GetStats().livePages == 1);
+  };
+
+  SECTION("Multiple threads")
+  {
+    const uint32_t numThreads = 8;
+    int32_t failures = 0;
+
+    rdcarray<Threading::ThreadHandle> threads;
+    for(uint32_t t = 0; t < numThreads; t++)
+    {
+      threads.push_back(Threading::CreateThread([&pool, &failures, t]() {
+        ChunkAllocator alloc(pool);
+
+        rdcarray<rdcpair<byte *, size_t>> allocs;
+
+        for(uint32_t iter = 0; iter < 200; iter++)
+        {
+          allocs.clear();
+
+          const byte tag = byte(t * 31 + iter);
+
+          for(uint32_t i = 0; i < 50; i++)
+          {
+            size_t size = ((i * 37 + t * 11 + iter) % 700) + 1;
+            byte *data = alloc.AllocAlignedBuffer(size);
+            byte *chunk = alloc.AllocChunk();
+
+            if(!data || !chunk)
+            {
+              Atomic::Inc32(&failures);
+              continue;
+            }
+
+            memset(data, tag, size);
+            memset(chunk, tag, 16);
+            allocs.push_back({data, size});
+            allocs.push_back({chunk, 16});
+          }
+
+          // if any other thread was given the same memory, it will have been overwritten
+          for(const rdcpair<byte *, size_t> &a : allocs)
+          {
+            for(size_t i = 0; i < a.second; i++)
+            {
+              if(a.first[i] != tag)
+              {
+                Atomic::Inc32(&failures);
+                break;
+              }
+            }
+          }
+
+          alloc.Reset();
+        }
+      }));
+    }
+
+    for(Threading::ThreadHandle t : threads)
+    {
+      Threading::JoinThread(t);
+      Threading::CloseThread(t);
+    }
+
+    CHECK(failures == 0);
+
+    ChunkPagePoolStats stats = pool.GetStats();
+    CHECK(stats.livePages == 0);
+    CHECK(stats.freePages > 0);
+    CHECK(stats.retiredPages > 0);
+  };
+};
+
 TEST_CASE("Read/write container types", "[serialiser][structured]")
 {
   StreamWriter *buf = new StreamWriter(StreamWriter::DefaultScratchSize);
@@ -1732,6 +1925,237 @@ TEST_CASE("Read/write complex types", "[serialiser][structured]")
   delete buf;
 };
 
+static void SerialiseArenaTestChunk(WriteSerialiser &ser, uint32_t i)
+{
+  MySpecialEnum enumVal = MySpecialEnum(i % 4);
+  SERIALISE_ELEMENT(enumVal);
+
+  rdcarray<MySpecialEnum> enumArray = {TheLastEnumValue, AnotherEnumValue, MySpecialEnum(i % 4)};
+  SERIALISE_ELEMENT(enumArray);
+
+  struct2 complex;
+  complex.name = StringFormat::Fmt("Object %u", i);
+  complex.floats = {1.2f, 3.4f, float(i)};
+  complex.viewports.resize(2);
+  complex.viewports[1] = struct1(float(i), 0.0f, 256.0f, 256.0f);
+  SERIALISE_ELEMENT(complex);
+
+  uint32_t value = i;
+  SERIALISE_ELEMENT(value).Named(StringFormat::Fmt("value%u", i % 3)).TypedAs("CustomType"_lit);
+}
+
+static void SerialiseArenaTestChunk(ReadSerialiser &ser)
+{
+  MySpecialEnum enumVal;
+  SERIALISE_ELEMENT(enumVal);
+
+  rdcarray<MySpecialEnum> enumArray;
+  SERIALISE_ELEMENT(enumArray);
+
+  struct2 complex;
+  SERIALISE_ELEMENT(complex);
+
+  uint32_t value;
+  SERIALISE_ELEMENT(value).Named(StringFormat::Fmt("value%u", value % 3)).TypedAs("CustomType"_lit);
+}
+
+TEST_CASE("Build structured data in an arena", "[serialiser][structured]")
+{
+  StreamWriter *buf = new StreamWriter(StreamWriter::DefaultScratchSize);
+
+  const uint32_t numChunks = 500;
+
+  {
+    WriteSerialiser ser(buf, Ownership::Nothing);
+
+    for(uint32_t i = 0; i < numChunks; i++)
+    {
+      SCOPED_SERIALISE_CHUNK(5 + (i % 2));
+      SerialiseArenaTestChunk(ser, i);
+    }
+
+    REQUIRE_FALSE(ser.IsErrored());
+  }
+
+  ChunkLookup testChunkLookup = [](uint32_t id) -> rdcstr {
+    return StringFormat::Fmt("TestChunk%u", id);
+  };
+
+  SDFile heapFile, arenaFile;
+
+  for(SDFile *file : {&heapFile, &arenaFile})
+  {
+    ReadSerialiser ser(new StreamReader(buf->GetData(), buf->GetOffset()), Ownership::Stream);
+    ser.ConfigureStructuredExport(testChunkLookup, false, 0, 1.0);
+
+    if(file == &arenaFile)
+      ser.GetStructuredFile().UseArena();
+
+    while(!ser.GetReader()->AtEnd())
+    {
+      ser.ReadChunk<uint32_t>();
+      SerialiseArenaTestChunk(ser);
+      ser.EndChunk();
+    }
+
+    REQUIRE_FALSE(ser.IsErrored());
+
+    ser.GetStructuredFile().Swap(*file);
+  }
+
+  CHECK(heapFile.GetArena() == NULL);
+  REQUIRE(arenaFile.GetArena() != NULL);
+  CHECK(arenaFile.GetArena()->GetAllocatedBytes() > 0);
+
+  REQUIRE(heapFile.chunks.size() == numChunks);
+  REQUIRE(arenaFile.chunks.size() == numChunks);
+
+  std::function<void(const SDObject *, const SDObject *)> compare = [&compare](const SDObject *a,
+                                                                               const SDObject *b) {
+    CHECK(a->name == b->name);
+    CHECK(a->type.name == b->type.name);
+    CHECK((a->type.basetype == b->type.basetype));
+    CHECK(a->type.byteSize == b->type.byteSize);
+    CHECK(a->data.str == b->data.str);
+    CHECK(a->data.basic.u == b->data.basic.u);
+    REQUIRE(a->NumChildren() == b->NumChildren());
+
+    for(size_t i = 0; i < a->NumChildren(); i++)
+      compare(a->GetChild(i), b->GetChild(i));
+  };
+
+  for(size_t c = 0; c < numChunks; c++)
+    compare(heapFile.chunks[c], arenaFile.chunks[c]);
+
+  SECTION("Repeated strings are interned")
+  {
+    // chunk names, enum strings and renamed objects are stored once
+    CHECK(arenaFile.chunks[0]->name.c_str() == arenaFile.chunks[2]->name.c_str());
+    CHECK(arenaFile.chunks[0]->name.c_str() != arenaFile.chunks[1]->name.c_str());
+    CHECK(arenaFile.chunks[1]->GetChild(0)->data.str.c_str() ==
+          arenaFile.chunks[5]->GetChild(0)->data.str.c_str());
+    CHECK(arenaFile.chunks[0]->GetChild(3)->name.c_str() ==
+          arenaFile.chunks[3]->GetChild(3)->name.c_str());
+    CHECK(arenaFile.chunks[0]->GetChild(3)->name == "value0");
+
+    // and type names set after creation
+    CHECK(arenaFile.chunks[0]->GetChild(3)->type.name.c_str() ==
+          arenaFile.chunks[1]->GetChild(3)->type.name.c_str());
+  };
+
+  SECTION("Arena and heap objects can be mixed")
+  {
+    SDChunk *chunk = arenaFile.chunks[10];
+
+    // removing an arena object only destructs it
+    chunk->RemoveChild(0);
+    CHECK(chunk->NumChildren() == 3);
+    CHECK(chunk->GetChild(0)->name == "enumArray");
+
+    // heap allocated objects can be added to arena objects, and are freed normally
+    chunk->DuplicateAndAddChild(heapFile.chunks[10]->GetChild(0));
+    chunk->AddAndOwnChild(makeSDString("extra"_lit, "A string that is not in the arena"_lit));
+    CHECK(chunk->NumChildren() == 5);
+    CHECK(chunk->GetChild(3)->name == "enumVal");
+
+    // arena objects can be duplicated to the heap
+    SDChunk *dup = arenaFile.chunks[11]->Duplicate();
+    compare(dup, heapFile.chunks[11]);
+    delete dup;
+
+    // the arena moves with the contents when swapping
+    SDFile swapped;
+    swapped.Swap(arenaFile);
+    CHECK(arenaFile.GetArena() == NULL);
+    CHECK(swapped.GetArena() != NULL);
+    CHECK(swapped.chunks[10]->NumChildren() == 5);
+  };
+
+  SECTION("Duplicates outlive the arena")
+  {
+    rdcarray<SDChunk *> dups;
+    for(SDChunk *chunk : arenaFile.chunks)
+      dups.push_back(chunk->Duplicate());
+
+    // the duplicates don't share any strings with the arena
+    CHECK(dups[0]->name.c_str() != arenaFile.chunks[0]->name.c_str());
+    CHECK(dups[0]->GetChild(3)->name.c_str() != arenaFile.chunks[0]->GetChild(3)->name.c_str());
+    CHECK(dups[0]->GetChild(3)->type.name.c_str() !=
+          arenaFile.chunks[0]->GetChild(3)->type.name.c_str());
+    CHECK(dups[1]->GetChild(0)->data.str.c_str() !=
+          arenaFile.chunks[1]->GetChild(0)->data.str.c_str());
+
+    // free the file and its arena before reading the duplicates
+    SDFile *source = new SDFile;
+    source->Swap(arenaFile);
+    delete source;
+
+    for(size_t c = 0; c < numChunks; c++)
+    {
+      compare(dups[c], heapFile.chunks[c]);
+      delete dups[c];
+    }
+  };
+
+  delete buf;
+};
+
+TEST_CASE("Benchmark building structured data in an arena", "[.][serialiser][benchmark]")
+{
+  StreamWriter *buf = new StreamWriter(StreamWriter::DefaultScratchSize);
+
+  const uint32_t numChunks = 200000;
+
+  {
+    WriteSerialiser ser(buf, Ownership::Nothing);
+
+    for(uint32_t i = 0; i < numChunks; i++)
+    {
+      SCOPED_SERIALISE_CHUNK(5 + (i % 2));
+      SerialiseArenaTestChunk(ser, i);
+    }
+  }
+
+  ChunkLookup testChunkLookup = [](uint32_t id) -> rdcstr {
+    return StringFormat::Fmt("TestChunk%u", id);
+  };
+
+  for(int useArena = 0; useArena < 2; useArena++)
+  {
+    PerformanceTimer timer;
+
+    SDFile *file = new SDFile;
+
+    {
+      ReadSerialiser ser(new StreamReader(buf->GetData(), buf->GetOffset()), Ownership::Stream);
+      ser.ConfigureStructuredExport(testChunkLookup, false, 0, 1.0);
+
+      if(useArena)
+        ser.GetStructuredFile().UseArena();
+
+      while(!ser.GetReader()->AtEnd())
+      {
+        ser.ReadChunk<uint32_t>();
+        SerialiseArenaTestChunk(ser);
+        ser.EndChunk();
+      }
+
+      ser.GetStructuredFile().Swap(*file);
+    }
+
+    double buildMs = timer.GetMilliseconds();
+
+    timer.Restart();
+    delete file;
+    double freeMs = timer.GetMilliseconds();
+
+    RDCLOG("%s: %.2f ms to build %u chunks, %.2f ms to free", useArena ? "arena" : "heap",
+           buildMs, numChunks, freeMs);
+  }
+
+  delete buf;
+};
+
 enum class TestEnumClass
 {
   A = 1,
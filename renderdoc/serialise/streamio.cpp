@@ -39,6 +39,434 @@ Decompressor::~Decompressor()
     delete m_Read;
 }
 
+// the block index is written after the compressed data as an array of uint64_t offsets (one for
+// each block, relative to the start of the compressed stream) followed by this footer. Readers
+// that don't know about the index stop reading after the last block so never see it.
+struct BlockIndexFooter
+{
+  uint64_t blockSize;
+  uint64_t numBlocks;
+  uint32_t magic;
+  uint32_t version;
+};
+
+static const uint32_t BlockIndexMagic = MAKE_FOURCC('R', 'D', 'B', 'I');
+static const uint32_t BlockIndexVersion = 1;
+
+void Compressor::RecordBlock()
+{
+  if(m_BlockIndexed)
+    m_BlockOffsets.push_back(m_Write->GetOffset());
+}
+
+bool Compressor::WriteBlockIndex(uint64_t blockSize)
+{
+  BlockIndexFooter footer = {blockSize, m_BlockOffsets.size(), BlockIndexMagic, BlockIndexVersion};
+
+  bool success = true;
+
+  success &= m_Write->Write(m_BlockOffsets.data(), m_BlockOffsets.byteSize());
+  success &= m_Write->Write(footer);
+
+  if(!success)
+    m_Error = m_Write->GetError();
+
+  return success;
+}
+
+bool Decompressor::ReadBlockIndex()
+{
+  const uint64_t size = m_Read->GetSize();
+
+  if(size < sizeof(BlockIndexFooter))
+  {
+    RDCWARN("Stream is too small to contain a block index");
+    return false;
+  }
+
+  m_Read->SetOffset(size - sizeof(BlockIndexFooter));
+
+  BlockIndexFooter footer = {};
+  m_Read->Read(footer);
+
+  // don't trust the footer until it's validated, so that a corrupt index can't make us read out of
+  // bounds - we can always fall back to reading sequentially
+  if(m_Read->IsErrored() || footer.magic != BlockIndexMagic ||
+     footer.version != BlockIndexVersion || footer.blockSize == 0 || footer.numBlocks == 0 ||
+     footer.numBlocks > (size - sizeof(BlockIndexFooter)) / sizeof(uint64_t))
+  {
+    RDCWARN("Invalid block index footer");
+    m_Read->SetOffset(0);
+    return false;
+  }
+
+  const uint64_t indexOffset =
+      size - sizeof(BlockIndexFooter) - footer.numBlocks * sizeof(uint64_t);
+
+  m_Read->SetOffset(indexOffset);
+
+  rdcarray<uint64_t> offsets;
+  offsets.resize((size_t)footer.numBlocks);
+  m_Read->Read(offsets.data(), offsets.byteSize());
+
+  bool valid = !m_Read->IsErrored();
+
+  for(size_t i = 0; valid && i < offsets.size(); i++)
+    valid = offsets[i] < indexOffset && (i == 0 || offsets[i] > offsets[i - 1]);
+
+  m_Read->SetOffset(0);
+
+  if(!valid)
+  {
+    RDCWARN("Invalid block index");
+    return false;
+  }
+
+  m_BlockSize = footer.blockSize;
+  m_BlockOffsets.swap(offsets);
+  m_DataEnd = indexOffset;
+
+  return true;
+}
+
+uint64_t Decompressor::SeekToBlock(uint64_t offs)
+{
+  RDCASSERT(CanSeek());
+
+  size_t block = (size_t)RDCMIN(offs / m_BlockSize, uint64_t(m_BlockOffsets.size() - 1));
+
+  m_Read->SetOffset(m_BlockOffsets[block]);
+  ResetBlock();
+
+  return block * m_BlockSize;
+}
+
+bool Decompressor::AtDataEnd()
+{
+  return m_Read->AtEnd() || m_Read->GetOffset() >= m_DataEnd;
+}
+
+ParallelCompression::ParallelCompression(uint32_t numThreads, uint64_t blockSize,
+                                         uint64_t compressBound, uint64_t historySize,
+                                         CompressBlockCallback callback)
+    : m_BlockSize(blockSize), m_HistorySize(historySize), m_Callback(callback)
+{
+  // we need at least two blocks so that the previous block is intact when we copy its history,
+  // and we keep enough blocks for every thread to be busy while the producer fills another
+  m_Blocks.resize(RDCMAX(2U, numThreads * 2));
+  for(Block &b : m_Blocks)
+  {
+    b.page = AllocAlignedBuffer(blockSize);
+    b.size = 0;
+    b.history = historySize > 0 ? AllocAlignedBuffer(historySize) : NULL;
+    b.historySize = 0;
+    b.compressed = AllocAlignedBuffer(compressBound);
+    b.compressedSize = 0;
+    b.state = 0;
+  }
+
+  m_WorkSemaphore = Threading::Semaphore::Create();
+  m_CompleteSemaphore = Threading::Semaphore::Create();
+
+  for(uint32_t i = 0; i < numThreads; i++)
+    m_Threads.push_back(Threading::CreateThread([this, i]() { ThreadEntry(i); }));
+}
+
+ParallelCompression::~ParallelCompression()
+{
+  // the owner should have flushed, but make sure no worker is still using the blocks
+  for(Block &b : m_Blocks)
+    WaitForBlock(b);
+
+  Atomic::Inc32(&m_ThreadKill);
+  m_WorkSemaphore->Wake((uint32_t)m_Threads.size());
+
+  for(Threading::ThreadHandle t : m_Threads)
+  {
+    Threading::JoinThread(t);
+    Threading::CloseThread(t);
+  }
+
+  m_WorkSemaphore->Destroy();
+  m_CompleteSemaphore->Destroy();
+
+  for(Block &b : m_Blocks)
+  {
+    FreeAlignedBuffer(b.page);
+    FreeAlignedBuffer(b.history);
+    FreeAlignedBuffer(b.compressed);
+  }
+}
+
+byte *ParallelCompression::GetPage()
+{
+  return m_Blocks[m_Submitted % m_Blocks.size()].page;
+}
+
+bool ParallelCompression::SubmitPage(uint64_t size, StreamWriter *write, RDResult &error)
+{
+  Block &b = m_Blocks[m_Submitted % m_Blocks.size()];
+
+  b.size = size;
+  b.historySize = 0;
+
+  // copy the end of the previous block as history. It has been submitted but can't have been
+  // re-used yet since it's the most recent
+  if(m_HistorySize > 0 && m_Submitted > 0 && !m_BlockOffsets)
+  {
+    const Block &prev = m_Blocks[(m_Submitted - 1) % m_Blocks.size()];
+    b.historySize = RDCMIN(m_HistorySize, prev.size);
+    memcpy(b.history, prev.page + prev.size - b.historySize, (size_t)b.historySize);
+  }
+
+  Atomic::Inc32(&b.state);
+  m_Submitted++;
+  m_WorkSemaphore->Wake(1);
+
+  // write whatever has completed so far without blocking
+  bool success = WriteCompleted(false, write, error);
+
+  // if the next page to fill is still in flight, we have to wait for it to be written
+  while(success && m_Submitted - m_Written >= (int64_t)m_Blocks.size())
+  {
+    WaitForBlock(m_Blocks[m_Written % m_Blocks.size()]);
+    success = WriteCompleted(false, write, error);
+  }
+
+  return success;
+}
+
+bool ParallelCompression::Flush(StreamWriter *write, RDResult &error)
+{
+  return WriteCompleted(true, write, error);
+}
+
+bool ParallelCompression::WriteCompleted(bool waitForAll, StreamWriter *write, RDResult &error)
+{
+  bool success = true;
+
+  while(m_Written < m_Submitted)
+  {
+    Block &b = m_Blocks[m_Written % m_Blocks.size()];
+
+    if(Atomic::CmpExch32(&b.state, 2, 2) != 2)
+    {
+      if(!waitForAll)
+        break;
+
+      WaitForBlock(b);
+      continue;
+    }
+
+    // once we've failed, keep returning blocks to the producer but don't write anything else
+    if(success)
+    {
+      if(b.compressedSize < 0)
+      {
+        SET_ERROR_RESULT(error, ResultCode::CompressionFailed, "Compression failed on block: %lli",
+                         b.compressedSize);
+        success = false;
+      }
+      else
+      {
+        if(m_BlockOffsets)
+          m_BlockOffsets->push_back(write->GetOffset());
+
+        success &= write->Write((uint32_t)b.compressedSize);
+        success &= write->Write(b.compressed, (uint64_t)b.compressedSize);
+        if(!success)
+          error = write->GetError();
+      }
+    }
+
+    Atomic::CmpExch32(&b.state, 2, 0);
+    m_Written++;
+  }
+
+  return success;
+}
+
+void ParallelCompression::WaitForBlock(Block &b)
+{
+  while(Atomic::CmpExch32(&b.state, 1, 1) == 1)
+  {
+    Atomic::CmpExch32(&m_ProducerWaiting, 0, 1);
+
+    // if the block completed before we flagged that we're waiting, no worker may wake us
+    if(Atomic::CmpExch32(&b.state, 1, 1) != 1)
+    {
+      // if a worker already took the flag it has woken the semaphore, and that wake must be
+      // consumed so that it doesn't accumulate
+      if(Atomic::CmpExch32(&m_ProducerWaiting, 1, 0) == 0)
+        m_CompleteSemaphore->WaitForWake();
+      break;
+    }
+
+    // any block completing wakes us, so check again
+    m_CompleteSemaphore->WaitForWake();
+  }
+}
+
+void ParallelCompression::ThreadEntry(uint32_t worker)
+{
+  Threading::SetCurrentThreadName(StringFormat::Fmt("Compression Worker %02u", worker));
+
+  while(true)
+  {
+    m_WorkSemaphore->WaitForWake();
+
+    if(Atomic::CmpExch32(&m_ThreadKill, 0, 0) != 0)
+      break;
+
+    // each wake corresponds to one submitted block, so claiming the next index always succeeds.
+    // Blocks are claimed in submission order but can complete in any order
+    int64_t idx = Atomic::Inc64(&m_Claimed) - 1;
+    Block &b = m_Blocks[idx % m_Blocks.size()];
+
+    b.compressedSize = m_Callback(worker, b.historySize > 0 ? b.history : NULL, b.historySize,
+                                  b.page, b.size, b.compressed);
+
+    Atomic::Inc32(&b.state);
+
+    // only wake the producer if it's waiting, exactly once per wait
+    if(Atomic::CmpExch32(&m_ProducerWaiting, 1, 0) == 1)
+      m_CompleteSemaphore->Wake(1);
+  }
+}
+
+DecompressReadAhead::DecompressReadAhead(Decompressor *decompressor, uint64_t remaining)
+    : m_Decompressor(decompressor)
+{
+  for(Page &p : m_Pages)
+  {
+    p.data = AllocAlignedBuffer(PageSize);
+    p.size = 0;
+    p.success = true;
+  }
+
+  m_FilledSemaphore = Threading::Semaphore::Create();
+  m_FreeSemaphore = Threading::Semaphore::Create();
+
+  Resume(remaining);
+}
+
+DecompressReadAhead::~DecompressReadAhead()
+{
+  Pause();
+
+  m_FilledSemaphore->Destroy();
+  m_FreeSemaphore->Destroy();
+
+  for(Page &p : m_Pages)
+    FreeAlignedBuffer(p.data);
+}
+
+void DecompressReadAhead::Pause()
+{
+  if(m_Thread == 0)
+    return;
+
+  Atomic::Inc32(&m_ThreadKill);
+  m_FreeSemaphore->Wake(1);
+
+  Threading::JoinThread(m_Thread);
+  Threading::CloseThread(m_Thread);
+  m_Thread = 0;
+}
+
+void DecompressReadAhead::Resume(uint64_t remaining)
+{
+  RDCASSERT(m_Thread == 0);
+
+  // any stale wakes left in the semaphores are harmless, both sides re-check the counts
+  m_Filled = m_Released = 0;
+  m_PageOffset = 0;
+  m_ThreadKill = 0;
+  m_Remaining = m_ReaderRemaining = remaining;
+
+  if(remaining > 0)
+    m_Thread = Threading::CreateThread([this]() { ThreadEntry(); });
+}
+
+bool DecompressReadAhead::Read(void *data, uint64_t numBytes, RDResult &error)
+{
+  if(numBytes > m_ReaderRemaining)
+  {
+    SET_ERROR_RESULT(error, ResultCode::FileIOFailed, "Reading off the end of decompressed data");
+    return false;
+  }
+
+  m_ReaderRemaining -= numBytes;
+
+  byte *dst = (byte *)data;
+
+  while(numBytes > 0)
+  {
+    while(Atomic::CmpExch64(&m_Filled, 0, 0) == m_Released)
+      m_FilledSemaphore->WaitForWake();
+
+    Page &p = m_Pages[m_Released % NumPages];
+
+    if(!p.success)
+    {
+      error = m_Decompressor->GetError();
+      if(error == ResultCode::Succeeded)
+        SET_ERROR_RESULT(error, ResultCode::CompressionFailed, "Decompression failed");
+      return false;
+    }
+
+    uint64_t chunkSize = RDCMIN(numBytes, p.size - m_PageOffset);
+
+    if(dst)
+    {
+      memcpy(dst, p.data + m_PageOffset, (size_t)chunkSize);
+      dst += chunkSize;
+    }
+
+    m_PageOffset += chunkSize;
+    numBytes -= chunkSize;
+
+    // once the page is consumed, hand it back to the worker to fill again
+    if(m_PageOffset == p.size)
+    {
+      m_PageOffset = 0;
+      Atomic::Inc64(&m_Released);
+      m_FreeSemaphore->Wake(1);
+    }
+  }
+
+  return true;
+}
+
+void DecompressReadAhead::ThreadEntry()
+{
+  Threading::SetCurrentThreadName("Decompression Read-ahead");
+
+  while(m_Remaining > 0)
+  {
+    // wait until there's a free page, unless we're being stopped
+    while(Atomic::CmpExch32(&m_ThreadKill, 0, 0) == 0 &&
+          m_Filled - Atomic::CmpExch64(&m_Released, 0, 0) >= (int64_t)NumPages)
+      m_FreeSemaphore->WaitForWake();
+
+    if(Atomic::CmpExch32(&m_ThreadKill, 0, 0) != 0)
+      break;
+
+    Page &p = m_Pages[m_Filled % NumPages];
+
+    p.size = RDCMIN(uint64_t(PageSize), m_Remaining);
+    p.success = m_Decompressor->Read(p.data, p.size);
+    m_Remaining -= p.size;
+
+    Atomic::Inc64(&m_Filled);
+    m_FilledSemaphore->Wake(1);
+
+    // the reader will pick up the error when it reaches this page
+    if(!p.success)
+      break;
+  }
+}
+
 static const uint64_t initialBufferSize = 64 * 1024;
 const byte StreamWriter::empty[128] = {};
 
@@ -62,6 +490,17 @@ StreamReader::StreamReader(const bytebuf &buffer)
   m_Ownership = Ownership::Nothing;
 }
 
+StreamReader::StreamReader(StreamBorrowedType, const byte *buffer, uint64_t bufferSize)
+{
+  m_InputSize = m_BufferSize = bufferSize;
+  // we never write through this pointer
+  m_BufferHead = m_BufferBase = (byte *)buffer;
+
+  m_Borrowed = true;
+
+  m_Ownership = Ownership::Nothing;
+}
+
 StreamReader::StreamReader(StreamInvalidType, RDResult res)
 {
   m_InputSize = 0;
@@ -131,6 +570,7 @@ StreamReader::StreamReader(FILE *file, uint64_t fileSize, Ownership own)
   }
 
   m_File = file;
+  m_FileBase = FileIO::ftell64(file);
   m_InputSize = fileSize;
 
   m_BufferSize = initialBufferSize;
@@ -180,11 +620,15 @@ StreamReader::StreamReader(StreamReader *reader, uint64_t bufferSize)
   m_Ownership = Ownership::Nothing;
 }
 
-StreamReader::StreamReader(Decompressor *decompressor, uint64_t uncompressedSize, Ownership own)
+StreamReader::StreamReader(Decompressor *decompressor, uint64_t uncompressedSize, Ownership own,
+                           bool readAhead)
 {
   m_Decompressor = decompressor;
   m_InputSize = uncompressedSize;
 
+  if(readAhead && uncompressedSize > 0)
+    m_ReadAhead = new DecompressReadAhead(decompressor, uncompressedSize);
+
   m_BufferSize = initialBufferSize;
   m_BufferHead = m_BufferBase = AllocAlignedBuffer(m_BufferSize);
 
@@ -198,7 +642,11 @@ StreamReader::~StreamReader()
   for(StreamCloseCallback cb : m_Callbacks)
     cb();
 
-  FreeAlignedBuffer(m_BufferBase);
+  if(!m_Borrowed)
+    FreeAlignedBuffer(m_BufferBase);
+
+  // stop the worker before the decompressor it's using can be deleted
+  SAFE_DELETE(m_ReadAhead);
 
   if(m_Ownership == Ownership::Stream)
   {
@@ -212,13 +660,74 @@ StreamReader::~StreamReader()
 
 void StreamReader::SetOffset(uint64_t offs)
 {
-  if(m_File || m_Decompressor)
+  if(m_Sock)
+  {
+    RDCERR("Socket stream readers do not support seeking");
+    return;
+  }
+
+  if(!m_File && !m_Decompressor)
+  {
+    m_BufferHead = m_BufferBase + offs;
+    return;
+  }
+
+  if(!m_BufferBase || IsErrored())
+    return;
+
+  if(offs > GetSize())
+  {
+    SET_ERROR_RESULT(m_Error, ResultCode::FileIOFailed, "Seeking off the end of data stream");
+    return;
+  }
+
+  const uint64_t curOffs = GetOffset();
+
+  // if we're seeking forward within what's already read, just move the head
+  if(offs >= curOffs && offs - curOffs <= Available())
+  {
+    m_BufferHead += offs - curOffs;
+    return;
+  }
+
+  // if we're seeking forward a small amount, or can't seek at all, read up to the offset
+  if(offs >= curOffs &&
+     (offs - curOffs < m_BufferSize || (m_Decompressor && !m_Decompressor->CanSeek())))
+  {
+    Read(NULL, offs - curOffs);
+    return;
+  }
+
+  if(m_Decompressor && !m_Decompressor->CanSeek())
   {
-    RDCERR("File and decompress stream readers do not support seeking");
+    RDCERR("Decompress stream readers can't seek backwards without a block index");
     return;
   }
 
-  m_BufferHead = m_BufferBase + offs;
+  // otherwise discard our window and refill it from the new location. For decompressors we can
+  // only start at a block boundary, so skip forward from there to the offset
+  uint64_t refillOffs = offs;
+
+  if(m_Decompressor)
+  {
+    if(m_ReadAhead)
+      m_ReadAhead->Pause();
+
+    refillOffs = m_Decompressor->SeekToBlock(offs);
+
+    if(m_ReadAhead)
+      m_ReadAhead->Resume(m_InputSize - refillOffs);
+  }
+  else
+    FileIO::fseek64(m_File, m_FileBase + offs, SEEK_SET);
+
+  m_ReadOffset = refillOffs;
+  m_BufferHead = m_BufferBase;
+
+  if(!ReadFromExternal(m_BufferBase, RDCMIN(m_BufferSize, m_InputSize - refillOffs)))
+    return;
+
+  Read(NULL, offs - refillOffs);
 }
 
 bool StreamReader::Reserve(uint64_t numBytes)
@@ -383,7 +892,11 @@ bool StreamReader::ReadFromExternal(void *buffer, uint64_t length)
 {
   bool success = true;
 
-  if(m_Decompressor)
+  if(m_ReadAhead)
+  {
+    success = m_ReadAhead->Read(buffer, length, m_Error);
+  }
+  else if(m_Decompressor)
   {
     success = m_Decompressor->Read(buffer, length);
 
@@ -466,6 +979,8 @@ bool StreamReader::ReadFromExternal(void *buffer, uint64_t length)
     // move to error state
     FreeAlignedBuffer(m_BufferBase);
 
+    SAFE_DELETE(m_ReadAhead);
+
     if(m_Ownership == Ownership::Stream)
     {
       if(m_File)
@@ -52,10 +52,98 @@ public:
   virtual bool Write(const void *data, uint64_t numBytes) = 0;
   virtual bool Finish() = 0;
 
+  // compress every block independently and write an index of block offsets after the compressed
+  // data when finishing, so that a Decompressor can seek. Must be called before anything is written
+  virtual void EnableBlockIndex() { m_BlockIndexed = true; }
+
 protected:
+  // called immediately before each block is written, to record its offset if indexing
+  void RecordBlock();
+  bool WriteBlockIndex(uint64_t blockSize);
+
   StreamWriter *m_Write;
   Ownership m_Ownership;
   RDResult m_Error;
+
+  bool m_BlockIndexed = false;
+  rdcarray<uint64_t> m_BlockOffsets;
+};
+
+// helper for compressors that can compress blocks independently on worker threads. The producer
+// fills pages one at a time and submits them, and the compressed blocks are written to the stream
+// in submission order as a 32-bit compressed size followed by the compressed data - the same
+// layout as the serial compressors write, so decompressors don't need to know the difference.
+class ParallelCompression
+{
+public:
+  // compresses inSize bytes from in into out, returning the number of compressed bytes or a
+  // negative value on failure. history contains up to historySize bytes from the end of the
+  // previous block, for compressors that can reference it. Called on the worker threads, worker is
+  // a unique index per thread less than the number of threads so per-thread state can be used.
+  typedef std::function<int64_t(uint32_t worker, const byte *history, uint64_t historySize,
+                                const byte *in, uint64_t inSize, byte *out)>
+      CompressBlockCallback;
+
+  ParallelCompression(uint32_t numThreads, uint64_t blockSize, uint64_t compressBound,
+                      uint64_t historySize, CompressBlockCallback callback);
+  ~ParallelCompression();
+
+  // the page to fill for the next block, always blockSize bytes in size
+  byte *GetPage();
+
+  // submit the current page containing size bytes, and write out any blocks that have completed.
+  // This will block if all pages are in flight until the oldest is written.
+  bool SubmitPage(uint64_t size, StreamWriter *write, RDResult &error);
+
+  // wait for all submitted blocks to complete and write them out.
+  bool Flush(StreamWriter *write, RDResult &error);
+
+  // record the offset each block is written at into blockOffsets, and compress every block without
+  // any history so they can be decompressed independently.
+  void SetBlockIndex(rdcarray<uint64_t> *blockOffsets) { m_BlockOffsets = blockOffsets; }
+
+private:
+  bool WriteCompleted(bool waitForAll, StreamWriter *write, RDResult &error);
+  void ThreadEntry(uint32_t worker);
+
+  struct Block
+  {
+    byte *page;
+    uint64_t size;
+    byte *history;
+    uint64_t historySize;
+    byte *compressed;
+    int64_t compressedSize;
+    // 0 = owned by the producer, 1 = submitted for compression, 2 = compressed
+    int32_t state;
+  };
+
+  // called by the producer to wait until a block isn't being compressed
+  void WaitForBlock(Block &b);
+
+  uint64_t m_BlockSize;
+  uint64_t m_HistorySize;
+  CompressBlockCallback m_Callback;
+  rdcarray<uint64_t> *m_BlockOffsets = NULL;
+
+  rdcarray<Block> m_Blocks;
+  rdcarray<Threading::ThreadHandle> m_Threads;
+
+  // woken once for every block submitted
+  Threading::Semaphore *m_WorkSemaphore = NULL;
+  // woken when a block is compressed while the producer is waiting. Waking it for every block
+  // would let its count grow without bound, and some platforms cap it
+  Threading::Semaphore *m_CompleteSemaphore = NULL;
+  // set by the producer while it waits on m_CompleteSemaphore, and cleared by whoever wakes it
+  int32_t m_ProducerWaiting = 0;
+
+  // only accessed by the producer, count of blocks submitted and written
+  int64_t m_Submitted = 0;
+  int64_t m_Written = 0;
+
+  // accessed by workers, count of blocks that have been claimed for compression
+  int64_t m_Claimed = 0;
+  int32_t m_ThreadKill = 0;
 };
 
 class Decompressor
@@ -67,10 +155,82 @@ public:
   virtual bool Recompress(Compressor *comp) = 0;
   virtual bool Read(void *data, uint64_t numBytes) = 0;
 
+  // reads the index written after the compressed data by a Compressor with EnableBlockIndex(). The
+  // source stream must be seekable and positioned at the start. If the index is missing or invalid
+  // this returns false and the stream can still be read sequentially.
+  bool ReadBlockIndex();
+  bool CanSeek() const { return !m_BlockOffsets.empty(); }
+  // move to the start of the block containing the given uncompressed offset, and return the
+  // uncompressed offset of that block which the next Read() will begin at.
+  uint64_t SeekToBlock(uint64_t offs);
+
 protected:
+  // discard any decompressed data and history, the next read will start at an independent block.
+  virtual void ResetBlock() = 0;
+  bool AtDataEnd();
+
   StreamReader *m_Read;
   Ownership m_Ownership;
   RDResult m_Error;
+
+  uint64_t m_BlockSize = 0;
+  rdcarray<uint64_t> m_BlockOffsets;
+  // where the compressed data ends, if there is a block index after it
+  uint64_t m_DataEnd = ~0ULL;
+};
+
+// helper for decompressing ahead of the reader on a worker thread. Fixed-size pages are filled in
+// order into a ring, so decompression can overlap with whatever is consuming the data - e.g. the
+// serialiser parsing chunks - instead of the two alternating on one thread.
+class DecompressReadAhead
+{
+public:
+  DecompressReadAhead(Decompressor *decompressor, uint64_t remaining);
+  ~DecompressReadAhead();
+
+  // read the next numBytes of decompressed data, blocking until the worker has produced it.
+  bool Read(void *data, uint64_t numBytes, RDResult &error);
+
+  // stop the worker and discard anything read ahead, so the decompressor can be used directly e.g.
+  // to seek. Resume() starts reading ahead again from the decompressor's current position.
+  void Pause();
+  void Resume(uint64_t remaining);
+
+  static const uint64_t PageSize = 1024 * 1024;
+  static const uint32_t NumPages = 4;
+
+private:
+  void ThreadEntry();
+
+  struct Page
+  {
+    byte *data;
+    uint64_t size;
+    bool success;
+  };
+
+  Decompressor *m_Decompressor;
+  Page m_Pages[NumPages];
+  Threading::ThreadHandle m_Thread = 0;
+
+  // woken once for every page filled by the worker
+  Threading::Semaphore *m_FilledSemaphore = NULL;
+  // woken once for every page released by the reader
+  Threading::Semaphore *m_FreeSemaphore = NULL;
+
+  // only accessed by the worker, bytes left to decompress
+  uint64_t m_Remaining = 0;
+
+  // count of pages filled by the worker and released by the reader
+  int64_t m_Filled = 0;
+  int64_t m_Released = 0;
+
+  // only accessed by the reader, how far into the current page it has read and how many bytes are
+  // left to read in total
+  uint64_t m_PageOffset = 0;
+  uint64_t m_ReaderRemaining = 0;
+
+  int32_t m_ThreadKill = 0;
 };
 
 class StreamReader
@@ -84,9 +244,16 @@ public:
   {
     DummyStream
   };
+  enum StreamBorrowedType
+  {
+    BorrowedStream
+  };
 
   StreamReader(StreamInvalidType, RDResult res);
   StreamReader(StreamDummyType);
+  // reads directly from memory owned elsewhere (e.g. a mapped file) without copying it. The memory
+  // must remain valid and unmodified while the reader or any pointer from ReadDirect is in use.
+  StreamReader(StreamBorrowedType, const byte *buffer, uint64_t bufferSize);
   StreamReader(const byte *buffer, uint64_t bufferSize);
   StreamReader(const bytebuf &buffer);
 
@@ -94,7 +261,9 @@ public:
   StreamReader(FILE *file, uint64_t fileSize, Ownership own);
   StreamReader(FILE *file);
   StreamReader(StreamReader *reader, uint64_t bufferSize);
-  StreamReader(Decompressor *decompressor, uint64_t uncompressedSize, Ownership own);
+  // if readAhead is true, decompression happens on a worker thread ahead of reads
+  StreamReader(Decompressor *decompressor, uint64_t uncompressedSize, Ownership own,
+               bool readAhead = false);
 
   ~StreamReader();
 
@@ -215,6 +384,26 @@ public:
     return true;
   }
 
+  // if the stream is reading from borrowed memory, return a pointer directly to the next numBytes
+  // and skip past them. Otherwise returns NULL without reading anything, and Read() must be used.
+  // There is no alignment guarantee beyond that of the borrowed memory.
+  const byte *ReadDirect(uint64_t numBytes)
+  {
+    if(!m_Borrowed || IsErrored() || GetOffset() + numBytes > GetSize())
+      return NULL;
+
+    const byte *ret = m_BufferHead;
+    m_BufferHead += numBytes;
+    return ret;
+  }
+
+  // returns true if ptr was returned from ReadDirect, i.e. it points into borrowed memory
+  bool IsBorrowedPointer(const void *ptr) const
+  {
+    return m_Borrowed && (const byte *)ptr >= m_BufferBase &&
+           (const byte *)ptr < m_BufferBase + m_BufferSize;
+  }
+
   bool SkipBytes(uint64_t numBytes)
   {
     // fast path for file skipping
@@ -271,12 +460,18 @@ private:
   // file pointer, if we're reading from a file
   FILE *m_File = NULL;
 
+  // the position in the file that corresponds to offset 0 in this stream
+  uint64_t m_FileBase = 0;
+
   // socket, if we're reading from a socket
   Network::Socket *m_Sock = NULL;
 
   // the decompressor, if reading from it
   Decompressor *m_Decompressor = NULL;
 
+  // decompressing ahead on a worker thread, if enabled
+  DecompressReadAhead *m_ReadAhead = NULL;
+
   // the offset in the file/decompressor that corresponds to the start of m_BufferBase
   uint64_t m_ReadOffset = 0;
 
@@ -288,6 +483,9 @@ private:
   // structured serialiser to 'read' pre-existing data.
   bool m_Dummy = false;
 
+  // flag indicating the buffer is borrowed from external memory that we don't own.
+  bool m_Borrowed = false;
+
   // do we own the file/compressor? are we responsible for
   // cleaning it up?
   Ownership m_Ownership;
@@ -24,6 +24,7 @@
 
 #include "streamio.h"
 #include "common/timing.h"
+#include "lz4io.h"
 
 #if ENABLED(ENABLE_UNIT_TESTS)
 
@@ -170,6 +171,195 @@ TEST_CASE("Test stream I/O with invalid/broken outputs", "[streamio]")
   };
 };
 
+TEST_CASE("Test reading from a memory mapped file", "[streamio]")
+{
+  rdcstr filename = FileIO::GetTempFolderFilename() + "/mapped.bin";
+
+  bytebuf contents;
+  contents.resize(256 * 1024 + 13);
+  for(size_t i = 0; i < contents.size(); i++)
+    contents[i] = byte(i * 13);
+
+  REQUIRE(FileIO::WriteAll(filename, contents));
+
+  FILE *f = FileIO::fopen(filename, FileIO::ReadBinary);
+  REQUIRE(f);
+
+  uint64_t size = 0;
+  const byte *mapping = FileIO::MapFileForRead(f, size);
+
+  // the mapping stays valid after the file is closed
+  FileIO::fclose(f);
+
+  REQUIRE(mapping);
+  CHECK(size == contents.size());
+
+  {
+    StreamReader reader(StreamReader::BorrowedStream, mapping + 100, size - 100);
+
+    uint32_t test = 0;
+    reader.Read(test);
+    CHECK_FALSE(memcmp(&test, contents.data() + 100, sizeof(test)));
+
+    const byte *direct = reader.ReadDirect(1000);
+    CHECK(direct == mapping + 104);
+    CHECK(reader.IsBorrowedPointer(direct));
+    CHECK(reader.GetOffset() == 1004);
+
+    // reading off the end doesn't return a pointer or move the stream
+    CHECK(reader.ReadDirect(size) == NULL);
+    CHECK(reader.GetOffset() == 1004);
+    CHECK_FALSE(reader.IsErrored());
+
+    reader.SetOffset(size - 100 - 9);
+    byte tail[9] = {};
+    reader.Read(tail, sizeof(tail));
+    CHECK_FALSE(memcmp(tail, contents.data() + contents.size() - 9, sizeof(tail)));
+    CHECK(reader.AtEnd());
+  }
+
+  // readers that copy never hand out direct pointers
+  {
+    StreamReader reader(mapping, size);
+
+    CHECK(reader.ReadDirect(4) == NULL);
+    CHECK_FALSE(reader.IsBorrowedPointer(mapping));
+  }
+
+  FileIO::UnmapFile(mapping, size);
+
+  FileIO::Delete(filename);
+};
+
+// reads the whole stream in variable-sized pieces the way the serialiser reads chunks, doing some
+// work on each byte to stand in for parsing. Returns a hash of the data
+static uint64_t ParseStream(StreamReader &reader, uint32_t workPerByte)
+{
+  const uint64_t maxChunk = 96 * 1024;
+  byte *chunk = new byte[maxChunk];
+
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  uint64_t chunkSize = 1;
+
+  while(!reader.AtEnd() && !reader.IsErrored())
+  {
+    chunkSize = RDCMIN((chunkSize * 7 + 13) % maxChunk + 1, reader.GetSize() - reader.GetOffset());
+    reader.Read(chunk, chunkSize);
+
+    for(uint64_t i = 0; i < chunkSize; i++)
+      for(uint32_t w = 0; w < workPerByte; w++)
+        hash = (hash ^ chunk[i]) * 0x100000001b3ULL;
+  }
+
+  delete[] chunk;
+
+  return hash;
+}
+
+TEST_CASE("Test reading ahead from a decompressor", "[streamio]")
+{
+  // not a multiple of the read-ahead page size or the LZ4 block size
+  const uint64_t size = 24 * 1024 * 1024 + 777;
+
+  byte *data = new byte[size];
+  uint32_t seed = 0x9876543;
+  for(uint64_t i = 0; i < size; i++)
+  {
+    seed = seed * 1664525U + 1013904223U;
+    data[i] = (seed & 0x30000000) ? byte(i / 97) : byte(seed >> 24);
+  }
+
+  StreamWriter compressed(StreamWriter::DefaultScratchSize);
+
+  {
+    LZ4Compressor *comp = new LZ4Compressor(&compressed, Ownership::Nothing);
+    comp->EnableBlockIndex();
+
+    StreamWriter writer(comp, Ownership::Stream);
+    writer.Write(data, size);
+    writer.Finish();
+    REQUIRE_FALSE(writer.IsErrored());
+  }
+
+  auto makeReader = [&](bool readAhead) {
+    LZ4Decompressor *decomp = new LZ4Decompressor(
+        new StreamReader(compressed.GetData(), compressed.GetOffset()), Ownership::Stream);
+    decomp->ReadBlockIndex();
+    return new StreamReader(decomp, size, Ownership::Stream, readAhead);
+  };
+
+  SECTION("Reading and seeking")
+  {
+    StreamReader *reader = makeReader(true);
+
+    byte *readData = new byte[size];
+
+    // small reads through the window, then one large read directly into the output
+    reader->Read(readData, 100);
+    reader->Read(readData + 100, 5000);
+    reader->Read(readData + 5100, size - 5100);
+
+    CHECK_FALSE(reader->IsErrored());
+    CHECK(reader->AtEnd());
+    CHECK_FALSE(memcmp(readData, data, (size_t)size));
+
+    // seeking discards what was read ahead and restarts from the new location
+    const uint64_t offsets[] = {12345, size - 16, 9 * 1024 * 1024 + 3, 0};
+
+    for(uint64_t offs : offsets)
+    {
+      reader->SetOffset(offs);
+      CHECK(reader->GetOffset() == offs);
+
+      byte tmp[16] = {};
+      reader->Read(tmp, sizeof(tmp));
+      CHECK_FALSE(memcmp(tmp, data + offs, sizeof(tmp)));
+    }
+
+    // reading off the end still fails cleanly
+    reader->SetOffset(size - 4);
+    uint64_t tmp = 0;
+    CHECK_FALSE(reader->Read(tmp));
+    CHECK(reader->IsErrored());
+
+    delete reader;
+
+    // deleting a reader while the worker is still busy is fine
+    reader = makeReader(true);
+    reader->Read(tmp);
+    delete reader;
+
+    delete[] readData;
+  };
+
+  SECTION("Overlapping decompression with parsing")
+  {
+    const uint32_t workPerByte = 1;
+
+    double readAheadTime[2] = {};
+    uint64_t hash[2] = {};
+
+    for(int readAhead = 0; readAhead < 2; readAhead++)
+    {
+      StreamReader *reader = makeReader(readAhead == 1);
+
+      PerformanceTimer timer;
+      hash[readAhead] = ParseStream(*reader, workPerByte);
+      readAheadTime[readAhead] = timer.GetMilliseconds();
+
+      CHECK_FALSE(reader->IsErrored());
+      delete reader;
+    }
+
+    CHECK(hash[0] == hash[1]);
+
+    RDCLOG("Parsing %llu MB with decompression inline: %.2f ms, read ahead: %.2f ms",
+           size / (1024 * 1024), readAheadTime[0], readAheadTime[1]);
+  };
+
+  delete[] data;
+};
+
 TEST_CASE("Test stream I/O operations over the network", "[streamio][network]")
 {
   uint16_t port = 8235;
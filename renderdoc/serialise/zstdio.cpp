@@ -28,28 +28,79 @@
 static const uint64_t zstdBlockSize = 128 * 1024;
 static const uint64_t compressBlockSize = ZSTD_compressBound(zstdBlockSize);
 
-ZSTDCompressor::ZSTDCompressor(StreamWriter *write, Ownership own) : Compressor(write, own)
+static const int zstdCompressionLevel = 7;
+
+ZSTDCompressor::ZSTDCompressor(StreamWriter *write, Ownership own, uint32_t numThreads)
+    : Compressor(write, own)
 {
+  m_PageOffset = 0;
+
+  if(numThreads > 1)
+  {
+    // each block is already an independent frame, so they can be compressed in any order as long
+    // as they're written in order.
+    m_WorkerContexts.resize(numThreads);
+    for(uint32_t i = 0; i < numThreads; i++)
+      m_WorkerContexts[i] = ZSTD_createCCtx();
+
+    m_Parallel = new ParallelCompression(
+        numThreads, zstdBlockSize, compressBlockSize, 0,
+        [this](uint32_t worker, const byte *, uint64_t, const byte *in, uint64_t inSize,
+               byte *out) -> int64_t {
+          size_t ret = ZSTD_compressCCtx(m_WorkerContexts[worker], out, compressBlockSize, in,
+                                         (size_t)inSize, zstdCompressionLevel);
+
+          if(ZSTD_isError(ret))
+          {
+            RDCERR("ZSTD compression failed: %s", ZSTD_getErrorName(ret));
+            return -1;
+          }
+
+          return (int64_t)ret;
+        });
+
+    m_Page = m_Parallel->GetPage();
+    m_CompressBuffer = NULL;
+
+    m_Stream = NULL;
+    return;
+  }
+
   m_Page = AllocAlignedBuffer(zstdBlockSize);
   m_CompressBuffer = AllocAlignedBuffer(compressBlockSize);
 
-  m_PageOffset = 0;
-
   m_Stream = ZSTD_createCStream();
 }
 
 ZSTDCompressor::~ZSTDCompressor()
 {
-  ZSTD_freeCStream(m_Stream);
+  if(m_Stream)
+    ZSTD_freeCStream(m_Stream);
 
-  FreeAlignedBuffer(m_Page);
-  FreeAlignedBuffer(m_CompressBuffer);
+  FreeBuffers();
+
+  // this will wait for any outstanding work, though normally Finish() has already flushed it
+  SAFE_DELETE(m_Parallel);
+
+  for(ZSTD_CCtx *ctx : m_WorkerContexts)
+    ZSTD_freeCCtx(ctx);
+}
+
+void ZSTDCompressor::FreeBuffers()
+{
+  // in parallel mode the page is owned by m_Parallel
+  if(!m_Parallel)
+  {
+    FreeAlignedBuffer(m_Page);
+    FreeAlignedBuffer(m_CompressBuffer);
+  }
+  m_Page = m_CompressBuffer = NULL;
 }
 
 bool ZSTDCompressor::Write(const void *data, uint64_t numBytes)
 {
   // if we encountered a stream error this will be NULL
-  if(!m_CompressBuffer)
+  if(!m_Page)
     return false;
 
   if(numBytes == 0)
@@ -112,15 +163,53 @@ bool ZSTDCompressor::Finish()
   // only the last one can be smaller, so we only write a partial page when finishing.
   // Calling Write() after Finish() is illegal
 
-  return FlushPage();
+  bool success = FlushPage();
+
+  if(m_Parallel && success)
+  {
+    success &= m_Parallel->Flush(m_Write, m_Error);
+
+    if(!success)
+      FreeBuffers();
+  }
+
+  if(m_BlockIndexed && success)
+    success &= WriteBlockIndex(zstdBlockSize);
+
+  return success;
+}
+
+void ZSTDCompressor::EnableBlockIndex()
+{
+  Compressor::EnableBlockIndex();
+
+  if(m_Parallel)
+    m_Parallel->SetBlockIndex(&m_BlockOffsets);
 }
 
 bool ZSTDCompressor::FlushPage()
 {
   // if we encountered a stream error this will be NULL
-  if(!m_CompressBuffer)
+  if(!m_Page)
     return false;
 
+  if(m_Parallel)
+  {
+    bool success = m_Parallel->SubmitPage(m_PageOffset, m_Write, m_Error);
+
+    if(!success)
+    {
+      FreeBuffers();
+      return false;
+    }
+
+    // continue in the next free page
+    m_Page = m_Parallel->GetPage();
+    m_PageOffset = 0;
+
+    return success;
+  }
+
   ZSTD_inBuffer in = {m_Page, (size_t)m_PageOffset, 0};
   ZSTD_outBuffer out = {m_CompressBuffer, ZSTD_CStreamOutSize(), 0};
 
@@ -132,6 +221,8 @@ bool ZSTDCompressor::FlushPage()
   if(!m_CompressBuffer)
     return false;
 
+  RecordBlock();
+
   // a bit redundant to write this but it means we can read the entire frame without
   // doing multiple reads
   success &= m_Write->Write((uint32_t)out.pos);
@@ -145,13 +236,11 @@ bool ZSTDCompressor::FlushPage()
 
 bool ZSTDCompressor::CompressZSTDFrame(ZSTD_inBuffer &in, ZSTD_outBuffer &out)
 {
-  size_t err = ZSTD_initCStream(m_Stream, 7);
+  size_t err = ZSTD_initCStream(m_Stream, zstdCompressionLevel);
 
   if(ZSTD_isError(err))
   {
-    FreeAlignedBuffer(m_Page);
-    FreeAlignedBuffer(m_CompressBuffer);
-    m_Page = m_CompressBuffer = NULL;
+    FreeBuffers();
     SET_ERROR_RESULT(m_Error, ResultCode::CompressionFailed, "ZSTD compression failed: %s",
                      ZSTD_getErrorName(err));
     return false;
@@ -173,9 +262,7 @@ bool ZSTDCompressor::CompressZSTDFrame(ZSTD_inBuffer &in, ZSTD_outBuffer &out)
       else
         SET_ERROR_RESULT(m_Error, ResultCode::CompressionFailed,
                          "ZSTD compression failed, no progress made");
-      FreeAlignedBuffer(m_Page);
-      FreeAlignedBuffer(m_CompressBuffer);
-      m_Page = m_CompressBuffer = NULL;
+      FreeBuffers();
       return false;
     }
   }
@@ -190,9 +277,7 @@ bool ZSTDCompressor::CompressZSTDFrame(ZSTD_inBuffer &in, ZSTD_outBuffer &out)
     else
       SET_ERROR_RESULT(m_Error, ResultCode::CompressionFailed,
                        "Error compressing, couldn't end stream");
-    FreeAlignedBuffer(m_Page);
-    FreeAlignedBuffer(m_CompressBuffer);
-    m_Page = m_CompressBuffer = NULL;
+    FreeBuffers();
     return false;
   }
 
@@ -221,7 +306,7 @@ bool ZSTDDecompressor::Recompress(Compressor *comp)
 {
   bool success = true;
 
-  while(success && !m_Read->AtEnd())
+  while(success && !AtDataEnd())
   {
     success &= FillPage();
     if(success)
@@ -296,6 +381,13 @@ bool ZSTDDecompressor::Read(void *data, uint64_t numBytes)
   return success;
 }
 
+void ZSTDDecompressor::ResetBlock()
+{
+  // every frame is independent so there's no other state to reset
+  m_PageOffset = 0;
+  m_PageLength = 0;
+}
+
 bool ZSTDDecompressor::FillPage()
 {
   uint32_t compSize = 0;
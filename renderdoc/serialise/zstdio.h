@@ -30,14 +30,17 @@
 class ZSTDCompressor : public Compressor
 {
 public:
-  ZSTDCompressor(StreamWriter *write, Ownership own);
+  // if numThreads is greater than 1, blocks are compressed in parallel on that many threads
+  ZSTDCompressor(StreamWriter *write, Ownership own, uint32_t numThreads = 1);
   ~ZSTDCompressor();
 
   bool Write(const void *data, uint64_t numBytes);
   bool Finish();
+  void EnableBlockIndex();
 
 private:
   bool FlushPage();
+  void FreeBuffers();
 
   bool CompressZSTDFrame(ZSTD_inBuffer &in, ZSTD_outBuffer &out);
 
@@ -46,6 +49,11 @@ private:
   uint64_t m_PageOffset;
 
   ZSTD_CStream *m_Stream;
+
+  // only used when compressing in parallel, with one context per worker thread. m_Page is then
+  // owned by m_Parallel and m_CompressBuffer is unused
+  ParallelCompression *m_Parallel = NULL;
+  rdcarray<ZSTD_CCtx *> m_WorkerContexts;
 };
 
 class ZSTDDecompressor : public Decompressor
@@ -58,6 +66,7 @@ public:
   bool Read(void *data, uint64_t numBytes);
 
 private:
+  void ResetBlock();
   bool FillPage();
 
   byte *m_Page;